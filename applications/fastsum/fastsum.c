@@ -26,6 +26,7 @@
 
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 #ifdef HAVE_COMPLEX_H
 #include <complex.h>
 #endif
@@ -695,20 +696,23 @@ static C SearchTree(const int d, const int t, const R *x, const C *alpha,
   }
 }
 
+/** add the time of one step to the statistics of the plan */
+static inline void fastsum_stats_add(fastsum_plan *ths, const int phase, const R seconds)
+{
+  ths->stats.time[phase] += (double)(seconds);
+  ths->stats.calls[phase]++;
+}
+
 static void fastsum_precompute_kernel(fastsum_plan *ths)
 {
   int j, k, t;
   INT N[ths->d];
   int n_total;
-#ifdef MEASURE_TIME
   ticks t0, t1;
-#endif
 
   ths->MEASURE_TIME_t[0] = K(0.0);
 
-#ifdef MEASURE_TIME
   t0 = getticks();
-#endif
   /** precompute spline values for near field */
   if (ths->eps_I > 0.0 && !(ths->flags & EXACT_NEARFIELD))
   {
@@ -728,14 +732,10 @@ static void fastsum_precompute_kernel(fastsum_plan *ths)
         ths->Add[k] = regkern3(ths->k, ths->eps_I * (R) k / (R)(ths->Ad), ths->p,
             ths->kernel_param, ths->eps_I, ths->eps_B);
   }
-#ifdef MEASURE_TIME
   t1 = getticks();
   ths->MEASURE_TIME_t[0] += NFFT(elapsed_seconds)(t1,t0);
-#endif
 
-#ifdef MEASURE_TIME
   t0 = getticks();
-#endif
   /** precompute Fourier coefficients of regularised kernel*/
   n_total = 1;
   for (t = 0; t < ths->d; t++)
@@ -770,10 +770,9 @@ static void fastsum_precompute_kernel(fastsum_plan *ths)
   NFFT(fftshift_complex)(ths->b, (int)(ths->d), N);
   FFTW(execute)(ths->fft_plan);
   NFFT(fftshift_complex)(ths->b, (int)(ths->d), N);
-#ifdef MEASURE_TIME
   t1 = getticks();
   ths->MEASURE_TIME_t[0] += nfft_elapsed_seconds(t1,t0);
-#endif
+  fastsum_stats_add(ths, NFFT_STATS_PRECOMPUTE, ths->MEASURE_TIME_t[0]);
 }
 
 void fastsum_init_guru_kernel(fastsum_plan *ths, int d, kernel k, R *param,
@@ -797,6 +796,9 @@ void fastsum_init_guru_kernel(fastsum_plan *ths, int d, kernel k, R *param,
   ths->eps_I = eps_I; /* =(R)ths->p/(R)nn; *//** inner boundary */
   ths->eps_B = eps_B; /* =K(1.0)/K(16.0); *//** outer boundary */
 
+  memset(&ths->stats, 0, sizeof(ths->stats));
+  ths->stats.nthreads = NFFT(get_num_threads)();
+
   /** init spline for near field computation */
   if (ths->eps_I > 0.0 && !(ths->flags & EXACT_NEARFIELD))
   {
@@ -874,6 +876,7 @@ void fastsum_init_guru_kernel(fastsum_plan *ths, int d, kernel k, R *param,
     FFTW(plan_with_nthreads)(nthreads);
 #endif
 
+  NFFT(wisdom_before_plan)();
   ths->fft_plan = FFTW(plan_dft)(d, N, ths->b, ths->b, FFTW_FORWARD,
       FFTW_ESTIMATE);
 
@@ -1085,16 +1088,12 @@ void fastsum_exact(fastsum_plan *ths)
 /** precomputation for fastsum */
 void fastsum_precompute_source_nodes(fastsum_plan *ths)
 {
-#ifdef MEASURE_TIME
   ticks t0, t1;
-#endif
 
   ths->MEASURE_TIME_t[1] = K(0.0);
   ths->MEASURE_TIME_t[3] = K(0.0);
 
-#ifdef MEASURE_TIME
   t0 = getticks();
-#endif
 
   if (ths->eps_I > 0.0)
   {
@@ -1105,14 +1104,11 @@ void fastsum_precompute_source_nodes(fastsum_plan *ths)
       BuildTree(ths->d, 0, ths->x, ths->alpha, ths->permutation_x_alpha, ths->N_total);
   } /* eps_I > 0 */
 
-#ifdef MEASURE_TIME
   t1 = getticks();
   ths->MEASURE_TIME_t[3] += nfft_elapsed_seconds(t1,t0);
-#endif
+  fastsum_stats_add(ths, NFFT_STATS_SORT, ths->MEASURE_TIME_t[3]);
 
-#ifdef MEASURE_TIME
   t0 = getticks();
-#endif
   /** init NFFT plan for transposed transform in first step*/
 //  for (k = 0; k < ths->mv1.M_total; k++)
 //    for (t = 0; t < ths->mv1.d; t++)
@@ -1127,10 +1123,8 @@ void fastsum_precompute_source_nodes(fastsum_plan *ths)
 
   if (ths->mv1.flags & PRE_FULL_PSI)
     NFFT(precompute_full_psi)(&(ths->mv1));
-#ifdef MEASURE_TIME
   t1 = getticks();
   ths->MEASURE_TIME_t[1] += nfft_elapsed_seconds(t1,t0);
-#endif
 
 //  /** init Fourier coefficients */
 //  for (k = 0; k < ths->mv1.M_total; k++)
@@ -1140,15 +1134,11 @@ void fastsum_precompute_source_nodes(fastsum_plan *ths)
 /** precomputation for fastsum */
 void fastsum_precompute_target_nodes(fastsum_plan *ths)
 {
-#ifdef MEASURE_TIME
   ticks t0, t1;
-#endif
 
   ths->MEASURE_TIME_t[2] = K(0.0);
 
-#ifdef MEASURE_TIME
   t0 = getticks();
-#endif
   /** init NFFT plan for transform in third step*/
 //  for (j = 0; j < ths->mv2.M_total; j++)
 //    for (t = 0; t < ths->mv2.d; t++)
@@ -1163,10 +1153,8 @@ void fastsum_precompute_target_nodes(fastsum_plan *ths)
 
   if (ths->mv2.flags & PRE_FULL_PSI)
     NFFT(precompute_full_psi)(&(ths->mv2));
-#ifdef MEASURE_TIME
   t1 = getticks();
   ths->MEASURE_TIME_t[2] += NFFT(elapsed_seconds)(t1,t0);
-#endif
 }
 
 /** precomputation for fastsum */
@@ -1180,52 +1168,40 @@ void fastsum_precompute(fastsum_plan *ths)
 void fastsum_trafo(fastsum_plan *ths)
 {
   int j, k, t;
-#ifdef MEASURE_TIME
   ticks t0, t1;
-#endif
 
   ths->MEASURE_TIME_t[4] = K(0.0);
   ths->MEASURE_TIME_t[5] = K(0.0);
   ths->MEASURE_TIME_t[6] = K(0.0);
   ths->MEASURE_TIME_t[7] = K(0.0);
 
-#ifdef MEASURE_TIME
+  ths->stats.trafo_calls++;
+  ths->stats.nodes += (unsigned long long)(ths->M_total);
+
   t0 = getticks();
-#endif
   /** first step of algorithm */
   NFFT(adjoint)(&(ths->mv1));
-#ifdef MEASURE_TIME
   t1 = getticks();
   ths->MEASURE_TIME_t[4] += NFFT(elapsed_seconds)(t1,t0);
-#endif
 
-#ifdef MEASURE_TIME
   t0 = getticks();
-#endif
   /** second step of algorithm */
 #ifdef _OPENMP
   #pragma omp parallel for default(shared) private(k)
 #endif
   for (k = 0; k < ths->mv2.N_total; k++)
     ths->mv2.f_hat[k] = ths->b[k] * ths->mv1.f_hat[k];
-#ifdef MEASURE_TIME
   t1 = getticks();
   ths->MEASURE_TIME_t[5] += nfft_elapsed_seconds(t1,t0);
-#endif
+  fastsum_stats_add(ths, NFFT_STATS_OTHER, ths->MEASURE_TIME_t[5]);
 
-#ifdef MEASURE_TIME
   t0 = getticks();
-#endif
   /** third step of algorithm */
   NFFT(trafo)(&(ths->mv2));
-#ifdef MEASURE_TIME
   t1 = getticks();
   ths->MEASURE_TIME_t[6] += nfft_elapsed_seconds(t1,t0);
-#endif
 
-#ifdef MEASURE_TIME
   t0 = getticks();
-#endif
 
   /** write far field to output */
 #ifdef _OPENMP
@@ -1260,10 +1236,26 @@ void fastsum_trafo(fastsum_plan *ths)
     }
   }
 
-#ifdef MEASURE_TIME
   t1 = getticks();
   ths->MEASURE_TIME_t[7] += NFFT(elapsed_seconds)(t1,t0);
-#endif
+  fastsum_stats_add(ths, NFFT_STATS_OTHER, ths->MEASURE_TIME_t[7]);
+}
+
+/** statistics of the fastsum plan including its two NFFT plans */
+void fastsum_get_stats(const fastsum_plan *ths, X(stats) *stats)
+{
+  *stats = ths->stats;
+  STATS_MERGE(*stats, ths->mv1.stats);
+  STATS_MERGE(*stats, ths->mv2.stats);
+}
+
+/** reset the statistics of the fastsum plan and its two NFFT plans */
+void fastsum_reset_stats(fastsum_plan *ths)
+{
+  memset(&ths->stats, 0, sizeof(ths->stats));
+  ths->stats.nthreads = NFFT(get_num_threads)();
+  NFFT(reset_stats)(&(ths->mv1));
+  NFFT(reset_stats)(&(ths->mv2));
 }
 /* \} */
 
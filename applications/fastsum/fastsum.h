@@ -131,7 +131,9 @@ typedef struct fastsum_plan_
   
   int *permutation_x_alpha;    /**< permutation vector of source nodes if STORE_PERMUTATION_X_ALPHA is set */
 
-  R MEASURE_TIME_t[8]; /**< Measured time for each step if MEASURE_TIME is set */
+  R MEASURE_TIME_t[8]; /**< Measured time for each step of the last run */
+
+  X(stats) stats; /**< Statistics of the plan without those of mv1 and mv2, see fastsum_get_stats */
 
 } fastsum_plan;
 
@@ -242,6 +244,20 @@ void fastsum_precompute(fastsum_plan *ths);
  * \param ths The pointer to a fastsum plan.
  */
 void fastsum_trafo(fastsum_plan *ths);
+
+/** statistics of all runs since the initialisation or the last reset,
+ *  including those of the NFFT plans mv1 and mv2
+ *
+ * \param ths The pointer to a fully initialised fastsum plan.
+ * \param stats The statistics.
+ */
+void fastsum_get_stats(const fastsum_plan *ths, X(stats) *stats);
+
+/** reset the statistics of the plan and its NFFT plans
+ *
+ * \param ths The pointer to a fully initialised fastsum plan.
+ */
+void fastsum_reset_stats(fastsum_plan *ths);
 /* \} */
 
 C regkern(kernel k, R xx, int p, const R *param, R a, R b);
@@ -40,6 +40,7 @@ int bench_openmp(FILE *infile, int n, int m, int p,
   R r_max = K(0.25) - my_fastsum_plan.eps_B / K(2.0);
   ticks t0, t1;
   R tt_total;
+  NFFT(stats) stats_mv1, stats_mv2;
 
   fscanf(infile, "%d %d %d", &d, &L, &M);
 
@@ -93,24 +94,8 @@ int bench_openmp(FILE *infile, int n, int m, int p,
   t1 = getticks();
   tt_total = NFFT(elapsed_seconds)(t1, t0);
 
-#ifndef MEASURE_TIME
-  my_fastsum_plan.MEASURE_TIME_t[0] = K(0.0);
-  my_fastsum_plan.MEASURE_TIME_t[1] = K(0.0);
-  my_fastsum_plan.MEASURE_TIME_t[2] = K(0.0);
-  my_fastsum_plan.MEASURE_TIME_t[3] = K(0.0);
-  my_fastsum_plan.MEASURE_TIME_t[4] = K(0.0);
-  my_fastsum_plan.MEASURE_TIME_t[5] = K(0.0);
-  my_fastsum_plan.MEASURE_TIME_t[6] = K(0.0);
-  my_fastsum_plan.MEASURE_TIME_t[7] = K(0.0);
-  my_fastsum_plan.mv1.MEASURE_TIME_t[0] = K(0.0);
-  my_fastsum_plan.mv1.MEASURE_TIME_t[2] = K(0.0);
-  my_fastsum_plan.mv2.MEASURE_TIME_t[0] = K(0.0);
-  my_fastsum_plan.mv2.MEASURE_TIME_t[2] = K(0.0);
-#endif
-#ifndef MEASURE_TIME_FFTW
-  my_fastsum_plan.mv1.MEASURE_TIME_t[1] = K(0.0);
-  my_fastsum_plan.mv2.MEASURE_TIME_t[1] = K(0.0);
-#endif
+  NFFT(get_stats)(&my_fastsum_plan.mv1, &stats_mv1);
+  NFFT(get_stats)(&my_fastsum_plan.mv2, &stats_mv2);
 
   printf(
       "%.6" __FES__ " %.6" __FES__ " %.6" __FES__ " %6" __FES__ " %.6" __FES__ " %.6" __FES__ " %.6" __FES__ " %.6" __FES__ " %.6" __FES__ " %6" __FES__ " %.6" __FES__ " %.6" __FES__ " %6" __FES__ " %.6" __FES__ " %.6" __FES__ " %6" __FES__ "\n",
@@ -126,12 +111,9 @@ int bench_openmp(FILE *infile, int n, int m, int p,
           - my_fastsum_plan.MEASURE_TIME_t[5]
           - my_fastsum_plan.MEASURE_TIME_t[6]
           - my_fastsum_plan.MEASURE_TIME_t[7], tt_total,
-      my_fastsum_plan.mv1.MEASURE_TIME_t[0],
-      my_fastsum_plan.mv1.MEASURE_TIME_t[1],
-      my_fastsum_plan.mv1.MEASURE_TIME_t[2],
-      my_fastsum_plan.mv2.MEASURE_TIME_t[0],
-      my_fastsum_plan.mv2.MEASURE_TIME_t[1],
-      my_fastsum_plan.mv2.MEASURE_TIME_t[2]);
+      (R)(stats_mv1.time[NFFT_STATS_D]), (R)(stats_mv1.time[NFFT_STATS_FFT]),
+      (R)(stats_mv1.time[NFFT_STATS_B]), (R)(stats_mv2.time[NFFT_STATS_D]),
+      (R)(stats_mv2.time[NFFT_STATS_FFT]), (R)(stats_mv2.time[NFFT_STATS_B]));
 
   fastsum_finalize(&my_fastsum_plan);
 
@@ -43,18 +43,6 @@
   unsigned test_fg=0;
 #endif
 
-#ifdef MEASURE_TIME_FFTW
-  unsigned test_fftw=1;
-#else
-  unsigned test_fftw=0;
-#endif
-
-#ifdef MEASURE_TIME
-  unsigned test=1;
-#else
-  unsigned test=0;
-#endif
-
 static void flags_cp(NFFT(plan) *dst, NFFT(plan) *src)
 {
   dst->x = src->x;
@@ -66,11 +54,21 @@ static void flags_cp(NFFT(plan) *dst, NFFT(plan) *src)
   dst->my_fftw_plan2 = src->my_fftw_plan2;
 }
 
+/** time of the last transform of the plan in the phase, e.g. NFFT_STATS_B */
+static R stats_time(const NFFT(plan) *p, const int phase)
+{
+  NFFT(stats) stats;
+
+  NFFT(get_stats)(p, &stats);
+
+  return (R)(stats.time[phase]);
+}
+
 static void time_accuracy(int d, int N, int M, int n, int m, unsigned test_ndft,
     unsigned test_pre_full_psi)
 {
   int r, NN[d], nn[d];
-  R t_ndft, t, e;
+  R t_ndft, t, e, t_fg_psi, t_pre_fg_psi, t_pre_full_psi;
   C *swapndft = NULL;
   ticks t0, t1;
 
@@ -165,22 +163,28 @@ static void time_accuracy(int d, int N, int M, int n, int m, unsigned test_ndft,
   NFFT(trafo)(&p);
   NFFT(trafo)(&p_pre_phi_hut);
   if (test_fg)
+  {
     NFFT(trafo)(&p_fg_psi);
+    t_fg_psi = stats_time(&p_fg_psi, NFFT_STATS_B);
+  }
   else
-    p_fg_psi.MEASURE_TIME_t[2] = MKNAN("");
+    t_fg_psi = MKNAN("");
   NFFT(trafo)(&p_pre_lin_psi);
   if (test_fg)
+  {
     NFFT(trafo)(&p_pre_fg_psi);
+    t_pre_fg_psi = stats_time(&p_pre_fg_psi, NFFT_STATS_B);
+  }
   else
-    p_pre_fg_psi.MEASURE_TIME_t[2] = MKNAN("");
+    t_pre_fg_psi = MKNAN("");
   NFFT(trafo)(&p_pre_psi);
   if (test_pre_full_psi)
+  {
     NFFT(trafo)(&p_pre_full_psi);
+    t_pre_full_psi = stats_time(&p_pre_full_psi, NFFT_STATS_B);
+  }
   else
-    p_pre_full_psi.MEASURE_TIME_t[2] = MKNAN("");
-
-  if (test_fftw == 0)
-    p.MEASURE_TIME_t[1] = MKNAN("");
+    t_pre_full_psi = MKNAN("");
 
   if (test_ndft)
     e = NFFT(error_l_2_complex)(swapndft, p.f, p.M_total);
@@ -189,10 +193,11 @@ static void time_accuracy(int d, int N, int M, int n, int m, unsigned test_ndft,
 
   printf(
       "%.2" __FES__ "\t%d\t%.2" __FES__ "\t%.2" __FES__ "\t%.2" __FES__ "\t%.2" __FES__ "\t%.2" __FES__ "\t%.2" __FES__ "\t%.2" __FES__ "\t%.2" __FES__ "\t%.2" __FES__ "\t%.2" __FES__ "\n",
-      t_ndft, m, e, p.MEASURE_TIME_t[0], p_pre_phi_hut.MEASURE_TIME_t[0],
-      p.MEASURE_TIME_t[1], p.MEASURE_TIME_t[2], p_fg_psi.MEASURE_TIME_t[2],
-      p_pre_lin_psi.MEASURE_TIME_t[2], p_pre_fg_psi.MEASURE_TIME_t[2],
-      p_pre_psi.MEASURE_TIME_t[2], p_pre_full_psi.MEASURE_TIME_t[2]);
+      t_ndft, m, e, stats_time(&p, NFFT_STATS_D),
+      stats_time(&p_pre_phi_hut, NFFT_STATS_D), stats_time(&p, NFFT_STATS_FFT),
+      stats_time(&p, NFFT_STATS_B), t_fg_psi,
+      stats_time(&p_pre_lin_psi, NFFT_STATS_B), t_pre_fg_psi,
+      stats_time(&p_pre_psi, NFFT_STATS_B), t_pre_full_psi);
 
   fflush(stdout);
 
@@ -278,12 +283,6 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
-  if ((test == 0) && (atoi(argv[1]) < 2))
-  {
-    fprintf(stderr, "MEASURE_TIME in infft.h not set\n");
-    return EXIT_FAILURE;
-  }
-
   fprintf(stderr, "Testing different precomputation schemes for the nfft.\n");
   fprintf(stderr, "Columns: d, N=M, t_ndft, e_nfft, t_D, t_pre_phi_hut, ");
   fprintf(stderr, "t_fftw, t_B, t_fg_psi, t_pre_lin_psi, t_pre_fg_psi, ");
@@ -38,6 +38,7 @@ void bench_openmp(FILE *infile, int m, int psi_flag)
   double re,im;
   ticks t0, t1;
   double tt_total, tt_preonepsi;
+  NFFT(stats) stats;
 
   fscanf(infile, "%d %d", &d, &trafo_adjoint);
 
@@ -106,16 +107,9 @@ void bench_openmp(FILE *infile, int m, int psi_flag)
   t1 = getticks();
   tt_total = NFFT(elapsed_seconds)(t1,t0);
 
-#ifndef MEASURE_TIME
-  p.MEASURE_TIME_t[0] = 0.0;
-  p.MEASURE_TIME_t[2] = 0.0;
-#endif
-
-#ifndef MEASURE_TIME_FFTW
-  p.MEASURE_TIME_t[1] = 0.0;
-#endif
+  NFFT(get_stats)(&p, &stats);
 
-  printf("%.6e %.6e %6e %.6e %.6e %.6e\n", tt_preonepsi, p.MEASURE_TIME_t[0], p.MEASURE_TIME_t[1], p.MEASURE_TIME_t[2], tt_total-tt_preonepsi-p.MEASURE_TIME_t[0]-p.MEASURE_TIME_t[1]-p.MEASURE_TIME_t[2], tt_total);
+  printf("%.6e %.6e %6e %.6e %.6e %.6e\n", tt_preonepsi, stats.time[NFFT_STATS_D], stats.time[NFFT_STATS_FFT], stats.time[NFFT_STATS_B], tt_total-tt_preonepsi-stats.time[NFFT_STATS_D]-stats.time[NFFT_STATS_FFT]-stats.time[NFFT_STATS_B], tt_total);
 //  printf("%.6e\n", tt);
 
   free(N);
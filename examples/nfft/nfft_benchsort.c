@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2002, 2017 Jens Keiner, Stefan Kunis, Daniel Potts
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* Compares the node orderings NFFT_SORT_NODES, NFFT_SORT_TILE_MAJOR and
+ * NFFT_SORT_MORTON against unsorted nodes for random and radial trajectories
+ * in two and three dimensions.
+ *
+ * usage: nfft_benchsort [N2 M2 N3 M3]
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+#ifdef HAVE_COMPLEX_H
+#include <complex.h>
+#endif
+
+#include "nfft3.h"
+#include "infft.h"
+
+static const unsigned orders[] =
+{
+  0U, NFFT_SORT_NODES, NFFT_SORT_TILE_MAJOR, NFFT_SORT_MORTON
+};
+
+static const char *order_names[] =
+{
+  "unsorted", "row-major", "tile-major", "morton"
+};
+
+/** Random nodes, uniformly distributed in the torus. */
+static void init_random(R *x, const int d, const int M)
+{
+  NFFT(vrand_shifted_unit_double)(x, d * M);
+}
+
+/** Radial trajectory in acquisition order: spokes of 2N samples through the
+ * origin, equally spaced in angle (d=2) or with random directions (d=3). */
+static void init_radial(R *x, const int d, const int N, const int M)
+{
+  const int S = 2 * N, P = M / S;
+  int p, s, t;
+
+  for (p = 0; p < P; p++)
+  {
+    R dir[3];
+
+    if (d == 2)
+    {
+      dir[0] = COS(KPI * (R)(p) / (R)(P));
+      dir[1] = SIN(KPI * (R)(p) / (R)(P));
+    }
+    else
+    {
+      const R z = K(2.0) * NFFT(drand48)() - K(1.0);
+      const R phi = K(2.0) * KPI * NFFT(drand48)();
+      dir[0] = SQRT(K(1.0) - z * z) * COS(phi);
+      dir[1] = SQRT(K(1.0) - z * z) * SIN(phi);
+      dir[2] = z;
+    }
+
+    for (s = 0; s < S; s++)
+      for (t = 0; t < d; t++)
+        x[(p * S + s) * d + t] = ((R)(s) / (R)(S) - K(0.5)) * dir[t];
+  }
+
+  /* remaining nodes, if M is not a multiple of 2N */
+  for (p = P * S; p < M; p++)
+    for (t = 0; t < d; t++)
+      x[p * d + t] = K(0.0);
+}
+
+/** Average time of op, repeated for at least 0.1 seconds. */
+static R measure(void (*op)(NFFT(plan) *), NFFT(plan) *p)
+{
+  R t = K(0.0);
+  int r = 0;
+  ticks t0, t1;
+
+  while (t < K(0.1))
+  {
+    r++;
+    t0 = getticks();
+    op(p);
+    t1 = getticks();
+    t += NFFT(elapsed_seconds)(t1, t0);
+  }
+
+  return t / (R)(r);
+}
+
+static void bench(const int d, const int N, const int M, const int radial)
+{
+  int NN[d], nn[d], t, i;
+  R *x = (R*) NFFT(malloc)((size_t)(d * M) * sizeof(R));
+
+  for (t = 0; t < d; t++)
+  {
+    NN[t] = N;
+    nn[t] = 2 * N;
+  }
+
+  if (radial)
+    init_radial(x, d, N, M);
+  else
+    init_random(x, d, M);
+
+  for (i = 0; i < (int)(sizeof(orders) / sizeof(orders[0])); i++)
+  {
+    NFFT(plan) p;
+    R t_pre, t_trafo, t_adjoint;
+    ticks t0, t1;
+
+    NFFT(init_guru)(&p, d, NN, M, nn, WINDOW_HELP_ESTIMATE_m,
+      PRE_PHI_HUT | PRE_PSI | MALLOC_F_HAT | MALLOC_X | MALLOC_F | FFTW_INIT
+      | FFT_OUT_OF_PLACE | orders[i], FFTW_ESTIMATE | FFTW_DESTROY_INPUT);
+
+    memcpy(p.x, x, (size_t)(d * M) * sizeof(R));
+
+    t0 = getticks();
+    NFFT(precompute_one_psi)(&p);
+    t1 = getticks();
+    t_pre = NFFT(elapsed_seconds)(t1, t0);
+
+    NFFT(vrand_unit_complex)(p.f_hat, p.N_total);
+    t_trafo = measure(NFFT(trafo), &p);
+
+    NFFT(vrand_unit_complex)(p.f, p.M_total);
+    t_adjoint = measure(NFFT(adjoint), &p);
+
+    printf("%d\t%-6s\t%-10s\t%.2" __FES__ "\t%.2" __FES__ "\t%.2" __FES__ "\n",
+      d, radial ? "radial" : "random", order_names[i], t_pre, t_trafo,
+      t_adjoint);
+    fflush(stdout);
+
+    NFFT(finalize)(&p);
+  }
+
+  NFFT(free)(x);
+}
+
+int main(int argc, char **argv)
+{
+  int N2 = 256, M2 = 4 * 256 * 256, N3 = 64, M3 = 4 * 64 * 64 * 64;
+
+  if (argc == 5)
+  {
+    N2 = atoi(argv[1]);
+    M2 = atoi(argv[2]);
+    N3 = atoi(argv[3]);
+    M3 = atoi(argv[4]);
+  }
+  else if (argc != 1)
+  {
+    fprintf(stderr, "usage: %s [N2 M2 N3 M3]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  printf("d\tnodes \torder     \tprecompute\ttrafo\tadjoint\n");
+
+  bench(2, N2, M2, 0);
+  bench(2, N2, M2, 1);
+  bench(3, N3, M3, 0);
+  bench(3, N3, M3, 1);
+
+  return EXIT_SUCCESS;
+}
@@ -477,26 +477,18 @@ void test1(int *nthreads_array, int n_threads_array_size, int m)
   s_testset testsets[4];
 
   run_testset(&testsets[0], 0, 1024, 1000000, m, 0, NFFT_SORT_NODES, nthreads_array, n_threads_array_size);
-#if defined MEASURE_TIME && defined MEASURE_TIME_FFTW
   print_output_histo_PENRT(file_out_tex, testsets[0]);
-#endif
 
   run_testset(&testsets[1], 1, 1024, 1000000, m, 0, NFFT_SORT_NODES | NFFT_OMP_BLOCKWISE_ADJOINT, nthreads_array, n_threads_array_size);
-#if defined MEASURE_TIME && defined MEASURE_TIME_FFTW
   print_output_histo_PENRT(file_out_tex, testsets[1]);
-#endif
 
   print_output_speedup_total(file_out_tex, testsets, 2, 0);
 
   run_testset(&testsets[2], 0, 1024, 1000000, m, NFSFT_USE_DPT, NFFT_SORT_NODES, nthreads_array, n_threads_array_size);
-#if defined MEASURE_TIME && defined MEASURE_TIME_FFTW
   print_output_histo_PENRT(file_out_tex, testsets[2]);
-#endif
 
   run_testset(&testsets[3], 1, 1024, 1000000, m, NFSFT_USE_DPT, NFFT_SORT_NODES | NFFT_OMP_BLOCKWISE_ADJOINT, nthreads_array, n_threads_array_size);
-#if defined MEASURE_TIME && defined MEASURE_TIME_FFTW
   print_output_histo_PENRT(file_out_tex, testsets[3]);
-#endif
 
   print_output_speedup_total(file_out_tex, testsets+2, 2, 0);
 }
@@ -507,13 +499,6 @@ int main(int argc, char** argv)
   int n_threads_array_size = get_nthreads_array(&nthreads_array);
   int k;
 
-#if !(defined MEASURE_TIME && defined MEASURE_TIME_FFTW)
-  fprintf(stderr, "WARNING: Detailed time measurements for NFSFT are not activated.\n");
-  fprintf(stderr, "For more detailed plots, please re-run the configure script with options\n");
-  fprintf(stderr, "--enable-measure-time --enable-measure-time-fftw --enable-nfsft --enable-openmp\n");
-  fprintf(stderr, "and run \"make clean all\"\n\n");
-#endif
-
   for (k = 0; k < n_threads_array_size; k++)
     fprintf(stderr, "%d ", nthreads_array[k]);
   fprintf(stderr, "\n");
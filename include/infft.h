@@ -145,93 +145,137 @@ typedef ptrdiff_t INT;
 
 /* macros for window functions */
 
+/* Each window function is available under its own name so that the nfft
+ * module can select it per plan at runtime, see NFFT_WINDOW_*. The macros
+ * PHI_HUT, PHI, WINDOW_HELP_INIT, WINDOW_HELP_FINALIZE and
+ * WINDOW_HELP_ESTIMATE_m refer to the window selected at compile time. */
+#define PHI_HUT_DIRAC_DELTA(n,k,d) K(1.0)
+#define PHI_DIRAC_DELTA(n,x,d) IF(FABS((x)) < K(10E-8),K(1.0),K(0.0))
+#define WINDOW_HELP_ESTIMATE_m_DIRAC_DELTA 0
+
+#define PHI_HUT_GAUSSIAN(n,k,d) ((R)EXP(-(POW(KPI*(k)/n,K(2.0))*ths->b[d])))
+#define PHI_GAUSSIAN(n,x,d) ((R)EXP(-POW((x)*((R)n),K(2.0)) / \
+  ths->b[d])/SQRT(KPI*ths->b[d]))
+#define WINDOW_HELP_B_GAUSSIAN(sigma,m) ((K(2.0)*(sigma)) / \
+  (K(2.0)*(sigma) - K(1.0)) * (((R)(m)) / KPI))
+#if defined(NFFT_LDOUBLE)
+  #define WINDOW_HELP_ESTIMATE_m_GAUSSIAN 17
+#elif defined(NFFT_SINGLE)
+  #define WINDOW_HELP_ESTIMATE_m_GAUSSIAN 5
+#else
+  #define WINDOW_HELP_ESTIMATE_m_GAUSSIAN 13
+#endif
+
+#define PHI_HUT_B_SPLINE(n,k,d) ((R)(((k) == 0) ? K(1.0) / n : \
+  POW(SIN((k) * KPI / n) / ((k) * KPI / n), \
+    K(2.0) * ths->m)/n))
+#define PHI_B_SPLINE(n,x,d) (Y(bsplines)(2*ths->m,((x)*n) + \
+  (R)ths->m) / n)
+#define WINDOW_HELP_ESTIMATE_m_B_SPLINE 11
+
+#define PHI_HUT_SINC_POWER(n,k,d) (Y(bsplines)(2 * ths->m, (K(2.0) * ths->m*(k)) / \
+  ((K(2.0) * ths->sigma[(d)] - 1) * n / \
+    ths->sigma[(d)]) + (R)ths->m))
+#define PHI_SINC_POWER(n,x,d) ((R)(n / ths->sigma[(d)] * \
+  (K(2.0) * ths->sigma[(d)] - K(1.0))/ (K(2.0)*ths->m) * \
+  POW(Y(sinc)(KPI * n / ths->sigma[(d)] * (x) * \
+  (K(2.0) * ths->sigma[(d)] - K(1.0)) / (K(2.0)*ths->m)) , 2*ths->m) / \
+  n))
+#if defined(NFFT_LDOUBLE)
+  #define WINDOW_HELP_ESTIMATE_m_SINC_POWER 13
+#else
+  #define WINDOW_HELP_ESTIMATE_m_SINC_POWER 11
+#endif
+
+#define PHI_HUT_KAISER_BESSEL(n,k,d) (Y(bessel_i0)((R)(ths->m) * SQRT(ths->b[d] * ths->b[d] - (K(2.0) * KPI * (R)(k) / (R)(n)) * (K(2.0) * KPI * (R)(k) / (R)(n)))))
+#define PHI_KAISER_BESSEL(n,x,d) (  (((R)(ths->m) * (R)(ths->m) - (x) * (R)(n) * (x) * (R)(n)) > K(0.0)) \
+                    ?   SINH(ths->b[d] * SQRT((R)(ths->m) * (R)(ths->m) - (x) * (R)(n) * (x) * (R)(n))) \
+                      / (KPI * SQRT((R)(ths->m) * (R)(ths->m) - (x) * (R)(n) * (x) * (R)(n))) \
+                    :   ((((R)(ths->m) * (R)(ths->m) - (x) * (R)(n) * (x) * (R)(n)) < K(0.0)) \
+                      ?   SIN(ths->b[d] * SQRT((x) * (R)(n) * (x) * (R)(n) - (R)(ths->m) * (R)(ths->m))) \
+                        / (KPI * SQRT((x) * (R)(n) * (x) * (R)(n) - (R)(ths->m) * (R)(ths->m))) \
+                      : ths->b[d] / KPI))
+#define WINDOW_HELP_B_KAISER_BESSEL(sigma,m) (KPI * (K(2.0) - K(1.0) / (sigma)))
+#if defined(NFFT_LDOUBLE)
+  #define WINDOW_HELP_ESTIMATE_m_KAISER_BESSEL 9
+#elif defined(NFFT_SINGLE)
+  #define WINDOW_HELP_ESTIMATE_m_KAISER_BESSEL 4
+#else
+  #define WINDOW_HELP_ESTIMATE_m_KAISER_BESSEL 8
+#endif
+
+/* The exponential of semicircle window is only available per plan in the nfft
+ * module. Its Fourier transform has no closed form and is computed
+ * numerically, its values are evaluated from piecewise polynomials. */
+#define PHI_EXP_SEMICIRCLE(n,x,d) ((FABS((x)*(R)(n)) < (R)(ths->m)) \
+  ? EXP(ths->b[d] * (SQRT(K(1.0) - ((x)*(R)(n)/(R)(ths->m)) \
+    * ((x)*(R)(n)/(R)(ths->m))) - K(1.0))) : K(0.0))
+#define WINDOW_HELP_B_EXP_SEMICIRCLE(sigma,m) (K(0.97) * KPI * \
+  (K(1.0) - K(1.0) / (K(2.0) * (sigma))) * K(2.0) * ((R)(m)))
+#if defined(NFFT_LDOUBLE)
+  #define WINDOW_HELP_ESTIMATE_m_EXP_SEMICIRCLE 9
+#elif defined(NFFT_SINGLE)
+  #define WINDOW_HELP_ESTIMATE_m_EXP_SEMICIRCLE 4
+#else
+  #define WINDOW_HELP_ESTIMATE_m_EXP_SEMICIRCLE 8
+#endif
+
 #if defined(DIRAC_DELTA)
-  #define PHI_HUT(n,k,d) K(1.0)
-  #define PHI(n,x,d) IF(FABS((x)) < K(10E-8),K(1.0),K(0.0))
-  #define WINDOW_HELP_INIT(d)
+  #define WINDOW_DEFAULT NFFT_WINDOW_DIRAC_DELTA
+  #define PHI_HUT(n,k,d) PHI_HUT_DIRAC_DELTA(n,k,d)
+  #define PHI(n,x,d) PHI_DIRAC_DELTA(n,x,d)
+  #define WINDOW_HELP_INIT
   #define WINDOW_HELP_FINALIZE
-  #define WINDOW_HELP_ESTIMATE_m 0
+  #define WINDOW_HELP_ESTIMATE_m WINDOW_HELP_ESTIMATE_m_DIRAC_DELTA
 #elif defined(GAUSSIAN)
-  #define PHI_HUT(n,k,d) ((R)EXP(-(POW(KPI*(k)/n,K(2.0))*ths->b[d])))
-  #define PHI(n,x,d) ((R)EXP(-POW((x)*((R)n),K(2.0)) / \
-    ths->b[d])/SQRT(KPI*ths->b[d]))
+  #define WINDOW_DEFAULT NFFT_WINDOW_GAUSSIAN
+  #define PHI_HUT(n,k,d) PHI_HUT_GAUSSIAN(n,k,d)
+  #define PHI(n,x,d) PHI_GAUSSIAN(n,x,d)
   #define WINDOW_HELP_INIT \
     { \
       int WINDOW_idx; \
       ths->b = (R*) Y(malloc)(ths->d*sizeof(R)); \
       for (WINDOW_idx = 0; WINDOW_idx < ths->d; WINDOW_idx++) \
-        ths->b[WINDOW_idx]=(K(2.0)*ths->sigma[WINDOW_idx]) / \
-          (K(2.0)*ths->sigma[WINDOW_idx] - K(1.0)) * (((R)ths->m) / KPI); \
+        ths->b[WINDOW_idx] = WINDOW_HELP_B_GAUSSIAN(ths->sigma[WINDOW_idx], \
+          ths->m); \
     }
   #define WINDOW_HELP_FINALIZE {Y(free)(ths->b);}
-#if defined(NFFT_LDOUBLE)
-  #define WINDOW_HELP_ESTIMATE_m 17
-#elif defined(NFFT_SINGLE)
-  #define WINDOW_HELP_ESTIMATE_m 5
-#else
-  #define WINDOW_HELP_ESTIMATE_m 13
-#endif
+  #define WINDOW_HELP_ESTIMATE_m WINDOW_HELP_ESTIMATE_m_GAUSSIAN
 #elif defined(B_SPLINE)
-  #define PHI_HUT(n,k,d) ((R)(((k) == 0) ? K(1.0) / n : \
-    POW(SIN((k) * KPI / n) / ((k) * KPI / n), \
-      K(2.0) * ths->m)/n))
-  #define PHI(n,x,d) (Y(bsplines)(2*ths->m,((x)*n) + \
-    (R)ths->m) / n)
+  #define WINDOW_DEFAULT NFFT_WINDOW_B_SPLINE
+  #define PHI_HUT(n,k,d) PHI_HUT_B_SPLINE(n,k,d)
+  #define PHI(n,x,d) PHI_B_SPLINE(n,x,d)
   #define WINDOW_HELP_INIT
   #define WINDOW_HELP_FINALIZE
-#if defined(NFFT_LDOUBLE)
-  #define WINDOW_HELP_ESTIMATE_m 11
-#elif defined(NFFT_SINGLE)
-  #define WINDOW_HELP_ESTIMATE_m 11
-#else
-  #define WINDOW_HELP_ESTIMATE_m 11
-#endif
+  #define WINDOW_HELP_ESTIMATE_m WINDOW_HELP_ESTIMATE_m_B_SPLINE
 #elif defined(SINC_POWER)
-  #define PHI_HUT(n,k,d) (Y(bsplines)(2 * ths->m, (K(2.0) * ths->m*(k)) / \
-    ((K(2.0) * ths->sigma[(d)] - 1) * n / \
-      ths->sigma[(d)]) + (R)ths->m))
-  #define PHI(n,x,d) ((R)(n / ths->sigma[(d)] * \
-    (K(2.0) * ths->sigma[(d)] - K(1.0))/ (K(2.0)*ths->m) * \
-    POW(Y(sinc)(KPI * n / ths->sigma[(d)] * (x) * \
-    (K(2.0) * ths->sigma[(d)] - K(1.0)) / (K(2.0)*ths->m)) , 2*ths->m) / \
-    n))
+  #define WINDOW_DEFAULT NFFT_WINDOW_SINC_POWER
+  #define PHI_HUT(n,k,d) PHI_HUT_SINC_POWER(n,k,d)
+  #define PHI(n,x,d) PHI_SINC_POWER(n,x,d)
   #define WINDOW_HELP_INIT
   #define WINDOW_HELP_FINALIZE
-#if defined(NFFT_LDOUBLE)
-  #define WINDOW_HELP_ESTIMATE_m 13
-#elif defined(NFFT_SINGLE)
-  #define WINDOW_HELP_ESTIMATE_m 11
-#else
-  #define WINDOW_HELP_ESTIMATE_m 11
-#endif
+  #define WINDOW_HELP_ESTIMATE_m WINDOW_HELP_ESTIMATE_m_SINC_POWER
 #else /* Kaiser-Bessel is the default. */
-  #define PHI_HUT(n,k,d) (Y(bessel_i0)((R)(ths->m) * SQRT(ths->b[d] * ths->b[d] - (K(2.0) * KPI * (R)(k) / (R)(n)) * (K(2.0) * KPI * (R)(k) / (R)(n)))))
-  #define PHI(n,x,d) (  (((R)(ths->m) * (R)(ths->m) - (x) * (R)(n) * (x) * (R)(n)) > K(0.0)) \
-                      ?   SINH(ths->b[d] * SQRT((R)(ths->m) * (R)(ths->m) - (x) * (R)(n) * (x) * (R)(n))) \
-                        / (KPI * SQRT((R)(ths->m) * (R)(ths->m) - (x) * (R)(n) * (x) * (R)(n))) \
-                      :   ((((R)(ths->m) * (R)(ths->m) - (x) * (R)(n) * (x) * (R)(n)) < K(0.0)) \
-                        ?   SIN(ths->b[d] * SQRT((x) * (R)(n) * (x) * (R)(n) - (R)(ths->m) * (R)(ths->m))) \
-                          / (KPI * SQRT((x) * (R)(n) * (x) * (R)(n) - (R)(ths->m) * (R)(ths->m))) \
-                        : ths->b[d] / KPI))
+  #define WINDOW_DEFAULT NFFT_WINDOW_KAISER_BESSEL
+  #define PHI_HUT(n,k,d) PHI_HUT_KAISER_BESSEL(n,k,d)
+  #define PHI(n,x,d) PHI_KAISER_BESSEL(n,x,d)
   #define WINDOW_HELP_INIT \
     { \
       int WINDOW_idx; \
       ths->b = (R*) Y(malloc)((size_t)(ths->d) * sizeof(R)); \
       for (WINDOW_idx = 0; WINDOW_idx < ths->d; WINDOW_idx++) \
-        ths->b[WINDOW_idx] = (KPI * (K(2.0) - K(1.0) / ths->sigma[WINDOW_idx])); \
+        ths->b[WINDOW_idx] = WINDOW_HELP_B_KAISER_BESSEL(ths->sigma[WINDOW_idx], \
+          ths->m); \
   }
   #define WINDOW_HELP_FINALIZE {Y(free)(ths->b);}
-  #if defined(NFFT_LDOUBLE)
-    #define WINDOW_HELP_ESTIMATE_m 9
-  #elif defined(NFFT_SINGLE)
-    #define WINDOW_HELP_ESTIMATE_m 4
-  #else
-    #define WINDOW_HELP_ESTIMATE_m 8
-  #endif
+  #define WINDOW_HELP_ESTIMATE_m WINDOW_HELP_ESTIMATE_m_KAISER_BESSEL
 #endif
 
 /* window.c */
-INT Y(m2K)(const INT m);
+INT Y(m2K)(const INT m, const unsigned window);
+INT Y(window_cut_off)(const unsigned window);
+R Y(window_error)(const INT m, const R sigma, const unsigned window);
+const char *Y(window_name)(const unsigned window);
 
 #if defined(NFFT_LDOUBLE)
 #if HAVE_DECL_COPYSIGNL == 0
@@ -1364,47 +1408,53 @@ R Y(elapsed_seconds)(ticks t1, ticks t0);
 /** Dummy use of unused parameters to silence compiler warnings */
 #define UNUSED(x) (void)x
 
-/** Timing, method works since the inaccurate timer is updated mostly in the
- *  measured function. For small times not every call of the measured function
- *  will also produce a 'unit' time step.
- *  Measuring the fftw might cause a wrong output vector due to the repeated
- *  ffts.
- */
-#ifdef MEASURE_TIME
- int MEASURE_TIME_r;
- double MEASURE_TIME_tt;
- ticks MEASURE_TIME_t0, MEASURE_TIME_t1;
-
-#define TIC(a)                                                                \
-  ths->MEASURE_TIME_t[(a)]=0;                                                 \
-  MEASURE_TIME_r=0;                                                           \
-  /* DISABLED LOOP due to code blocks causing segfault when repeatedly run */ \
-  /*while(ths->MEASURE_TIME_t[(a)]<0.01)*/                                    \
+/** Adds the time, runs, nodes and bytes of the statistics t to s, as for a
+ *  plan that uses the plan of t internally. */
+#define STATS_MERGE(s, t)                                                     \
+  do                                                                          \
+  {                                                                           \
+    int STATS_i;                                                              \
+    for (STATS_i = 0; STATS_i < NFFT_STATS_PHASES; STATS_i++)                 \
     {                                                                         \
-      MEASURE_TIME_r++;                                                       \
-      MEASURE_TIME_t0 = getticks();                                           \
+      (s).time[STATS_i] += (t).time[STATS_i];                                 \
+      (s).calls[STATS_i] += (t).calls[STATS_i];                               \
+    }                                                                         \
+    (s).nodes += (t).nodes;                                                   \
+    (s).bytes += (t).bytes;                                                   \
+    if ((t).nthreads > (s).nthreads)                                          \
+      (s).nthreads = (t).nthreads;                                            \
+  } while (0)
+
+/** Runtime statistics, STATS_TIC(a) and STATS_TOC(a) enclose a run of the
+ *  phase a, e.g. NFFT_STATS_SORT, and add its time to ths->stats. TIC(a) and
+ *  TOC(a) do the same for the steps D, FFT and B, a = 0, 1 and 2, and store
+ *  the time of the run in ths->MEASURE_TIME_t[a] in addition.
+ */
+#define STATS_TIC(a)                                                          \
+  {                                                                           \
+    ticks STATS_t0, STATS_t1;                                                 \
+    double STATS_s;                                                           \
+    STATS_t0 = getticks();
 
-/* THE MEASURED FUNCTION IS CALLED REPEATEDLY */
+#define STATS_STOP(a)                                                         \
+    STATS_t1 = getticks();                                                    \
+    STATS_s = Y(elapsed_seconds)(STATS_t1, STATS_t0);                         \
+    ths->stats.time[(a)] += STATS_s;                                          \
+    ths->stats.calls[(a)]++;
 
-#define TOC(a)                                                                \
-      MEASURE_TIME_t1 = getticks();                                           \
-      MEASURE_TIME_tt = Y(elapsed_seconds)(MEASURE_TIME_t1,MEASURE_TIME_t0);\
-      ths->MEASURE_TIME_t[(a)]+=MEASURE_TIME_tt;                              \
-    }                                                                         \
-  ths->MEASURE_TIME_t[(a)]/=MEASURE_TIME_r;                                   \
+#define STATS_TOC(a)                                                          \
+    STATS_STOP(a)                                                             \
+  }
 
-#else
-#define TIC(a)
-#define TOC(a)
-#endif
+#define TIC(a) STATS_TIC(a)
+
+#define TOC(a)                                                                \
+    STATS_STOP(a)                                                             \
+    ths->MEASURE_TIME_t[(a)] = STATS_s;                                       \
+  }
 
-#ifdef MEASURE_TIME_FFTW
 #define TIC_FFTW(a) TIC(a)
 #define TOC_FFTW(a) TOC(a)
-#else
-#define TIC_FFTW(a)
-#define TOC_FFTW(a)
-#endif
 
 /* sinc.c: */
 
@@ -1447,7 +1497,22 @@ R Y(error_l_2_complex)(const C *x, const C *y, const INT n);
 
 /* sort.c: */
 void Y(sort_node_indices_radix_msdf)(INT n, INT *keys0, INT *keys1, INT rhigh);
-void Y(sort_node_indices_radix_lsdf)(INT n, INT *keys0, INT *keys1, INT rhigh);
+void Y(sort_node_indices_radix_lsdf)(INT n, INT *keys0, INT *keys1, INT rhigh,
+  INT nthreads);
+
+/* wisdom.c: */
+void Y(wisdom_before_plan)(void);
+void Y(wisdom_after_plan)(const unsigned fftw_flags);
+
+/* nfft.c: */
+/** Vector units of the kernels for d=2 and d=3. */
+#define SIMD_NONE 0
+#define SIMD_AVX2 1
+#define SIMD_AVX512 2
+/** Selects the vector unit of all plans, at most the widest one of the
+ *  processor, or that one for isa < 0. Returns the unit in use. Not to be
+ *  called while transforms run. */
+int Y(simd_select)(const int isa);
 
 /* assert.c */
 void Y(assertion_failed)(const char *s, int line, const char *file);
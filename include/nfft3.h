@@ -86,6 +86,15 @@ NFFT_DEFINE_MALLOC_API(NFFT_MANGLE_FLOAT)
 NFFT_DEFINE_MALLOC_API(NFFT_MANGLE_DOUBLE)
 NFFT_DEFINE_MALLOC_API(NFFT_MANGLE_LONG_DOUBLE)
 
+/* Phases of a transform in the runtime statistics, see nfft_get_stats. */
+#define NFFT_STATS_D               0
+#define NFFT_STATS_FFT             1
+#define NFFT_STATS_B               2
+#define NFFT_STATS_SORT            3
+#define NFFT_STATS_PRECOMPUTE      4
+#define NFFT_STATS_OTHER           5
+#define NFFT_STATS_PHASES          6
+
 /* Macro to define prototypes for all NFFT API functions.
  * We expand this macro for each supported precision.
  *   X: NFFT name-mangling macro
@@ -105,6 +114,38 @@ typedef struct \
   MACRO_MV_PLAN(R) \
 } X(mv_plan_double); \
 \
+/** memory of an NFFT plan in bytes, see \ref nfft_estimate_memory */ \
+typedef struct\
+{\
+  size_t x; /**< Nodes, for flag \ref MALLOC_X. */\
+  size_t f_hat; /**< Fourier coefficients, for flag \ref MALLOC_F_HAT. */\
+  size_t f; /**< Samples, for flag \ref MALLOC_F. */\
+  size_t c_phi_inv; /**< Diagonal matrix \f$D\f$, always precomputed. */\
+  size_t psi; /**< Window values of the sparse matrix \f$B\f$. */\
+  size_t psi_index; /**< Indices of \ref PRE_FULL_PSI. */\
+  size_t g; /**< Oversampled grids g1 and g2, for flag \ref FFTW_INIT. */\
+  size_t index_x; /**< Sorted nodes, for flag \ref NFFT_SORT_NODES. */\
+  size_t other; /**< Bandwidths, oversampling factors, window parameters and
+                     the arrays of FFTW plans of \ref NFFT_PRUNED_FFT. */\
+  size_t total; /**< Sum of the above, the size of an arena for
+                     \ref nfft_init_guru_arena, without the memory FFTW
+                     allocates for its plans. */\
+} X(plan_memory); \
+\
+/** runtime statistics of a plan, see \ref nfft_get_stats */ \
+typedef struct\
+{\
+  double time[NFFT_STATS_PHASES]; /**< Cumulative time in seconds of each
+                                       phase, \ref NFFT_STATS_D, ... */\
+  unsigned long long calls[NFFT_STATS_PHASES]; /**< Number of runs of each
+                                                    phase. */\
+  unsigned long long trafo_calls; /**< Number of transforms. */\
+  unsigned long long adjoint_calls; /**< Number of adjoint transforms. */\
+  unsigned long long nodes; /**< Number of nodes processed. */\
+  double bytes; /**< Estimated bytes read and written by the transforms. */\
+  NFFT_INT nthreads; /**< Number of threads of the last transform. */\
+} X(stats); \
+\
 /** data structure for an NFFT (nonequispaced fast Fourier transform) plan with R precision */ \
 typedef struct\
 {\
@@ -121,8 +162,17 @@ typedef struct\
               -  6 (KAISER_BESSEL),
               -  9 (SINC_POWER),
               - 11 (B_SPLINE),
-              - 12 (GAUSSIAN) */\
+              - 12 (GAUSSIAN),
+              -  8 (EXP_SEMICIRCLE) */\
   R *b; /**< Shape parameter for window function */\
+  unsigned window; /**< Window function of this plan, one of the
+                        NFFT_WINDOW_* flags. Selected by passing one of these
+                        to \ref nfft_init_guru, default is the window chosen
+                        at compile time. */\
+  R *window_coeffs; /**< Coefficients of the piecewise polynomials that
+                         approximate the window for
+                         \ref NFFT_WINDOW_EXP_SEMICIRCLE, size is
+                         \f$d(2m+2)(p+1)\f$ for degree \f$p\f$. */\
   NFFT_INT K; /**< Number of equispaced samples of window function. Used for flag
              PRE_LIN_PSI. */\
 \
@@ -136,18 +186,29 @@ typedef struct\
 \
   R *x; /**< Nodes in time/spatial domain, size is \f$dM\f$ R ## s */\
 \
-  R MEASURE_TIME_t[3]; /**< Measured time for each step if MEASURE_TIME is
-    set */\
+  R MEASURE_TIME_t[3]; /**< Time of the last run of the steps D, FFT and B,
+    see also stats */\
+  X(stats) stats; /**< Runtime statistics, see \ref nfft_get_stats. */\
 \
   /* internal use only */\
-  Y(plan) my_fftw_plan1; /**< Forward FFTW plan */\
-  Y(plan) my_fftw_plan2; /**< Backward FFTW plan */\
+  Y(plan) my_fftw_plan1; /**< Forward FFTW plan, NULL for
+                              \ref NFFT_PRUNED_FFT */\
+  Y(plan) my_fftw_plan2; /**< Backward FFTW plan, NULL for
+                              \ref NFFT_PRUNED_FFT */\
+  Y(plan) *my_fftw_plan1_pruned; /**< Forward FFTW plans of the single
+                                      dimensions for \ref NFFT_PRUNED_FFT */\
+  Y(plan) *my_fftw_plan2_pruned; /**< Backward FFTW plans of the single
+                                      dimensions for \ref NFFT_PRUNED_FFT */\
 \
   R **c_phi_inv; /**< Precomputed data for the diagonal matrix \f$D\f$, size \
     is \f$N_0+\dots+N_{d-1}\f$ doubles*/\
   R *psi; /**< Precomputed data for the sparse matrix \f$B\f$, size depends
                     on precomputation scheme */\
-  NFFT_INT *psi_index_g; /**< Indices in source/target vector for \ref PRE_FULL_PSI */\
+  float *psi_single; /**< Precomputed data for the sparse matrix \f$B\f$ in
+                          single precision for \ref NFFT_MIXED_PRECISION */\
+  NFFT_INT *psi_index_g; /**< Indices in source/target vector for \ref PRE_FULL_PSI,
+                             the d first grid indices of each node for
+                             \ref NFFT_COMPACT_FULL_PSI */\
   NFFT_INT *psi_index_f; /**< Indices in source/target vector for \ref PRE_FULL_PSI */\
 \
   C *g; /**< Oversampled vector of samples, size is \ref n_total double complex */\
@@ -158,8 +219,64 @@ typedef struct\
   R *spline_coeffs; /**< Input for de Boor algorithm if B_SPLINE or SINC_POWER is defined */\
 \
   NFFT_INT *index_x; /**< Index array for nodes x used when flag \ref NFFT_SORT_NODES is set. */\
+  NFFT_INT *index_x_temp; /**< Scratch of the size of index_x for sorting the nodes. */\
+  int index_x_sorted; /**< Nonzero while index_x is sorted for the precomputed
+                           nodes, see \ref nfft_update_nodes. */\
+\
+  NFFT_INT howmany; /**< Number of vectors transformed at once, default is 1.
+                         See \ref nfft_init_guru_many. */\
+  NFFT_INT stride; /**< Distance between two consecutive entries of one vector
+                        in f_hat and f, default is 1. */\
+  NFFT_INT f_hat_dist; /**< Distance between the first entries of two vectors
+                            in f_hat. */\
+  NFFT_INT f_dist; /**< Distance between the first entries of two vectors
+                        in f. */\
+\
+  NFFT_INT nthreads; /**< Number of threads of the plan, see
+                          \ref nfft_plan_with_nthreads. */\
+\
+  R *f_r; /**< Real samples for flag \ref NFFT_REAL, size is M_total. */\
+  R *g_r; /**< Real oversampled samples for flag \ref NFFT_REAL, size is
+               \ref n_total, output of the c2r and input of the r2c transform. */\
+\
+  void *map; /**< Contents of the plan file the plan was loaded from, see
+                  \ref nfft_plan_load, NULL otherwise. */\
+  size_t map_size; /**< Size of map in bytes. */\
+  R *map_x; /**< Writable copy of the nodes of the plan file for a plan
+                 without \ref MALLOC_X, NULL otherwise. */\
+\
+  void *arena; /**< Block the arrays of the plan are carved from, see
+                    \ref nfft_init_guru_arena, NULL otherwise. */\
+  size_t arena_size; /**< Size of arena in bytes. */\
+  size_t arena_used; /**< Bytes of arena in use. */\
+  void *arena_block; /**< Allocation holding arena if the plan allocated it,
+                          NULL if the caller provided it. */\
 } X(plan); \
 \
+/** normal operator \f$A^H W A\f$ of a plan, see \ref nfft_init_normal */ \
+typedef struct\
+{\
+  NFFT_INT N_total; /**< Total number of Fourier coefficients. */\
+  C *f_hat; /**< Fourier coefficients, overwritten by the result of
+                 \ref nfft_trafo_normal. */\
+  NFFT_INT M_total; /**< Total number of nodes of the plan. */\
+  const X(plan) *p; /**< Plan the operator was initialised with. */\
+  const R *w; /**< Weights it was initialised with, or NULL. */\
+\
+  NFFT_INT d; /**< Dimension (rank). */\
+  NFFT_INT *N; /**< Multi bandwidth. */\
+  NFFT_INT *L; /**< Multi length 2N of the circulant embedding. */\
+  NFFT_INT L_total; /**< Total size of the circulant embedding. */\
+  NFFT_INT nthreads; /**< Number of threads, that of the plan. */\
+\
+  C *kernel_hat; /**< FFT of the 2N-periodic kernel, divided by L_total. */\
+  C *g; /**< Zero-padded vector of size L_total. */\
+  Y(plan) my_fftw_plan1; /**< Forward FFT of length L of the circulant
+                              embedding, from g to g. */\
+  Y(plan) my_fftw_plan2; /**< Backward FFT of length L of the circulant
+                              embedding, from g to g. */\
+} X(normal_plan); \
+\
 NFFT_EXTERN void X(trafo_direct)(const X(plan) *ths);\
 NFFT_EXTERN void X(adjoint_direct)(const X(plan) *ths);\
 NFFT_EXTERN void X(trafo)(X(plan) *ths);\
@@ -178,12 +295,53 @@ NFFT_EXTERN void X(init_guru)(X(plan) *ths, int d, int *N, int M, int *n, \
   int m, unsigned flags, unsigned fftw_flags);\
 NFFT_EXTERN void X(init_lin)(X(plan) *ths, int d, int *N, int M, int *n, \
   int m, int K, unsigned flags, unsigned fftw_flags); \
+NFFT_EXTERN void X(init_guru_many)(X(plan) *ths, int d, int *N, int M, int *n, \
+  int m, int howmany, int stride, int f_hat_dist, int f_dist, unsigned flags, \
+  unsigned fftw_flags);\
+NFFT_EXTERN void X(trafo_many)(X(plan) *ths);\
+NFFT_EXTERN void X(adjoint_many)(X(plan) *ths);\
+NFFT_EXTERN void X(init_guru_real)(X(plan) *ths, int d, int *N, int M, int *n, \
+  int m, unsigned flags, unsigned fftw_flags);\
+NFFT_EXTERN size_t X(estimate_memory)(int d, int *N, int M, int *n, int m, \
+  unsigned flags, X(plan_memory) *mem);\
+NFFT_EXTERN void X(init_guru_arena)(X(plan) *ths, int d, int *N, int M, \
+  int *n, int m, unsigned flags, unsigned fftw_flags, void *arena, \
+  size_t arena_size);\
+NFFT_EXTERN void X(trafo_real)(X(plan) *ths);\
+NFFT_EXTERN void X(adjoint_real)(X(plan) *ths);\
+NFFT_EXTERN const char* X(trafo_stream_begin)(X(plan) *ths);\
+NFFT_EXTERN void X(trafo_stream_chunk)(X(plan) *ths, int M, const R *x, \
+  C *f);\
+NFFT_EXTERN const char* X(adjoint_stream_begin)(X(plan) *ths);\
+NFFT_EXTERN void X(adjoint_stream_chunk)(X(plan) *ths, int M, const R *x, \
+  const C *f);\
+NFFT_EXTERN void X(adjoint_stream_end)(X(plan) *ths);\
+NFFT_EXTERN void X(init_normal)(X(normal_plan) *ths, X(plan) *p, const R *w);\
+NFFT_EXTERN void X(trafo_normal)(X(normal_plan) *ths);\
+NFFT_EXTERN void X(finalize_normal)(X(normal_plan) *ths);\
+NFFT_EXTERN void X(trafo_grad)(X(plan) *ths, C *grad);\
+NFFT_EXTERN void X(adjoint_grad)(X(plan) *ths, const C *grad);\
+NFFT_EXTERN void X(get_stats)(const X(plan) *ths, X(stats) *stats);\
+NFFT_EXTERN void X(reset_stats)(X(plan) *ths);\
+NFFT_EXTERN const char* X(get_plan_window_name)(const X(plan) *ths);\
 NFFT_EXTERN void X(precompute_one_psi)(X(plan) *ths);\
 NFFT_EXTERN void X(precompute_psi)(X(plan) *ths);\
 NFFT_EXTERN void X(precompute_full_psi)(X(plan) *ths);\
 NFFT_EXTERN void X(precompute_fg_psi)(X(plan) *ths); \
 NFFT_EXTERN void X(precompute_lin_psi)(X(plan) *ths);\
 NFFT_EXTERN const char* X(check)(X(plan) *ths);\
+NFFT_EXTERN const char* X(set_nodes)(X(plan) *ths, int M_total, const R *x);\
+NFFT_EXTERN void X(update_nodes)(X(plan) *ths, int count, const int *indices, \
+  const R *x);\
+NFFT_EXTERN void X(plan_with_nthreads)(X(plan) *ths, int nthreads);\
+NFFT_EXTERN void X(init_sigma)(X(plan) *ths, int d, int *N, int M, R sigma);\
+NFFT_EXTERN void X(init_tuned)(X(plan) *ths, int d, int *N, int M, \
+  const R *x, R eps, unsigned flags);\
+NFFT_EXTERN char* X(export_tuning_to_string)(void);\
+NFFT_EXTERN int X(import_tuning_from_string)(const char *s);\
+NFFT_EXTERN void X(forget_tuning)(void);\
+NFFT_EXTERN const char* X(plan_save)(const X(plan) *ths, const char *filename);\
+NFFT_EXTERN const char* X(plan_load)(X(plan) *ths, const char *filename);\
 NFFT_EXTERN void X(finalize)(X(plan) *ths);
 
 /* Nfft module API. */
@@ -205,8 +363,27 @@ NFFT_DEFINE_API(NFFT_MANGLE_LONG_DOUBLE,FFTW_MANGLE_LONG_DOUBLE,long double,fftw
 #define FFTW_INIT                  (1U<<10)
 #define NFFT_SORT_NODES            (1U<<11)
 #define NFFT_OMP_BLOCKWISE_ADJOINT (1U<<12)
+#define NFFT_REAL                  (1U<<13)
+#define NFFT_WINDOW_KAISER_BESSEL  (1U<<14)
+#define NFFT_WINDOW_GAUSSIAN       (2U<<14)
+#define NFFT_WINDOW_B_SPLINE       (3U<<14)
+#define NFFT_WINDOW_SINC_POWER     (4U<<14)
+#define NFFT_WINDOW_DIRAC_DELTA    (5U<<14)
+#define NFFT_WINDOW_EXP_SEMICIRCLE (6U<<14)
+#define NFFT_WINDOW_MASK           (7U<<14)
+#define NFFT_OMP_TILED_ADJOINT     (1U<<17)
+#define NFFT_SORT_TILE_MAJOR       (1U<<18)
+#define NFFT_SORT_MORTON           (1U<<19)
+#define NFFT_MIXED_PRECISION       (1U<<20)
+#define NFFT_PRUNED_FFT            (1U<<21)
+#define NFFT_COMPACT_FULL_PSI      (1U<<22)
+#define NFFT_NUMA_FIRST_TOUCH      (1U<<23)
 #define PRE_ONE_PSI (PRE_LIN_PSI| PRE_FG_PSI| PRE_PSI| PRE_FULL_PSI)
 
+/* Flags for nfft_init_tuned. */
+#define NFFT_TUNE_ESTIMATE         (0U)
+#define NFFT_TUNE_MEASURE          (1U<<24)
+
 /* nfct */
 
 /* name mangling macros */
@@ -218,10 +395,11 @@ NFFT_DEFINE_API(NFFT_MANGLE_LONG_DOUBLE,FFTW_MANGLE_LONG_DOUBLE,long double,fftw
  * We expand this macro for each supported precision.
  *   X: nfct name-mangling macro
  *   Y: fftw name-mangling macro
+ *   Z: nfft name mangling macro
  *   R: real data type
  *   C: complex data type
  */
-#define NFCT_DEFINE_API(X,Y,R,C) \
+#define NFCT_DEFINE_API(X,Y,Z,R,C) \
 /** data structure for an NFCT (nonequispaced fast cosine transform) plan with R precision */ \
 typedef struct\
 {\
@@ -244,7 +422,8 @@ typedef struct\
 \
   R *x; /**< nodes (in time/spatial domain)   */\
 \
-  double MEASURE_TIME_t[3]; /**< measured time for each step */\
+  double MEASURE_TIME_t[3]; /**< time of the last run of each step */\
+  Z(stats) stats; /**< runtime statistics, see \ref nfft_get_stats */\
 \
   /* internal use only */\
   Y(plan)  my_fftw_r2r_plan; /**< fftw_plan */\
@@ -280,12 +459,14 @@ NFFT_EXTERN void X(trafo_direct)(const X(plan) *ths_plan); \
 NFFT_EXTERN void X(adjoint)(X(plan) *ths_plan); \
 NFFT_EXTERN void X(adjoint_direct)(const X(plan) *ths_plan); \
 NFFT_EXTERN const char* X(check)(X(plan) *ths);\
+NFFT_EXTERN void X(get_stats)(const X(plan) *ths, Z(stats) *stats);\
+NFFT_EXTERN void X(reset_stats)(X(plan) *ths);\
 NFFT_EXTERN void X(finalize)(X(plan) *ths_plan); \
 
 /* nfct api */
-NFCT_DEFINE_API(NFCT_MANGLE_FLOAT,FFTW_MANGLE_FLOAT,float,fftwf_complex)
-NFCT_DEFINE_API(NFCT_MANGLE_DOUBLE,FFTW_MANGLE_DOUBLE,double,fftw_complex)
-NFCT_DEFINE_API(NFCT_MANGLE_LONG_DOUBLE,FFTW_MANGLE_LONG_DOUBLE,long double,fftwl_complex)
+NFCT_DEFINE_API(NFCT_MANGLE_FLOAT,FFTW_MANGLE_FLOAT,NFFT_MANGLE_FLOAT,float,fftwf_complex)
+NFCT_DEFINE_API(NFCT_MANGLE_DOUBLE,FFTW_MANGLE_DOUBLE,NFFT_MANGLE_DOUBLE,double,fftw_complex)
+NFCT_DEFINE_API(NFCT_MANGLE_LONG_DOUBLE,FFTW_MANGLE_LONG_DOUBLE,NFFT_MANGLE_LONG_DOUBLE,long double,fftwl_complex)
 
 /* nfst */
 
@@ -298,10 +479,11 @@ NFCT_DEFINE_API(NFCT_MANGLE_LONG_DOUBLE,FFTW_MANGLE_LONG_DOUBLE,long double,fftw
  * We expand this macro for each supported precision.
  *   X: nfst name-mangling macro
  *   Y: fftw name-mangling macro
+ *   Z: nfft name mangling macro
  *   R: real data type
  *   C: complex data type
  */
-#define NFST_DEFINE_API(X,Y,R,C) \
+#define NFST_DEFINE_API(X,Y,Z,R,C) \
 /** data structure for an NFST (nonequispaced fast sine transform) plan with R precision */ \
 typedef struct\
 {\
@@ -324,7 +506,8 @@ typedef struct\
 \
   R *x; /**< nodes (in time/spatial domain) */\
 \
-  double MEASURE_TIME_t[3]; /**< measured time for each step */\
+  double MEASURE_TIME_t[3]; /**< time of the last run of each step */\
+  Z(stats) stats; /**< runtime statistics, see \ref nfft_get_stats */\
 \
   /* internal use only */\
   Y(plan)  my_fftw_r2r_plan; /**< fftw_plan forward */\
@@ -362,12 +545,14 @@ NFFT_EXTERN void X(trafo_direct)(const X(plan) *ths_plan); \
 NFFT_EXTERN void X(adjoint)(X(plan) *ths_plan); \
 NFFT_EXTERN void X(adjoint_direct)(const X(plan) *ths_plan); \
 NFFT_EXTERN const char* X(check)(X(plan) *ths);\
+NFFT_EXTERN void X(get_stats)(const X(plan) *ths, Z(stats) *stats);\
+NFFT_EXTERN void X(reset_stats)(X(plan) *ths);\
 NFFT_EXTERN void X(finalize)(X(plan) *ths_plan); \
 
 /* nfst api */
-NFST_DEFINE_API(NFST_MANGLE_FLOAT,FFTW_MANGLE_FLOAT,float,fftwf_complex)
-NFST_DEFINE_API(NFST_MANGLE_DOUBLE,FFTW_MANGLE_DOUBLE,double,fftw_complex)
-NFST_DEFINE_API(NFST_MANGLE_LONG_DOUBLE,FFTW_MANGLE_LONG_DOUBLE,long double,fftwl_complex)
+NFST_DEFINE_API(NFST_MANGLE_FLOAT,FFTW_MANGLE_FLOAT,NFFT_MANGLE_FLOAT,float,fftwf_complex)
+NFST_DEFINE_API(NFST_MANGLE_DOUBLE,FFTW_MANGLE_DOUBLE,NFFT_MANGLE_DOUBLE,double,fftw_complex)
+NFST_DEFINE_API(NFST_MANGLE_LONG_DOUBLE,FFTW_MANGLE_LONG_DOUBLE,NFFT_MANGLE_LONG_DOUBLE,long double,fftwl_complex)
 
 /* nnfft */
 
@@ -575,6 +760,8 @@ typedef struct\
     coefficients */\
   double MEASURE_TIME_t[3]; /**< Measured time for each step if MEASURE_TIME is
     set */\
+  Z(stats) stats; /**< Runtime statistics without those of plan_nfft, see
+    \ref nfsft_get_stats */\
 } X(plan);\
 \
 NFFT_EXTERN void X(init)(X(plan) *plan, int N, int M); \
@@ -590,7 +777,9 @@ NFFT_EXTERN void X(adjoint_direct)(X(plan)* plan); \
 NFFT_EXTERN void X(trafo)(X(plan)* plan); \
 NFFT_EXTERN void X(adjoint)(X(plan)* plan); \
 NFFT_EXTERN void X(finalize)(X(plan) *plan); \
-NFFT_EXTERN void X(precompute_x)(X(plan) *plan);
+NFFT_EXTERN void X(precompute_x)(X(plan) *plan); \
+NFFT_EXTERN void X(get_stats)(const X(plan) *plan, Z(stats) *stats); \
+NFFT_EXTERN void X(reset_stats)(X(plan) *plan);
 
 /* nfsft api */
 NFSFT_DEFINE_API(NFSFT_MANGLE_FLOAT,NFFT_MANGLE_FLOAT,float,fftwf_complex)
@@ -777,6 +966,7 @@ typedef struct\
   R dot_z_hat_iter_old; /**< previous dot_z_hat_iter */\
   R dot_p_hat_iter; /**< weighted dotproduct of p_hat_iter */\
   R dot_v_iter; /**< weighted dotproduct of v_iter */\
+  Y(normal_plan) *normal; /**< normal operator for NORMAL_OPERATOR */\
 } X(plan_complex);\
 \
 NFFT_EXTERN void X(init_advanced_complex)(X(plan_complex)* ths, Y(mv_plan_complex) *mv, unsigned flags);\
@@ -827,6 +1017,7 @@ SOLVER_DEFINE_API(SOLVER_MANGLE_LONG_DOUBLE,NFFT_MANGLE_LONG_DOUBLE,long double,
 #define NORMS_FOR_LANDWEBER   (1U<< 4)
 #define PRECOMPUTE_WEIGHT     (1U<< 5)
 #define PRECOMPUTE_DAMP       (1U<< 6)
+#define NORMAL_OPERATOR       (1U<< 7)
 
 /* util */
 
@@ -859,6 +1050,15 @@ void Y(vpr_double)(R *x, const NFFT_INT n, const char *text); \
 void Y(vpr_complex)(C *x, const NFFT_INT n, const char *text); \
 /* thread.c */ \
 NFFT_INT Y(get_num_threads)(void); \
+/* wisdom.c */ \
+/** Sets the file of the FFTW wisdom store, NULL disables it. The wisdom is \
+ * imported before the first FFTW plan of the library and written back after \
+ * measured plans. Default is the file named by the environment variable \
+ * NFFT_WISDOM_FILE (NFFTF_WISDOM_FILE, NFFTL_WISDOM_FILE in single and long \
+ * double precision). */ \
+void Y(set_wisdom_filename)(const char *filename); \
+/** Returns the file of the FFTW wisdom store or NULL. */ \
+const char *Y(get_wisdom_filename)(void); \
 /* time.c */ \
 R Y(clock_gettime_seconds)(void); \
 /* error.c: */ \
@@ -868,6 +1068,8 @@ R Y(error_l_infty_1_complex)(const C *x, const C *y, const NFFT_INT n, \
 /* int.c: */ \
 NFFT_INT Y(exp2i)(const NFFT_INT a); \
 NFFT_INT Y(next_power_of_2)(const NFFT_INT N); \
+/** Returns the smallest even 2^a 3^b 5^c 7^d larger or equal to N. */ \
+NFFT_INT Y(next_fft_size)(const NFFT_INT N); \
 /* vector1.c */ \
 /** Computes the inner/dot product \f$x^H x\f$. */ \
 R Y(dot_complex)(C *x, NFFT_INT n); \
@@ -882,7 +1084,8 @@ void Y(get_version)(unsigned *major, unsigned *minor, unsigned *patch); \
 /** \
  * Return name of window function. \
  * \
- * The window function to be used is configured at compile time. \
+ * The default window function is configured at compile time. Plans of the \
+ * nfft module may select a different one, see nfft_get_plan_window_name. \
  */ \
 const char *Y(get_window_name)(); \
 NFFT_INT Y(get_default_window_cut_off)();
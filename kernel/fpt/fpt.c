@@ -868,10 +868,12 @@ fpt_set fpt_init(const int M, const int t, const unsigned int flags)
 {
     fftw_plan_with_nthreads(nthreads);
 #endif
+    X(wisdom_before_plan)();
     set->plans_dct2[tau] =
       fftw_plan_many_r2r(1, &plength, 2, (double*)set->work, NULL,
                          2, 1, (double*)set->result, NULL, 2, 1,set->kindsr,
-                         0);
+                         FFTW_MEASURE);
+    X(wisdom_after_plan)(FFTW_MEASURE);
 #ifdef _OPENMP
 }
 #endif
@@ -889,10 +891,12 @@ fpt_set fpt_init(const int M, const int t, const unsigned int flags)
 {
   fftw_plan_with_nthreads(nthreads);
 #endif
+    X(wisdom_before_plan)();
     set->plans_dct3[tau] =
       fftw_plan_many_r2r(1, &plength, 2, (double*)set->work, NULL,
                          2, 1, (double*)set->result, NULL, 2, 1, set->kinds,
-                         0);
+                         FFTW_MEASURE);
+    X(wisdom_after_plan)(FFTW_MEASURE);
 #ifdef _OPENMP
 }
 #endif
@@ -906,6 +910,11 @@ fpt_set fpt_init(const int M, const int t, const unsigned int flags)
   set->vec4 = NULL;
   set->z = NULL;
 
+  set->plan_values = NULL;
+  set->plan_values_t = NULL;
+  set->plan_values_length = 0;
+  set->plan_values_t_length = 0;
+
   set->xc_slow = NULL;
   set->temp = NULL;
 
@@ -1311,6 +1320,39 @@ void fpt_precompute(fpt_set set, const int m, double *alpha, double *beta,
   fpt_precompute_2(set, m, alpha, beta, gam, k_start, threshold);
 }
 
+/**
+ * Returns the DCT of the given kind and length for function values, in place
+ * on set->work. The plan is kept in *plan and only created again when the
+ * length changes, so repeated transforms do not plan.
+ */
+static fftw_plan fpt_values_plan(fpt_set set, fftw_plan *plan, int *length,
+  const int l, const fftw_r2r_kind kind)
+{
+  if (*plan == NULL || *length != l)
+  {
+    fftw_r2r_kind kinds[2] = {kind, kind};
+    int n = l;
+#ifdef _OPENMP
+    int nthreads = X(get_num_threads)();
+#pragma omp critical (nfft_omp_critical_fftw_plan)
+{
+    fftw_plan_with_nthreads(nthreads);
+#endif
+    if (*plan)
+      fftw_destroy_plan(*plan);
+    X(wisdom_before_plan)();
+    *plan = fftw_plan_many_r2r(1, &n, 2, (double*)set->work, NULL, 2, 1,
+      (double*)set->work, NULL, 2, 1, kinds, FFTW_MEASURE);
+    X(wisdom_after_plan)(FFTW_MEASURE);
+#ifdef _OPENMP
+}
+#endif
+    *length = l;
+  }
+
+  return *plan;
+}
+
 void fpt_trafo_direct(fpt_set set, const int m, const double _Complex *x, double _Complex *y,
   const int k_end, const unsigned int flags)
 {
@@ -1403,8 +1445,6 @@ void fpt_trafo(fpt_set set, const int m, const double _Complex *x, double _Compl
   fpt_step *step;
   /** */
   fftw_plan plan = 0;
-  int length = k_end+1;
-  fftw_r2r_kind kinds[2] = {FFTW_REDFT01,FFTW_REDFT01};
 
   /** Loop counter */
   int k;
@@ -1429,19 +1469,8 @@ void fpt_trafo(fpt_set set, const int m, const double _Complex *x, double _Compl
     return;
 
   if (flags & FPT_FUNCTION_VALUES)
-  {
-#ifdef _OPENMP
-    int nthreads = X(get_num_threads)();
-#pragma omp critical (nfft_omp_critical_fftw_plan)
-{
-    fftw_plan_with_nthreads(nthreads);
-#endif
-    plan = fftw_plan_many_r2r(1, &length, 2, (double*)set->work, NULL, 2, 1,
-      (double*)set->work, NULL, 2, 1, kinds, 0U);
-#ifdef _OPENMP
-}
-#endif
-  }
+    plan = fpt_values_plan(set, &set->plan_values, &set->plan_values_length,
+      k_end + 1, FFTW_REDFT01);
 
   /* Initialize working arrays. */
   memset(set->result,0U,2*Nk*sizeof(double _Complex));
@@ -1669,10 +1698,6 @@ void fpt_trafo(fpt_set set, const int m, const double _Complex *x, double _Compl
   {
     y[0] *= 2.0;
     fftw_execute_r2r(plan,(double*)y,(double*)y);
-#ifdef _OPENMP
-    #pragma omp critical (nfft_omp_critical_fftw_plan)
-#endif
-    fftw_destroy_plan(plan);
     for (k = 0; k <= k_end; k++)
     {
       y[k] *= 0.5;
@@ -1767,8 +1792,6 @@ void fpt_transposed(fpt_set set, const int m, double _Complex *x,
   fpt_step *step;
   /** */
   fftw_plan plan;
-  int length = k_end+1;
-  fftw_r2r_kind kinds[2] = {FFTW_REDFT10,FFTW_REDFT10};
   /** Loop counter */
   int k;
   int t_stab;
@@ -1793,22 +1816,9 @@ void fpt_transposed(fpt_set set, const int m, double _Complex *x,
 
   if (flags & FPT_FUNCTION_VALUES)
   {
-#ifdef _OPENMP
-    int nthreads = X(get_num_threads)();
-#pragma omp critical (nfft_omp_critical_fftw_plan)
-{
-    fftw_plan_with_nthreads(nthreads);
-#endif
-    plan = fftw_plan_many_r2r(1, &length, 2, (double*)set->work, NULL, 2, 1,
-      (double*)set->work, NULL, 2, 1, kinds, 0U);
-#ifdef _OPENMP
-}
-#endif
+    plan = fpt_values_plan(set, &set->plan_values_t, &set->plan_values_t_length,
+      k_end + 1, FFTW_REDFT10);
     fftw_execute_r2r(plan,(double*)y,(double*)set->result);
-#ifdef _OPENMP
-    #pragma omp critical (nfft_omp_critical_fftw_plan)
-#endif
-    fftw_destroy_plan(plan);
     for (k = 0; k <= k_end; k++)
     {
       set->result[k] *= 0.5;
@@ -2089,6 +2099,18 @@ void fpt_finalize(fpt_set set)
   set->plans_dct3 = NULL;
   set->plans_dct2 = NULL;
 
+#ifdef _OPENMP
+#pragma omp critical (nfft_omp_critical_fftw_plan)
+#endif
+{
+  if (set->plan_values)
+    fftw_destroy_plan(set->plan_values);
+  if (set->plan_values_t)
+    fftw_destroy_plan(set->plan_values_t);
+}
+  set->plan_values = NULL;
+  set->plan_values_t = NULL;
+
   /* Check if fast transform is activated. */
   if (!(set->flags & FPT_NO_FAST_ALGORITHM))
   {
@@ -88,6 +88,13 @@ typedef struct fpt_set_s_
                                                library                       */
   fftw_r2r_kind *kindsr;                  /**< Transform kinds for fftw
                                                library                       */
+  fftw_plan plan_values;                  /**< DCT-III to function values
+                                               of fpt_trafo, created on first
+                                               use                           */
+  fftw_plan plan_values_t;                /**< DCT-II from function values
+                                               of fpt_transposed             */
+  int plan_values_length;                 /**< Length of plan_values         */
+  int plan_values_t_length;               /**< Length of plan_values_t       */
 
   /* Data for slow transforms. */
   double *xc_slow;
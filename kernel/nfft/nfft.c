@@ -40,6 +40,14 @@
 #include <assert.h>
 #endif
 
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NFFT_PLAN_MMAP
+#endif
+
 #undef X
 #define X(name) NFFT(name)
 
@@ -58,68 +66,427 @@ static inline INT intprod(const INT *vec, const INT a, const INT d)
 /* handy shortcuts */
 #define BASE(x) CEXP(x)
 
+/* Window functions. The window is chosen per plan (ths->window), so PHI and
+ * PHI_HUT dispatch at runtime. Loops over the 2m+2 window values of a node use
+ * window_psij instead, which branches once per node and dimension, and the
+ * deconvolution D always reads the table c_phi_inv built at initialisation. */
+#undef PHI_HUT
+#undef PHI
+#define PHI_HUT(n,k,d) window_phi_hut(ths,(INT)(n),(INT)(k),(INT)(d))
+#define PHI(n,x,d) window_phi(ths,(INT)(n),(R)(x),(INT)(d))
+
+static inline R window_phi_hut(const X(plan) *ths, const INT n, const INT k,
+  const INT d)
+{
+  switch (ths->window)
+  {
+    case NFFT_WINDOW_DIRAC_DELTA: return PHI_HUT_DIRAC_DELTA(n,k,d);
+    case NFFT_WINDOW_GAUSSIAN: return PHI_HUT_GAUSSIAN(n,k,d);
+    case NFFT_WINDOW_B_SPLINE: return PHI_HUT_B_SPLINE(n,k,d);
+    case NFFT_WINDOW_SINC_POWER: return PHI_HUT_SINC_POWER(n,k,d);
+    /* computed numerically, see precompute_phi_hut_exp_semicircle */
+    case NFFT_WINDOW_EXP_SEMICIRCLE: UNUSED(n);
+      return K(1.0) / ths->c_phi_inv[d][k + ths->N[d] / 2];
+    default: return PHI_HUT_KAISER_BESSEL(n,k,d);
+  }
+}
+
+static inline R window_phi(const X(plan) *ths, const INT n, const R x,
+  const INT d)
+{
+  switch (ths->window)
+  {
+    case NFFT_WINDOW_DIRAC_DELTA: return PHI_DIRAC_DELTA(n,x,d);
+    case NFFT_WINDOW_GAUSSIAN: return PHI_GAUSSIAN(n,x,d);
+    case NFFT_WINDOW_B_SPLINE: return PHI_B_SPLINE(n,x,d);
+    case NFFT_WINDOW_SINC_POWER: return PHI_SINC_POWER(n,x,d);
+    case NFFT_WINDOW_EXP_SEMICIRCLE: return PHI_EXP_SEMICIRCLE(n,x,d);
+    default: return PHI_KAISER_BESSEL(n,x,d);
+  }
+}
+
+/** Computes psij[l] = phi(x - (u+l)/n_t), l = 0,...,2m+1, for one window. */
+#define MACRO_window_psij(name, PHI_name) \
+static void window_psij_ ## name(const X(plan) *ths, const INT t, const R x, \
+  const INT u, R *psij) \
+{ \
+  const INT n = ths->n[t]; \
+  INT l; \
+  for (l = 0; l < 2 * ths->m + 2; l++) \
+    psij[l] = PHI_name(n, x - ((R)((u + l))) / (R)(n), t); \
+}
+
+MACRO_window_psij(dirac_delta, PHI_DIRAC_DELTA)
+MACRO_window_psij(gaussian, PHI_GAUSSIAN)
+MACRO_window_psij(b_spline, PHI_B_SPLINE)
+MACRO_window_psij(sinc_power, PHI_SINC_POWER)
+MACRO_window_psij(kaiser_bessel, PHI_KAISER_BESSEL)
+
+/** Degree of the polynomials approximating the exponential of semicircle. */
+#define WINDOW_EXP_SEMICIRCLE_DEGREE(m) ((m) + 5)
+
+/**
+ * Evaluates the exponential of semicircle window from its piecewise
+ * polynomials. Window value l is a polynomial in z = 2 frac(n x) - 1, the
+ * coefficients are stored degree by degree so that Horner's rule runs over
+ * all 2m+2 values at once.
+ */
+static void window_psij_exp_semicircle(const X(plan) *ths, const INT t,
+  const R x, const INT u, R *psij)
+{
+  const INT m2p2 = 2 * ths->m + 2;
+  const INT p = WINDOW_EXP_SEMICIRCLE_DEGREE(ths->m);
+  const R *c = ths->window_coeffs + t * (p + 1) * m2p2;
+  const R y = (R)(ths->n[t]) * x;
+  const R z = K(2.0) * (y - FLOOR(y)) - K(1.0);
+  INT l, k;
+
+  UNUSED(u);
+
+  for (l = 0; l < m2p2; l++)
+    psij[l] = c[p * m2p2 + l];
+
+  for (k = p - 1; k >= 0; k--)
+    for (l = 0; l < m2p2; l++)
+      psij[l] = psij[l] * z + c[k * m2p2 + l];
+}
+
+/**
+ * Evaluates the 2m+2 window values of node coordinate x in dimension t,
+ * starting at grid index u.
+ */
+static inline void window_psij(const X(plan) *ths, const INT t, const R x,
+  const INT u, R *psij)
+{
+  switch (ths->window)
+  {
+    case NFFT_WINDOW_DIRAC_DELTA: window_psij_dirac_delta(ths, t, x, u, psij); break;
+    case NFFT_WINDOW_GAUSSIAN: window_psij_gaussian(ths, t, x, u, psij); break;
+    case NFFT_WINDOW_B_SPLINE: window_psij_b_spline(ths, t, x, u, psij); break;
+    case NFFT_WINDOW_SINC_POWER: window_psij_sinc_power(ths, t, x, u, psij); break;
+    case NFFT_WINDOW_EXP_SEMICIRCLE: window_psij_exp_semicircle(ths, t, x, u, psij); break;
+    default: window_psij_kaiser_bessel(ths, t, x, u, psij); break;
+  }
+}
+
+/** Edge length of cache-sized tiles of the oversampled grid, such that the part
+ * of g touched by the nodes of one tile stays in the cache. */
+#define NFFT_TILE_EDGE(d) ((d) == 1 ? 1024 : ((d) == 2 ? 64 : ((d) == 3 ? 16 : 8)))
+
+/** Interleaves the bits of the grid indices u[t] < 2^bits[t] (Morton order),
+ * the last dimension being the least significant one. */
+static inline INT sort_key_morton(const INT d, const INT *u, const INT *bits,
+    const INT bits_max)
+{
+  INT key = 0, pos = 0, b, t;
+
+  for (b = 0; b < bits_max; b++)
+    for (t = d - 1; t >= 0; t--)
+      if (b < bits[t])
+        key |= ((u[t] >> b) & 1) << pos++;
+
+  return key;
+}
+
+/** Parameters of the node order selected by flags, see sort0. Returns an
+ * upper bound of the keys. */
+static inline INT sort_key_init(const INT d, const INT *n, const unsigned flags,
+    INT *edge, INT *nt, INT *bits, INT *bits_max)
+{
+  INT j, nprod;
+
+  *bits_max = 0;
+
+  for (j = 0, nprod = 1; j < d; j++)
+  {
+    if (flags & NFFT_SORT_MORTON)
+    {
+      bits[j] = Y(log2i)(MAX(n[j] - 1, 1)) + 1;
+      *bits_max = MAX(*bits_max, bits[j]);
+      nprod *= (INT)1 << bits[j];
+    }
+    else if (flags & NFFT_SORT_TILE_MAJOR)
+    {
+      edge[j] = MIN(NFFT_TILE_EDGE(d), n[j]);
+      nt[j] = (n[j] + edge[j] - 1) / edge[j];
+      nprod *= nt[j] * edge[j];
+    }
+    else
+      nprod *= n[j];
+  }
+
+  return nprod;
+}
+
+/** Key of node xj in the order selected by flags, see sort0. */
+static inline INT sort_key(const INT d, const INT *n, const INT m,
+    const unsigned flags, const R *xj, const INT *edge, const INT *nt,
+    const INT *bits, const INT bits_max)
+{
+  INT u_j[d], key = 0, j;
+
+  for (j = 0; j < d; j++)
+  {
+    const INT help = (INT) LRINT(FLOOR((R)(n[j]) * xj[j] - (R)(m)));
+    u_j[j] = (help % n[j] + n[j]) % n[j];
+  }
+
+  if (flags & NFFT_SORT_MORTON)
+    key = sort_key_morton(d, u_j, bits, bits_max);
+  else if (flags & NFFT_SORT_TILE_MAJOR)
+  {
+    INT tile = 0;
+    for (j = 0; j < d; j++)
+    {
+      tile = tile * nt[j] + u_j[j] / edge[j];
+      key = key * edge[j] + u_j[j] % edge[j];
+    }
+    for (j = 0; j < d; j++)
+      tile *= edge[j];
+    key += tile;
+  }
+  else
+  {
+    for (j = 0; j < d; j++)
+      key = key * n[j] + u_j[j];
+  }
+
+  return key;
+}
+
 /**
  * Sort nodes (index) to get better cache utilization during multiplication
  * with matrix B.
  * The resulting index set is written to ar[2*j+1], the nodes array remains
  * unchanged.
  *
+ * The key of a node is the grid index of its first touched cell, in row-major
+ * order by default. With NFFT_SORT_TILE_MAJOR the grid is split into tiles of
+ * NFFT_TILE_EDGE(d) points per dimension, which are ordered row-major, and
+ * the cells within a tile again row-major. With NFFT_SORT_MORTON the key
+ * interleaves the bits of the cell indices.
+ *
  * \arg n FFTW length (number of oversampled in each dimension)
  * \arg m window length
+ * \arg flags plan flags, selecting the order
  * \arg local_x_num number of nodes
  * \arg local_x nodes array
  * \arg ar_x resulting index array
+ * \arg ar_x_temp scratch of the same size as ar_x
+ * \arg nthreads number of threads
  *
  * \author Toni Volkmer
  */
 static inline void sort0(const INT d, const INT *n, const INT m,
-    const INT local_x_num, const R *local_x, INT *ar_x)
+    const unsigned flags, const INT local_x_num, const R *local_x, INT *ar_x,
+    INT *ar_x_temp, const INT nthreads)
 {
-  INT u_j[d], i, j, help, rhigh;
-  INT *ar_x_temp;
+  INT i, rhigh;
   INT nprod;
+  INT edge[d], nt[d], bits[d], bits_max;
+
+  nprod = sort_key_init(d, n, flags, edge, nt, bits, &bits_max);
 
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(i) num_threads(nthreads)
+#endif
   for (i = 0; i < local_x_num; i++)
   {
-    ar_x[2 * i] = 0;
-    ar_x[2 *i + 1] = i;
-    for (j = 0; j < d; j++)
-    {
-      help = (INT) LRINT(FLOOR((R)(n[j]) * local_x[d * i + j] - (R)(m)));
-      u_j[j] = (help % n[j] + n[j]) % n[j];
-
-      ar_x[2 * i] += u_j[j];
-      if (j + 1 < d)
-        ar_x[2 * i] *= n[j + 1];
-    }
+    ar_x[2 * i] = sort_key(d, n, m, flags, &local_x[d * i], edge, nt, bits,
+      bits_max);
+    ar_x[2 * i + 1] = i;
   }
 
-  for (j = 0, nprod = 1; j < d; j++)
-    nprod *= n[j];
-
+  /* keys are below nprod, i.e. have at most rhigh+1 bits */
   rhigh = (INT) LRINT(CEIL(LOG2((R)nprod))) - 1;
 
-  ar_x_temp = (INT*) Y(malloc)(2 * (size_t)(local_x_num) * sizeof(INT));
-  Y(sort_node_indices_radix_lsdf)(local_x_num, ar_x, ar_x_temp, rhigh);
+  Y(sort_node_indices_radix_lsdf)(local_x_num, ar_x, ar_x_temp, rhigh,
+    nthreads);
 #ifdef OMP_ASSERT
   for (i = 1; i < local_x_num; i++)
     assert(ar_x[2 * (i - 1)] <= ar_x[2 * i]);
 #endif
-  Y(free)(ar_x_temp);
 }
 
+static int plan_file_contains(const X(plan) *ths, const void *p);
+static void plan_file_own(X(plan) *ths);
+
 /**
  * Sort nodes (index) to get better cache utilization during multiplication
  * with matrix B.
  * The resulting index set is written to ths->index_x[2*j+1], the nodes array
- * remains unchanged.
+ * remains unchanged. The index set of a plan file is already sorted. With
+ * PRE_PSI, PRE_FG_PSI or PRE_FULL_PSI the nodes only change together with
+ * the precomputation, so the index set is kept until then.
  *
  * \arg ths nfft_plan
  */
-static inline void sort(const X(plan) *ths)
+static inline void sort(X(plan) *ths)
 {
-  if (ths->flags & NFFT_SORT_NODES)
-    sort0(ths->d, ths->n, ths->m, ths->M_total, ths->x, ths->index_x);
+  if ((ths->flags & NFFT_SORT_NODES) && !ths->index_x_sorted
+    && !plan_file_contains(ths, ths->index_x))
+  {
+    STATS_TIC(NFFT_STATS_SORT)
+    sort0(ths->d, ths->n, ths->m, ths->flags, ths->M_total, ths->x,
+      ths->index_x, ths->index_x_temp, ths->nthreads);
+    STATS_TOC(NFFT_STATS_SORT)
+
+    if (ths->flags & (PRE_PSI | PRE_FG_PSI | PRE_FULL_PSI))
+      ths->index_x_sorted = 1;
+  }
+}
+
+/**
+ * Direct transform, or its adjoint, used for too low degrees N. Its time is
+ * counted as NFFT_STATS_OTHER.
+ *
+ * \arg ths nfft_plan
+ * \arg adjoint nonzero for the adjoint transform
+ */
+static void nfft_direct(X(plan) *ths, const int adjoint)
+{
+  STATS_TIC(NFFT_STATS_OTHER)
+  if (adjoint)
+    X(adjoint_direct)(ths);
+  else
+    X(trafo_direct)(ths);
+  STATS_TOC(NFFT_STATS_OTHER)
+}
+
+/**
+ * Counts M nodes with v vectors in the matrix B and f deconvolutions and FFTs
+ * in the statistics, with an estimate of the bytes read and written, i.e.
+ * without reuse in caches.
+ *
+ * \arg ths nfft_plan
+ * \arg M number of nodes
+ * \arg v number of vectors per node
+ * \arg f number of steps D and FFT
+ */
+static void nfft_stats_count(X(plan) *ths, const INT M, const INT v,
+  const INT f)
+{
+  INT t, lprod;
+  double node;
+
+  for (t = 0, lprod = 1; t < ths->d; t++)
+    lprod *= 2 * ths->m + 2;
+
+  /* node, samples and the window's part of the oversampled vectors */
+  node = (double)(ths->d * (INT)sizeof(R) + v * (1 + lprod) * (INT)sizeof(C));
+
+  if (ths->flags & PRE_PSI)
+    node += (double)(ths->d * (2 * ths->m + 2)) * (double)((ths->flags
+      & NFFT_MIXED_PRECISION) ? sizeof(float) : sizeof(R));
+  else if (ths->flags & PRE_FULL_PSI)
+    node += (double)lprod * (double)(sizeof(R) + ((ths->flags
+      & NFFT_COMPACT_FULL_PSI) ? 0 : sizeof(INT)));
+
+  ths->stats.nodes += (unsigned long long)M;
+  ths->stats.bytes += (double)M * node + (double)f * (double)(2 * ths->N_total
+    + 4 * ths->n_total) * (double)sizeof(C);
+  ths->stats.nthreads = ths->nthreads;
+}
+
+/**
+ * Sets size bytes at a to zero. With NFFT_NUMA_FIRST_TOUCH the bytes are split
+ * into ths->nthreads equal parts and thread k clears the k-th one, the share
+ * of the array that parallel loops with static schedule give to it. Used for
+ * the first touch of an array, this puts its pages on the NUMA node of the
+ * thread working on them.
+ *
+ * \arg ths nfft_plan
+ * \arg a array
+ * \arg size size in bytes
+ */
+static void nfft_zero(const X(plan) *ths, void *a, const size_t size)
+{
+#ifndef _OPENMP
+  UNUSED(ths);
+#else
+  if (ths->flags & NFFT_NUMA_FIRST_TOUCH)
+  {
+    const INT nt = ths->nthreads;
+    INT k;
+
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads) schedule(static,1)
+    for (k = 0; k < nt; k++)
+    {
+      const size_t lo = size / (size_t)nt * (size_t)k
+        + MIN(size % (size_t)nt, (size_t)k);
+      const size_t hi = size / (size_t)nt * (size_t)(k + 1)
+        + MIN(size % (size_t)nt, (size_t)(k + 1));
+
+      memset((char*)a + lo, 0, hi - lo);
+    }
+    return;
+  }
+#endif
+
+  memset(a, 0, size);
+}
+
+/* Arena allocation. Arrays of a plan with an arena are carved from it at
+ * offsets aligned to ARENA_ALIGN bytes, in the order of init_help. What does
+ * not fit, e.g. after nfft_set_nodes with more nodes, is allocated as usual.
+ * A block the plan allocates itself is aligned to ARENA_HUGE_PAGE bytes from
+ * that size on, such that transparent huge pages can back it. */
+
+#define ARENA_ALIGN ((size_t)64)
+#define ARENA_ROUND(s) (((s) + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN)
+#define ARENA_HUGE_PAGE ((size_t)1 << 21)
+
+static void arena_init(X(plan) *ths, void *arena, const size_t size)
+{
+  ths->arena = arena;
+  ths->arena_size = size;
+  ths->arena_block = NULL;
+
+  /* skip to the first aligned byte */
+  ths->arena_used = arena ? (ARENA_ALIGN - (size_t)((uintptr_t)arena
+    % ARENA_ALIGN)) % ARENA_ALIGN : 0;
+}
+
+static int arena_contains(const X(plan) *ths, const void *p)
+{
+  const char *lo = (const char*)ths->arena, *hi = lo + ths->arena_size;
+
+  return ths->arena && (const char*)p >= lo && (const char*)p < hi;
+}
+
+/** Allocates an array of the plan, from the arena if it fits. */
+static void *plan_malloc(X(plan) *ths, const size_t size)
+{
+  if (ths->arena && ths->arena_used <= ths->arena_size
+    && ARENA_ROUND(size) <= ths->arena_size - ths->arena_used)
+  {
+    void *p = (char*)ths->arena + ths->arena_used;
+    ths->arena_used += ARENA_ROUND(size);
+    return p;
+  }
+
+  return Y(malloc)(size);
+}
+
+/** Frees an array of the plan, unless it lies in the arena or plan file. */
+static void plan_free(const X(plan) *ths, void *p)
+{
+  if (!arena_contains(ths, p) && !plan_file_contains(ths, p))
+    Y(free)(p);
+}
+
+/** Allocates an array of the plan, first touched as by nfft_zero with
+ *  NFFT_NUMA_FIRST_TOUCH. */
+static void *malloc_first_touch(X(plan) *ths, const size_t size)
+{
+  void *p = plan_malloc(ths, size);
+
+#ifdef _OPENMP
+  if (ths->flags & NFFT_NUMA_FIRST_TOUCH)
+    nfft_zero(ths, p, size);
+#endif
+
+  return p;
 }
 
 /** direct computation of non equispaced fourier transforms
@@ -153,7 +520,7 @@ void X(trafo_direct)(const X(plan) *ths)
     /* specialize for univariate case, rationale: faster */
     INT j;
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(j)
+    #pragma omp parallel for default(shared) private(j) num_threads(ths->nthreads)
 #endif
     for (j = 0; j < ths->M_total; j++)
     {
@@ -170,7 +537,7 @@ void X(trafo_direct)(const X(plan) *ths)
     /* multivariate case */
     INT j;
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(j)
+    #pragma omp parallel for default(shared) private(j) num_threads(ths->nthreads)
 #endif
     for (j = 0; j < ths->M_total; j++)
     {
@@ -215,7 +582,7 @@ void X(adjoint_direct)(const X(plan) *ths)
     /* specialize for univariate case, rationale: faster */
 #ifdef _OPENMP
       INT k_L;
-      #pragma omp parallel for default(shared) private(k_L)
+      #pragma omp parallel for default(shared) private(k_L) num_threads(ths->nthreads)
       for (k_L = 0; k_L < ths->N_total; k_L++)
       {
         INT j;
@@ -243,7 +610,7 @@ void X(adjoint_direct)(const X(plan) *ths)
     /* multivariate case */
     INT j, k_L;
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(j, k_L)
+    #pragma omp parallel for default(shared) private(j, k_L) num_threads(ths->nthreads)
     for (k_L = 0; k_L < ths->N_total; k_L++)
     {
       INT k[ths->d], k_temp, t;
@@ -339,392 +706,797 @@ static inline void uo2(INT *u, INT *o, const R x, const INT n, const INT m)
   *o = (c + 1 + m + n) % n;
 }
 
-#define MACRO_D_compute_A \
-{ \
-  g_hat[k_plain[ths->d]] = f_hat[ks_plain[ths->d]] * c_phi_inv_k[ths->d]; \
-}
-
-#define MACRO_D_compute_T \
-{ \
-  f_hat[ks_plain[ths->d]] = g_hat[k_plain[ths->d]] * c_phi_inv_k[ths->d]; \
-}
-
-#define MACRO_D_init_result_A memset(g_hat, 0, (size_t)(ths->n_total) * sizeof(C));
+/* Explicitly vectorised kernels for d=2 and d=3 (double precision, x86).
+ *
+ * The 2m+2 taps of the fastest dimension are contiguous in g up to at most
+ * one wraparound, so each row is handled by one or two calls of a vector
+ * kernel working on interleaved complex numbers. The instruction set is
+ * detected once at plan initialisation, or chosen with nfft_simd_select; the
+ * scalar kernels below remain the portable fallback and are used whenever no
+ * supported unit is available. */
+#if !defined(NFFT_SINGLE) && !defined(NFFT_LDOUBLE) && !defined(NFFT_NO_SIMD) \
+  && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NFFT_SIMD
+#endif
 
-#define MACRO_D_init_result_T memset(f_hat, 0, (size_t)(ths->N_total) * sizeof(C));
+#ifdef NFFT_SIMD
+#include <immintrin.h>
 
-#define MACRO_with_PRE_PHI_HUT * ths->c_phi_inv[t2][ks[t2]];
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
 
-#define MACRO_without_PRE_PHI_HUT / (PHI_HUT(ths->n[t2],ks[t2]-(ths->N[t2]/2),t2));
+/* the vector unit in use, -1 before the first plan */
+static int simd_isa = -1;
 
-#define MACRO_init_k_ks \
-{ \
-  for (t = ths->d-1; 0 <= t; t--) \
-  { \
-    kp[t] = k[t] = 0; \
-    ks[t] = ths->N[t]/2; \
-  } \
-  t++; \
+/** The widest vector unit of the processor. */
+static int simd_detect(void)
+{
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return SIMD_AVX512;
+  else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    return SIMD_AVX2;
+  else
+    return SIMD_NONE;
 }
 
-#define MACRO_update_c_phi_inv_k(which_one) \
-{ \
-  for (t2 = t; t2 < ths->d; t2++) \
-  { \
-    c_phi_inv_k[t2+1] = c_phi_inv_k[t2] MACRO_ ##which_one; \
-    ks_plain[t2+1] = ks_plain[t2]*ths->N[t2] + ks[t2]; \
-    k_plain[t2+1] = k_plain[t2]*ths->n[t2] + k[t2]; \
-  } \
+/** Detects the vector unit once, called from init_help. Plans may be
+ * initialised concurrently, so simd_isa is only written in the critical
+ * section. */
+static void simd_init(void)
+{
+#ifdef _OPENMP
+  #pragma omp critical (nfft_omp_critical_simd)
+#endif
+  {
+    if (simd_isa < 0)
+      simd_isa = simd_detect();
+  }
 }
 
-#define MACRO_count_k_ks \
-{ \
-  for (t = ths->d-1; (t > 0) && (kp[t] == ths->N[t]-1); t--) \
-  { \
-    kp[t] = k[t] = 0; \
-    ks[t]= ths->N[t]/2; \
-  } \
-\
-  kp[t]++; k[t]++; ks[t]++; \
-  if(kp[t] == ths->N[t]/2) \
-  { \
-    k[t] = ths->n[t] - ths->N[t]/2; \
-    ks[t] = 0; \
-  } \
-} \
-
-/* sub routines for the fast transforms  matrix vector multiplication with D, D^T */
-#define MACRO_D(which_one) \
-static inline void D_serial_ ## which_one (X(plan) *ths) \
+/** Calls the vectorised variant of a kernel and returns, if there is one. */
+#define SIMD_DISPATCH(name, args) \
 { \
-  C *f_hat, *g_hat; /* local copy */ \
-  R c_phi_inv_k[ths->d+1]; /* postfix product of PHI_HUT */ \
-  INT t, t2; /* index dimensions */ \
-  INT k_L; /* plain index */ \
-  INT kp[ths->d]; /* multi index (simple) */ \
-  INT k[ths->d]; /* multi index in g_hat */ \
-  INT ks[ths->d]; /* multi index in f_hat, c_phi_inv*/ \
-  INT k_plain[ths->d+1]; /* postfix plain index */ \
-  INT ks_plain[ths->d+1]; /* postfix plain index */ \
- \
-  f_hat = (C*)ths->f_hat; g_hat = (C*)ths->g_hat; \
-  MACRO_D_init_result_ ## which_one; \
-\
-  c_phi_inv_k[0] = K(1.0); \
-  k_plain[0] = 0; \
-  ks_plain[0] = 0; \
-\
-  MACRO_init_k_ks; \
-\
-  if (ths->flags & PRE_PHI_HUT) \
+  if (simd_isa == SIMD_AVX512) \
   { \
-    for (k_L = 0; k_L < ths->N_total; k_L++) \
-    { \
-      MACRO_update_c_phi_inv_k(with_PRE_PHI_HUT); \
-      MACRO_D_compute_ ## which_one; \
-      MACRO_count_k_ks; \
-    } \
+    name ## _avx512 args; \
+    return; \
   } \
-  else \
+  else if (simd_isa == SIMD_AVX2) \
   { \
-    for (k_L = 0; k_L < ths->N_total; k_L++) \
-    { \
-      MACRO_update_c_phi_inv_k(without_PRE_PHI_HUT); \
-      MACRO_D_compute_ ## which_one; \
-      MACRO_count_k_ks; \
-    } \
+    name ## _avx2 args; \
+    return; \
   } \
 }
 
-#ifdef _OPENMP
-static inline void D_openmp_A(X(plan) *ths)
+/** Returns sum_l psi[l] g[l], l = 0,...,len-1. */
+static inline TARGET_AVX2 C row_dot_avx2(const C *g, const R *psi,
+  const INT len)
 {
-  C *f_hat, *g_hat;                     /**< local copy                     */
-  INT k_L;                              /**< plain index                    */
-
-  f_hat = (C*)ths->f_hat; g_hat = (C*)ths->g_hat;
-  memset(g_hat, 0, ths->n_total * sizeof(C));
+  __m256d acc = _mm256_setzero_pd();
+  __m128d s;
+  C r;
+  INT l;
 
-  if (ths->flags & PRE_PHI_HUT)
+  for (l = 0; l + 2 <= len; l += 2)
   {
-    #pragma omp parallel for default(shared) private(k_L)
-    for (k_L = 0; k_L < ths->N_total; k_L++)
-    {
-      INT kp[ths->d];                       /**< multi index (simple)           */ //0..N-1
-      INT k[ths->d];                        /**< multi index in g_hat           */
-      INT ks[ths->d];                       /**< multi index in f_hat, c_phi_inv*/
-      R c_phi_inv_k_val = K(1.0);
-      INT k_plain_val = 0;
-      INT ks_plain_val = 0;
-      INT t;
-      INT k_temp = k_L;
+    const __m256d p = _mm256_permute4x64_pd(
+      _mm256_castpd128_pd256(_mm_loadu_pd(psi + l)), 0x50);
+    acc = _mm256_fmadd_pd(p, _mm256_loadu_pd((const R*)(g + l)), acc);
+  }
 
-      for (t = ths->d-1; t >= 0; t--)
-      {
-        kp[t] = k_temp % ths->N[t];
-        if (kp[t] >= ths->N[t]/2)
-          k[t] = ths->n[t] - ths->N[t] + kp[t];
-        else
-          k[t] = kp[t];
-        ks[t] = (kp[t] + ths->N[t]/2) % ths->N[t];
-        k_temp /= ths->N[t];
-      }
+  s = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+  _mm_storeu_pd((R*)&r, s);
 
-      for (t = 0; t < ths->d; t++)
-      {
-        c_phi_inv_k_val *= ths->c_phi_inv[t][ks[t]];
-        ks_plain_val = ks_plain_val*ths->N[t] + ks[t];
-        k_plain_val = k_plain_val*ths->n[t] + k[t];
-      }
+  if (l < len)
+    r += psi[l] * g[l];
 
-      g_hat[k_plain_val] = f_hat[ks_plain_val] * c_phi_inv_k_val;
-    } /* for(k_L) */
-  } /* if(PRE_PHI_HUT) */
-  else
-  {
-    #pragma omp parallel for default(shared) private(k_L)
-    for (k_L = 0; k_L < ths->N_total; k_L++)
-    {
-      INT kp[ths->d];                       /**< multi index (simple)           */ //0..N-1
-      INT k[ths->d];                        /**< multi index in g_hat           */
-      INT ks[ths->d];                       /**< multi index in f_hat, c_phi_inv*/
-      R c_phi_inv_k_val = K(1.0);
-      INT k_plain_val = 0;
-      INT ks_plain_val = 0;
-      INT t;
-      INT k_temp = k_L;
+  return r;
+}
 
-      for (t = ths->d-1; t >= 0; t--)
-      {
-        kp[t] = k_temp % ths->N[t];
-        if (kp[t] >= ths->N[t]/2)
-          k[t] = ths->n[t] - ths->N[t] + kp[t];
-        else
-          k[t] = kp[t];
-        ks[t] = (kp[t] + ths->N[t]/2) % ths->N[t];
-        k_temp /= ths->N[t];
-      }
+/** Computes g[l] += psi[l] a, l = 0,...,len-1. */
+static inline TARGET_AVX2 void row_axpy_avx2(C *g, const R *psi, const C a,
+  const INT len)
+{
+  const __m128d a1 = _mm_loadu_pd((const R*)&a);
+  const __m256d av = _mm256_insertf128_pd(_mm256_castpd128_pd256(a1), a1, 1);
+  INT l;
 
-      for (t = 0; t < ths->d; t++)
-      {
-        c_phi_inv_k_val /= (PHI_HUT(ths->n[t],ks[t]-(ths->N[t]/2),t));
-        ks_plain_val = ks_plain_val*ths->N[t] + ks[t];
-        k_plain_val = k_plain_val*ths->n[t] + k[t];
-      }
+  for (l = 0; l + 2 <= len; l += 2)
+  {
+    const __m256d p = _mm256_permute4x64_pd(
+      _mm256_castpd128_pd256(_mm_loadu_pd(psi + l)), 0x50);
+    _mm256_storeu_pd((R*)(g + l),
+      _mm256_fmadd_pd(p, av, _mm256_loadu_pd((const R*)(g + l))));
+  }
 
-      g_hat[k_plain_val] = f_hat[ks_plain_val] * c_phi_inv_k_val;
-    } /* for(k_L) */
-  } /* else(PRE_PHI_HUT) */
+  if (l < len)
+    g[l] += psi[l] * a;
 }
-#endif
-
-#ifndef _OPENMP
-MACRO_D(A)
-#endif
 
-static inline void D_A(X(plan) *ths)
+/** Returns sum_l psi[l] g[l], l = 0,...,len-1. */
+static inline TARGET_AVX512 C row_dot_avx512(const C *g, const R *psi,
+  const INT len)
 {
-#ifdef _OPENMP
-  D_openmp_A(ths);
-#else
-  D_serial_A(ths);
-#endif
-}
+  const __m512i dup = _mm512_set_epi64(3, 3, 2, 2, 1, 1, 0, 0);
+  __m512d acc = _mm512_setzero_pd();
+  __m256d acc4;
+  __m128d s;
+  C r;
+  INT l;
 
-#ifdef _OPENMP
-static void D_openmp_T(X(plan) *ths)
-{
-  C *f_hat, *g_hat;                     /**< local copy                     */
-  INT k_L;                              /**< plain index                    */
+  for (l = 0; l + 4 <= len; l += 4)
+  {
+    const __m512d p = _mm512_permutexvar_pd(dup,
+      _mm512_castpd256_pd512(_mm256_loadu_pd(psi + l)));
+    acc = _mm512_fmadd_pd(p, _mm512_loadu_pd((const R*)(g + l)), acc);
+  }
 
-  f_hat = (C*)ths->f_hat; g_hat = (C*)ths->g_hat;
-  memset(f_hat, 0, ths->N_total * sizeof(C));
+  acc4 = _mm256_add_pd(_mm512_castpd512_pd256(acc),
+    _mm512_extractf64x4_pd(acc, 1));
 
-  if (ths->flags & PRE_PHI_HUT)
+  if (l + 2 <= len)
   {
-    #pragma omp parallel for default(shared) private(k_L)
-    for (k_L = 0; k_L < ths->N_total; k_L++)
-    {
-      INT kp[ths->d];                       /**< multi index (simple)           */ //0..N-1
-      INT k[ths->d];                        /**< multi index in g_hat           */
-      INT ks[ths->d];                       /**< multi index in f_hat, c_phi_inv*/
-      R c_phi_inv_k_val = K(1.0);
-      INT k_plain_val = 0;
-      INT ks_plain_val = 0;
-      INT t;
-      INT k_temp = k_L;
+    const __m256d p = _mm256_permute4x64_pd(
+      _mm256_castpd128_pd256(_mm_loadu_pd(psi + l)), 0x50);
+    acc4 = _mm256_fmadd_pd(p, _mm256_loadu_pd((const R*)(g + l)), acc4);
+    l += 2;
+  }
 
-      for (t = ths->d - 1; t >= 0; t--)
-      {
-        kp[t] = k_temp % ths->N[t];
-        if (kp[t] >= ths->N[t]/2)
-          k[t] = ths->n[t] - ths->N[t] + kp[t];
-        else
-          k[t] = kp[t];
-        ks[t] = (kp[t] + ths->N[t]/2) % ths->N[t];
-        k_temp /= ths->N[t];
-      }
+  s = _mm_add_pd(_mm256_castpd256_pd128(acc4), _mm256_extractf128_pd(acc4, 1));
+  _mm_storeu_pd((R*)&r, s);
 
-      for (t = 0; t < ths->d; t++)
-      {
-        c_phi_inv_k_val *= ths->c_phi_inv[t][ks[t]];
-        ks_plain_val = ks_plain_val*ths->N[t] + ks[t];
-        k_plain_val = k_plain_val*ths->n[t] + k[t];
-      }
+  if (l < len)
+    r += psi[l] * g[l];
 
-      f_hat[ks_plain_val] = g_hat[k_plain_val] * c_phi_inv_k_val;
-    } /* for(k_L) */
-  } /* if(PRE_PHI_HUT) */
-  else
+  return r;
+}
+
+/** Computes g[l] += psi[l] a, l = 0,...,len-1. */
+static inline TARGET_AVX512 void row_axpy_avx512(C *g, const R *psi,
+  const C a, const INT len)
+{
+  const __m512i dup = _mm512_set_epi64(3, 3, 2, 2, 1, 1, 0, 0);
+  const __m512d av = _mm512_permutexvar_pd(
+    _mm512_set_epi64(1, 0, 1, 0, 1, 0, 1, 0),
+    _mm512_castpd128_pd512(_mm_loadu_pd((const R*)&a)));
+  INT l;
+
+  for (l = 0; l + 4 <= len; l += 4)
   {
-    #pragma omp parallel for default(shared) private(k_L)
-    for (k_L = 0; k_L < ths->N_total; k_L++)
-    {
-      INT kp[ths->d];                       /**< multi index (simple)           */ //0..N-1
-      INT k[ths->d];                        /**< multi index in g_hat           */
-      INT ks[ths->d];                       /**< multi index in f_hat, c_phi_inv*/
-      R c_phi_inv_k_val = K(1.0);
-      INT k_plain_val = 0;
-      INT ks_plain_val = 0;
-      INT t;
-      INT k_temp = k_L;
+    const __m512d p = _mm512_permutexvar_pd(dup,
+      _mm512_castpd256_pd512(_mm256_loadu_pd(psi + l)));
+    _mm512_storeu_pd((R*)(g + l),
+      _mm512_fmadd_pd(p, av, _mm512_loadu_pd((const R*)(g + l))));
+  }
 
-      for (t = ths->d-1; t >= 0; t--)
-      {
-        kp[t] = k_temp % ths->N[t];
-        if (kp[t] >= ths->N[t]/2)
-          k[t] = ths->n[t] - ths->N[t] + kp[t];
-        else
-          k[t] = kp[t];
-        ks[t] = (kp[t] + ths->N[t]/2) % ths->N[t];
-        k_temp /= ths->N[t];
-      }
+  if (l + 2 <= len)
+  {
+    const __m256d p = _mm256_permute4x64_pd(
+      _mm256_castpd128_pd256(_mm_loadu_pd(psi + l)), 0x50);
+    _mm256_storeu_pd((R*)(g + l), _mm256_fmadd_pd(p,
+      _mm512_castpd512_pd256(av), _mm256_loadu_pd((const R*)(g + l))));
+    l += 2;
+  }
 
-      for (t = 0; t < ths->d; t++)
-      {
-        c_phi_inv_k_val /= (PHI_HUT(ths->n[t],ks[t]-(ths->N[t]/2),t));
-        ks_plain_val = ks_plain_val*ths->N[t] + ks[t];
-        k_plain_val = k_plain_val*ths->n[t] + k[t];
-      }
+  if (l < len)
+    g[l] += psi[l] * a;
+}
+
+/** Length of the first contiguous run of the 2m+2 indices u,...,o mod n. */
+#define SIMD_RUN(u,o,m) (((u) < (o)) ? 2 * (m) + 2 : 2 * (m) + 1 - (o))
 
-      f_hat[ks_plain_val] = g_hat[k_plain_val] * c_phi_inv_k_val;
-    } /* for(k_L) */
-  } /* else(PRE_PHI_HUT) */
+/** Wraps index i in [0,2n) to [0,n). */
+#define SIMD_WRAP(i,n) (((i) < (n)) ? (i) : (i) - (n))
+
+/** Two-dimensional trafo for one node, see nfft_trafo_2d_compute. */
+#define MACRO_nfft_trafo_2d_compute_simd(isa, TARGET) \
+static TARGET void nfft_trafo_2d_compute_ ## isa(C *fj, const C *g, \
+    const R *psij_const0, const R *psij_const1, const R *xj0, const R *xj1, \
+    const INT n0, const INT n1, const INT m) \
+{ \
+  INT u0, o0, l0, u1, o1, r1; \
+  C s = K(0.0); \
+ \
+  uo2(&u0, &o0, *xj0, n0, m); \
+  uo2(&u1, &o1, *xj1, n1, m); \
+  r1 = SIMD_RUN(u1, o1, m); \
+ \
+  for (l0 = 0; l0 <= 2 * m + 1; l0++) \
+  { \
+    const C *gj = g + SIMD_WRAP(u0 + l0, n0) * n1; \
+    C t = row_dot_ ## isa(gj + u1, psij_const1, r1); \
+    if (r1 < 2 * m + 2) \
+      t += row_dot_ ## isa(gj, psij_const1 + r1, 2 * m + 2 - r1); \
+    s += psij_const0[l0] * t; \
+  } \
+ \
+  *fj = s; \
 }
-#endif
 
-#ifndef _OPENMP
-MACRO_D(T)
-#endif
+/** Adds f psij0[l0] psij1 to the rows u0,...,u0+count-1 (mod n0) of g. */
+#define MACRO_nfft_adjoint_2d_rows_simd(isa, TARGET) \
+static inline TARGET void nfft_adjoint_2d_rows_ ## isa(const C f, C *g, \
+    const R *psij_const0, const R *psij_const1, const INT u0, \
+    const INT count, const INT n0, const INT n1, const INT u1, const INT r1, \
+    const INT m) \
+{ \
+  INT l0; \
+ \
+  for (l0 = 0; l0 < count; l0++) \
+  { \
+    C *gj = g + SIMD_WRAP(u0 + l0, n0) * n1; \
+    const C a = psij_const0[l0] * f; \
+    row_axpy_ ## isa(gj + u1, psij_const1, a, r1); \
+    if (r1 < 2 * m + 2) \
+      row_axpy_ ## isa(gj, psij_const1 + r1, a, 2 * m + 2 - r1); \
+  } \
+}
 
-static void D_T(X(plan) *ths)
-{
-#ifdef _OPENMP
-  D_openmp_T(ths);
-#else
-  D_serial_T(ths);
-#endif
+/** Two-dimensional adjoint for one node, see nfft_adjoint_2d_compute_serial. */
+#define MACRO_nfft_adjoint_2d_compute_serial_simd(isa, TARGET) \
+static TARGET void nfft_adjoint_2d_compute_serial_ ## isa(const C *fj, C *g, \
+    const R *psij_const0, const R *psij_const1, const R *xj0, const R *xj1, \
+    const INT n0, const INT n1, const INT m) \
+{ \
+  INT u0, o0, u1, o1; \
+ \
+  uo2(&u0, &o0, *xj0, n0, m); \
+  uo2(&u1, &o1, *xj1, n1, m); \
+ \
+  nfft_adjoint_2d_rows_ ## isa(*fj, g, psij_const0, psij_const1, u0, \
+    2 * m + 2, n0, n1, u1, SIMD_RUN(u1, o1, m), m); \
 }
 
-/* sub routines for the fast transforms matrix vector multiplication with B, B^T */
-#define MACRO_B_init_result_A memset(ths->f, 0, (size_t)(ths->M_total) * sizeof(C));
-#define MACRO_B_init_result_T memset(ths->g, 0, (size_t)(ths->n_total) * sizeof(C));
+/** Two-dimensional adjoint for one node restricted to the rows my_u0,...,my_o0,
+ * see nfft_adjoint_2d_compute_omp_blockwise. */
+#define MACRO_nfft_adjoint_2d_compute_omp_blockwise_simd(isa, TARGET) \
+static TARGET void nfft_adjoint_2d_compute_omp_blockwise_ ## isa(const C f, \
+    C *g, const R *psij_const0, const R *psij_const1, const R *xj0, \
+    const R *xj1, const INT n0, const INT n1, const INT m, const INT my_u0, \
+    const INT my_o0) \
+{ \
+  INT ar_u0, ar_o0, u0, o0, u1, o1, r1, offset_psij; \
+ \
+  uo2(&ar_u0, &ar_o0, *xj0, n0, m); \
+  uo2(&u1, &o1, *xj1, n1, m); \
+  r1 = SIMD_RUN(u1, o1, m); \
+ \
+  u0 = MAX(my_u0, ar_u0); \
+  o0 = (ar_u0 < ar_o0) ? MIN(my_o0, ar_o0) : my_o0; \
+  offset_psij = u0 - ar_u0; \
+ \
+  nfft_adjoint_2d_rows_ ## isa(f, g, psij_const0 + offset_psij, psij_const1, \
+    u0, o0 - u0 + 1, n0, n1, u1, r1, m); \
+ \
+  if (ar_u0 >= ar_o0) \
+  { \
+    offset_psij += my_u0 - ar_u0 + n0; \
+    u0 = my_u0; \
+    o0 = MIN(my_o0, ar_o0); \
+    nfft_adjoint_2d_rows_ ## isa(f, g, psij_const0 + offset_psij, \
+      psij_const1, u0, o0 - u0 + 1, n0, n1, u1, r1, m); \
+  } \
+}
 
-#define MACRO_B_PRE_FULL_PSI_compute_A \
+/** Three-dimensional trafo for one node, see nfft_trafo_3d_compute. */
+#define MACRO_nfft_trafo_3d_compute_simd(isa, TARGET) \
+static TARGET void nfft_trafo_3d_compute_ ## isa(C *fj, const C *g, \
+    const R *psij_const0, const R *psij_const1, const R *psij_const2, \
+    const R *xj0, const R *xj1, const R *xj2, const INT n0, const INT n1, \
+    const INT n2, const INT m) \
 { \
-  (*fj) += ths->psi[ix] * g[ths->psi_index_g[ix]]; \
+  INT u0, o0, l0, u1, o1, l1, u2, o2, r2; \
+  C s = K(0.0); \
+ \
+  uo2(&u0, &o0, *xj0, n0, m); \
+  uo2(&u1, &o1, *xj1, n1, m); \
+  uo2(&u2, &o2, *xj2, n2, m); \
+  r2 = SIMD_RUN(u2, o2, m); \
+ \
+  for (l0 = 0; l0 <= 2 * m + 1; l0++) \
+  { \
+    const INT i0 = SIMD_WRAP(u0 + l0, n0) * n1; \
+    C s1 = K(0.0); \
+ \
+    for (l1 = 0; l1 <= 2 * m + 1; l1++) \
+    { \
+      const C *gj = g + (i0 + SIMD_WRAP(u1 + l1, n1)) * n2; \
+      C t = row_dot_ ## isa(gj + u2, psij_const2, r2); \
+      if (r2 < 2 * m + 2) \
+        t += row_dot_ ## isa(gj, psij_const2 + r2, 2 * m + 2 - r2); \
+      s1 += psij_const1[l1] * t; \
+    } \
+ \
+    s += psij_const0[l0] * s1; \
+  } \
+ \
+  *fj = s; \
 }
 
-#define MACRO_B_PRE_FULL_PSI_compute_T \
+/** Adds f psij0[l0] psij1[l1] psij2 to the planes u0,...,u0+count-1 (mod n0)
+ * of g. */
+#define MACRO_nfft_adjoint_3d_planes_simd(isa, TARGET) \
+static inline TARGET void nfft_adjoint_3d_planes_ ## isa(const C f, C *g, \
+    const R *psij_const0, const R *psij_const1, const R *psij_const2, \
+    const INT u0, const INT count, const INT n0, const INT n1, const INT n2, \
+    const INT u1, const INT u2, const INT r2, const INT m) \
 { \
-  g[ths->psi_index_g[ix]] += ths->psi[ix] * (*fj); \
+  INT l0, l1; \
+ \
+  for (l0 = 0; l0 < count; l0++) \
+  { \
+    const INT i0 = SIMD_WRAP(u0 + l0, n0) * n1; \
+    const C f0 = psij_const0[l0] * f; \
+ \
+    for (l1 = 0; l1 <= 2 * m + 1; l1++) \
+    { \
+      C *gj = g + (i0 + SIMD_WRAP(u1 + l1, n1)) * n2; \
+      const C a = psij_const1[l1] * f0; \
+      row_axpy_ ## isa(gj + u2, psij_const2, a, r2); \
+      if (r2 < 2 * m + 2) \
+        row_axpy_ ## isa(gj, psij_const2 + r2, a, 2 * m + 2 - r2); \
+    } \
+  } \
 }
 
-#define MACRO_B_compute_A \
+/** Three-dimensional adjoint for one node, see nfft_adjoint_3d_compute_serial.
+ */
+#define MACRO_nfft_adjoint_3d_compute_serial_simd(isa, TARGET) \
+static TARGET void nfft_adjoint_3d_compute_serial_ ## isa(const C *fj, C *g, \
+    const R *psij_const0, const R *psij_const1, const R *psij_const2, \
+    const R *xj0, const R *xj1, const R *xj2, const INT n0, const INT n1, \
+    const INT n2, const INT m) \
 { \
-  ths->f[j] += phi_prod[ths->d] * ths->g[ll_plain[ths->d]]; \
+  INT u0, o0, u1, o1, u2, o2; \
+ \
+  uo2(&u0, &o0, *xj0, n0, m); \
+  uo2(&u1, &o1, *xj1, n1, m); \
+  uo2(&u2, &o2, *xj2, n2, m); \
+ \
+  nfft_adjoint_3d_planes_ ## isa(*fj, g, psij_const0, psij_const1, \
+    psij_const2, u0, 2 * m + 2, n0, n1, n2, u1, u2, SIMD_RUN(u2, o2, m), m); \
 }
 
-#define MACRO_B_compute_T \
+/** Three-dimensional adjoint for one node restricted to the planes
+ * my_u0,...,my_o0, see nfft_adjoint_3d_compute_omp_blockwise. */
+#define MACRO_nfft_adjoint_3d_compute_omp_blockwise_simd(isa, TARGET) \
+static TARGET void nfft_adjoint_3d_compute_omp_blockwise_ ## isa(const C f, \
+    C *g, const R *psij_const0, const R *psij_const1, const R *psij_const2, \
+    const R *xj0, const R *xj1, const R *xj2, const INT n0, const INT n1, \
+    const INT n2, const INT m, const INT my_u0, const INT my_o0) \
 { \
-  ths->g[ll_plain[ths->d]] += phi_prod[ths->d] * ths->f[j]; \
+  INT ar_u0, ar_o0, u0, o0, u1, o1, u2, o2, r2, offset_psij; \
+ \
+  uo2(&ar_u0, &ar_o0, *xj0, n0, m); \
+  uo2(&u1, &o1, *xj1, n1, m); \
+  uo2(&u2, &o2, *xj2, n2, m); \
+  r2 = SIMD_RUN(u2, o2, m); \
+ \
+  u0 = MAX(my_u0, ar_u0); \
+  o0 = (ar_u0 < ar_o0) ? MIN(my_o0, ar_o0) : my_o0; \
+  offset_psij = u0 - ar_u0; \
+ \
+  nfft_adjoint_3d_planes_ ## isa(f, g, psij_const0 + offset_psij, \
+    psij_const1, psij_const2, u0, o0 - u0 + 1, n0, n1, n2, u1, u2, r2, m); \
+ \
+  if (ar_u0 >= ar_o0) \
+  { \
+    offset_psij += my_u0 - ar_u0 + n0; \
+    u0 = my_u0; \
+    o0 = MIN(my_o0, ar_o0); \
+    nfft_adjoint_3d_planes_ ## isa(f, g, psij_const0 + offset_psij, \
+      psij_const1, psij_const2, u0, o0 - u0 + 1, n0, n1, n2, u1, u2, r2, m); \
+  } \
 }
 
-#define MACRO_with_FG_PSI fg_psi[t2][lj[t2]]
+MACRO_nfft_trafo_2d_compute_simd(avx2, TARGET_AVX2)
+MACRO_nfft_trafo_2d_compute_simd(avx512, TARGET_AVX512)
+MACRO_nfft_adjoint_2d_rows_simd(avx2, TARGET_AVX2)
+MACRO_nfft_adjoint_2d_rows_simd(avx512, TARGET_AVX512)
+MACRO_nfft_trafo_3d_compute_simd(avx2, TARGET_AVX2)
+MACRO_nfft_trafo_3d_compute_simd(avx512, TARGET_AVX512)
+MACRO_nfft_adjoint_3d_planes_simd(avx2, TARGET_AVX2)
+MACRO_nfft_adjoint_3d_planes_simd(avx512, TARGET_AVX512)
+#ifdef _OPENMP
+MACRO_nfft_adjoint_2d_compute_omp_blockwise_simd(avx2, TARGET_AVX2)
+MACRO_nfft_adjoint_2d_compute_omp_blockwise_simd(avx512, TARGET_AVX512)
+MACRO_nfft_adjoint_3d_compute_omp_blockwise_simd(avx2, TARGET_AVX2)
+MACRO_nfft_adjoint_3d_compute_omp_blockwise_simd(avx512, TARGET_AVX512)
+#else
+MACRO_nfft_adjoint_2d_compute_serial_simd(avx2, TARGET_AVX2)
+MACRO_nfft_adjoint_2d_compute_serial_simd(avx512, TARGET_AVX512)
+MACRO_nfft_adjoint_3d_compute_serial_simd(avx2, TARGET_AVX2)
+MACRO_nfft_adjoint_3d_compute_serial_simd(avx512, TARGET_AVX512)
+#endif
+#endif /* NFFT_SIMD */
 
-#define MACRO_with_PRE_PSI ths->psi[(j*ths->d+t2) * (2*ths->m+2)+lj[t2]]
+int Y(simd_select)(const int isa)
+{
+#ifdef NFFT_SIMD
+  const int max = simd_detect();
 
-#define MACRO_without_PRE_PSI_improved psij_const[t2 * (2*ths->m+2) + lj[t2]]
+#ifdef _OPENMP
+  #pragma omp critical (nfft_omp_critical_simd)
+#endif
+  simd_isa = (isa < 0) ? max : MIN(isa, max);
 
-#define MACRO_without_PRE_PSI  PHI(ths->n[t2], ths->x[j*ths->d+t2] \
-  - ((R) (lj[t2]+u[t2]))/((R)ths->n[t2]), t2)
+  return simd_isa;
+#else
+  UNUSED(isa);
+  return SIMD_NONE;
+#endif
+}
 
-#define MACRO_init_uo_l_lj_t \
-INT l_all[ths->d*(2*ths->m+2)]; \
+#define MACRO_D_compute_A \
 { \
-  for (t = ths->d-1; t >= 0; t--) \
+  g_hat[k_plain[ths->d]] = f_hat[ks_plain[ths->d]] * c_phi_inv_k[ths->d]; \
+}
+
+#define MACRO_D_compute_T \
+{ \
+  f_hat[ks_plain[ths->d]] = g_hat[k_plain[ths->d]] * c_phi_inv_k[ths->d]; \
+}
+
+#define MACRO_D_init_result_A nfft_zero(ths, g_hat, (size_t)(ths->n_total) * sizeof(C));
+
+#define MACRO_D_init_result_T nfft_zero(ths, f_hat, (size_t)(ths->N_total) * sizeof(C));
+
+#define MACRO_with_PRE_PHI_HUT * ths->c_phi_inv[t2][ks[t2]];
+
+#define MACRO_init_k_ks \
+{ \
+  for (t = ths->d-1; 0 <= t; t--) \
   { \
-    uo(ths,j,&u[t],&o[t],t); \
-    INT lj_t; \
-    for (lj_t = 0; lj_t < 2*ths->m+2; lj_t++) \
-      l_all[t*(2*ths->m+2) + lj_t] = (u[t] + lj_t + ths->n[t]) % ths->n[t]; \
-    lj[t] = 0; \
+    kp[t] = k[t] = 0; \
+    ks[t] = ths->N[t]/2; \
   } \
   t++; \
 }
 
-#define MACRO_update_phi_prod_ll_plain(which_one) { \
+#define MACRO_update_c_phi_inv_k(which_one) \
+{ \
   for (t2 = t; t2 < ths->d; t2++) \
-    { \
-      phi_prod[t2+1] = phi_prod[t2] * MACRO_ ## which_one; \
-      ll_plain[t2+1] = ll_plain[t2] * ths->n[t2] + l_all[t2*(2*ths->m+2) + lj[t2]]; \
-    } \
+  { \
+    c_phi_inv_k[t2+1] = c_phi_inv_k[t2] MACRO_ ##which_one; \
+    ks_plain[t2+1] = ks_plain[t2]*ths->N[t2] + ks[t2]; \
+    k_plain[t2+1] = k_plain[t2]*ths->n[t2] + k[t2]; \
+  } \
 }
 
-#define MACRO_count_uo_l_lj_t \
+#define MACRO_count_k_ks \
 { \
-  for (t = ths->d-1; (t > 0) && (lj[t] == o[t]-u[t]); t--) \
+  for (t = ths->d-1; (t > 0) && (kp[t] == ths->N[t]-1); t--) \
   { \
-    lj[t] = 0; \
+    kp[t] = k[t] = 0; \
+    ks[t]= ths->N[t]/2; \
   } \
+\
+  kp[t]++; k[t]++; ks[t]++; \
+  if(kp[t] == ths->N[t]/2) \
+  { \
+    k[t] = ths->n[t] - ths->N[t]/2; \
+    ks[t] = 0; \
+  } \
+} \
+
+/* sub routines for the fast transforms  matrix vector multiplication with D, D^T */
+#define MACRO_D(which_one) \
+static inline void D_serial_ ## which_one (X(plan) *ths) \
+{ \
+  C *f_hat, *g_hat; /* local copy */ \
+  R c_phi_inv_k[ths->d+1]; /* postfix product of PHI_HUT */ \
+  INT t, t2; /* index dimensions */ \
+  INT k_L; /* plain index */ \
+  INT kp[ths->d]; /* multi index (simple) */ \
+  INT k[ths->d]; /* multi index in g_hat */ \
+  INT ks[ths->d]; /* multi index in f_hat, c_phi_inv*/ \
+  INT k_plain[ths->d+1]; /* postfix plain index */ \
+  INT ks_plain[ths->d+1]; /* postfix plain index */ \
  \
-  lj[t]++; \
+  f_hat = (C*)ths->f_hat; g_hat = (C*)ths->g_hat; \
+  MACRO_D_init_result_ ## which_one; \
+\
+  c_phi_inv_k[0] = K(1.0); \
+  k_plain[0] = 0; \
+  ks_plain[0] = 0; \
+\
+  MACRO_init_k_ks; \
+\
+  for (k_L = 0; k_L < ths->N_total; k_L++) \
+  { \
+    MACRO_update_c_phi_inv_k(with_PRE_PHI_HUT); \
+    MACRO_D_compute_ ## which_one; \
+    MACRO_count_k_ks; \
+  } \
 }
 
-#define MACRO_COMPUTE_with_PRE_PSI MACRO_with_PRE_PSI
-#define MACRO_COMPUTE_with_PRE_FG_PSI MACRO_with_FG_PSI
-#define MACRO_COMPUTE_with_FG_PSI MACRO_with_FG_PSI
-#define MACRO_COMPUTE_with_PRE_LIN_PSI MACRO_with_FG_PSI
-#define MACRO_COMPUTE_without_PRE_PSI MACRO_without_PRE_PSI_improved
-#define MACRO_COMPUTE_without_PRE_PSI_improved MACRO_without_PRE_PSI_improved
+#ifdef _OPENMP
+static inline void D_openmp_A(X(plan) *ths)
+{
+  C *f_hat, *g_hat;                     /**< local copy                     */
+  INT k_L;                              /**< plain index                    */
 
-#define MACRO_B_COMPUTE_ONE_NODE(whichone_AT,whichone_FLAGS) \
-      if (ths->d == 4) \
-      { \
-        INT l0, l1, l2, l3; \
-        for (l0 = 0; l0 < 2*ths->m+2; l0++) \
-        { \
-          lj[0] = l0; \
-          t2 = 0; \
-          phi_prod[t2+1] = phi_prod[t2] * MACRO_COMPUTE_ ## whichone_FLAGS; \
-          ll_plain[t2+1] = ll_plain[t2] * ths->n[t2] + l_all[t2*(2*ths->m+2) + lj[t2]]; \
-          for (l1 = 0; l1 < 2*ths->m+2; l1++) \
-          { \
-            lj[1] = l1; \
-            t2 = 1; \
-            phi_prod[t2+1] = phi_prod[t2] * MACRO_COMPUTE_ ## whichone_FLAGS; \
-            ll_plain[t2+1] = ll_plain[t2] * ths->n[t2] + l_all[t2*(2*ths->m+2) + lj[t2]]; \
-            for (l2 = 0; l2 < 2*ths->m+2; l2++) \
-            { \
-              lj[2] = l2; \
-              t2 = 2; \
-              phi_prod[t2+1] = phi_prod[t2] * MACRO_COMPUTE_ ## whichone_FLAGS; \
-              ll_plain[t2+1] = ll_plain[t2] * ths->n[t2] + l_all[t2*(2*ths->m+2) + lj[t2]]; \
-              for (l3 = 0; l3 < 2*ths->m+2; l3++) \
-              { \
-                lj[3] = l3; \
-                t2 = 3; \
-                phi_prod[t2+1] = phi_prod[t2] * MACRO_COMPUTE_ ## whichone_FLAGS; \
+  f_hat = (C*)ths->f_hat; g_hat = (C*)ths->g_hat;
+  nfft_zero(ths, g_hat, ths->n_total * sizeof(C));
+
+  #pragma omp parallel for default(shared) private(k_L) num_threads(ths->nthreads)
+  for (k_L = 0; k_L < ths->N_total; k_L++)
+  {
+    INT kp[ths->d];                       /**< multi index (simple)           */ //0..N-1
+    INT k[ths->d];                        /**< multi index in g_hat           */
+    INT ks[ths->d];                       /**< multi index in f_hat, c_phi_inv*/
+    R c_phi_inv_k_val = K(1.0);
+    INT k_plain_val = 0;
+    INT ks_plain_val = 0;
+    INT t;
+    INT k_temp = k_L;
+
+    for (t = ths->d-1; t >= 0; t--)
+    {
+      kp[t] = k_temp % ths->N[t];
+      if (kp[t] >= ths->N[t]/2)
+        k[t] = ths->n[t] - ths->N[t] + kp[t];
+      else
+        k[t] = kp[t];
+      ks[t] = (kp[t] + ths->N[t]/2) % ths->N[t];
+      k_temp /= ths->N[t];
+    }
+
+    for (t = 0; t < ths->d; t++)
+    {
+      c_phi_inv_k_val *= ths->c_phi_inv[t][ks[t]];
+      ks_plain_val = ks_plain_val*ths->N[t] + ks[t];
+      k_plain_val = k_plain_val*ths->n[t] + k[t];
+    }
+
+    g_hat[k_plain_val] = f_hat[ks_plain_val] * c_phi_inv_k_val;
+  } /* for(k_L) */
+}
+#endif
+
+#ifndef _OPENMP
+MACRO_D(A)
+#endif
+
+static inline void D_A(X(plan) *ths)
+{
+#ifdef _OPENMP
+  D_openmp_A(ths);
+#else
+  D_serial_A(ths);
+#endif
+}
+
+#ifdef _OPENMP
+static void D_openmp_T(X(plan) *ths)
+{
+  C *f_hat, *g_hat;                     /**< local copy                     */
+  INT k_L;                              /**< plain index                    */
+
+  f_hat = (C*)ths->f_hat; g_hat = (C*)ths->g_hat;
+  nfft_zero(ths, f_hat, ths->N_total * sizeof(C));
+
+  #pragma omp parallel for default(shared) private(k_L) num_threads(ths->nthreads)
+  for (k_L = 0; k_L < ths->N_total; k_L++)
+  {
+    INT kp[ths->d];                       /**< multi index (simple)           */ //0..N-1
+    INT k[ths->d];                        /**< multi index in g_hat           */
+    INT ks[ths->d];                       /**< multi index in f_hat, c_phi_inv*/
+    R c_phi_inv_k_val = K(1.0);
+    INT k_plain_val = 0;
+    INT ks_plain_val = 0;
+    INT t;
+    INT k_temp = k_L;
+
+    for (t = ths->d - 1; t >= 0; t--)
+    {
+      kp[t] = k_temp % ths->N[t];
+      if (kp[t] >= ths->N[t]/2)
+        k[t] = ths->n[t] - ths->N[t] + kp[t];
+      else
+        k[t] = kp[t];
+      ks[t] = (kp[t] + ths->N[t]/2) % ths->N[t];
+      k_temp /= ths->N[t];
+    }
+
+    for (t = 0; t < ths->d; t++)
+    {
+      c_phi_inv_k_val *= ths->c_phi_inv[t][ks[t]];
+      ks_plain_val = ks_plain_val*ths->N[t] + ks[t];
+      k_plain_val = k_plain_val*ths->n[t] + k[t];
+    }
+
+    f_hat[ks_plain_val] = g_hat[k_plain_val] * c_phi_inv_k_val;
+  } /* for(k_L) */
+}
+#endif
+
+#ifndef _OPENMP
+MACRO_D(T)
+#endif
+
+static void D_T(X(plan) *ths)
+{
+#ifdef _OPENMP
+  D_openmp_T(ths);
+#else
+  D_serial_T(ths);
+#endif
+}
+
+/* Pruned FFT, flag NFFT_PRUNED_FFT.
+ *
+ * Only N_t of the n_t indices of g_hat are nonzero in each dimension t, i.e.
+ * 0,...,N_t/2-1 and n_t-N_t/2,...,n_t-1. The d-variate FFT is computed
+ * dimension by dimension in place in g1. The trafo starts with the last
+ * dimension and transforms only the lines whose indices in the preceding
+ * dimensions are nonzero, all other lines are zero. The adjoint starts with
+ * the first dimension and transforms only the lines that contribute to the
+ * N_total coefficients read by D. For the last dimension, N_{d-2}/2
+ * consecutive rows are done by a single plan. */
+
+/** Offset in g of the c-th combination of nonzero indices in the dimensions
+ *  0,...,p-1. */
+static INT nfft_pruned_offset(const X(plan) *ths, const INT *stride,
+  const INT p, INT c)
+{
+  INT s, off = 0;
+
+  for (s = p - 1; s >= 0; s--)
+  {
+    const INT k = c % ths->N[s];
+    c /= ths->N[s];
+    off += (k < ths->N[s]/2 ? k : ths->n[s] - ths->N[s] + k) * stride[s];
+  }
+
+  return off;
+}
+
+static void nfft_fftw_pruned(const X(plan) *ths, FFTW(plan) *plans,
+  const int adjoint)
+{
+  const INT d = ths->d;
+  INT stride[d], s, t, p, c, c_max;
+
+  for (t = d - 1, stride[d-1] = 1; t > 0; t--)
+    stride[t-1] = stride[t] * ths->n[t];
+
+  for (s = 0; s < d; s++)
+  {
+    t = adjoint ? s : d - 1 - s;
+    p = (t == d - 1) ? d - 2 : t;
+    c_max = intprod(ths->N, 0, p);
+
+    for (c = 0; c < c_max; c++)
+    {
+      C *g = ths->g1 + nfft_pruned_offset(ths, stride, p, c);
+
+      if (t == d - 1)
+      {
+        /* rows n_{d-2}-N_{d-2}/2,... and 0,... */
+        C *g2 = g + (ths->n[d-2] - ths->N[d-2]/2) * stride[d-2];
+        FFTW(execute_dft)(plans[t], g2, g2);
+        FFTW(execute_dft)(plans[t], g, g);
+      }
+      else
+        FFTW(execute_dft)(plans[t], g, g);
+    }
+  }
+}
+
+static void nfft_fftw_execute_A(X(plan) *ths)
+{
+  if (ths->flags & NFFT_PRUNED_FFT)
+    nfft_fftw_pruned(ths, ths->my_fftw_plan1_pruned, 0);
+  else
+    FFTW(execute)(ths->my_fftw_plan1);
+}
+
+static void nfft_fftw_execute_T(X(plan) *ths)
+{
+  if (ths->flags & NFFT_PRUNED_FFT)
+    nfft_fftw_pruned(ths, ths->my_fftw_plan2_pruned, 1);
+  else
+    FFTW(execute)(ths->my_fftw_plan2);
+}
+
+/* sub routines for the fast transforms matrix vector multiplication with B, B^T */
+#define MACRO_B_init_result_A nfft_zero(ths, ths->f, (size_t)(ths->M_total) * sizeof(C));
+#define MACRO_B_init_result_T nfft_zero(ths, ths->g, (size_t)(ths->n_total) * sizeof(C));
+
+#define MACRO_B_PRE_FULL_PSI_compute_A \
+{ \
+  (*fj) += ths->psi[ix] * g[ths->psi_index_g[ix]]; \
+}
+
+#define MACRO_B_PRE_FULL_PSI_compute_T \
+{ \
+  g[ths->psi_index_g[ix]] += ths->psi[ix] * (*fj); \
+}
+
+#define MACRO_B_compute_A \
+{ \
+  ths->f[j] += phi_prod[ths->d] * ths->g[ll_plain[ths->d]]; \
+}
+
+#define MACRO_B_compute_T \
+{ \
+  ths->g[ll_plain[ths->d]] += phi_prod[ths->d] * ths->f[j]; \
+}
+
+#define MACRO_with_FG_PSI fg_psi[t2][lj[t2]]
+
+#define MACRO_with_PRE_PSI ths->psi[(j*ths->d+t2) * (2*ths->m+2)+lj[t2]]
+
+#define MACRO_without_PRE_PSI_improved psij_const[t2 * (2*ths->m+2) + lj[t2]]
+
+#define MACRO_init_uo_l_lj_t \
+INT l_all[ths->d*(2*ths->m+2)]; \
+{ \
+  for (t = ths->d-1; t >= 0; t--) \
+  { \
+    uo(ths,j,&u[t],&o[t],t); \
+    INT lj_t; \
+    for (lj_t = 0; lj_t < 2*ths->m+2; lj_t++) \
+      l_all[t*(2*ths->m+2) + lj_t] = (u[t] + lj_t + ths->n[t]) % ths->n[t]; \
+    lj[t] = 0; \
+  } \
+  t++; \
+}
+
+#define MACRO_update_phi_prod_ll_plain(which_one) { \
+  for (t2 = t; t2 < ths->d; t2++) \
+    { \
+      phi_prod[t2+1] = phi_prod[t2] * MACRO_ ## which_one; \
+      ll_plain[t2+1] = ll_plain[t2] * ths->n[t2] + l_all[t2*(2*ths->m+2) + lj[t2]]; \
+    } \
+}
+
+#define MACRO_count_uo_l_lj_t \
+{ \
+  for (t = ths->d-1; (t > 0) && (lj[t] == o[t]-u[t]); t--) \
+  { \
+    lj[t] = 0; \
+  } \
+ \
+  lj[t]++; \
+}
+
+#define MACRO_COMPUTE_with_PRE_PSI MACRO_with_PRE_PSI
+#define MACRO_COMPUTE_with_PRE_FG_PSI MACRO_with_FG_PSI
+#define MACRO_COMPUTE_with_FG_PSI MACRO_with_FG_PSI
+#define MACRO_COMPUTE_with_PRE_LIN_PSI MACRO_with_FG_PSI
+#define MACRO_COMPUTE_without_PRE_PSI MACRO_without_PRE_PSI_improved
+#define MACRO_COMPUTE_without_PRE_PSI_improved MACRO_without_PRE_PSI_improved
+
+#define MACRO_B_COMPUTE_ONE_NODE(whichone_AT,whichone_FLAGS) \
+      if (ths->d == 4) \
+      { \
+        INT l0, l1, l2, l3; \
+        for (l0 = 0; l0 < 2*ths->m+2; l0++) \
+        { \
+          lj[0] = l0; \
+          t2 = 0; \
+          phi_prod[t2+1] = phi_prod[t2] * MACRO_COMPUTE_ ## whichone_FLAGS; \
+          ll_plain[t2+1] = ll_plain[t2] * ths->n[t2] + l_all[t2*(2*ths->m+2) + lj[t2]]; \
+          for (l1 = 0; l1 < 2*ths->m+2; l1++) \
+          { \
+            lj[1] = l1; \
+            t2 = 1; \
+            phi_prod[t2+1] = phi_prod[t2] * MACRO_COMPUTE_ ## whichone_FLAGS; \
+            ll_plain[t2+1] = ll_plain[t2] * ths->n[t2] + l_all[t2*(2*ths->m+2) + lj[t2]]; \
+            for (l2 = 0; l2 < 2*ths->m+2; l2++) \
+            { \
+              lj[2] = l2; \
+              t2 = 2; \
+              phi_prod[t2+1] = phi_prod[t2] * MACRO_COMPUTE_ ## whichone_FLAGS; \
+              ll_plain[t2+1] = ll_plain[t2] * ths->n[t2] + l_all[t2*(2*ths->m+2) + lj[t2]]; \
+              for (l3 = 0; l3 < 2*ths->m+2; l3++) \
+              { \
+                lj[3] = l3; \
+                t2 = 3; \
+                phi_prod[t2+1] = phi_prod[t2] * MACRO_COMPUTE_ ## whichone_FLAGS; \
                 ll_plain[t2+1] = ll_plain[t2] * ths->n[t2] + l_all[t2*(2*ths->m+2) + lj[t2]]; \
  \
                 MACRO_B_compute_ ## whichone_AT; \
@@ -856,7 +1628,7 @@ static inline void B_serial_ ## which_one (X(plan) *ths) \
       tmp2 = K(1.0); \
       tmp3 = K(1.0); \
       fg_exp_l[t2][0] = K(1.0); \
-      for (lj_fg = 1; lj_fg <= (2 * ths->m + 2); lj_fg++) \
+      for (lj_fg = 1; lj_fg < (2 * ths->m + 2); lj_fg++) \
       { \
         tmp3 = tmp2*tmpEXP2; \
         tmp2 *= tmpEXP2sq; \
@@ -897,7 +1669,7 @@ static inline void B_serial_ ## which_one (X(plan) *ths) \
       tmp2 = K(1.0); \
       tmp3 = K(1.0); \
       fg_exp_l[t2][0] = K(1.0); \
-      for (lj_fg = 1; lj_fg <= (2*ths->m+2); lj_fg++) \
+      for (lj_fg = 1; lj_fg < (2*ths->m+2); lj_fg++) \
       { \
         tmp3 = tmp2*tmpEXP2; \
         tmp2 *= tmpEXP2sq; \
@@ -970,12 +1742,8 @@ static inline void B_serial_ ## which_one (X(plan) *ths) \
     MACRO_init_uo_l_lj_t; \
  \
     for (t2 = 0; t2 < ths->d; t2++) \
-    { \
-      INT lj_t; \
-      for (lj_t = 0; lj_t < 2*ths->m+2; lj_t++) \
-        psij_const[t2 * (2*ths->m+2) + lj_t] = PHI(ths->n[t2], ths->x[j*ths->d+t2] \
-                - ((R) (lj_t+u[t2]))/((R)ths->n[t2]), t2); \
-    } \
+      window_psij(ths, t2, ths->x[j*ths->d+t2], u[t2], \
+        &psij_const[t2 * (2*ths->m+2)]); \
  \
     MACRO_B_COMPUTE_ONE_NODE(which_one,without_PRE_PSI_improved); \
   } /* for(j) */ \
@@ -999,7 +1767,7 @@ MACRO_B(A)
       R tmp2 = K(1.0); \
       R tmp3 = K(1.0); \
       fg_exp_l[t2][0] = K(1.0); \
-      for(lj_fg = 1; lj_fg <= (2*ths->m+2); lj_fg++) \
+      for(lj_fg = 1; lj_fg < (2*ths->m+2); lj_fg++) \
       { \
         tmp3 = tmp2*tmpEXP2; \
         tmp2 *= tmpEXP2sq; \
@@ -1057,12 +1825,8 @@ MACRO_B(A)
 
 #define MACRO_B_openmp_A_COMPUTE_BEFORE_LOOP_without_PRE_PSI \
     for (t2 = 0; t2 < ths->d; t2++) \
-    { \
-      INT lj_t; \
-      for (lj_t = 0; lj_t < 2*ths->m+2; lj_t++) \
-        psij_const[t2 * (2*ths->m+2) + lj_t] = PHI(ths->n[t2], ths->x[j*ths->d+t2] \
-                - ((R) (lj_t+u[t2]))/((R)ths->n[t2]), t2); \
-    }
+      window_psij(ths, t2, ths->x[j*ths->d+t2], u[t2], \
+        &psij_const[t2 * (2*ths->m+2)]);
 #define MACRO_B_openmp_A_COMPUTE_UPDATE_without_PRE_PSI \
   MACRO_update_phi_prod_ll_plain(without_PRE_PSI_improved);
 
@@ -1174,14 +1938,14 @@ static inline void B_openmp_A (X(plan) *ths)
   INT lprod; /* 'regular bandwidth' of matrix B  */
   INT k;
 
-  memset(ths->f, 0, ths->M_total * sizeof(C));
+  nfft_zero(ths, ths->f, ths->M_total * sizeof(C));
 
   for (k = 0, lprod = 1; k < ths->d; k++)
     lprod *= (2*ths->m+2);
 
   if (ths->flags & PRE_FULL_PSI)
   {
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
     for (k = 0; k < ths->M_total; k++)
     {
       INT l;
@@ -1195,7 +1959,7 @@ static inline void B_openmp_A (X(plan) *ths)
 
   if (ths->flags & PRE_PSI)
   {
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
     for (k = 0; k < ths->M_total; k++)
     {
       INT t, t2; /* index dimensions */
@@ -1211,7 +1975,7 @@ static inline void B_openmp_A (X(plan) *ths)
 
     MACRO_B_openmp_A_COMPUTE_INIT_FG_PSI
 
-    #pragma omp parallel for default(shared) private(k,t,t2)
+    #pragma omp parallel for default(shared) private(k,t,t2) num_threads(ths->nthreads)
     for (k = 0; k < ths->M_total; k++)
     {
       R fg_psi[ths->d][2*ths->m+2];
@@ -1232,7 +1996,7 @@ static inline void B_openmp_A (X(plan) *ths)
 
     MACRO_B_openmp_A_COMPUTE_INIT_FG_PSI
 
-    #pragma omp parallel for default(shared) private(k,t,t2)
+    #pragma omp parallel for default(shared) private(k,t,t2) num_threads(ths->nthreads)
     for (k = 0; k < ths->M_total; k++)
     {
       R fg_psi[ths->d][2*ths->m+2];
@@ -1248,7 +2012,7 @@ static inline void B_openmp_A (X(plan) *ths)
   {
     sort(ths);
 
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
     for (k = 0; k<ths->M_total; k++)
     {
       INT t, t2; /* index dimensions */
@@ -1267,7 +2031,7 @@ static inline void B_openmp_A (X(plan) *ths)
   /* no precomputed psi at all */
   sort(ths);
 
-  #pragma omp parallel for default(shared) private(k)
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
   for (k = 0; k < ths->M_total; k++)
   {
     INT t, t2; /* index dimensions */
@@ -1278,53 +2042,453 @@ static inline void B_openmp_A (X(plan) *ths)
 }
 #endif
 
-static void B_A(X(plan) *ths)
+/** computes the factors fg_exp_l used by FG_PSI and PRE_FG_PSI */
+static void nfft_B_init_fg_exp_l(const X(plan) *ths, R *fg_exp_l)
 {
-#ifdef _OPENMP
-  B_openmp_A(ths);
-#else
-  B_serial_A(ths);
-#endif
+  const INT l_max = 2*ths->m+2;
+  INT t2, lj;
+  R tmpEXP2, tmpEXP2sq, tmp2, tmp3;
+
+  for (t2 = 0; t2 < ths->d; t2++)
+  {
+    tmpEXP2 = EXP(K(-1.0) / ths->b[t2]);
+    tmpEXP2sq = tmpEXP2*tmpEXP2;
+    tmp2 = K(1.0);
+    fg_exp_l[t2*l_max] = K(1.0);
+    for (lj = 1; lj < l_max; lj++)
+    {
+      tmp3 = tmp2*tmpEXP2;
+      tmp2 *= tmpEXP2sq;
+      fg_exp_l[t2*l_max+lj] = fg_exp_l[t2*l_max+lj-1] * tmp3;
+    }
+  }
 }
 
-#ifdef _OPENMP
-/**
- * Performs binary search in sorted index array and returns the offset of the
- * specified key.
- * If the key is not unique, the index of the left-most element with the
- * requested key is returned.
- * If the index array does not contain the key, the index of the next-largest
- * element is returned.
- *
- * \arg ar_x sorted index array containing the key at offset 2*k
- * and the nodes index at offset 2*k+1
- * \arg len number of nodes x
- * \arg key the key value
+/* Mixed precision, flag NFFT_MIXED_PRECISION.
  *
- * \author Toni Volkmer
- */
-static inline INT index_x_binary_search(const INT *ar_x, const INT len, const INT key)
+ * The window values of PRE_PSI are stored in single precision in psi_single
+ * and the products and sums of the sparse matrix B are formed in single
+ * precision, while g, the FFT and the matrix D stay in the precision of the
+ * plan. The window values are divided by the value at the centre, e.g. about
+ * 1e16 for the Kaiser-Bessel window with m=8, since their products would
+ * overflow a float already for d=3; g is scaled by the product of these
+ * factors in turn. The 2m+2 taps of the last dimension are contiguous in g up
+ * to one wraparound, the taps of the other dimensions are enumerated row by
+ * row. */
+
+/** Factor of the single precision window values of dimension t. */
+static R nfft_mixed_scale(const X(plan) *ths, const INT t)
 {
-  INT left = 0, right = len - 1;
+  const R s = PHI(ths->n[t], K(0.0), t);
+  return (s > K(0.0) && isfinite(s)) ? s : K(1.0);
+}
 
-  if (len == 1)
-    return 0;
+/** Product of the factors of all dimensions. */
+static R nfft_mixed_scale_prod(const X(plan) *ths)
+{
+  R s = K(1.0);
+  INT t;
 
-  while (left < right - 1)
+  for (t = 0; t < ths->d; t++)
+    s *= nfft_mixed_scale(ths, t);
+
+  return s;
+}
+
+/** Offset in g of the row given by the taps idx[0..d-2] of the first d-1
+ *  dimensions, u being the first grid index of the node. */
+static INT nfft_B_row(const X(plan) *ths, const INT *u, const INT *idx)
+{
+  INT t, off = 0;
+
+  for (t = 0; t < ths->d - 1; t++)
+    off = off * ths->n[t] + (u[t] + idx[t]) % ths->n[t];
+
+  return off * ths->n[ths->d - 1];
+}
+
+/** Window product of the current row, in single precision. */
+static float nfft_mixed_weight(const float *psij, const INT d, const INT l_max,
+  const INT *idx)
+{
+  INT t;
+  float w = 1.0f;
+
+  for (t = 0; t < d - 1; t++)
+    w *= psij[t * l_max + idx[t]];
+
+  return w;
+}
+
+/** Advances the taps idx[0..d-2] to the next row, returns 0 after the last. */
+static int nfft_B_next_row(INT *idx, const INT d, const INT l_max)
+{
+  INT t;
+
+  for (t = d - 2; t >= 0; t--)
   {
-    INT i = (left + right) / 2;
-    if (ar_x[2*i] >= key)
-      right = i;
-    else if (ar_x[2*i] < key)
-      left = i;
+    if (++idx[t] < l_max)
+      return 1;
+    idx[t] = 0;
   }
 
-  if (ar_x[2*left] < key && left != len-1)
-    return left+1;
-
-  return left;
+  return 0;
 }
-#endif
+
+static void nfft_trafo_B_mixed(X(plan) *ths)
+{
+  const INT d = ths->d, M = ths->M_total, l_max = 2*ths->m+2;
+  const INT n_last = ths->n[d-1];
+  const R *g = (const R*) ths->g;
+  const R scale = nfft_mixed_scale_prod(ths);
+  INT k;
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+#endif
+  for (k = 0; k < M; k++)
+  {
+    const INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
+    const float *psij = ths->psi_single + j * d * l_max;
+    const float *psi_last = psij + (d-1) * l_max;
+    INT u[d], idx[d], t, o, len0;
+    float f_re = 0.0f, f_im = 0.0f;
+
+    for (t = 0; t < d; t++)
+    {
+      uo(ths, j, &u[t], &o, t);
+      u[t] = (u[t] + ths->n[t]) % ths->n[t];
+      idx[t] = 0;
+    }
+
+    len0 = MIN(l_max, n_last - u[d-1]);
+
+    do
+    {
+      const R *gr = g + 2 * nfft_B_row(ths, u, idx);
+      const float w = nfft_mixed_weight(psij, d, l_max, idx);
+      float r_re = 0.0f, r_im = 0.0f;
+      INT l;
+
+      for (l = 0; l < len0; l++)
+      {
+        r_re += psi_last[l] * (float)(gr[2 * (u[d-1] + l)] * scale);
+        r_im += psi_last[l] * (float)(gr[2 * (u[d-1] + l) + 1] * scale);
+      }
+
+      for (l = len0; l < l_max; l++)
+      {
+        r_re += psi_last[l] * (float)(gr[2 * (l - len0)] * scale);
+        r_im += psi_last[l] * (float)(gr[2 * (l - len0) + 1] * scale);
+      }
+
+      f_re += w * r_re;
+      f_im += w * r_im;
+    } while (nfft_B_next_row(idx, d, l_max));
+
+    ths->f[j] = (R)(f_re) + II * (R)(f_im);
+  }
+}
+
+/** Adds the rows of node j to g whose index in the first dimension lies in
+ *  [i0_lo, i0_hi], with atomic operations if atomic is set. The scale *par is
+ *  applied once per row to the single precision product of the weight and
+ *  f_j. */
+static void nfft_adjoint_B_mixed_node(X(plan) *ths, const INT j, const R *par,
+  const INT i0_lo, const INT i0_hi, const int atomic)
+{
+  const INT d = ths->d, l_max = 2*ths->m+2;
+  const R scale = *par;
+  const INT n_last = ths->n[d-1];
+  R *g = (R*) ths->g;
+  const float *psij = ths->psi_single + j * d * l_max;
+  const float *psi_last = psij + (d-1) * l_max;
+  const float f_re = (float)(CREAL(ths->f[j]));
+  const float f_im = (float)(CIMAG(ths->f[j]));
+  INT u[d], idx[d], t, o, len0;
+
+  UNUSED(atomic);
+
+  for (t = 0; t < d; t++)
+  {
+    uo(ths, j, &u[t], &o, t);
+    u[t] = (u[t] + ths->n[t]) % ths->n[t];
+    idx[t] = 0;
+  }
+
+  len0 = MIN(l_max, n_last - u[d-1]);
+
+  do
+  {
+    R *gr = g + 2 * nfft_B_row(ths, u, idx);
+    const float w = nfft_mixed_weight(psij, d, l_max, idx);
+    const R a_re = (R)(w * f_re) * scale, a_im = (R)(w * f_im) * scale;
+    INT l;
+
+    if (d > 1 && ((u[0] + idx[0]) % ths->n[0] < i0_lo
+      || (u[0] + idx[0]) % ths->n[0] > i0_hi))
+      continue;
+
+    for (l = 0; l < l_max; l++)
+    {
+      const INT i = l < len0 ? u[d-1] + l : l - len0;
+      R *gl = gr + 2 * i;
+
+      if (d == 1 && (i < i0_lo || i > i0_hi))
+        continue;
+
+#ifdef _OPENMP
+      if (atomic)
+      {
+        #pragma omp atomic
+        gl[0] += (R)(psi_last[l]) * a_re;
+
+        #pragma omp atomic
+        gl[1] += (R)(psi_last[l]) * a_im;
+        continue;
+      }
+#endif
+      gl[0] += (R)(psi_last[l]) * a_re;
+      gl[1] += (R)(psi_last[l]) * a_im;
+    }
+  } while (nfft_B_next_row(idx, d, l_max));
+}
+
+/* Compact full precomputation, flag NFFT_COMPACT_FULL_PSI.
+ *
+ * Like PRE_FULL_PSI, psi holds the (2m+2)^d products of the window values of
+ * each node, but psi_index_g holds only the d first grid indices of the node
+ * instead of (2m+2)^d indices, the others follow from the tensor structure.
+ * The rows are enumerated as for NFFT_MIXED_PRECISION. */
+
+static void nfft_trafo_B_compact(X(plan) *ths)
+{
+  const INT d = ths->d, M = ths->M_total, l_max = 2*ths->m+2;
+  const INT n_last = ths->n[d-1];
+  INT lprod, t, k;
+
+  for (t = 0, lprod = 1; t < d; t++)
+    lprod *= l_max;
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+#endif
+  for (k = 0; k < M; k++)
+  {
+    const INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
+    const INT *u = ths->psi_index_g + j * d;
+    const R *psij = ths->psi + j * lprod;
+    const INT len0 = MIN(l_max, n_last - u[d-1]);
+    INT idx[d], l;
+    C fj = K(0.0);
+
+    for (l = 0; l < d; l++)
+      idx[l] = 0;
+
+    do
+    {
+      const C *gr = ths->g + nfft_B_row(ths, u, idx);
+
+      for (l = 0; l < len0; l++)
+        fj += psij[l] * gr[u[d-1] + l];
+
+      for (l = len0; l < l_max; l++)
+        fj += psij[l] * gr[l - len0];
+
+      psij += l_max;
+    } while (nfft_B_next_row(idx, d, l_max));
+
+    ths->f[j] = fj;
+  }
+}
+
+/** Adds the rows of node j to g whose index in the first dimension lies in
+ *  [i0_lo, i0_hi], with atomic operations if atomic is set, see
+ *  nfft_adjoint_B_mixed_node. */
+static void nfft_adjoint_B_compact_node(X(plan) *ths, const INT j,
+  const R *par, const INT i0_lo, const INT i0_hi, const int atomic)
+{
+  const INT d = ths->d, l_max = 2*ths->m+2;
+  const INT n_last = ths->n[d-1];
+  const INT *u = ths->psi_index_g + j * d;
+  const INT len0 = MIN(l_max, n_last - u[d-1]);
+  const R f_re = CREAL(ths->f[j]), f_im = CIMAG(ths->f[j]);
+  const R *psij;
+  INT lprod, idx[d], l;
+
+  UNUSED(par);
+  UNUSED(atomic);
+
+  for (l = 0, lprod = 1; l < d; l++)
+  {
+    lprod *= l_max;
+    idx[l] = 0;
+  }
+
+  psij = ths->psi + j * lprod;
+
+  do
+  {
+    R *gr = (R*)(ths->g + nfft_B_row(ths, u, idx));
+
+    if (d > 1 && ((u[0] + idx[0]) % ths->n[0] < i0_lo
+      || (u[0] + idx[0]) % ths->n[0] > i0_hi))
+    {
+      psij += l_max;
+      continue;
+    }
+
+    for (l = 0; l < l_max; l++)
+    {
+      const INT i = l < len0 ? u[d-1] + l : l - len0;
+      R *gl = gr + 2 * i;
+
+      if (d == 1 && (i < i0_lo || i > i0_hi))
+        continue;
+
+#ifdef _OPENMP
+      if (atomic)
+      {
+        #pragma omp atomic
+        gl[0] += psij[l] * f_re;
+
+        #pragma omp atomic
+        gl[1] += psij[l] * f_im;
+        continue;
+      }
+#endif
+      gl[0] += psij[l] * f_re;
+      gl[1] += psij[l] * f_im;
+    }
+
+    psij += l_max;
+  } while (nfft_B_next_row(idx, d, l_max));
+}
+
+/** evaluates the window once per node, i.e. computes the 2m+2 values
+ *  \f$\psi(x_j-l/n)\f$ in each dimension from the precomputed data at hand
+ */
+static void nfft_B_psij(const X(plan) *ths, const INT j, const INT *u,
+  const R *fg_exp_l, R *psij_const)
+{
+  const INT l_max = 2*ths->m+2;
+  INT t2, lj;
+
+  for (t2 = 0; t2 < ths->d; t2++)
+  {
+    R *psij = psij_const + t2*l_max;
+    const R xj = ths->x[j*ths->d+t2];
+
+    if (ths->flags & NFFT_MIXED_PRECISION)
+    {
+      for (lj = 0; lj < l_max; lj++)
+        psij[lj] = (R)(ths->psi_single[(j*ths->d+t2)*l_max+lj])
+          * nfft_mixed_scale(ths, t2);
+    }
+    else if (ths->flags & PRE_PSI)
+    {
+      for (lj = 0; lj < l_max; lj++)
+        psij[lj] = ths->psi[(j*ths->d+t2)*l_max+lj];
+    }
+    else if (ths->flags & (PRE_FG_PSI | FG_PSI))
+    {
+      R tmpEXP1, tmp1 = K(1.0);
+
+      if (ths->flags & PRE_FG_PSI)
+      {
+        psij[0] = ths->psi[2*(j*ths->d+t2)];
+        tmpEXP1 = ths->psi[2*(j*ths->d+t2)+1];
+      }
+      else
+      {
+        psij[0] = PHI(ths->n[t2], xj - ((R)u[t2])/((R)ths->n[t2]), t2);
+        tmpEXP1 = EXP(K(2.0) * ((R)(ths->n[t2]) * xj - (R)(u[t2])) / ths->b[t2]);
+      }
+
+      for (lj = 1; lj < l_max; lj++)
+      {
+        tmp1 *= tmpEXP1;
+        psij[lj] = psij[0]*tmp1*fg_exp_l[t2*l_max+lj];
+      }
+    }
+    else if (ths->flags & PRE_LIN_PSI)
+    {
+      const INT ip_s = ths->K/(ths->m+2);
+      const R y = (((R)(ths->n[t2]) * xj - (R)(u[t2])) * ((R)(ths->K)))
+        / (R)(ths->m+2);
+      const INT ip_u = LRINT(FLOOR(y));
+      const R ip_w = y - (R)ip_u;
+
+      for (lj = 0; lj < l_max; lj++)
+        psij[lj] = ths->psi[(ths->K+1)*t2 + ABS(ip_u-lj*ip_s)] * (K(1.0)-ip_w)
+          + ths->psi[(ths->K+1)*t2 + ABS(ip_u-lj*ip_s+1)] * ip_w;
+    }
+    else
+    {
+      window_psij(ths, t2, xj, u[t2], psij);
+    }
+  }
+}
+
+static void B_A(X(plan) *ths)
+{
+  if (ths->flags & NFFT_MIXED_PRECISION)
+  {
+    nfft_trafo_B_mixed(ths);
+    return;
+  }
+
+  if (ths->flags & NFFT_COMPACT_FULL_PSI)
+  {
+    nfft_trafo_B_compact(ths);
+    return;
+  }
+
+#ifdef _OPENMP
+  B_openmp_A(ths);
+#else
+  B_serial_A(ths);
+#endif
+}
+
+#ifdef _OPENMP
+/**
+ * Performs binary search in sorted index array and returns the offset of the
+ * specified key.
+ * If the key is not unique, the index of the left-most element with the
+ * requested key is returned.
+ * If the index array does not contain the key, the index of the next-largest
+ * element is returned.
+ *
+ * \arg ar_x sorted index array containing the key at offset 2*k
+ * and the nodes index at offset 2*k+1
+ * \arg len number of nodes x
+ * \arg key the key value
+ *
+ * \author Toni Volkmer
+ */
+static inline INT index_x_binary_search(const INT *ar_x, const INT len, const INT key)
+{
+  INT left = 0, right = len - 1;
+
+  if (len == 1)
+    return 0;
+
+  while (left < right - 1)
+  {
+    INT i = (left + right) / 2;
+    if (ar_x[2*i] >= key)
+      right = i;
+    else if (ar_x[2*i] < key)
+      left = i;
+  }
+
+  if (ar_x[2*left] < key && left != len-1)
+    return left+1;
+
+  return left;
+}
+#endif
 
 #ifdef _OPENMP
 /**
@@ -1425,12 +2589,13 @@ static void nfft_adjoint_B_omp_blockwise_init(INT *my_u0, INT *my_o0,
  * Parallel calculation (OpenMP) with and without atomic operations.
  *
  * \arg lprod stride (2*m+2)^d
+ * \arg nthreads number of threads
  *
  * \author Toni Volkmer
  */
 static void nfft_adjoint_B_compute_full_psi(C *g, const INT *psi_index_g,
     const R *psi, const C *f, const INT M, const INT d, const INT *n,
-    const INT m, const unsigned flags, const INT *index_x)
+    const INT m, const unsigned flags, const INT *index_x, const INT nthreads)
 {
   INT k;
   INT lprod;
@@ -1439,6 +2604,7 @@ static void nfft_adjoint_B_compute_full_psi(C *g, const INT *psi_index_g,
 #endif
 #ifndef _OPENMP
   UNUSED(n);
+  UNUSED(nthreads);
 #endif
   {
     INT t;
@@ -1452,7 +2618,7 @@ static void nfft_adjoint_B_compute_full_psi(C *g, const INT *psi_index_g,
 #ifdef _OPENMP
   if (flags & NFFT_OMP_BLOCKWISE_ADJOINT)
   {
-    #pragma omp parallel private(k)
+    #pragma omp parallel private(k) num_threads(nthreads)
     {
       INT my_u0, my_o0, min_u_a, max_u_a, min_u_b, max_u_b;
       const INT *ar_x = index_x;
@@ -1537,7 +2703,7 @@ static void nfft_adjoint_B_compute_full_psi(C *g, const INT *psi_index_g,
 #endif
 
 #ifdef _OPENMP
-  #pragma omp parallel for default(shared) private(k)
+  #pragma omp parallel for default(shared) private(k) num_threads(nthreads)
 #endif
   for (k = 0; k < M; k++)
   {
@@ -1660,12 +2826,8 @@ MACRO_B(T)
 #define MACRO_adjoint_nd_B_OMP_COMPUTE_BEFORE_LOOP_without_PRE_PSI \
       R psij_const[ths->d * (2*ths->m+2)]; \
       for (t2 = 0; t2 < ths->d; t2++) \
-      { \
-        INT lj_t; \
-        for (lj_t = 0; lj_t < 2*ths->m+2; lj_t++) \
-          psij_const[t2 * (2*ths->m+2) + lj_t] = PHI(ths->n[t2], ths->x[j*ths->d+t2] \
-                  - ((R) (lj_t+u[t2]))/((R)ths->n[t2]), t2); \
-      }
+        window_psij(ths, t2, ths->x[j*ths->d+t2], u[t2], \
+          &psij_const[t2 * (2*ths->m+2)]);
 #define MACRO_adjoint_nd_B_OMP_COMPUTE_UPDATE_without_PRE_PSI \
   MACRO_update_phi_prod_ll_plain(without_PRE_PSI_improved);
 
@@ -1789,7 +2951,7 @@ MACRO_B(T)
       INT lprodrest = 1; \
       for (k = 1; k < ths->d; k++) \
         lprodrest *= (2*ths->m+2); \
-      _Pragma("omp parallel private(k)") \
+      _Pragma("omp parallel private(k) num_threads(ths->nthreads)") \
       { \
         INT my_u0, my_o0, min_u_a, max_u_a, min_u_b, max_u_b; \
         INT *ar_x = ths->index_x; \
@@ -1971,95 +3133,492 @@ MACRO_B(T)
       } \
 }
 
-static inline void B_openmp_T(X(plan) *ths)
+/* Tiled adjoint (NFFT_OMP_TILED_ADJOINT). The oversampled grid is split into
+ * tiles of roughly NFFT_TILE_EDGE(d) points per dimension and the nodes are
+ * binned by the tile containing floor(x n). A thread spreads all nodes of a
+ * tile into a private subgrid padded by the window support and adds the
+ * subgrid to g afterwards. Tiles are processed in 3^d colour classes such that
+ * the subgrids of tiles of equal colour never overlap, so no atomic operations
+ * are needed. */
+
+/** Tile index of the grid point c, 0 <= c < n, for nt tiles along a dimension
+ * with boundaries floor(k n / nt). */
+#define NFFT_TILE_INDEX(c,n,nt) ((((c) + 1) * (nt) + (n) - 1) / (n) - 1)
+
+/** Adds a f psij_0[l_0] ... psij_{d-1}[l_{d-1}] to the subgrid sub of size
+ * S[0] x ... x S[d-1] at local offset off. The local indices wrap around
+ * modulo S[t] in dimensions where the subgrid covers the whole grid. */
+static void nfft_adjoint_B_omp_tiled_spread(C *sub, const INT *S,
+  const INT *off, const R *psij_const, const C f, const INT d, const INT m)
 {
-  INT lprod; /* 'regular bandwidth' of matrix B  */
-  INT k;
-
-  memset(ths->g, 0, (size_t)(ths->n_total) * sizeof(C));
-
-  for (k = 0, lprod = 1; k < ths->d; k++)
-    lprod *= (2*ths->m+2);
+  const INT l_max = 2*m+2;
+  INT lj[d];
+  INT t;
 
-  if (ths->flags & PRE_FULL_PSI)
-  {
-    nfft_adjoint_B_compute_full_psi(ths->g, ths->psi_index_g, ths->psi, ths->f,
-        ths->M_total, ths->d, ths->n, ths->m, ths->flags, ths->index_x);
-    return;
-  }
+  for (t = 0; t < d; t++)
+    lj[t] = 0;
 
-  if (ths->flags & PRE_PSI)
+  while (1)
   {
-    MACRO_adjoint_nd_B_OMP_BLOCKWISE(with_PRE_PSI);
+    C a = f;
+    INT i = 0;
 
-    #pragma omp parallel for default(shared) private(k)
-    for (k = 0; k < ths->M_total; k++)
+    for (t = 0; t < d-1; t++)
     {
-      INT t, t2; /* index dimensions */ \
-      INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
-      MACRO_adjoint_nd_B_OMP_COMPUTE(with_PRE_PSI);
-    } /* for(j) */
-    return;
-  } /* if(PRE_PSI) */
+      a *= psij_const[t*l_max+lj[t]];
+      i = (i + (off[t] + lj[t]) % S[t]) * S[t+1];
+    }
 
-  if (ths->flags & PRE_FG_PSI)
-  {
-    INT t, t2; /* index dimensions */
-    R fg_exp_l[ths->d][2*ths->m+2];
-    for(t2 = 0; t2 < ths->d; t2++)
+    if (off[d-1] + l_max > S[d-1])
     {
-      INT lj_fg;
-      R tmpEXP2 = EXP(K(-1.0)/ths->b[t2]);
-      R tmpEXP2sq = tmpEXP2*tmpEXP2;
-      R tmp2 = K(1.0);
-      R tmp3 = K(1.0);
-      fg_exp_l[t2][0] = K(1.0);
-      for(lj_fg = 1; lj_fg <= (2*ths->m+2); lj_fg++)
+      INT l;
+      for (l = 0; l < l_max; l++)
+        sub[i+(off[d-1]+l)%S[d-1]] += psij_const[(d-1)*l_max+l] * a;
+    }
+    else
+    {
+      i += off[d-1];
+#ifdef NFFT_SIMD
+      if (simd_isa == SIMD_AVX512)
+        row_axpy_avx512(sub + i, psij_const + (d-1)*l_max, a, l_max);
+      else if (simd_isa == SIMD_AVX2)
+        row_axpy_avx2(sub + i, psij_const + (d-1)*l_max, a, l_max);
+      else
+#endif
       {
-        tmp3 = tmp2*tmpEXP2;
-        tmp2 *= tmpEXP2sq;
-        fg_exp_l[t2][lj_fg] = fg_exp_l[t2][lj_fg-1]*tmp3;
+        INT l;
+        for (l = 0; l < l_max; l++)
+          sub[i+l] += psij_const[(d-1)*l_max+l] * a;
       }
     }
 
-    MACRO_adjoint_nd_B_OMP_BLOCKWISE(with_PRE_FG_PSI);
-
-    #pragma omp parallel for default(shared) private(k,t,t2)
-    for (k = 0; k < ths->M_total; k++)
+    for (t = d-2; t >= 0; t--)
     {
-      INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
-      MACRO_adjoint_nd_B_OMP_COMPUTE(with_PRE_FG_PSI);
-    } /* for(j) */
-    return;
-  } /* if(PRE_FG_PSI) */
+      if (++lj[t] < l_max)
+        break;
+      lj[t] = 0;
+    }
+    if (t < 0)
+      break;
+  }
+}
 
-  if (ths->flags & FG_PSI)
+/** Adds the subgrid sub to g, gidx[t][i] being the index in g of the local
+ * index i in dimension t. */
+static void nfft_adjoint_B_omp_tiled_add(C *g, const INT *n, const C *sub,
+  const INT *S, INT * const *gidx, const INT d)
+{
+  INT ij[d];
+  INT t, s_row = 0;
+
+  for (t = 0; t < d; t++)
+    ij[t] = 0;
+
+  while (1)
   {
-    INT t, t2; /* index dimensions */
-    R fg_exp_l[ths->d][2*ths->m+2];
+    const C *sub_row = sub + s_row;
+    INT i = 0, l;
 
-    sort(ths);
+    for (t = 0; t < d-1; t++)
+      i = (i + gidx[t][ij[t]]) * n[t+1];
 
-    for (t2 = 0; t2 < ths->d; t2++)
+    for (l = 0; l < S[d-1]; l++)
+      g[i + gidx[d-1][l]] += sub_row[l];
+
+    s_row += S[d-1];
+
+    for (t = d-2; t >= 0; t--)
     {
-      INT lj_fg;
-      R tmpEXP2 = EXP(K(-1.0)/ths->b[t2]);
-      R tmpEXP2sq = tmpEXP2*tmpEXP2;
-      R tmp2 = K(1.0);
-      R tmp3 = K(1.0);
-      fg_exp_l[t2][0] = K(1.0);
-      for (lj_fg = 1; lj_fg <= (2*ths->m+2); lj_fg++)
-      {
-        tmp3 = tmp2*tmpEXP2;
-        tmp2 *= tmpEXP2sq;
-        fg_exp_l[t2][lj_fg] = fg_exp_l[t2][lj_fg-1]*tmp3;
-      }
+      if (++ij[t] < S[t])
+        break;
+      ij[t] = 0;
     }
+    if (t < 0)
+      break;
+  }
+}
 
-    MACRO_adjoint_nd_B_OMP_BLOCKWISE(with_FG_PSI);
+/** Sorts the indices 0,...,len-1 by key into list, start[q] being the offset
+ * of key q in list. Negative keys are dropped. */
+static void nfft_adjoint_B_omp_tiled_bucket(const INT *key, const INT len,
+  const INT n_keys, INT *start, INT *list)
+{
+  INT k;
 
-    #pragma omp parallel for default(shared) private(k,t,t2)
-    for (k = 0; k < ths->M_total; k++)
+  memset(start, 0, (size_t)(n_keys+1) * sizeof(INT));
+
+  for (k = 0; k < len; k++)
+    if (key[k] >= 0)
+      start[key[k]+1]++;
+
+  for (k = 0; k < n_keys; k++)
+    start[k+1] += start[k];
+
+  for (k = 0; k < len; k++)
+    if (key[k] >= 0)
+      list[start[key[k]]++] = k;
+
+  for (k = n_keys; k > 0; k--)
+    start[k] = start[k-1];
+  start[0] = 0;
+}
+
+/** Binning of the nodes by tile, see above. */
+typedef struct tile_bins_s
+{
+  INT n_tiles;                          /**< number of tiles                  */
+  INT n_colours;                        /**< number of colours, 3^d           */
+  INT S_total;                          /**< size of the largest subgrid      */
+  INT *nt;                              /**< number of tiles per dimension    */
+  INT *S;                               /**< subgrid size per dimension       */
+  INT *tile_key;                        /**< scratch keys of the bucket sorts */
+  INT *node_start;                      /**< offset of each tile in node_list */
+  INT *node_list;                       /**< nodes sorted by tile             */
+  INT *colour_start;                    /**< offset of each colour in
+                                             colour_list                      */
+  INT *colour_list;                     /**< non-empty tiles sorted by colour */
+} tile_bins;
+
+/** Bins the nodes of the plan by tile and the tiles by colour. */
+static tile_bins *tile_bins_create(X(plan) *ths)
+{
+  const INT d = ths->d, m = ths->m, M = ths->M_total;
+  tile_bins *bins = (tile_bins*) Y(malloc)(sizeof(tile_bins));
+  INT *nt, *tile_key;
+  INT t, k;
+
+  bins->nt = nt = (INT*) Y(malloc)((size_t)(d) * sizeof(INT));
+  bins->S = (INT*) Y(malloc)((size_t)(d) * sizeof(INT));
+
+  /* Tiles are at least 2m+1 points wide, such that the subgrid of a tile
+   * overlaps only the subgrids of its neighbours. */
+  bins->n_tiles = 1;
+  bins->n_colours = 1;
+  bins->S_total = 1;
+  for (t = 0; t < d; t++)
+  {
+    const INT edge = MAX(NFFT_TILE_EDGE(d), 2*m+1);
+    nt[t] = MAX(ths->n[t] / edge, 1);
+    bins->S[t] = MIN((ths->n[t] + nt[t] - 1) / nt[t] + 2*m+1, ths->n[t]);
+    bins->n_tiles *= nt[t];
+    bins->n_colours *= 3;
+    bins->S_total *= bins->S[t];
+  }
+
+  bins->tile_key = tile_key =
+    (INT*) Y(malloc)((size_t)(MAX(M, bins->n_tiles)) * sizeof(INT));
+  bins->node_list = (INT*) Y(malloc)((size_t)(M) * sizeof(INT));
+  bins->node_start = (INT*) Y(malloc)((size_t)(bins->n_tiles+1) * sizeof(INT));
+  bins->colour_list = (INT*) Y(malloc)((size_t)(bins->n_tiles) * sizeof(INT));
+  bins->colour_start =
+    (INT*) Y(malloc)((size_t)(bins->n_colours+1) * sizeof(INT));
+
+  /* bin the nodes by tile */
+  #pragma omp parallel for default(shared) private(k,t) num_threads(ths->nthreads)
+  for (k = 0; k < M; k++)
+  {
+    INT tile = 0;
+    for (t = 0; t < d; t++)
+    {
+      const INT n = ths->n[t];
+      const INT c = (LRINT(FLOOR(ths->x[k*d+t] * (R)(n))) % n + n) % n;
+      tile = tile * nt[t] + NFFT_TILE_INDEX(c, n, nt[t]);
+    }
+    tile_key[k] = tile;
+  }
+
+  nfft_adjoint_B_omp_tiled_bucket(tile_key, M, bins->n_tiles, bins->node_start,
+    bins->node_list);
+
+  /* Colour of a tile: its parity in each dimension, where the last of an odd
+   * number of tiles gets a third colour. Empty tiles are skipped. */
+  for (k = 0; k < bins->n_tiles; k++)
+  {
+    INT r = k, colour = 0, p = 1;
+
+    if (bins->node_start[k] == bins->node_start[k+1])
+    {
+      tile_key[k] = -1;
+      continue;
+    }
+
+    for (t = d-1; t >= 0; t--)
+    {
+      const INT kt = r % nt[t];
+      colour += p * ((nt[t] % 2 == 1 && nt[t] > 1 && kt == nt[t]-1) ? 2 : kt % 2);
+      p *= 3;
+      r /= nt[t];
+    }
+    tile_key[k] = colour;
+  }
+
+  nfft_adjoint_B_omp_tiled_bucket(tile_key, bins->n_tiles, bins->n_colours,
+    bins->colour_start, bins->colour_list);
+
+  return bins;
+}
+
+static void tile_bins_free(tile_bins *bins)
+{
+  Y(free)(bins->colour_start);
+  Y(free)(bins->colour_list);
+  Y(free)(bins->node_start);
+  Y(free)(bins->node_list);
+  Y(free)(bins->tile_key);
+  Y(free)(bins->S);
+  Y(free)(bins->nt);
+  Y(free)(bins);
+}
+
+/** Computes g = B^T f with private subgrids per tile, see above. */
+static void nfft_adjoint_B_omp_tiled(X(plan) *ths)
+{
+  const INT d = ths->d, m = ths->m;
+  const INT l_max = 2*m+2;
+  tile_bins *bins = tile_bins_create(ths);
+  const INT *nt = bins->nt, *S = bins->S;
+  const INT n_colours = bins->n_colours, S_total = bins->S_total;
+  const INT *node_start = bins->node_start, *node_list = bins->node_list;
+  const INT *colour_start = bins->colour_start;
+  const INT *colour_list = bins->colour_list;
+  INT t, k;
+  R fg_exp_l[d*l_max];
+
+  if (ths->flags & (PRE_FG_PSI | FG_PSI))
+    nfft_B_init_fg_exp_l(ths, fg_exp_l);
+
+  #pragma omp parallel default(shared) private(k,t) num_threads(ths->nthreads)
+  {
+    C *sub = (C*) Y(malloc)((size_t)(S_total) * sizeof(C));
+    INT *gidx[d];
+    INT colour;
+
+    for (t = 0; t < d; t++)
+      gidx[t] = (INT*) Y(malloc)((size_t)(S[t]) * sizeof(INT));
+
+    for (colour = 0; colour < n_colours; colour++)
+    {
+      #pragma omp for schedule(dynamic,1)
+      for (k = colour_start[colour]; k < colour_start[colour+1]; k++)
+      {
+        const INT tile = colour_list[k];
+        INT ts[d], St[d];
+        INT r = tile, St_total = 1, p, i;
+
+        /* The subgrid of a tile starts m points before it. If the padded
+         * tile is as wide as the grid, it is the grid itself, starting at 0,
+         * and the spreading wraps around. */
+        for (t = d-1; t >= 0; t--)
+        {
+          const INT n = ths->n[t];
+          const INT kt = r % nt[t];
+          r /= nt[t];
+          ts[t] = (kt * n) / nt[t];
+          St[t] = ((kt+1) * n) / nt[t] - ts[t] + 2*m+1;
+          if (St[t] >= n)
+          {
+            ts[t] = m;
+            St[t] = n;
+          }
+          St_total *= St[t];
+          for (i = 0; i < St[t]; i++)
+            gidx[t][i] = ((ts[t] - m + i) % n + n) % n;
+        }
+
+        memset(sub, 0, (size_t)(St_total) * sizeof(C));
+
+        for (p = node_start[tile]; p < node_start[tile+1]; p++)
+        {
+          const INT j = node_list[p];
+          INT u[d], o[d], off[d];
+          R psij_const[d*l_max];
+
+          for (t = 0; t < d; t++)
+          {
+            uo(ths, j, &u[t], &o[t], t);
+            off[t] = ((u[t] + m) % ths->n[t] + ths->n[t]) % ths->n[t] - ts[t];
+            if (St[t] == ths->n[t])
+              off[t] = (off[t] + ths->n[t]) % ths->n[t];
+          }
+
+          nfft_B_psij(ths, j, u, fg_exp_l, psij_const);
+          nfft_adjoint_B_omp_tiled_spread(sub, St, off, psij_const, ths->f[j],
+            d, m);
+        }
+
+        nfft_adjoint_B_omp_tiled_add(ths->g, ths->n, sub, St, gidx, d);
+      } /* for(tiles of one colour) */
+    } /* for(colour) */
+
+    for (t = 0; t < d; t++)
+      Y(free)(gidx[t]);
+    Y(free)(sub);
+  } /* omp parallel */
+
+  tile_bins_free(bins);
+}
+
+/** Adds the rows of node j to g, see nfft_adjoint_B_mixed_node; par holds
+ *  the constants of the routine, passed on by the callers below. */
+typedef void (*nfft_adjoint_node_t)(X(plan) *ths, const INT j, const R *par,
+  const INT i0_lo, const INT i0_hi, const int atomic);
+
+/** Computes g = B^T f node by node for NFFT_OMP_BLOCKWISE_ADJOINT: each thread
+ *  adds the rows of its block of the first dimension, from the sorted nodes
+ *  whose window reaches it. */
+static void nfft_adjoint_B_nodes_blockwise(X(plan) *ths,
+  nfft_adjoint_node_t node, const R *par)
+{
+  const INT M = ths->M_total;
+  const INT *ar_x = ths->index_x;
+  INT k;
+
+  #pragma omp parallel private(k) num_threads(ths->nthreads)
+  {
+    INT my_u0, my_o0, min_u_a, max_u_a, min_u_b, max_u_b;
+
+    nfft_adjoint_B_omp_blockwise_init(&my_u0, &my_o0, &min_u_a, &max_u_a,
+      &min_u_b, &max_u_b, ths->d, ths->n, ths->m);
+
+    if (min_u_a != -1)
+    {
+      for (k = index_x_binary_search(ar_x, M, min_u_a); k < M
+        && ar_x[2*k] >= min_u_a && ar_x[2*k] <= max_u_a; k++)
+        node(ths, ar_x[2*k+1], par, my_u0, my_o0, 0);
+    }
+
+    if (min_u_b != -1)
+    {
+      for (k = index_x_binary_search(ar_x, M, min_u_b); k < M
+        && ar_x[2*k] >= min_u_b && ar_x[2*k] <= max_u_b; k++)
+        node(ths, ar_x[2*k+1], par, my_u0, my_o0, 0);
+    }
+  } /* omp parallel */
+}
+
+/** Computes g = B^T f node by node for NFFT_OMP_TILED_ADJOINT: the nodes of
+ *  tiles of one colour are added to g directly, since their windows do not
+ *  overlap. */
+static void nfft_adjoint_B_nodes_tiled(X(plan) *ths, nfft_adjoint_node_t node,
+  const R *par)
+{
+  tile_bins *bins = tile_bins_create(ths);
+  INT colour, k, p;
+
+  #pragma omp parallel default(shared) private(colour,k,p) num_threads(ths->nthreads)
+  {
+    for (colour = 0; colour < bins->n_colours; colour++)
+    {
+      #pragma omp for schedule(dynamic,1)
+      for (k = bins->colour_start[colour]; k < bins->colour_start[colour+1]; k++)
+      {
+        const INT tile = bins->colour_list[k];
+
+        for (p = bins->node_start[tile]; p < bins->node_start[tile+1]; p++)
+          node(ths, bins->node_list[p], par, 0, ths->n[0] - 1, 0);
+      }
+    }
+  } /* omp parallel */
+
+  tile_bins_free(bins);
+}
+
+static inline void B_openmp_T(X(plan) *ths)
+{
+  INT lprod; /* 'regular bandwidth' of matrix B  */
+  INT k;
+
+  nfft_zero(ths, ths->g, (size_t)(ths->n_total) * sizeof(C));
+
+  for (k = 0, lprod = 1; k < ths->d; k++)
+    lprod *= (2*ths->m+2);
+
+  if (ths->flags & PRE_FULL_PSI)
+  {
+    nfft_adjoint_B_compute_full_psi(ths->g, ths->psi_index_g, ths->psi, ths->f,
+        ths->M_total, ths->d, ths->n, ths->m, ths->flags, ths->index_x,
+        ths->nthreads);
+    return;
+  }
+
+  if (ths->flags & NFFT_OMP_TILED_ADJOINT)
+  {
+    nfft_adjoint_B_omp_tiled(ths);
+    return;
+  }
+
+  if (ths->flags & PRE_PSI)
+  {
+    MACRO_adjoint_nd_B_OMP_BLOCKWISE(with_PRE_PSI);
+
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+    for (k = 0; k < ths->M_total; k++)
+    {
+      INT t, t2; /* index dimensions */ \
+      INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
+      MACRO_adjoint_nd_B_OMP_COMPUTE(with_PRE_PSI);
+    } /* for(j) */
+    return;
+  } /* if(PRE_PSI) */
+
+  if (ths->flags & PRE_FG_PSI)
+  {
+    INT t, t2; /* index dimensions */
+    R fg_exp_l[ths->d][2*ths->m+2];
+    for(t2 = 0; t2 < ths->d; t2++)
+    {
+      INT lj_fg;
+      R tmpEXP2 = EXP(K(-1.0)/ths->b[t2]);
+      R tmpEXP2sq = tmpEXP2*tmpEXP2;
+      R tmp2 = K(1.0);
+      R tmp3 = K(1.0);
+      fg_exp_l[t2][0] = K(1.0);
+      for(lj_fg = 1; lj_fg < (2*ths->m+2); lj_fg++)
+      {
+        tmp3 = tmp2*tmpEXP2;
+        tmp2 *= tmpEXP2sq;
+        fg_exp_l[t2][lj_fg] = fg_exp_l[t2][lj_fg-1]*tmp3;
+      }
+    }
+
+    MACRO_adjoint_nd_B_OMP_BLOCKWISE(with_PRE_FG_PSI);
+
+    #pragma omp parallel for default(shared) private(k,t,t2) num_threads(ths->nthreads)
+    for (k = 0; k < ths->M_total; k++)
+    {
+      INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
+      MACRO_adjoint_nd_B_OMP_COMPUTE(with_PRE_FG_PSI);
+    } /* for(j) */
+    return;
+  } /* if(PRE_FG_PSI) */
+
+  if (ths->flags & FG_PSI)
+  {
+    INT t, t2; /* index dimensions */
+    R fg_exp_l[ths->d][2*ths->m+2];
+
+    sort(ths);
+
+    for (t2 = 0; t2 < ths->d; t2++)
+    {
+      INT lj_fg;
+      R tmpEXP2 = EXP(K(-1.0)/ths->b[t2]);
+      R tmpEXP2sq = tmpEXP2*tmpEXP2;
+      R tmp2 = K(1.0);
+      R tmp3 = K(1.0);
+      fg_exp_l[t2][0] = K(1.0);
+      for (lj_fg = 1; lj_fg < (2*ths->m+2); lj_fg++)
+      {
+        tmp3 = tmp2*tmpEXP2;
+        tmp2 *= tmpEXP2sq;
+        fg_exp_l[t2][lj_fg] = fg_exp_l[t2][lj_fg-1]*tmp3;
+      }
+    }
+
+    MACRO_adjoint_nd_B_OMP_BLOCKWISE(with_FG_PSI);
+
+    #pragma omp parallel for default(shared) private(k,t,t2) num_threads(ths->nthreads)
+    for (k = 0; k < ths->M_total; k++)
     {
       INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
       MACRO_adjoint_nd_B_OMP_COMPUTE(with_FG_PSI);
@@ -2073,7 +3632,7 @@ static inline void B_openmp_T(X(plan) *ths)
 
     MACRO_adjoint_nd_B_OMP_BLOCKWISE(with_PRE_LIN_PSI);
 
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
     for (k = 0; k<ths->M_total; k++)
     {
       INT t, t2; /* index dimensions */
@@ -2088,7 +3647,7 @@ static inline void B_openmp_T(X(plan) *ths)
 
   MACRO_adjoint_nd_B_OMP_BLOCKWISE(without_PRE_PSI);
 
-  #pragma omp parallel for default(shared) private(k)
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
   for (k = 0; k < ths->M_total; k++)
   {
     INT t, t2; /* index dimensions */
@@ -2098,8 +3657,81 @@ static inline void B_openmp_T(X(plan) *ths)
 }
 #endif
 
+/** Computes g = B^T f for NFFT_MIXED_PRECISION, by the strategy of the
+ *  adjoint chosen in the flags of the plan. */
+static void nfft_adjoint_B_mixed(X(plan) *ths)
+{
+  const R scale = nfft_mixed_scale_prod(ths);
+  INT k;
+
+  nfft_zero(ths, ths->g, (size_t)(ths->n_total) * sizeof(C));
+
+#ifdef _OPENMP
+  if (ths->flags & NFFT_OMP_TILED_ADJOINT)
+  {
+    nfft_adjoint_B_omp_tiled(ths);
+    return;
+  }
+
+  if (ths->flags & NFFT_OMP_BLOCKWISE_ADJOINT)
+  {
+    nfft_adjoint_B_nodes_blockwise(ths, nfft_adjoint_B_mixed_node, &scale);
+    return;
+  }
+
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+#endif
+  for (k = 0; k < ths->M_total; k++)
+  {
+    const INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
+    nfft_adjoint_B_mixed_node(ths, j, &scale, 0, ths->n[0] - 1, 1);
+  }
+}
+
+/** Computes g = B^T f for NFFT_COMPACT_FULL_PSI, by the strategy of the
+ *  adjoint chosen in the flags of the plan. */
+static void nfft_adjoint_B_compact(X(plan) *ths)
+{
+  INT k;
+
+  nfft_zero(ths, ths->g, (size_t)(ths->n_total) * sizeof(C));
+
+#ifdef _OPENMP
+  if (ths->flags & NFFT_OMP_TILED_ADJOINT)
+  {
+    nfft_adjoint_B_nodes_tiled(ths, nfft_adjoint_B_compact_node, NULL);
+    return;
+  }
+
+  if (ths->flags & NFFT_OMP_BLOCKWISE_ADJOINT)
+  {
+    nfft_adjoint_B_nodes_blockwise(ths, nfft_adjoint_B_compact_node, NULL);
+    return;
+  }
+
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+#endif
+  for (k = 0; k < ths->M_total; k++)
+  {
+    const INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
+    nfft_adjoint_B_compact_node(ths, j, NULL, 0, ths->n[0] - 1, 1);
+  }
+}
+
 static void B_T(X(plan) *ths)
 {
+  if (ths->flags & NFFT_MIXED_PRECISION)
+  {
+    nfft_adjoint_B_mixed(ths);
+    return;
+  }
+
+  if (ths->flags & NFFT_COMPACT_FULL_PSI)
+  {
+    nfft_adjoint_B_compact(ths);
+    return;
+  }
+
 #ifdef _OPENMP
   B_openmp_T(ths);
 #else
@@ -2285,11 +3917,23 @@ static void nfft_trafo_1d_B(X(plan) *ths)
   const INT n = ths->n[0], M = ths->M_total, m = ths->m, m2p2 = 2*m+2;
   const C *g = (C*)ths->g;
 
+  if (ths->flags & NFFT_MIXED_PRECISION)
+  {
+    nfft_trafo_B_mixed(ths);
+    return;
+  }
+
+  if (ths->flags & NFFT_COMPACT_FULL_PSI)
+  {
+    nfft_trafo_B_compact(ths);
+    return;
+  }
+
   if (ths->flags & PRE_FULL_PSI)
   {
     INT k;
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -2306,7 +3950,7 @@ static void nfft_trafo_1d_B(X(plan) *ths)
   {
     INT k;
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -2325,7 +3969,7 @@ static void nfft_trafo_1d_B(X(plan) *ths)
     nfft_1d_init_fg_exp_l(fg_exp_l, m, ths->b[0]);
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -2359,7 +4003,7 @@ static void nfft_trafo_1d_B(X(plan) *ths)
     nfft_1d_init_fg_exp_l(fg_exp_l, m, ths->b[0]);
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -2394,7 +4038,7 @@ static void nfft_trafo_1d_B(X(plan) *ths)
     sort(ths);
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -2426,18 +4070,17 @@ static void nfft_trafo_1d_B(X(plan) *ths)
     sort(ths);
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
       R psij_const[m2p2];
-      INT u, o, l;
+      INT u, o;
       INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
 
       uo(ths, (INT)j, &u, &o, (INT)0);
 
-      for (l = 0; l < m2p2; l++)
-        psij_const[l] = (PHI(ths->n[0], ths->x[j] - ((R)((u+l))) / (R)(n), 0));
+      window_psij(ths, 0, ths->x[j], u, psij_const);
 
       nfft_trafo_1d_compute(&ths->f[j], g, psij_const, &ths->x[j], n, m);
     }
@@ -2515,12 +4158,11 @@ static void nfft_trafo_1d_B(X(plan) *ths)
 #define MACRO_adjoint_1d_B_OMP_BLOCKWISE_COMPUTE_NO_PSI \
 { \
             R psij_const[2 * m + 2]; \
-            INT u, o, l; \
+            INT u, o; \
  \
             uo(ths, j, &u, &o, (INT)0); \
  \
-            for (l = 0; l <= 2 * m + 1; l++) \
-              psij_const[l] = (PHI(ths->n[0],ths->x[j]-((R)((u+l)))/((R)n),0)); \
+            window_psij(ths, 0, ths->x[j], u, psij_const); \
  \
             nfft_adjoint_1d_compute_omp_blockwise(ths->f[j], g, psij_const, \
                 ths->x + j, n, m, my_u0, my_o0); \
@@ -2530,7 +4172,7 @@ static void nfft_trafo_1d_B(X(plan) *ths)
 { \
     if (ths->flags & NFFT_OMP_BLOCKWISE_ADJOINT) \
     { \
-      _Pragma("omp parallel private(k)") \
+      _Pragma("omp parallel private(k) num_threads(ths->nthreads)") \
       { \
         INT my_u0, my_o0, min_u_a, max_u_a, min_u_b, max_u_b; \
         INT *ar_x = ths->index_x; \
@@ -2588,15 +4230,36 @@ static void nfft_adjoint_1d_B(X(plan) *ths)
   INT k;
   C *g = (C*)ths->g;
 
-  memset(g, 0, (size_t)(ths->n_total) * sizeof(C));
+  nfft_zero(ths, g, (size_t)(ths->n_total) * sizeof(C));
+
+  if (ths->flags & NFFT_MIXED_PRECISION)
+  {
+    nfft_adjoint_B_mixed(ths);
+    return;
+  }
+
+  if (ths->flags & NFFT_COMPACT_FULL_PSI)
+  {
+    nfft_adjoint_B_compact(ths);
+    return;
+  }
 
   if (ths->flags & PRE_FULL_PSI)
   {
     nfft_adjoint_B_compute_full_psi(g, ths->psi_index_g, ths->psi, ths->f, M,
-        (INT)1, ths->n, m, ths->flags, ths->index_x);
+        (INT)1, ths->n, m, ths->flags, ths->index_x,
+        ths->nthreads);
     return;
   } /* if(PRE_FULL_PSI) */
 
+#ifdef _OPENMP
+  if (ths->flags & NFFT_OMP_TILED_ADJOINT)
+  {
+    nfft_adjoint_B_omp_tiled(ths);
+    return;
+  }
+#endif
+
   if (ths->flags & PRE_PSI)
   {
 #ifdef _OPENMP
@@ -2604,7 +4267,7 @@ static void nfft_adjoint_1d_B(X(plan) *ths)
 #endif
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -2631,7 +4294,7 @@ static void nfft_adjoint_1d_B(X(plan) *ths)
 
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -2672,7 +4335,7 @@ static void nfft_adjoint_1d_B(X(plan) *ths)
 #endif
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -2714,7 +4377,7 @@ static void nfft_adjoint_1d_B(X(plan) *ths)
 #endif
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -2751,18 +4414,17 @@ static void nfft_adjoint_1d_B(X(plan) *ths)
 #endif
 
 #ifdef _OPENMP
-  #pragma omp parallel for default(shared) private(k)
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
   for (k = 0; k < M; k++)
   {
-    INT u,o,l;
+    INT u,o;
     R psij_const[2 * m + 2];
     INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
 
     uo(ths, j, &u, &o, (INT)0);
 
-    for (l = 0; l <= 2 * m + 1; l++)
-      psij_const[l] = (PHI(ths->n[0], ths->x[j] - ((R)((u+l))) / (R)(n),0));
+    window_psij(ths, 0, ths->x[j], u, psij_const);
 
 #ifdef _OPENMP
     nfft_adjoint_1d_compute_omp_atomic(ths->f[j], g, psij_const, ths->x + j, n, m);
@@ -2776,7 +4438,7 @@ void X(trafo_1d)(X(plan) *ths)
 {
   if((ths->N[0] <= ths->m) || (ths->n[0] <= 2*ths->m+2))
   {
-    X(trafo_direct)(ths);
+    nfft_direct(ths, 0);
     return;
   }
   
@@ -2794,44 +4456,29 @@ void X(trafo_1d)(X(plan) *ths)
 #ifdef _OPENMP
     {
       INT k;
-      #pragma omp parallel for default(shared) private(k)
+      #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
       for (k = 0; k < ths->n_total; k++)
         ths->g_hat[k] = 0.0;
     }
 #else
-    memset(ths->g_hat, 0, (size_t)(ths->n_total) * sizeof(C));
+    nfft_zero(ths, ths->g_hat, (size_t)(ths->n_total) * sizeof(C));
 #endif
-    if(ths->flags & PRE_PHI_HUT)
-    {
-      INT k;
-      c_phi_inv1 = ths->c_phi_inv[0];
-      c_phi_inv2 = &ths->c_phi_inv[0][N2];
+    INT k;
+    c_phi_inv1 = ths->c_phi_inv[0];
+    c_phi_inv2 = &ths->c_phi_inv[0][N2];
 
 #ifdef _OPENMP
-      #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
-      for (k = 0; k < N2; k++)
-      {
-        g_hat1[k] = f_hat1[k] * c_phi_inv1[k];
-        g_hat2[k] = f_hat2[k] * c_phi_inv2[k];
-      }
-    }
-    else
+    for (k = 0; k < N2; k++)
     {
-      INT k;
-#ifdef _OPENMP
-      #pragma omp parallel for default(shared) private(k)
-#endif
-      for (k = 0; k < N2; k++)
-      {
-        g_hat1[k] = f_hat1[k] / (PHI_HUT(ths->n[0],k-N2,0));
-        g_hat2[k] = f_hat2[k] / (PHI_HUT(ths->n[0],k,0));
-      }
+      g_hat1[k] = f_hat1[k] * c_phi_inv1[k];
+      g_hat2[k] = f_hat2[k] * c_phi_inv2[k];
     }
     TOC(0)
 
     TIC_FFTW(1)
-    FFTW(execute)(ths->my_fftw_plan1);
+    nfft_fftw_execute_A(ths);
     TOC_FFTW(1);
 
     TIC(2);
@@ -2844,7 +4491,7 @@ void X(adjoint_1d)(X(plan) *ths)
 {
   if((ths->N[0] <= ths->m) || (ths->n[0] <= 2*ths->m+2))
   {
-    X(adjoint_direct)(ths);
+    nfft_direct(ths, 1);
     return;
   }
   
@@ -2868,37 +4515,21 @@ void X(adjoint_1d)(X(plan) *ths)
   TOC(2)
 
   TIC_FFTW(1)
-  FFTW(execute)(ths->my_fftw_plan2);
+  nfft_fftw_execute_T(ths);
   TOC_FFTW(1);
 
   TIC(0)
-  if(ths->flags & PRE_PHI_HUT)
-  {
-    INT k;
-    c_phi_inv1=ths->c_phi_inv[0];
-    c_phi_inv2=&ths->c_phi_inv[0][N/2];
+  INT k;
+  c_phi_inv1=ths->c_phi_inv[0];
+  c_phi_inv2=&ths->c_phi_inv[0][N/2];
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
-    for (k = 0; k < N/2; k++)
-    {
-      f_hat1[k] = g_hat1[k] * c_phi_inv1[k];
-      f_hat2[k] = g_hat2[k] * c_phi_inv2[k];
-    }
-  }
-  else
+  for (k = 0; k < N/2; k++)
   {
-    INT k;
-
-#ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
-#endif
-    for (k = 0; k < N/2; k++)
-    {
-      f_hat1[k] = g_hat1[k] / (PHI_HUT(ths->n[0],k-N/2,0));
-      f_hat2[k] = g_hat2[k] / (PHI_HUT(ths->n[0],k,0));
-    }
+    f_hat1[k] = g_hat1[k] * c_phi_inv1[k];
+    f_hat2[k] = g_hat2[k] * c_phi_inv2[k];
   }
   TOC(0)
 }
@@ -2932,6 +4563,11 @@ static void nfft_trafo_2d_compute(C *fj, const C *g, const R *psij_const0,
   const C *gj;
   const R *psij0,*psij1;
 
+#ifdef NFFT_SIMD
+  SIMD_DISPATCH(nfft_trafo_2d_compute, (fj, g, psij_const0, psij_const1, xj0,
+    xj1, n0, n1, m))
+#endif
+
   psij0=psij_const0;
   psij1=psij_const1;
 
@@ -3069,6 +4705,11 @@ static void nfft_adjoint_2d_compute_omp_blockwise(const C f, C *g,
   INT ar_u0,ar_o0,l0,u1,o1,l1;
   INT index_temp1[2*m+2];
 
+#ifdef NFFT_SIMD
+  SIMD_DISPATCH(nfft_adjoint_2d_compute_omp_blockwise, (f, g,
+    psij_const0, psij_const1, xj0, xj1, n0, n1, m, my_u0, my_o0))
+#endif
+
   uo2(&ar_u0,&ar_o0,*xj0, n0, m);
   uo2(&u1,&o1,*xj1, n1, m);
 
@@ -3148,6 +4789,11 @@ static void nfft_adjoint_2d_compute_serial(const C *fj, C *g,
   C *gj;
   const R *psij0,*psij1;
 
+#ifdef NFFT_SIMD
+  SIMD_DISPATCH(nfft_adjoint_2d_compute_serial, (fj, g,
+    psij_const0, psij_const1, xj0, xj1, n0, n1, m))
+#endif
+
   psij0=psij_const0;
   psij1=psij_const1;
 
@@ -3228,11 +4874,23 @@ static void nfft_trafo_2d_B(X(plan) *ths)
 
   INT k;
 
+  if (ths->flags & NFFT_MIXED_PRECISION)
+  {
+    nfft_trafo_B_mixed(ths);
+    return;
+  }
+
+  if (ths->flags & NFFT_COMPACT_FULL_PSI)
+  {
+    nfft_trafo_B_compact(ths);
+    return;
+  }
+
   if(ths->flags & PRE_FULL_PSI)
   {
     const INT lprod = (2*m+2) * (2*m+2);
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -3248,7 +4906,7 @@ static void nfft_trafo_2d_B(X(plan) *ths)
   if(ths->flags & PRE_PSI)
   {
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -3267,7 +4925,7 @@ static void nfft_trafo_2d_B(X(plan) *ths)
     nfft_2d_init_fg_exp_l(fg_exp_l+2*m+2, m, ths->b[1]);
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -3311,7 +4969,7 @@ static void nfft_trafo_2d_B(X(plan) *ths)
     sort(ths);
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -3355,7 +5013,7 @@ static void nfft_trafo_2d_B(X(plan) *ths)
     sort(ths);
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -3389,21 +5047,19 @@ static void nfft_trafo_2d_B(X(plan) *ths)
   sort(ths);
 
 #ifdef _OPENMP
-  #pragma omp parallel for default(shared) private(k)
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
   for (k = 0; k < M; k++)
   {
     R psij_const[2*(2*m+2)];
-    INT u, o, l;
+    INT u, o;
     INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
 
     uo(ths,j,&u,&o,(INT)0);
-    for (l = 0; l <= 2*m+1; l++)
-      psij_const[l]=(PHI(ths->n[0], ths->x[2*j] - ((R)((u+l))) / (R)(n0),0));
+    window_psij(ths, 0, ths->x[2*j], u, psij_const);
 
     uo(ths,j,&u,&o,(INT)1);
-    for (l = 0; l <= 2*m+1; l++)
-      psij_const[2*m+2+l] = (PHI(ths->n[1], ths->x[2*j+1] - ((R)((u+l)))/(R)(n1),1));
+    window_psij(ths, 1, ths->x[2*j+1], u, psij_const+2*m+2);
 
     nfft_trafo_2d_compute(ths->f+j, g, psij_const, psij_const+2*m+2, ths->x+2*j, ths->x+2*j+1, n0, n1, m);
   }
@@ -3508,15 +5164,13 @@ static void nfft_trafo_2d_B(X(plan) *ths)
 #define MACRO_adjoint_2d_B_OMP_BLOCKWISE_COMPUTE_NO_PSI \
 { \
             R psij_const[2*(2*m+2)]; \
-            INT u, o, l; \
+            INT u, o; \
  \
             uo(ths,j,&u,&o,(INT)0); \
-            for(l=0;l<=2*m+1;l++) \
-              psij_const[l]=(PHI(ths->n[0],ths->x[2*j]-((R)((u+l)))/((R)n0),0)); \
+            window_psij(ths, 0, ths->x[2*j], u, psij_const); \
  \
             uo(ths,j,&u,&o,(INT)1); \
-            for(l=0;l<=2*m+1;l++) \
-              psij_const[2*m+2+l]=(PHI(ths->n[1],ths->x[2*j+1]-((R)((u+l)))/((R)n1),1)); \
+            window_psij(ths, 1, ths->x[2*j+1], u, psij_const+2*m+2); \
  \
             nfft_adjoint_2d_compute_omp_blockwise(ths->f[j], g, \
                 psij_const, psij_const+2*m+2, ths->x+2*j, ths->x+2*j+1, \
@@ -3527,7 +5181,7 @@ static void nfft_trafo_2d_B(X(plan) *ths)
 { \
     if (ths->flags & NFFT_OMP_BLOCKWISE_ADJOINT) \
     { \
-      _Pragma("omp parallel private(k)") \
+      _Pragma("omp parallel private(k) num_threads(ths->nthreads)") \
       { \
         INT my_u0, my_o0, min_u_a, max_u_a, min_u_b, max_u_b; \
         INT *ar_x = ths->index_x; \
@@ -3589,15 +5243,36 @@ static void nfft_adjoint_2d_B(X(plan) *ths)
   C* g = (C*) ths->g;
   INT k;
 
-  memset(g, 0, (size_t)(ths->n_total) * sizeof(C));
+  nfft_zero(ths, g, (size_t)(ths->n_total) * sizeof(C));
+
+  if (ths->flags & NFFT_MIXED_PRECISION)
+  {
+    nfft_adjoint_B_mixed(ths);
+    return;
+  }
+
+  if (ths->flags & NFFT_COMPACT_FULL_PSI)
+  {
+    nfft_adjoint_B_compact(ths);
+    return;
+  }
 
   if(ths->flags & PRE_FULL_PSI)
   {
     nfft_adjoint_B_compute_full_psi(g, ths->psi_index_g, ths->psi, ths->f, M,
-        (INT)2, ths->n, m, ths->flags, ths->index_x);
+        (INT)2, ths->n, m, ths->flags, ths->index_x,
+        ths->nthreads);
     return;
   } /* if(PRE_FULL_PSI) */
 
+#ifdef _OPENMP
+  if(ths->flags & NFFT_OMP_TILED_ADJOINT)
+  {
+    nfft_adjoint_B_omp_tiled(ths);
+    return;
+  }
+#endif
+
   if(ths->flags & PRE_PSI)
   {
 #ifdef _OPENMP
@@ -3605,7 +5280,7 @@ static void nfft_adjoint_2d_B(X(plan) *ths)
 #endif
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -3632,7 +5307,7 @@ static void nfft_adjoint_2d_B(X(plan) *ths)
 
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -3684,7 +5359,7 @@ static void nfft_adjoint_2d_B(X(plan) *ths)
 #endif
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -3737,7 +5412,7 @@ static void nfft_adjoint_2d_B(X(plan) *ths)
 #endif
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -3780,21 +5455,19 @@ static void nfft_adjoint_2d_B(X(plan) *ths)
 #endif
 
 #ifdef _OPENMP
-  #pragma omp parallel for default(shared) private(k)
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
   for (k = 0; k < M; k++)
   {
-    INT u,o,l;
+    INT u,o;
     R psij_const[2*(2*m+2)];
     INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
 
     uo(ths,j,&u,&o,(INT)0);
-    for(l=0;l<=2*m+1;l++)
-      psij_const[l]=(PHI(ths->n[0], ths->x[2*j] - ((R)((u+l))) / (R)(n0),0));
+    window_psij(ths, 0, ths->x[2*j], u, psij_const);
 
     uo(ths,j,&u,&o,(INT)1);
-    for(l=0;l<=2*m+1;l++)
-      psij_const[2*m+2+l]=(PHI(ths->n[1], ths->x[2*j+1] - ((R)((u+l))) / (R)(n1),1));
+    window_psij(ths, 1, ths->x[2*j+1], u, psij_const+2*m+2);
 
 #ifdef _OPENMP
     nfft_adjoint_2d_compute_omp_atomic(ths->f[j], g, psij_const, psij_const+2*m+2, ths->x+2*j, ths->x+2*j+1, n0, n1, m);
@@ -3809,7 +5482,7 @@ void X(trafo_2d)(X(plan) *ths)
 {
   if((ths->N[0] <= ths->m) || (ths->N[1] <= ths->m) || (ths->n[0] <= 2*ths->m+2) || (ths->n[1] <= 2*ths->m+2))
   {
-    X(trafo_direct)(ths);
+    nfft_direct(ths, 0);
     return;
   }
   
@@ -3832,72 +5505,51 @@ void X(trafo_2d)(X(plan) *ths)
 
   TIC(0)
 #ifdef _OPENMP
-  #pragma omp parallel for default(shared) private(k0)
+  #pragma omp parallel for default(shared) private(k0) num_threads(ths->nthreads)
   for (k0 = 0; k0 < ths->n_total; k0++)
     ths->g_hat[k0] = 0.0;
 #else
-  memset(ths->g_hat, 0, (size_t)(ths->n_total) * sizeof(C));
+  nfft_zero(ths, ths->g_hat, (size_t)(ths->n_total) * sizeof(C));
 #endif
-  if(ths->flags & PRE_PHI_HUT)
-    {
-      c_phi_inv01=ths->c_phi_inv[0];
-      c_phi_inv02=&ths->c_phi_inv[0][N0/2];
+  c_phi_inv01=ths->c_phi_inv[0];
+  c_phi_inv02=&ths->c_phi_inv[0][N0/2];
 
 #ifdef _OPENMP
-      #pragma omp parallel for default(shared) private(k0,k1,ck01,ck02,c_phi_inv11,c_phi_inv12,g_hat11,f_hat11,g_hat21,f_hat21,g_hat12,f_hat12,g_hat22,f_hat22,ck11,ck12)
+  #pragma omp parallel for default(shared) private(k0,k1,ck01,ck02,c_phi_inv11,c_phi_inv12,g_hat11,f_hat11,g_hat21,f_hat21,g_hat12,f_hat12,g_hat22,f_hat22,ck11,ck12) num_threads(ths->nthreads)
 #endif
-      for(k0=0;k0<N0/2;k0++)
-      {
-        ck01=c_phi_inv01[k0];
-        ck02=c_phi_inv02[k0];
-
-        c_phi_inv11=ths->c_phi_inv[1];
-        c_phi_inv12=&ths->c_phi_inv[1][N1/2];
-
-        g_hat11=g_hat + (n0-(N0/2)+k0)*n1+n1-(N1/2);
-        f_hat11=f_hat + k0*N1;
-        g_hat21=g_hat + k0*n1+n1-(N1/2);
-        f_hat21=f_hat + ((N0/2)+k0)*N1;
-        g_hat12=g_hat + (n0-(N0/2)+k0)*n1;
-        f_hat12=f_hat + k0*N1+(N1/2);
-        g_hat22=g_hat + k0*n1;
-        f_hat22=f_hat + ((N0/2)+k0)*N1+(N1/2);
-
-        for(k1=0;k1<N1/2;k1++)
-        {
-          ck11=c_phi_inv11[k1];
-          ck12=c_phi_inv12[k1];
+  for(k0=0;k0<N0/2;k0++)
+  {
+    ck01=c_phi_inv01[k0];
+    ck02=c_phi_inv02[k0];
 
-          g_hat11[k1] = f_hat11[k1] * ck01 * ck11;
-          g_hat21[k1] = f_hat21[k1] * ck02 * ck11;
-          g_hat12[k1] = f_hat12[k1] * ck01 * ck12;
-          g_hat22[k1] = f_hat22[k1] * ck02 * ck12;
-        }
-      }
-    }
-  else
-#ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k0,k1,ck01,ck02,ck11,ck12)
-#endif
-    for(k0=0;k0<N0/2;k0++)
-      {
-  ck01=K(1.0)/(PHI_HUT(ths->n[0],k0-N0/2,0));
-  ck02=K(1.0)/(PHI_HUT(ths->n[0],k0,0));
-  for(k1=0;k1<N1/2;k1++)
+    c_phi_inv11=ths->c_phi_inv[1];
+    c_phi_inv12=&ths->c_phi_inv[1][N1/2];
+
+    g_hat11=g_hat + (n0-(N0/2)+k0)*n1+n1-(N1/2);
+    f_hat11=f_hat + k0*N1;
+    g_hat21=g_hat + k0*n1+n1-(N1/2);
+    f_hat21=f_hat + ((N0/2)+k0)*N1;
+    g_hat12=g_hat + (n0-(N0/2)+k0)*n1;
+    f_hat12=f_hat + k0*N1+(N1/2);
+    g_hat22=g_hat + k0*n1;
+    f_hat22=f_hat + ((N0/2)+k0)*N1+(N1/2);
+
+    for(k1=0;k1<N1/2;k1++)
     {
-      ck11=K(1.0)/(PHI_HUT(ths->n[1],k1-N1/2,1));
-      ck12=K(1.0)/(PHI_HUT(ths->n[1],k1,1));
-      g_hat[(n0-N0/2+k0)*n1+n1-N1/2+k1] = f_hat[k0*N1+k1]             * ck01 * ck11;
-      g_hat[k0*n1+n1-N1/2+k1]           = f_hat[(N0/2+k0)*N1+k1]      * ck02 * ck11;
-      g_hat[(n0-N0/2+k0)*n1+k1]         = f_hat[k0*N1+N1/2+k1]        * ck01 * ck12;
-      g_hat[k0*n1+k1]                   = f_hat[(N0/2+k0)*N1+N1/2+k1] * ck02 * ck12;
+      ck11=c_phi_inv11[k1];
+      ck12=c_phi_inv12[k1];
+
+      g_hat11[k1] = f_hat11[k1] * ck01 * ck11;
+      g_hat21[k1] = f_hat21[k1] * ck02 * ck11;
+      g_hat12[k1] = f_hat12[k1] * ck01 * ck12;
+      g_hat22[k1] = f_hat22[k1] * ck02 * ck12;
     }
-      }
+  }
 
   TOC(0)
 
   TIC_FFTW(1)
-  FFTW(execute)(ths->my_fftw_plan1);
+  nfft_fftw_execute_A(ths);
   TOC_FFTW(1);
 
   TIC(2);
@@ -3909,7 +5561,7 @@ void X(adjoint_2d)(X(plan) *ths)
 {
   if((ths->N[0] <= ths->m) || (ths->N[1] <= ths->m) || (ths->n[0] <= 2*ths->m+2) || (ths->n[1] <= 2*ths->m+2))
   {
-    X(adjoint_direct)(ths);
+    nfft_direct(ths, 1);
     return;
   }
   
@@ -3935,65 +5587,44 @@ void X(adjoint_2d)(X(plan) *ths)
   TOC(2);
 
   TIC_FFTW(1)
-  FFTW(execute)(ths->my_fftw_plan2);
+  nfft_fftw_execute_T(ths);
   TOC_FFTW(1);
 
   TIC(0)
-  if(ths->flags & PRE_PHI_HUT)
-    {
-      c_phi_inv01=ths->c_phi_inv[0];
-      c_phi_inv02=&ths->c_phi_inv[0][N0/2];
+  c_phi_inv01=ths->c_phi_inv[0];
+  c_phi_inv02=&ths->c_phi_inv[0][N0/2];
 
 #ifdef _OPENMP
-      #pragma omp parallel for default(shared) private(k0,k1,ck01,ck02,c_phi_inv11,c_phi_inv12,g_hat11,f_hat11,g_hat21,f_hat21,g_hat12,f_hat12,g_hat22,f_hat22,ck11,ck12)
+  #pragma omp parallel for default(shared) private(k0,k1,ck01,ck02,c_phi_inv11,c_phi_inv12,g_hat11,f_hat11,g_hat21,f_hat21,g_hat12,f_hat12,g_hat22,f_hat22,ck11,ck12) num_threads(ths->nthreads)
 #endif
-      for(k0=0;k0<N0/2;k0++)
-      {
-        ck01=c_phi_inv01[k0];
-        ck02=c_phi_inv02[k0];
-
-        c_phi_inv11=ths->c_phi_inv[1];
-        c_phi_inv12=&ths->c_phi_inv[1][N1/2];
-
-        g_hat11=g_hat + (n0-(N0/2)+k0)*n1+n1-(N1/2);
-        f_hat11=f_hat + k0*N1;
-        g_hat21=g_hat + k0*n1+n1-(N1/2);
-        f_hat21=f_hat + ((N0/2)+k0)*N1;
-        g_hat12=g_hat + (n0-(N0/2)+k0)*n1;
-        f_hat12=f_hat + k0*N1+(N1/2);
-        g_hat22=g_hat + k0*n1;
-        f_hat22=f_hat + ((N0/2)+k0)*N1+(N1/2);
-
-        for(k1=0;k1<N1/2;k1++)
-        {
-          ck11=c_phi_inv11[k1];
-          ck12=c_phi_inv12[k1];
+  for(k0=0;k0<N0/2;k0++)
+  {
+    ck01=c_phi_inv01[k0];
+    ck02=c_phi_inv02[k0];
 
-          f_hat11[k1] = g_hat11[k1] * ck01 * ck11;
-          f_hat21[k1] = g_hat21[k1] * ck02 * ck11;
-          f_hat12[k1] = g_hat12[k1] * ck01 * ck12;
-          f_hat22[k1] = g_hat22[k1] * ck02 * ck12;
-        }
-      }
-    }
-  else
-#ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k0,k1,ck01,ck02,ck11,ck12)
-#endif
-    for(k0=0;k0<N0/2;k0++)
-      {
-  ck01=K(1.0)/(PHI_HUT(ths->n[0],k0-N0/2,0));
-  ck02=K(1.0)/(PHI_HUT(ths->n[0],k0,0));
-  for(k1=0;k1<N1/2;k1++)
+    c_phi_inv11=ths->c_phi_inv[1];
+    c_phi_inv12=&ths->c_phi_inv[1][N1/2];
+
+    g_hat11=g_hat + (n0-(N0/2)+k0)*n1+n1-(N1/2);
+    f_hat11=f_hat + k0*N1;
+    g_hat21=g_hat + k0*n1+n1-(N1/2);
+    f_hat21=f_hat + ((N0/2)+k0)*N1;
+    g_hat12=g_hat + (n0-(N0/2)+k0)*n1;
+    f_hat12=f_hat + k0*N1+(N1/2);
+    g_hat22=g_hat + k0*n1;
+    f_hat22=f_hat + ((N0/2)+k0)*N1+(N1/2);
+
+    for(k1=0;k1<N1/2;k1++)
     {
-      ck11=K(1.0)/(PHI_HUT(ths->n[1],k1-N1/2,1));
-      ck12=K(1.0)/(PHI_HUT(ths->n[1],k1,1));
-      f_hat[k0*N1+k1]             = g_hat[(n0-N0/2+k0)*n1+n1-N1/2+k1] * ck01 * ck11;
-      f_hat[(N0/2+k0)*N1+k1]      = g_hat[k0*n1+n1-N1/2+k1]           * ck02 * ck11;
-      f_hat[k0*N1+N1/2+k1]        = g_hat[(n0-N0/2+k0)*n1+k1]         * ck01 * ck12;
-      f_hat[(N0/2+k0)*N1+N1/2+k1] = g_hat[k0*n1+k1]                   * ck02 * ck12;
+      ck11=c_phi_inv11[k1];
+      ck12=c_phi_inv12[k1];
+
+      f_hat11[k1] = g_hat11[k1] * ck01 * ck11;
+      f_hat21[k1] = g_hat21[k1] * ck02 * ck11;
+      f_hat12[k1] = g_hat12[k1] * ck01 * ck12;
+      f_hat22[k1] = g_hat22[k1] * ck02 * ck12;
     }
-      }
+  }
   TOC(0)
 }
 
@@ -4025,6 +5656,11 @@ static void nfft_trafo_3d_compute(C *fj, const C *g, const R *psij_const0,
   const C *gj;
   const R *psij0, *psij1, *psij2;
 
+#ifdef NFFT_SIMD
+  SIMD_DISPATCH(nfft_trafo_3d_compute, (fj, g, psij_const0, psij_const1,
+    psij_const2, xj0, xj1, xj2, n0, n1, n2, m))
+#endif
+
   psij0 = psij_const0;
   psij1 = psij_const1;
   psij2 = psij_const2;
@@ -4297,6 +5933,12 @@ static void nfft_adjoint_3d_compute_omp_blockwise(const C f, C *g,
   INT index_temp1[2*m+2];
   INT index_temp2[2*m+2];
 
+#ifdef NFFT_SIMD
+  SIMD_DISPATCH(nfft_adjoint_3d_compute_omp_blockwise, (f, g,
+    psij_const0, psij_const1, psij_const2, xj0, xj1, xj2, n0, n1, n2, m,
+    my_u0, my_o0))
+#endif
+
   uo2(&ar_u0,&ar_o0,*xj0, n0, m);
   uo2(&u1,&o1,*xj1, n1, m);
   uo2(&u2,&o2,*xj2, n2, m);
@@ -4446,6 +6088,11 @@ static void nfft_adjoint_3d_compute_serial(const C *fj, C *g,
   C *gj;
   const R *psij0, *psij1, *psij2;
 
+#ifdef NFFT_SIMD
+  SIMD_DISPATCH(nfft_adjoint_3d_compute_serial, (fj, g,
+    psij_const0, psij_const1, psij_const2, xj0, xj1, xj2, n0, n1, n2, m))
+#endif
+
   psij0 = psij_const0;
   psij1 = psij_const1;
   psij2 = psij_const2;
@@ -4696,11 +6343,23 @@ static void nfft_trafo_3d_B(X(plan) *ths)
 
   INT k;
 
+  if (ths->flags & NFFT_MIXED_PRECISION)
+  {
+    nfft_trafo_B_mixed(ths);
+    return;
+  }
+
+  if (ths->flags & NFFT_COMPACT_FULL_PSI)
+  {
+    nfft_trafo_B_compact(ths);
+    return;
+  }
+
   if(ths->flags & PRE_FULL_PSI)
   {
     const INT lprod = (2*m+2) * (2*m+2) * (2*m+2);
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -4716,7 +6375,7 @@ static void nfft_trafo_3d_B(X(plan) *ths)
   if(ths->flags & PRE_PSI)
   {
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -4735,7 +6394,7 @@ static void nfft_trafo_3d_B(X(plan) *ths)
     nfft_3d_init_fg_exp_l(fg_exp_l+2*(2*m+2), m, ths->b[2]);
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -4790,7 +6449,7 @@ static void nfft_trafo_3d_B(X(plan) *ths)
     sort(ths);
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -4845,7 +6504,7 @@ static void nfft_trafo_3d_B(X(plan) *ths)
     sort(ths);
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -4889,25 +6548,22 @@ static void nfft_trafo_3d_B(X(plan) *ths)
   sort(ths);
 
 #ifdef _OPENMP
-  #pragma omp parallel for default(shared) private(k)
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
   for (k = 0; k < M; k++)
   {
     R psij_const[3*(2*m+2)];
-    INT u, o, l;
+    INT u, o;
     INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
 
     uo(ths,j,&u,&o,(INT)0);
-    for(l=0;l<=2*m+1;l++)
-      psij_const[l]=(PHI(ths->n[0], ths->x[3*j] - ((R)((u+l))) / (R)(n0),0));
+    window_psij(ths, 0, ths->x[3*j], u, psij_const);
 
     uo(ths,j,&u,&o,(INT)1);
-    for(l=0;l<=2*m+1;l++)
-      psij_const[2*m+2+l]=(PHI(ths->n[1], ths->x[3*j+1] - ((R)((u+l))) / (R)(n1),1));
+    window_psij(ths, 1, ths->x[3*j+1], u, psij_const+2*m+2);
 
     uo(ths,j,&u,&o,(INT)2);
-    for(l=0;l<=2*m+1;l++)
-      psij_const[2*(2*m+2)+l]=(PHI(ths->n[2], ths->x[3*j+2] - ((R)((u+l))) / (R)(n2),2));
+    window_psij(ths, 2, ths->x[3*j+2], u, psij_const+2*(2*m+2));
 
     nfft_trafo_3d_compute(ths->f+j, g, psij_const, psij_const+2*m+2, psij_const+(2*m+2)*2, ths->x+3*j, ths->x+3*j+1, ths->x+3*j+2, n0, n1, n2, m);
   }
@@ -5046,20 +6702,17 @@ static void nfft_trafo_3d_B(X(plan) *ths)
 
 #define MACRO_adjoint_3d_B_OMP_BLOCKWISE_COMPUTE_NO_PSI \
 { \
-            INT u, o, l; \
+            INT u, o; \
             R psij_const[3*(2*m+2)]; \
  \
             uo(ths,j,&u,&o,(INT)0); \
-            for(l=0;l<=2*m+1;l++) \
-              psij_const[l]=(PHI(ths->n[0],ths->x[3*j]-((R)((u+l)))/((R) n0),0)); \
+            window_psij(ths, 0, ths->x[3*j], u, psij_const); \
  \
             uo(ths,j,&u,&o,(INT)1); \
-            for(l=0;l<=2*m+1;l++) \
-              psij_const[2*m+2+l]=(PHI(ths->n[1],ths->x[3*j+1]-((R)((u+l)))/((R) n1),1)); \
+            window_psij(ths, 1, ths->x[3*j+1], u, psij_const+2*m+2); \
  \
             uo(ths,j,&u,&o,(INT)2); \
-            for(l=0;l<=2*m+1;l++) \
-              psij_const[2*(2*m+2)+l]=(PHI(ths->n[2],ths->x[3*j+2]-((R)((u+l)))/((R) n2),2)); \
+            window_psij(ths, 2, ths->x[3*j+2], u, psij_const+2*(2*m+2)); \
  \
             nfft_adjoint_3d_compute_omp_blockwise(ths->f[j], g, \
                 psij_const, psij_const+2*m+2, psij_const+(2*m+2)*2, \
@@ -5071,7 +6724,7 @@ static void nfft_trafo_3d_B(X(plan) *ths)
 { \
     if (ths->flags & NFFT_OMP_BLOCKWISE_ADJOINT) \
     { \
-      _Pragma("omp parallel private(k)") \
+      _Pragma("omp parallel private(k) num_threads(ths->nthreads)") \
       { \
         INT my_u0, my_o0, min_u_a, max_u_a, min_u_b, max_u_b; \
         INT *ar_x = ths->index_x; \
@@ -5134,15 +6787,36 @@ static void nfft_adjoint_3d_B(X(plan) *ths)
 
   C* g = (C*) ths->g;
 
-  memset(g, 0, (size_t)(ths->n_total) * sizeof(C));
+  nfft_zero(ths, g, (size_t)(ths->n_total) * sizeof(C));
+
+  if (ths->flags & NFFT_MIXED_PRECISION)
+  {
+    nfft_adjoint_B_mixed(ths);
+    return;
+  }
+
+  if (ths->flags & NFFT_COMPACT_FULL_PSI)
+  {
+    nfft_adjoint_B_compact(ths);
+    return;
+  }
 
   if(ths->flags & PRE_FULL_PSI)
   {
     nfft_adjoint_B_compute_full_psi(g, ths->psi_index_g, ths->psi, ths->f, M,
-        (INT)3, ths->n, m, ths->flags, ths->index_x);
+        (INT)3, ths->n, m, ths->flags, ths->index_x,
+        ths->nthreads);
     return;
   } /* if(PRE_FULL_PSI) */
 
+#ifdef _OPENMP
+  if(ths->flags & NFFT_OMP_TILED_ADJOINT)
+  {
+    nfft_adjoint_B_omp_tiled(ths);
+    return;
+  }
+#endif
+
   if(ths->flags & PRE_PSI)
   {
 #ifdef _OPENMP
@@ -5150,7 +6824,7 @@ static void nfft_adjoint_3d_B(X(plan) *ths)
 #endif
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -5177,7 +6851,7 @@ static void nfft_adjoint_3d_B(X(plan) *ths)
 #endif
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -5240,7 +6914,7 @@ static void nfft_adjoint_3d_B(X(plan) *ths)
 #endif
 
 #ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
 #endif
     for (k = 0; k < M; k++)
     {
@@ -5282,989 +6956,4452 @@ static void nfft_adjoint_3d_B(X(plan) *ths)
         psij_const[2*(2*m+2)+l] = fg_psij0*fg_psij2*fg_exp_l[2*(2*m+2)+l];
       }
 
-#ifdef _OPENMP
-      nfft_adjoint_3d_compute_omp_atomic(ths->f[j], g, psij_const, psij_const+2*m+2, psij_const+(2*m+2)*2, ths->x+3*j, ths->x+3*j+1, ths->x+3*j+2, n0, n1, n2, m);
-#else
-      nfft_adjoint_3d_compute_serial(ths->f+j, g, psij_const, psij_const+2*m+2, psij_const+(2*m+2)*2, ths->x+3*j, ths->x+3*j+1, ths->x+3*j+2, n0, n1, n2, m);
-#endif
+#ifdef _OPENMP
+      nfft_adjoint_3d_compute_omp_atomic(ths->f[j], g, psij_const, psij_const+2*m+2, psij_const+(2*m+2)*2, ths->x+3*j, ths->x+3*j+1, ths->x+3*j+2, n0, n1, n2, m);
+#else
+      nfft_adjoint_3d_compute_serial(ths->f+j, g, psij_const, psij_const+2*m+2, psij_const+(2*m+2)*2, ths->x+3*j, ths->x+3*j+1, ths->x+3*j+2, n0, n1, n2, m);
+#endif
+    }
+
+    return;
+  } /* if(FG_PSI) */
+
+  if(ths->flags & PRE_LIN_PSI)
+  {
+    const INT K = ths->K;
+    const INT ip_s = K / (m + 2);
+
+    sort(ths);
+
+#ifdef _OPENMP
+    MACRO_adjoint_3d_B_OMP_BLOCKWISE(PRE_LIN_PSI)
+#endif
+
+#ifdef _OPENMP
+    #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+#endif
+    for (k = 0; k < M; k++)
+    {
+      INT u,o,l;
+      INT ip_u;
+      R ip_y, ip_w;
+      INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
+      R psij_const[3*(2*m+2)];
+
+      uo(ths,j,&u,&o,(INT)0);
+      ip_y = FABS((R)(n0) * ths->x[3*j+0] - (R)(u)) * ((R)ip_s);
+      ip_u = (INT)(LRINT(FLOOR(ip_y)));
+      ip_w = ip_y - (R)(ip_u);
+      for(l=0; l < 2*m+2; l++)
+        psij_const[l] = ths->psi[ABS(ip_u-l*ip_s)]*(K(1.0)-ip_w) +
+          ths->psi[ABS(ip_u-l*ip_s+1)]*(ip_w);
+
+      uo(ths,j,&u,&o,(INT)1);
+      ip_y = FABS((R)(n1) * ths->x[3*j+1] - (R)(u)) * ((R)ip_s);
+      ip_u = (INT)(LRINT(FLOOR(ip_y)));
+      ip_w = ip_y - (R)(ip_u);
+      for(l=0; l < 2*m+2; l++)
+        psij_const[2*m+2+l] = ths->psi[(K+1)+ABS(ip_u-l*ip_s)]*(K(1.0)-ip_w) +
+          ths->psi[(K+1)+ABS(ip_u-l*ip_s+1)]*(ip_w);
+
+      uo(ths,j,&u,&o,(INT)2);
+      ip_y = FABS((R)(n2) * ths->x[3*j+2] - (R)(u))*((R)ip_s);
+      ip_u = (INT)(LRINT(FLOOR(ip_y)));
+      ip_w = ip_y - (R)(ip_u);
+      for(l=0; l < 2*m+2; l++)
+        psij_const[2*(2*m+2)+l] = ths->psi[2*(K+1)+ABS(ip_u-l*ip_s)]*(K(1.0)-ip_w) +
+          ths->psi[2*(K+1)+ABS(ip_u-l*ip_s+1)]*(ip_w);
+
+#ifdef _OPENMP
+      nfft_adjoint_3d_compute_omp_atomic(ths->f[j], g, psij_const, psij_const+2*m+2, psij_const+(2*m+2)*2, ths->x+3*j, ths->x+3*j+1, ths->x+3*j+2, n0, n1, n2, m);
+#else
+      nfft_adjoint_3d_compute_serial(ths->f+j, g, psij_const, psij_const+2*m+2, psij_const+(2*m+2)*2, ths->x+3*j, ths->x+3*j+1, ths->x+3*j+2, n0, n1, n2, m);
+#endif
+    }
+    return;
+  } /* if(PRE_LIN_PSI) */
+
+  /* no precomputed psi at all */
+  sort(ths);
+
+#ifdef _OPENMP
+  MACRO_adjoint_3d_B_OMP_BLOCKWISE(NO_PSI)
+#endif
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+#endif
+  for (k = 0; k < M; k++)
+  {
+    INT u,o;
+    R psij_const[3*(2*m+2)];
+    INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
+
+    uo(ths,j,&u,&o,(INT)0);
+    window_psij(ths, 0, ths->x[3*j], u, psij_const);
+
+    uo(ths,j,&u,&o,(INT)1);
+    window_psij(ths, 1, ths->x[3*j+1], u, psij_const+2*m+2);
+
+    uo(ths,j,&u,&o,(INT)2);
+    window_psij(ths, 2, ths->x[3*j+2], u, psij_const+2*(2*m+2));
+
+#ifdef _OPENMP
+    nfft_adjoint_3d_compute_omp_atomic(ths->f[j], g, psij_const, psij_const+2*m+2, psij_const+(2*m+2)*2, ths->x+3*j, ths->x+3*j+1, ths->x+3*j+2, n0, n1, n2, m);
+#else
+    nfft_adjoint_3d_compute_serial(ths->f+j, g, psij_const, psij_const+2*m+2, psij_const+(2*m+2)*2, ths->x+3*j, ths->x+3*j+1, ths->x+3*j+2, n0, n1, n2, m);
+#endif
+  }
+}
+
+
+void X(trafo_3d)(X(plan) *ths)
+{
+  if((ths->N[0] <= ths->m) || (ths->N[1] <= ths->m) || (ths->N[2] <= ths->m) || (ths->n[0] <= 2*ths->m+2) || (ths->n[1] <= 2*ths->m+2) || (ths->n[2] <= 2*ths->m+2))
+  {
+    nfft_direct(ths, 0);
+    return;
+  }
+  
+  INT k0,k1,k2,n0,n1,n2,N0,N1,N2;
+  C *g_hat,*f_hat;
+  R *c_phi_inv01, *c_phi_inv02, *c_phi_inv11, *c_phi_inv12, *c_phi_inv21, *c_phi_inv22;
+  R ck01, ck02, ck11, ck12, ck21, ck22;
+  C *g_hat111,*f_hat111,*g_hat211,*f_hat211,*g_hat121,*f_hat121,*g_hat221,*f_hat221;
+  C *g_hat112,*f_hat112,*g_hat212,*f_hat212,*g_hat122,*f_hat122,*g_hat222,*f_hat222;
+
+  ths->g_hat=ths->g1;
+  ths->g=ths->g2;
+
+  N0=ths->N[0];
+  N1=ths->N[1];
+  N2=ths->N[2];
+  n0=ths->n[0];
+  n1=ths->n[1];
+  n2=ths->n[2];
+
+  f_hat=(C*)ths->f_hat;
+  g_hat=(C*)ths->g_hat;
+
+  TIC(0)
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k0) num_threads(ths->nthreads)
+  for (k0 = 0; k0 < ths->n_total; k0++)
+    ths->g_hat[k0] = 0.0;
+#else
+  nfft_zero(ths, ths->g_hat, (size_t)(ths->n_total) * sizeof(C));
+#endif
+
+  c_phi_inv01=ths->c_phi_inv[0];
+  c_phi_inv02=&ths->c_phi_inv[0][N0/2];
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k0,k1,k2,ck01,ck02,c_phi_inv11,c_phi_inv12,ck11,ck12,c_phi_inv21,c_phi_inv22,g_hat111,f_hat111,g_hat211,f_hat211,g_hat121,f_hat121,g_hat221,f_hat221,g_hat112,f_hat112,g_hat212,f_hat212,g_hat122,f_hat122,g_hat222,f_hat222,ck21,ck22) num_threads(ths->nthreads)
+#endif
+  for(k0=0;k0<N0/2;k0++)
+  {
+    ck01=c_phi_inv01[k0];
+    ck02=c_phi_inv02[k0];
+    c_phi_inv11=ths->c_phi_inv[1];
+    c_phi_inv12=&ths->c_phi_inv[1][N1/2];
+
+    for(k1=0;k1<N1/2;k1++)
+    {
+      ck11=c_phi_inv11[k1];
+      ck12=c_phi_inv12[k1];
+      c_phi_inv21=ths->c_phi_inv[2];
+      c_phi_inv22=&ths->c_phi_inv[2][N2/2];
+
+      g_hat111=g_hat + ((n0-(N0/2)+k0)*n1+n1-(N1/2)+k1)*n2+n2-(N2/2);
+      f_hat111=f_hat + (k0*N1+k1)*N2;
+      g_hat211=g_hat + (k0*n1+n1-(N1/2)+k1)*n2+n2-(N2/2);
+      f_hat211=f_hat + (((N0/2)+k0)*N1+k1)*N2;
+      g_hat121=g_hat + ((n0-(N0/2)+k0)*n1+k1)*n2+n2-(N2/2);
+      f_hat121=f_hat + (k0*N1+(N1/2)+k1)*N2;
+      g_hat221=g_hat + (k0*n1+k1)*n2+n2-(N2/2);
+      f_hat221=f_hat + (((N0/2)+k0)*N1+(N1/2)+k1)*N2;
+
+      g_hat112=g_hat + ((n0-(N0/2)+k0)*n1+n1-(N1/2)+k1)*n2;
+      f_hat112=f_hat + (k0*N1+k1)*N2+(N2/2);
+      g_hat212=g_hat + (k0*n1+n1-(N1/2)+k1)*n2;
+      f_hat212=f_hat + (((N0/2)+k0)*N1+k1)*N2+(N2/2);
+      g_hat122=g_hat + ((n0-(N0/2)+k0)*n1+k1)*n2;
+      f_hat122=f_hat + (k0*N1+N1/2+k1)*N2+(N2/2);
+      g_hat222=g_hat + (k0*n1+k1)*n2;
+      f_hat222=f_hat + (((N0/2)+k0)*N1+(N1/2)+k1)*N2+(N2/2);
+
+      for(k2=0;k2<N2/2;k2++)
+      {
+        ck21=c_phi_inv21[k2];
+        ck22=c_phi_inv22[k2];
+
+        g_hat111[k2] = f_hat111[k2] * ck01 * ck11 * ck21;
+        g_hat211[k2] = f_hat211[k2] * ck02 * ck11 * ck21;
+        g_hat121[k2] = f_hat121[k2] * ck01 * ck12 * ck21;
+        g_hat221[k2] = f_hat221[k2] * ck02 * ck12 * ck21;
+
+        g_hat112[k2] = f_hat112[k2] * ck01 * ck11 * ck22;
+        g_hat212[k2] = f_hat212[k2] * ck02 * ck11 * ck22;
+        g_hat122[k2] = f_hat122[k2] * ck01 * ck12 * ck22;
+        g_hat222[k2] = f_hat222[k2] * ck02 * ck12 * ck22;
+      }
+    }
+  }
+
+  TOC(0)
+
+  TIC_FFTW(1)
+  nfft_fftw_execute_A(ths);
+  TOC_FFTW(1);
+
+  TIC(2);
+  nfft_trafo_3d_B(ths);
+  TOC(2);
+}
+
+void X(adjoint_3d)(X(plan) *ths)
+{
+  if((ths->N[0] <= ths->m) || (ths->N[1] <= ths->m) || (ths->N[2] <= ths->m) || (ths->n[0] <= 2*ths->m+2) || (ths->n[1] <= 2*ths->m+2) || (ths->n[2] <= 2*ths->m+2))
+  {
+    nfft_direct(ths, 1);
+    return;
+  }
+  
+  INT k0,k1,k2,n0,n1,n2,N0,N1,N2;
+  C *g_hat,*f_hat;
+  R *c_phi_inv01, *c_phi_inv02, *c_phi_inv11, *c_phi_inv12, *c_phi_inv21, *c_phi_inv22;
+  R ck01, ck02, ck11, ck12, ck21, ck22;
+  C *g_hat111,*f_hat111,*g_hat211,*f_hat211,*g_hat121,*f_hat121,*g_hat221,*f_hat221;
+  C *g_hat112,*f_hat112,*g_hat212,*f_hat212,*g_hat122,*f_hat122,*g_hat222,*f_hat222;
+
+  ths->g_hat=ths->g1;
+  ths->g=ths->g2;
+
+  N0=ths->N[0];
+  N1=ths->N[1];
+  N2=ths->N[2];
+  n0=ths->n[0];
+  n1=ths->n[1];
+  n2=ths->n[2];
+
+  f_hat=(C*)ths->f_hat;
+  g_hat=(C*)ths->g_hat;
+
+  TIC(2);
+  nfft_adjoint_3d_B(ths);
+  TOC(2);
+
+  TIC_FFTW(1)
+  nfft_fftw_execute_T(ths);
+  TOC_FFTW(1);
+
+  TIC(0)
+  c_phi_inv01=ths->c_phi_inv[0];
+  c_phi_inv02=&ths->c_phi_inv[0][N0/2];
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k0,k1,k2,ck01,ck02,c_phi_inv11,c_phi_inv12,ck11,ck12,c_phi_inv21,c_phi_inv22,g_hat111,f_hat111,g_hat211,f_hat211,g_hat121,f_hat121,g_hat221,f_hat221,g_hat112,f_hat112,g_hat212,f_hat212,g_hat122,f_hat122,g_hat222,f_hat222,ck21,ck22) num_threads(ths->nthreads)
+#endif
+  for(k0=0;k0<N0/2;k0++)
+  {
+    ck01=c_phi_inv01[k0];
+    ck02=c_phi_inv02[k0];
+    c_phi_inv11=ths->c_phi_inv[1];
+    c_phi_inv12=&ths->c_phi_inv[1][N1/2];
+
+    for(k1=0;k1<N1/2;k1++)
+    {
+      ck11=c_phi_inv11[k1];
+      ck12=c_phi_inv12[k1];
+      c_phi_inv21=ths->c_phi_inv[2];
+      c_phi_inv22=&ths->c_phi_inv[2][N2/2];
+
+      g_hat111=g_hat + ((n0-(N0/2)+k0)*n1+n1-(N1/2)+k1)*n2+n2-(N2/2);
+      f_hat111=f_hat + (k0*N1+k1)*N2;
+      g_hat211=g_hat + (k0*n1+n1-(N1/2)+k1)*n2+n2-(N2/2);
+      f_hat211=f_hat + (((N0/2)+k0)*N1+k1)*N2;
+      g_hat121=g_hat + ((n0-(N0/2)+k0)*n1+k1)*n2+n2-(N2/2);
+      f_hat121=f_hat + (k0*N1+(N1/2)+k1)*N2;
+      g_hat221=g_hat + (k0*n1+k1)*n2+n2-(N2/2);
+      f_hat221=f_hat + (((N0/2)+k0)*N1+(N1/2)+k1)*N2;
+
+      g_hat112=g_hat + ((n0-(N0/2)+k0)*n1+n1-(N1/2)+k1)*n2;
+      f_hat112=f_hat + (k0*N1+k1)*N2+(N2/2);
+      g_hat212=g_hat + (k0*n1+n1-(N1/2)+k1)*n2;
+      f_hat212=f_hat + (((N0/2)+k0)*N1+k1)*N2+(N2/2);
+      g_hat122=g_hat + ((n0-(N0/2)+k0)*n1+k1)*n2;
+      f_hat122=f_hat + (k0*N1+(N1/2)+k1)*N2+(N2/2);
+      g_hat222=g_hat + (k0*n1+k1)*n2;
+      f_hat222=f_hat + (((N0/2)+k0)*N1+(N1/2)+k1)*N2+(N2/2);
+
+      for(k2=0;k2<N2/2;k2++)
+      {
+        ck21=c_phi_inv21[k2];
+        ck22=c_phi_inv22[k2];
+
+        f_hat111[k2] = g_hat111[k2] * ck01 * ck11 * ck21;
+        f_hat211[k2] = g_hat211[k2] * ck02 * ck11 * ck21;
+        f_hat121[k2] = g_hat121[k2] * ck01 * ck12 * ck21;
+        f_hat221[k2] = g_hat221[k2] * ck02 * ck12 * ck21;
+
+        f_hat112[k2] = g_hat112[k2] * ck01 * ck11 * ck22;
+        f_hat212[k2] = g_hat212[k2] * ck02 * ck11 * ck22;
+        f_hat122[k2] = g_hat122[k2] * ck01 * ck12 * ck22;
+        f_hat222[k2] = g_hat222[k2] * ck02 * ck12 * ck22;
+      }
+    }
+  }
+
+  TOC(0)
+}
+
+/* ########################################## SPECIFIC VERSIONS FOR d=6 */
+
+/* The kernels for d=6 are generated by MACRO_nd_compute(D) with the dimension
+ * D as a constant. The taps in the first D-1 dimensions are visited by D-1
+ * nested loops, each updating the offset off[t+1] in g and the window product
+ * w[t+1] of its level only. The 2m+2 taps of the last dimension are contiguous
+ * in g up to one wraparound. For d=4,5 the generic B_A and B_T already
+ * unroll the dimension loop, nested loops gain too little there. */
+
+/** grid indices (u[t]+l) mod n[t] of the first D-1 dimensions */
+#define MACRO_nd_init_index_temp(D) \
+{ \
+  for (t = 0; t < D-1; t++) \
+    for (l = 0; l < l_max; l++) \
+      index_temp[t*l_max+l] = (u[t]+l) % n[t]; \
+  off[0] = 0; \
+  w[0] = K(1.0); \
+}
+
+/** loop over the taps of dimension t, skipping those where skip holds */
+#define MACRO_nd_level(t, skip, inner) \
+{ \
+  INT l ## t; \
+  for (l ## t = 0; l ## t < l_max; l ## t++) \
+  { \
+    if (skip) \
+      continue; \
+    off[t+1] = off[t]*n[t] + index_temp[t*l_max+l ## t]; \
+    w[t+1] = w[t]*psij_const[t*l_max+l ## t]; \
+    inner \
+  } \
+}
+
+#define MACRO_nd_skip(t) (index_temp[t*l_max+l ## t] < my_u0 \
+  || index_temp[t*l_max+l ## t] > my_o0)
+
+#define MACRO_nd_rows_6(skip0, row) \
+  MACRO_nd_level(0, skip0, MACRO_nd_level(1, 0, MACRO_nd_level(2, 0, \
+    MACRO_nd_level(3, 0, MACRO_nd_level(4, 0, row)))))
+
+#define MACRO_nd_trafo_row(D) \
+{ \
+  const C *gr = g + off[D-1]*n[D-1]; \
+  C r = K(0.0); \
+ \
+  for (l = 0; l < len0; l++) \
+    r += psi_last[l] * gr[u[D-1]+l]; \
+  for (l = len0; l < l_max; l++) \
+    r += psi_last[l] * gr[l-len0]; \
+ \
+  f += w[D-1] * r; \
+}
+
+#ifdef _OPENMP
+#define MACRO_nd_atomic_add(gl, val) \
+{ \
+  R *gl_real = (R*)(gl); \
+  const C val_ = (val); \
+  _Pragma("omp atomic") \
+  gl_real[0] += CREAL(val_); \
+  _Pragma("omp atomic") \
+  gl_real[1] += CIMAG(val_); \
+}
+#else
+#define MACRO_nd_atomic_add(gl, val) (*(gl) += (val))
+#endif
+
+#define MACRO_nd_adjoint_row(D) \
+{ \
+  C *gr = g + off[D-1]*n[D-1]; \
+  const C wf = w[D-1] * fj; \
+ \
+  if (atomic) \
+  { \
+    for (l = 0; l < l_max; l++) \
+      MACRO_nd_atomic_add(gr + (l < len0 ? u[D-1]+l : l-len0), \
+        psi_last[l] * wf); \
+  } \
+  else \
+  { \
+    for (l = 0; l < len0; l++) \
+      gr[u[D-1]+l] += psi_last[l] * wf; \
+    for (l = len0; l < l_max; l++) \
+      gr[l-len0] += psi_last[l] * wf; \
+  } \
+}
+
+#define MACRO_nd_compute(D) \
+static void nfft_trafo_ ## D ## d_compute(C *fj, const C *g, \
+    const R *psij_const, const INT *n, const INT *u, const INT m) \
+{ \
+  const INT l_max = 2*m+2; \
+  const R *psi_last = psij_const + (D-1)*l_max; \
+  const INT len0 = MIN(l_max, n[D-1] - u[D-1]); \
+  INT index_temp[(D-1)*(2*m+2)]; \
+  INT off[D]; \
+  R w[D]; \
+  INT t, l; \
+  C f = K(0.0); \
+ \
+  MACRO_nd_init_index_temp(D); \
+ \
+  MACRO_nd_rows_ ## D(0, MACRO_nd_trafo_row(D)) \
+ \
+  *fj = f; \
+} \
+ \
+static void nfft_adjoint_ ## D ## d_compute(const C fj, C *g, \
+    const R *psij_const, const INT *n, const INT *u, const INT m, \
+    const INT my_u0, const INT my_o0, const int atomic) \
+{ \
+  const INT l_max = 2*m+2; \
+  const R *psi_last = psij_const + (D-1)*l_max; \
+  const INT len0 = MIN(l_max, n[D-1] - u[D-1]); \
+  INT index_temp[(D-1)*(2*m+2)]; \
+  INT off[D]; \
+  R w[D]; \
+  INT t, l; \
+ \
+  MACRO_nd_init_index_temp(D); \
+ \
+  MACRO_nd_rows_ ## D(MACRO_nd_skip(0), MACRO_nd_adjoint_row(D)) \
+}
+
+MACRO_nd_compute(6)
+
+/** Window values psij_const and first grid indices 0 <= u[t] < n[t] of node j
+ *  for d=6. */
+static void nfft_nd_psij(const X(plan) *ths, const INT j, const R *fg_exp_l,
+  INT *u, R *psij_const)
+{
+  INT t, o;
+
+  for (t = 0; t < ths->d; t++)
+    uo(ths, j, &u[t], &o, t);
+
+  nfft_B_psij(ths, j, u, fg_exp_l, psij_const);
+
+  for (t = 0; t < ths->d; t++)
+    u[t] = (u[t] + ths->n[t]) % ths->n[t];
+}
+
+static void nfft_adjoint_nd_node(X(plan) *ths, const INT j, const R *fg_exp_l,
+  const INT my_u0, const INT my_o0, const int atomic)
+{
+  const INT m = ths->m;
+  INT u[ths->d];
+  R psij_const[ths->d*(2*m+2)];
+
+  nfft_nd_psij(ths, j, fg_exp_l, u, psij_const);
+
+  nfft_adjoint_6d_compute(ths->f[j], ths->g, psij_const, ths->n, u, m, my_u0,
+    my_o0, atomic);
+}
+
+/** Multiplication with B for d=6, other dimensions and the schemes
+ *  PRE_FULL_PSI, NFFT_MIXED_PRECISION use B_A. */
+static void nfft_trafo_nd_B(X(plan) *ths)
+{
+  const INT d = ths->d, M = ths->M_total, m = ths->m;
+  R fg_exp_l[d*(2*m+2)];
+  INT k;
+
+  if (d != 6 || (ths->flags & (PRE_FULL_PSI | NFFT_MIXED_PRECISION)))
+  {
+    B_A(ths);
+    return;
+  }
+
+  if (ths->flags & (PRE_FG_PSI | FG_PSI))
+    nfft_B_init_fg_exp_l(ths, fg_exp_l);
+
+  sort(ths);
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+#endif
+  for (k = 0; k < M; k++)
+  {
+    const INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
+    INT u[d];
+    R psij_const[d*(2*m+2)];
+
+    nfft_nd_psij(ths, j, fg_exp_l, u, psij_const);
+
+    nfft_trafo_6d_compute(ths->f+j, ths->g, psij_const, ths->n, u, m);
+  }
+}
+
+/** Multiplication with B^T for d=6, other dimensions and the schemes
+ *  PRE_FULL_PSI, NFFT_MIXED_PRECISION and NFFT_OMP_TILED_ADJOINT use B_T. */
+static void nfft_adjoint_nd_B(X(plan) *ths)
+{
+  const INT d = ths->d, M = ths->M_total, m = ths->m;
+  R fg_exp_l[d*(2*m+2)];
+  INT k;
+
+  if (d != 6 || (ths->flags & (PRE_FULL_PSI | NFFT_MIXED_PRECISION))
+#ifdef _OPENMP
+    || (ths->flags & NFFT_OMP_TILED_ADJOINT)
+#endif
+    )
+  {
+    B_T(ths);
+    return;
+  }
+
+  nfft_zero(ths, ths->g, (size_t)(ths->n_total) * sizeof(C));
+
+  if (ths->flags & (PRE_FG_PSI | FG_PSI))
+    nfft_B_init_fg_exp_l(ths, fg_exp_l);
+
+  sort(ths);
+
+#ifdef _OPENMP
+  if (ths->flags & NFFT_OMP_BLOCKWISE_ADJOINT)
+  {
+    #pragma omp parallel private(k) num_threads(ths->nthreads)
+    {
+      INT my_u0, my_o0, min_u_a, max_u_a, min_u_b, max_u_b;
+      const INT *ar_x = ths->index_x;
+
+      nfft_adjoint_B_omp_blockwise_init(&my_u0, &my_o0, &min_u_a, &max_u_a,
+          &min_u_b, &max_u_b, d, ths->n, m);
+
+      if (min_u_a != -1)
+      {
+        k = index_x_binary_search(ar_x, M, min_u_a);
+
+        MACRO_adjoint_nd_B_OMP_BLOCKWISE_ASSERT_A
+
+        while (k < M && ar_x[2*k] >= min_u_a && ar_x[2*k] <= max_u_a)
+        {
+          nfft_adjoint_nd_node(ths, ar_x[2*k+1], fg_exp_l, my_u0, my_o0, 0);
+          k++;
+        }
+      }
+
+      if (min_u_b != -1)
+      {
+        k = index_x_binary_search(ar_x, M, min_u_b);
+
+        MACRO_adjoint_nd_B_OMP_BLOCKWISE_ASSERT_B
+
+        while (k < M && ar_x[2*k] >= min_u_b && ar_x[2*k] <= max_u_b)
+        {
+          nfft_adjoint_nd_node(ths, ar_x[2*k+1], fg_exp_l, my_u0, my_o0, 0);
+          k++;
+        }
+      }
+    } /* omp parallel */
+    return;
+  } /* if(NFFT_OMP_BLOCKWISE_ADJOINT) */
+
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+  for (k = 0; k < M; k++)
+  {
+    const INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
+    nfft_adjoint_nd_node(ths, j, fg_exp_l, 0, ths->n[0]-1, 1);
+  }
+#else
+  for (k = 0; k < M; k++)
+  {
+    const INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
+    nfft_adjoint_nd_node(ths, j, fg_exp_l, 0, ths->n[0]-1, 0);
+  }
+#endif
+}
+
+/** user routines
+ */
+void X(trafo)(X(plan) *ths)
+{
+  ths->stats.trafo_calls++;
+  nfft_stats_count(ths, ths->M_total, ths->howmany, ths->howmany);
+
+  if (ths->flags & NFFT_REAL)
+  {
+    X(trafo_real)(ths);
+    return;
+  }
+
+  if (ths->howmany > 1)
+  {
+    X(trafo_many)(ths);
+    return;
+  }
+
+  /* use direct transform if degree N is too low */
+  for (int j = 0; j < ths->d; j++)
+  {
+    if((ths->N[j] <= ths->m) || (ths->n[j] <= 2*ths->m+2))
+    {
+      nfft_direct(ths, 0);
+      return;
+    }
+  }
+  
+  switch(ths->d)
+  {
+    case 1: X(trafo_1d)(ths); break;
+    case 2: X(trafo_2d)(ths); break;
+    case 3: X(trafo_3d)(ths); break;
+    default:
+    {
+      /* use ths->my_fftw_plan1 */
+      ths->g_hat = ths->g1;
+      ths->g = ths->g2;
+
+      /** form \f$ \hat g_k = \frac{\hat f_k}{c_k\left(\phi\right)} \text{ for }
+       *  k \in I_N \f$
+       */
+      TIC(0)
+      D_A(ths);
+      TOC(0)
+
+      /** compute by d-variate discrete Fourier transform
+       *  \f$ g_l = \sum_{k \in I_N} \hat g_k {\rm e}^{-2\pi {\rm i} \frac{kl}{n}}
+       *  \text{ for } l \in I_n \f$
+       */
+      TIC_FFTW(1)
+      nfft_fftw_execute_A(ths);
+      TOC_FFTW(1)
+
+      /** set \f$ f_j =\sum_{l \in I_n,m(x_j)} g_l \psi\left(x_j-\frac{l}{n}\right)
+       *  \text{ for } j=0,\dots,M_total-1 \f$
+       */
+      TIC(2)
+      nfft_trafo_nd_B(ths);
+      TOC(2)
+    }
+  }
+} /* nfft_trafo */
+
+void X(adjoint)(X(plan) *ths)
+{
+  ths->stats.adjoint_calls++;
+  nfft_stats_count(ths, ths->M_total, ths->howmany, ths->howmany);
+
+  if (ths->flags & NFFT_REAL)
+  {
+    X(adjoint_real)(ths);
+    return;
+  }
+
+  if (ths->howmany > 1)
+  {
+    X(adjoint_many)(ths);
+    return;
+  }
+
+  /* use direct transform if degree N is too low */
+  for (int j = 0; j < ths->d; j++)
+  {
+    if((ths->N[j] <= ths->m) || (ths->n[j] <= 2*ths->m+2))
+    {
+      nfft_direct(ths, 1);
+      return;
+    }
+  }
+  
+  switch(ths->d)
+  {
+    case 1: X(adjoint_1d)(ths); break;
+    case 2: X(adjoint_2d)(ths); break;
+    case 3: X(adjoint_3d)(ths); break;
+    default:
+    {
+      /* use ths->my_fftw_plan2 */
+      ths->g_hat=ths->g1;
+      ths->g=ths->g2;
+      
+      /** set \f$ g_l = \sum_{j=0}^{M_total-1} f_j \psi\left(x_j-\frac{l}{n}\right)
+       *  \text{ for } l \in I_n,m(x_j) \f$
+       */
+      TIC(2)
+      nfft_adjoint_nd_B(ths);
+      TOC(2)
+
+      /** compute by d-variate discrete Fourier transform
+       *  \f$ \hat g_k = \sum_{l \in I_n} g_l {\rm e}^{+2\pi {\rm i} \frac{kl}{n}}
+       *  \text{ for }  k \in I_N\f$
+       */
+      TIC_FFTW(1)
+      nfft_fftw_execute_T(ths);
+      TOC_FFTW(1)
+
+      /** form \f$ \hat f_k = \frac{\hat g_k}{c_k\left(\phi\right)} \text{ for }
+       *  k \in I_N \f$
+       */
+      TIC(0)
+      D_T(ths);
+      TOC(0)
+    }
+  }
+} /* nfft_adjoint */
+
+/* sub routines for the batched transforms, the oversampled vectors g_hat and g
+ * hold all ths->howmany vectors interleaved, i.e. entry l of vector v is stored
+ * at g[l*howmany+v], such that one window evaluation serves all vectors */
+static inline R D_many_index(const X(plan) *ths, const INT k_L, INT *k_plain,
+  INT *ks_plain)
+{
+  INT kp, k, ks; /* index in one dimension */
+  INT t, k_temp = k_L; /* index dimensions */
+  INT k_stride = 1, ks_stride = 1;
+  R c_phi_inv_k = K(1.0);
+
+  *k_plain = 0;
+  *ks_plain = 0;
+
+  for (t = ths->d-1; t >= 0; t--)
+  {
+    kp = k_temp % ths->N[t];
+    k = (kp >= ths->N[t]/2) ? ths->n[t] - ths->N[t] + kp : kp;
+    ks = (kp + ths->N[t]/2) % ths->N[t];
+    k_temp /= ths->N[t];
+
+    c_phi_inv_k *= ths->c_phi_inv[t][ks];
+
+    *k_plain += k * k_stride;
+    *ks_plain += ks * ks_stride;
+    k_stride *= ths->n[t];
+    ks_stride *= ths->N[t];
+  }
+
+  return c_phi_inv_k;
+}
+
+static void D_many_A(X(plan) *ths)
+{
+  const INT howmany = ths->howmany;
+  INT k_L; /* plain index */
+
+  nfft_zero(ths, ths->g_hat, (size_t)(ths->n_total * howmany) * sizeof(C));
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k_L) num_threads(ths->nthreads)
+#endif
+  for (k_L = 0; k_L < ths->N_total; k_L++)
+  {
+    INT k_plain, ks_plain, v;
+    const R c_phi_inv_k = D_many_index(ths, k_L, &k_plain, &ks_plain);
+    C *g_hat_k = ths->g_hat + k_plain * howmany;
+    const C *f_hat_k = ths->f_hat + ks_plain * ths->stride;
+
+    for (v = 0; v < howmany; v++)
+      g_hat_k[v] = f_hat_k[v * ths->f_hat_dist] * c_phi_inv_k;
+  }
+}
+
+static void D_many_T(X(plan) *ths)
+{
+  const INT howmany = ths->howmany;
+  INT k_L; /* plain index */
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k_L) num_threads(ths->nthreads)
+#endif
+  for (k_L = 0; k_L < ths->N_total; k_L++)
+  {
+    INT k_plain, ks_plain, v;
+    const R c_phi_inv_k = D_many_index(ths, k_L, &k_plain, &ks_plain);
+    const C *g_hat_k = ths->g_hat + k_plain * howmany;
+    C *f_hat_k = ths->f_hat + ks_plain * ths->stride;
+
+    for (v = 0; v < howmany; v++)
+      f_hat_k[v * ths->f_hat_dist] = g_hat_k[v] * c_phi_inv_k;
+  }
+}
+
+/** g_l += psi * f_j for all vectors of the batch, with atomic operations if
+ *  atomic is set */
+static inline void nfft_B_many_T_add(C *gl, const C *fj, const R psi,
+  const INT howmany, const INT f_dist, const int atomic)
+{
+  INT v;
+
+#ifdef _OPENMP
+  if (atomic)
+  {
+    for (v = 0; v < howmany; v++)
+    {
+      C val = psi * fj[v*f_dist];
+      R *gref_real = (R*) (gl + v);
+
+      #pragma omp atomic
+      gref_real[0] += CREAL(val);
+
+      #pragma omp atomic
+      gref_real[1] += CIMAG(val);
+    }
+    return;
+  }
+#else
+  UNUSED(atomic);
+#endif
+
+  for (v = 0; v < howmany; v++)
+    gl[v] += psi * fj[v*f_dist];
+}
+
+/** g_l += psi * f_j for real samples */
+static inline void nfft_B_real_T_add(R *gl, const R *fj, const R psi,
+  const INT howmany, const INT f_dist, const int atomic)
+{
+  INT v;
+
+#ifdef _OPENMP
+  if (atomic)
+  {
+    for (v = 0; v < howmany; v++)
+    {
+      #pragma omp atomic
+      gl[v] += psi * fj[v*f_dist];
+    }
+    return;
+  }
+#else
+  UNUSED(atomic);
+#endif
+
+  for (v = 0; v < howmany; v++)
+    gl[v] += psi * fj[v*f_dist];
+}
+
+/* B step applied node by node, with element type T of the sample vectors
+ * ths->f_vec and ths->g_vec and accumulation routine T_add for B^T. The node
+ * routine name_node has the arguments of nfft_adjoint_node_t with par =
+ * fg_exp_l, such that B^T runs with the strategies of the adjoint in the
+ * flags of the plan. */
+#define MACRO_B_many(which_one, name, T, f_vec, g_vec, T_add) \
+static void name ## _node(X(plan) *ths, const INT j, const R *fg_exp_l, \
+  const INT i0_lo, const INT i0_hi, const int atomic) \
+{ \
+  const INT howmany = ths->howmany; \
+  const INT l_max = 2*ths->m+2; \
+  const INT n_rest = ths->n_total / ths->n[0]; \
+  const int all = (i0_lo == 0 && i0_hi == ths->n[0] - 1); \
+  T *fj = ths->f_vec + j*ths->stride; \
+  INT lprod; /* 'regular bandwidth' of matrix B  */ \
+  INT l_L; /* index one row of B */ \
+  INT t, t2; /* index dimensions */ \
+ \
+  for (t = 0, lprod = 1; t < ths->d; t++) \
+    lprod *= l_max; \
+ \
+  MACRO_B_many_init_node_ ## which_one; \
+ \
+  if (ths->flags & PRE_FULL_PSI) \
+  { \
+    for (l_L = 0; l_L < lprod; l_L++) \
+    { \
+      const INT ix = ths->psi_index_g[j*lprod+l_L]; \
+      const R psi_l = ths->psi[j*lprod+l_L]; \
+      T *gl = ths->g_vec + ix*howmany; \
+ \
+      if (!all && (ix / n_rest < i0_lo || ix / n_rest > i0_hi)) \
+        continue; \
+ \
+      MACRO_B_many_compute_ ## which_one(psi_l, T_add); \
+    } \
+  } \
+  else \
+  { \
+    INT u[ths->d], o[ths->d]; /* multi band with respect to x_j */ \
+    INT lj[ths->d]; /* multi index 0<=lj<u+o+1 */ \
+    INT ll_plain[ths->d+1]; /* postfix plain index in g */ \
+    R phi_prod[ths->d+1]; /* postfix product of PHI */ \
+    R psij_const[ths->d*l_max]; \
+ \
+    phi_prod[0] = K(1.0); \
+    ll_plain[0] = 0; \
+ \
+    MACRO_init_uo_l_lj_t; \
+ \
+    nfft_B_psij(ths, j, u, fg_exp_l, psij_const); \
+ \
+    for (l_L = 0; l_L < lprod; l_L++) \
+    { \
+      T *gl; \
+ \
+      MACRO_update_phi_prod_ll_plain(without_PRE_PSI_improved); \
+ \
+      if (all || (l_all[lj[0]] >= i0_lo && l_all[lj[0]] <= i0_hi)) \
+      { \
+        gl = ths->g_vec + ll_plain[ths->d]*howmany; \
+        MACRO_B_many_compute_ ## which_one(phi_prod[ths->d], T_add); \
+      } \
+ \
+      MACRO_count_uo_l_lj_t; \
+    } /* for(l_L) */ \
+  } \
+} \
+ \
+static void name (X(plan) *ths) \
+{ \
+  const INT howmany = ths->howmany; \
+  const INT l_max = 2*ths->m+2; \
+  INT k; /* index nodes */ \
+  R fg_exp_l[ths->d*l_max]; \
+ \
+  UNUSED(howmany); \
+ \
+  MACRO_B_many_init_result_ ## which_one(T, g_vec); \
+ \
+  if (ths->flags & (PRE_FG_PSI | FG_PSI)) \
+    nfft_B_init_fg_exp_l(ths, fg_exp_l); \
+ \
+  sort(ths); \
+ \
+  MACRO_B_many_nodes_ ## which_one(name ## _node) \
+}
+
+#define MACRO_B_many_init_result_A(T, g_vec)
+#define MACRO_B_many_init_result_T(T, g_vec) \
+  nfft_zero(ths, ths->g_vec, (size_t)(ths->n_total * howmany) * sizeof(T));
+
+#define MACRO_B_many_init_node_A \
+{ \
+  INT v; \
+  UNUSED(atomic); \
+  for (v = 0; v < howmany; v++) \
+    fj[v*ths->f_dist] = K(0.0); \
+}
+#define MACRO_B_many_init_node_T
+
+#define MACRO_B_many_compute_A(psi_l, T_add) \
+{ \
+  INT v; \
+  for (v = 0; v < howmany; v++) \
+    fj[v*ths->f_dist] += (psi_l) * gl[v]; \
+}
+#define MACRO_B_many_compute_T(psi_l, T_add) \
+  T_add(gl, fj, (psi_l), howmany, ths->f_dist, atomic);
+
+/* all nodes, each one by one thread, with atomic operations for B^T */
+#ifdef _OPENMP
+#define MACRO_B_many_nodes_all(node, atomic) \
+{ \
+  _Pragma("omp parallel for default(shared) private(k) num_threads(ths->nthreads)") \
+  for (k = 0; k < ths->M_total; k++) \
+  { \
+    const INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k; \
+    node(ths, j, fg_exp_l, 0, ths->n[0] - 1, atomic); \
+  } \
+}
+#else
+#define MACRO_B_many_nodes_all(node, atomic) \
+{ \
+  for (k = 0; k < ths->M_total; k++) \
+  { \
+    const INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k; \
+    node(ths, j, fg_exp_l, 0, ths->n[0] - 1, atomic); \
+  } \
+}
+#endif
+
+#define MACRO_B_many_nodes_A(node) MACRO_B_many_nodes_all(node, 0)
+
+/* B^T by the tiled or the blockwise adjoint if chosen, without atomic
+ * operations */
+#ifdef _OPENMP
+#define MACRO_B_many_nodes_T(node) \
+  if (ths->flags & NFFT_OMP_TILED_ADJOINT) \
+    nfft_adjoint_B_nodes_tiled(ths, node, fg_exp_l); \
+  else if (ths->flags & NFFT_OMP_BLOCKWISE_ADJOINT) \
+    nfft_adjoint_B_nodes_blockwise(ths, node, fg_exp_l); \
+  else \
+    MACRO_B_many_nodes_all(node, 1)
+#else
+#define MACRO_B_many_nodes_T(node) MACRO_B_many_nodes_all(node, 0)
+#endif
+
+MACRO_B_many(A, B_many_A, C, f, g, nfft_B_many_T_add)
+MACRO_B_many(T, B_many_T, C, f, g, nfft_B_many_T_add)
+MACRO_B_many(A, B_real_A, R, f_r, g_r, nfft_B_real_T_add)
+MACRO_B_many(T, B_real_T, R, f_r, g_r, nfft_B_real_T_add)
+
+/** applies the direct transform or its adjoint to each vector of the batch,
+ *  in place on the strided f_hat and f, one exponential serving all vectors */
+static void nfft_direct_many(X(plan) *ths, const int adjoint)
+{
+  const INT d = ths->d, howmany = ths->howmany, stride = ths->stride;
+  const INT count = adjoint ? ths->N_total : ths->M_total;
+  INT i;
+
+  STATS_TIC(NFFT_STATS_OTHER)
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(i) num_threads(ths->nthreads)
+#endif
+  for (i = 0; i < count; i++)
+  {
+    const INT out_dist = adjoint ? ths->f_hat_dist : ths->f_dist;
+    const INT in_dist = adjoint ? ths->f_dist : ths->f_hat_dist;
+    const INT in_count = adjoint ? ths->M_total : ths->N_total;
+    C *out = (adjoint ? ths->f_hat : ths->f) + i * stride;
+    const C *in = adjoint ? ths->f : ths->f_hat;
+    INT k[d], l, t, v, k_temp;
+
+    for (v = 0; v < howmany; v++)
+      out[v * out_dist] = K(0.0);
+
+    /* the frequency of f_hat[i] for the adjoint */
+    for (t = d - 1, k_temp = i; adjoint && t >= 0; t--)
+    {
+      k[t] = k_temp % ths->N[t] - ths->N[t]/2;
+      k_temp /= ths->N[t];
+    }
+
+    for (l = 0; l < in_count; l++)
+    {
+      const R *x = ths->x + (adjoint ? l : i) * d;
+      const C *in_l = in + l * stride;
+      R omega = K(0.0);
+      C e;
+
+      /* the frequency of f_hat[l] for the transform */
+      for (t = d - 1, k_temp = l; !adjoint && t >= 0; t--)
+      {
+        k[t] = k_temp % ths->N[t] - ths->N[t]/2;
+        k_temp /= ths->N[t];
+      }
+
+      for (t = 0; t < d; t++)
+        omega += (R)(k[t]) * K2PI * x[t];
+
+      e = adjoint ? BASE(II * omega) : BASE(-II * omega);
+
+      for (v = 0; v < howmany; v++)
+        out[v * out_dist] += in_l[v * in_dist] * e;
+    }
+  }
+  STATS_TOC(NFFT_STATS_OTHER)
+}
+
+void X(trafo_many)(X(plan) *ths)
+{
+  /* use direct transform if degree N is too low */
+  for (int j = 0; j < ths->d; j++)
+  {
+    if((ths->N[j] <= ths->m) || (ths->n[j] <= 2*ths->m+2))
+    {
+      nfft_direct_many(ths, 0);
+      return;
+    }
+  }
+
+  /* use ths->my_fftw_plan1 */
+  ths->g_hat = ths->g1;
+  ths->g = ths->g2;
+
+  TIC(0)
+  D_many_A(ths);
+  TOC(0)
+
+  /** compute howmany d-variate discrete Fourier transforms with one plan */
+  TIC_FFTW(1)
+  FFTW(execute)(ths->my_fftw_plan1);
+  TOC_FFTW(1)
+
+  TIC(2)
+  B_many_A(ths);
+  TOC(2)
+} /* nfft_trafo_many */
+
+void X(adjoint_many)(X(plan) *ths)
+{
+  /* use direct transform if degree N is too low */
+  for (int j = 0; j < ths->d; j++)
+  {
+    if((ths->N[j] <= ths->m) || (ths->n[j] <= 2*ths->m+2))
+    {
+      nfft_direct_many(ths, 1);
+      return;
+    }
+  }
+
+  /* use ths->my_fftw_plan2 */
+  ths->g_hat = ths->g1;
+  ths->g = ths->g2;
+
+  TIC(2)
+  B_many_T(ths);
+  TOC(2)
+
+  TIC_FFTW(1)
+  FFTW(execute)(ths->my_fftw_plan2);
+  TOC_FFTW(1)
+
+  TIC(0)
+  D_many_T(ths);
+  TOC(0)
+} /* nfft_adjoint_many */
+
+/* sub routines for the real transforms, the c2r/r2c transforms of FFTW work
+ * on the half spectrum g1 of size n_0 x ... x n_{d-2} x (n_{d-1}/2+1) */
+static inline INT nfft_real_index(const X(plan) *ths, const INT *k)
+{
+  INT t, k_plain = 0;
+
+  for (t = 0; t < ths->d-1; t++)
+    k_plain = k_plain*ths->n[t] + (k[t] + ths->n[t]) % ths->n[t];
+
+  return k_plain*(ths->n[ths->d-1]/2+1) + k[ths->d-1];
+}
+
+/** returns \f$\hat f_k / c_k(\phi)\f$ for \f$-N/2 \le k \le N/2\f$, zero
+ *  outside of \f$I_N\f$ */
+static inline C nfft_real_coeff(const X(plan) *ths, const INT *k)
+{
+  INT t, ks_plain = 0;
+  R c_phi_inv_k = K(1.0);
+
+  for (t = 0; t < ths->d; t++)
+  {
+    const INT ks = k[t] + ths->N[t]/2;
+
+    if (ks < 0 || ks >= ths->N[t])
+      return K(0.0);
+
+    c_phi_inv_k *= ths->c_phi_inv[t][ks];
+
+    ks_plain = ks_plain*ths->N[t] + ks;
+  }
+
+  return ths->f_hat[ks_plain] * c_phi_inv_k;
+}
+
+/** forms the half spectrum of the Hermitian part of \f$\hat g\f$, conjugated
+ *  such that the backward c2r transform yields \f${\rm Re}(F \hat g)\f$ */
+static void D_real_A(X(plan) *ths)
+{
+  const INT d = ths->d;
+  INT k_L, k_total, t;
+
+  for (t = 0, k_total = ths->N[d-1]/2+1; t < d-1; t++)
+    k_total *= ths->N[t] + 1;
+
+  nfft_zero(ths, ths->g_hat, (size_t)(ths->n_total / ths->n[d-1]
+    * (ths->n[d-1]/2+1)) * sizeof(C));
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k_L) num_threads(ths->nthreads)
+#endif
+  for (k_L = 0; k_L < k_total; k_L++)
+  {
+    INT k[d], mk[d], tt, k_temp = k_L;
+    C c_plus, c_minus;
+
+    k[d-1] = k_temp % (ths->N[d-1]/2+1);
+    k_temp /= ths->N[d-1]/2+1;
+    for (tt = d-2; tt >= 0; tt--)
+    {
+      k[tt] = k_temp % (ths->N[tt]+1) - ths->N[tt]/2;
+      k_temp /= ths->N[tt]+1;
+    }
+
+    for (tt = 0; tt < d; tt++)
+      mk[tt] = -k[tt];
+
+    c_plus = nfft_real_coeff(ths, k);
+    c_minus = nfft_real_coeff(ths, mk);
+
+    ths->g_hat[nfft_real_index(ths, k)] = K(0.5) * (CONJ(c_plus) + c_minus);
+  }
+}
+
+/** recovers \f$\hat f_k\f$ from the half spectrum computed by the forward r2c
+ *  transform, using \f$\hat g_{-k} = \overline{\hat g_k}\f$ */
+static void D_real_T(X(plan) *ths)
+{
+  const INT d = ths->d;
+  INT k_L;
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k_L) num_threads(ths->nthreads)
+#endif
+  for (k_L = 0; k_L < ths->N_total; k_L++)
+  {
+    INT k[d], tt, k_temp = k_L;
+    R c_phi_inv_k = K(1.0);
+    C g_hat_k;
+
+    for (tt = d-1; tt >= 0; tt--)
+    {
+      const INT ks = k_temp % ths->N[tt];
+      k[tt] = ks - ths->N[tt]/2;
+      k_temp /= ths->N[tt];
+
+      c_phi_inv_k *= ths->c_phi_inv[tt][ks];
+    }
+
+    if (k[d-1] >= 0)
+      g_hat_k = CONJ(ths->g_hat[nfft_real_index(ths, k)]);
+    else
+    {
+      for (tt = 0; tt < d; tt++)
+        k[tt] = -k[tt];
+      g_hat_k = ths->g_hat[nfft_real_index(ths, k)];
+    }
+
+    ths->f_hat[k_L] = g_hat_k * c_phi_inv_k;
+  }
+}
+
+/** direct real transforms by means of the complex ones */
+static void nfft_direct_real(X(plan) *ths, const int adjoint)
+{
+  INT j;
+
+  ths->f = (C*)Y(malloc)((size_t)(ths->M_total) * sizeof(C));
+
+  if (adjoint)
+  {
+    for (j = 0; j < ths->M_total; j++)
+      ths->f[j] = ths->f_r[j];
+    nfft_direct(ths, 1);
+  }
+  else
+  {
+    nfft_direct(ths, 0);
+    for (j = 0; j < ths->M_total; j++)
+      ths->f_r[j] = CREAL(ths->f[j]);
+  }
+
+  Y(free)(ths->f);
+  ths->f = NULL;
+}
+
+void X(trafo_real)(X(plan) *ths)
+{
+  /* use direct transform if degree N is too low */
+  for (int j = 0; j < ths->d; j++)
+  {
+    if((ths->N[j] <= ths->m) || (ths->n[j] <= 2*ths->m+2))
+    {
+      nfft_direct_real(ths, 0);
+      return;
+    }
+  }
+
+  /* use ths->my_fftw_plan1, a c2r transform from g1 to g_r */
+  ths->g_hat = ths->g1;
+
+  TIC(0)
+  D_real_A(ths);
+  TOC(0)
+
+  TIC_FFTW(1)
+  FFTW(execute)(ths->my_fftw_plan1);
+  TOC_FFTW(1)
+
+  TIC(2)
+  B_real_A(ths);
+  TOC(2)
+} /* nfft_trafo_real */
+
+void X(adjoint_real)(X(plan) *ths)
+{
+  /* use direct transform if degree N is too low */
+  for (int j = 0; j < ths->d; j++)
+  {
+    if((ths->N[j] <= ths->m) || (ths->n[j] <= 2*ths->m+2))
+    {
+      nfft_direct_real(ths, 1);
+      return;
+    }
+  }
+
+  /* use ths->my_fftw_plan2, a r2c transform from g_r to g1 */
+  ths->g_hat = ths->g1;
+
+  TIC(2)
+  B_real_T(ths);
+  TOC(2)
+
+  TIC_FFTW(1)
+  FFTW(execute)(ths->my_fftw_plan2);
+  TOC_FFTW(1)
+
+  TIC(0)
+  D_real_T(ths);
+  TOC(0)
+} /* nfft_adjoint_real */
+
+/* streamed transforms, the nodes are passed in chunks while g stays in the
+ * plan, so that memory is bounded by n_total rather than M_total */
+
+/** B^T without clearing g, the chunks accumulate; the nodes of a chunk are
+ *  not sorted, so threads add with atomic operations */
+#define MACRO_B_many_init_result_S(T, g_vec)
+#define MACRO_B_many_init_node_S
+#define MACRO_B_many_compute_S MACRO_B_many_compute_T
+#ifdef _OPENMP
+#define MACRO_B_many_nodes_S(node) MACRO_B_many_nodes_all(node, 1)
+#else
+#define MACRO_B_many_nodes_S(node) MACRO_B_many_nodes_all(node, 0)
+#endif
+
+MACRO_B_many(S, B_stream_T, C, f, g, nfft_B_many_T_add)
+
+/** applies B or B^T to a chunk of M nodes x and samples f, with the window
+ *  evaluated on the fly since the precomputed data belongs to the nodes of
+ *  the plan */
+static void nfft_stream_chunk(X(plan) *ths, const int M, const R *x, C *f,
+  const int adjoint)
+{
+  R *x_plan = ths->x;
+  C *f_plan = ths->f;
+  const INT M_total = ths->M_total;
+  const unsigned flags = ths->flags;
+
+  ths->x = (R*)x;
+  ths->f = f;
+  ths->M_total = M;
+  ths->flags &= ~(PRE_PSI | PRE_FG_PSI | PRE_FULL_PSI | NFFT_SORT_NODES
+    | NFFT_MIXED_PRECISION | NFFT_COMPACT_FULL_PSI);
+
+  nfft_stats_count(ths, M, 1, 0);
+
+  TIC(2)
+  if (adjoint)
+    B_stream_T(ths);
+  else
+    B_many_A(ths);
+  TOC(2)
+
+  ths->x = x_plan;
+  ths->f = f_plan;
+  ths->M_total = M_total;
+  ths->flags = flags;
+}
+
+/** NULL if the plan supports streamed transforms, an error message otherwise */
+static const char *nfft_stream_check(const X(plan) *ths)
+{
+  INT t;
+
+  if (ths->flags & NFFT_REAL)
+    return "Flag NFFT_REAL does not support streamed transforms.";
+
+  if (ths->howmany > 1)
+    return "Streamed transforms do not support howmany > 1.";
+
+  /* the plan would fall back to the direct transform */
+  for (t = 0; t < ths->d; t++)
+    if ((ths->N[t] <= ths->m) || (ths->n[t] <= 2*ths->m+2))
+      return "Streamed transforms require N > m and n > 2m+2.";
+
+  return 0;
+}
+
+const char* X(trafo_stream_begin)(X(plan) *ths)
+{
+  const char *err = nfft_stream_check(ths);
+
+  if (err)
+    return err;
+
+  ths->stats.trafo_calls++;
+  nfft_stats_count(ths, 0, 1, 1);
+
+  ths->g_hat = ths->g1;
+  ths->g = ths->g2;
+
+  TIC(0)
+  D_A(ths);
+  TOC(0)
+
+  TIC_FFTW(1)
+  nfft_fftw_execute_A(ths);
+  TOC_FFTW(1)
+
+  return 0;
+}
+
+void X(trafo_stream_chunk)(X(plan) *ths, int M, const R *x, C *f)
+{
+  nfft_stream_chunk(ths, M, x, f, 0);
+}
+
+const char* X(adjoint_stream_begin)(X(plan) *ths)
+{
+  const char *err = nfft_stream_check(ths);
+
+  if (err)
+    return err;
+
+  ths->stats.adjoint_calls++;
+  nfft_stats_count(ths, 0, 1, 1);
+
+  ths->g_hat = ths->g1;
+  ths->g = ths->g2;
+
+  nfft_zero(ths, ths->g, (size_t)(ths->n_total) * sizeof(C));
+
+  return 0;
+}
+
+void X(adjoint_stream_chunk)(X(plan) *ths, int M, const R *x, const C *f)
+{
+  nfft_stream_chunk(ths, M, x, (C*)f, 1);
+}
+
+void X(adjoint_stream_end)(X(plan) *ths)
+{
+  TIC_FFTW(1)
+  nfft_fftw_execute_T(ths);
+  TOC_FFTW(1)
+
+  TIC(0)
+  D_T(ths);
+  TOC(0)
+}
+
+#if defined(_OPENMP) && defined(HAVE_FFTW_MAKE_PLANNER_THREAD_SAFE)
+/** Makes the FFTW planner thread-safe once. Plans are then destroyed without
+ *  the critical section nfft_omp_critical_fftw_plan. */
+static void planner_thread_safe(void)
+{
+  static int done = 0;
+
+  #pragma omp critical (nfft_omp_critical_fftw_plan)
+  {
+    if (!done)
+    {
+      FFTW(make_planner_thread_safe)();
+      done = 1;
+    }
+  }
+}
+#endif
+
+/* normal operator A^H W A, a Toeplitz matrix with entries
+ * t_{k-k'} = sum_j w_j e^{2 pi i (k-k') x_j}, applied by its circulant
+ * embedding of length 2N */
+
+/** nodes per chunk of the adjoint NFFT of the weights */
+#define NORMAL_CHUNK 1024
+
+/** position of the coefficient k_L of f_hat in the circulant embedding */
+static INT normal_index(const X(normal_plan) *ths, INT k_L)
+{
+  INT t, kp, l = 0, l_stride = 1;
+
+  for (t = ths->d-1; t >= 0; t--)
+  {
+    kp = k_L % ths->N[t];
+    k_L /= ths->N[t];
+    l += (kp - ths->N[t]/2 + ((kp < ths->N[t]/2) ? ths->L[t] : 0)) * l_stride;
+    l_stride *= ths->L[t];
+  }
+
+  return l;
+}
+
+void X(init_normal)(X(normal_plan) *ths, X(plan) *p, const R *w)
+{
+  const INT d = p->d;
+  int N2[d], n2[d], _L[d];
+  X(plan) q;
+  C f[NORMAL_CHUNK];
+  INT t, j, l, M;
+
+  ths->d = d;
+  ths->N_total = p->N_total;
+  ths->M_total = p->M_total;
+  ths->nthreads = p->nthreads;
+  ths->N = (INT*) Y(malloc)((size_t)(d) * sizeof(INT));
+  ths->L = (INT*) Y(malloc)((size_t)(d) * sizeof(INT));
+
+  for (t = 0, ths->L_total = 1; t < d; t++)
+  {
+    ths->N[t] = p->N[t];
+    ths->L[t] = 2 * p->N[t];
+    ths->L_total *= ths->L[t];
+    N2[t] = _L[t] = (int)(ths->L[t]);
+    n2[t] = (int)(2 * p->n[t]);
+  }
+
+  /* solver_before_loop_complex checks that it runs on these */
+  ths->p = p;
+  ths->w = w;
+
+  ths->f_hat = (C*) Y(malloc)((size_t)(ths->N_total) * sizeof(C));
+  ths->g = (C*) Y(malloc)((size_t)(ths->L_total) * sizeof(C));
+  ths->kernel_hat = (C*) Y(malloc)((size_t)(ths->L_total) * sizeof(C));
+
+#if defined(_OPENMP) && defined(HAVE_FFTW_MAKE_PLANNER_THREAD_SAFE)
+  planner_thread_safe();
+#endif
+#ifdef _OPENMP
+  #pragma omp critical (nfft_omp_critical_fftw_plan)
+#endif
+  {
+#ifdef _OPENMP
+    FFTW(plan_with_nthreads)((int)ths->nthreads);
+#endif
+    Y(wisdom_before_plan)();
+    ths->my_fftw_plan1 = FFTW(plan_dft)((int)d, _L, ths->g, ths->g,
+      FFTW_FORWARD, p->fftw_flags);
+    ths->my_fftw_plan2 = FFTW(plan_dft)((int)d, _L, ths->g, ths->g,
+      FFTW_BACKWARD, p->fftw_flags);
+    Y(wisdom_after_plan)(p->fftw_flags);
+  }
+
+  /* the kernel t_l for l in I_{2N} by one streamed adjoint NFFT of the
+   * weights, which needs no memory proportional to the number of nodes */
+  X(init_guru)(&q, (int)d, N2, 0, n2, (int)p->m, PRE_PHI_HUT
+    | (p->flags & NFFT_WINDOW_MASK) | MALLOC_F_HAT | FFTW_INIT
+    | FFT_OUT_OF_PLACE, FFTW_ESTIMATE | FFTW_DESTROY_INPUT);
+  X(plan_with_nthreads)(&q, (int)p->nthreads);
+
+  if (X(adjoint_stream_begin)(&q) == 0)
+  {
+    for (j = 0; j < p->M_total; j += M)
+    {
+      M = MIN(NORMAL_CHUNK, p->M_total - j);
+
+      for (l = 0; l < M; l++)
+        f[l] = (w != NULL) ? w[j+l] : K(1.0);
+
+      X(adjoint_stream_chunk)(&q, (int)M, p->x + j*d, f);
+    }
+    X(adjoint_stream_end)(&q);
+  }
+  else
+  {
+    /* too small to stream, the direct adjoint transform of all nodes */
+    X(finalize)(&q);
+    X(init_guru)(&q, (int)d, N2, (int)p->M_total, n2, (int)p->m, PRE_PHI_HUT
+      | (p->flags & NFFT_WINDOW_MASK) | MALLOC_X | MALLOC_F | MALLOC_F_HAT
+      | FFTW_INIT | FFT_OUT_OF_PLACE, FFTW_ESTIMATE | FFTW_DESTROY_INPUT);
+    X(plan_with_nthreads)(&q, (int)p->nthreads);
+
+    for (j = 0; j < p->M_total; j++)
+    {
+      for (t = 0; t < d; t++)
+        q.x[j*d+t] = p->x[j*d+t];
+      q.f[j] = (w != NULL) ? w[j] : K(1.0);
+    }
+
+    X(adjoint_direct)(&q);
+  }
+
+  /* t_l sits at l+N in f_hat of q and at l mod 2N in the embedding */
+  for (l = 0; l < ths->L_total; l++)
+  {
+    INT l_temp = l, l_plain = 0, l_stride = 1;
+
+    for (t = d-1; t >= 0; t--)
+    {
+      l_plain += ((l_temp % ths->L[t] + ths->N[t]) % ths->L[t]) * l_stride;
+      l_temp /= ths->L[t];
+      l_stride *= ths->L[t];
+    }
+
+    ths->kernel_hat[l_plain] = q.f_hat[l] / (R)(ths->L_total);
+  }
+
+  X(finalize)(&q);
+
+  FFTW(execute_dft)(ths->my_fftw_plan1, ths->kernel_hat, ths->kernel_hat);
+}
+
+void X(trafo_normal)(X(normal_plan) *ths)
+{
+  INT k;
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+#endif
+  for (k = 0; k < ths->L_total; k++)
+    ths->g[k] = K(0.0);
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+#endif
+  for (k = 0; k < ths->N_total; k++)
+    ths->g[normal_index(ths, k)] = ths->f_hat[k];
+
+  FFTW(execute)(ths->my_fftw_plan1);
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+#endif
+  for (k = 0; k < ths->L_total; k++)
+    ths->g[k] *= ths->kernel_hat[k];
+
+  FFTW(execute)(ths->my_fftw_plan2);
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+#endif
+  for (k = 0; k < ths->N_total; k++)
+    ths->f_hat[k] = ths->g[normal_index(ths, k)];
+}
+
+void X(finalize_normal)(X(normal_plan) *ths)
+{
+#if defined(_OPENMP) && !defined(HAVE_FFTW_MAKE_PLANNER_THREAD_SAFE)
+  #pragma omp critical (nfft_omp_critical_fftw_plan)
+#endif
+  {
+    FFTW(destroy_plan)(ths->my_fftw_plan2);
+    FFTW(destroy_plan)(ths->my_fftw_plan1);
+  }
+
+  Y(free)(ths->kernel_hat);
+  Y(free)(ths->g);
+  Y(free)(ths->f_hat);
+  Y(free)(ths->L);
+  Y(free)(ths->N);
+}
+
+/* value and gradient, the d+1 transforms of f_hat and of -2 pi i k_t f_hat
+ * share one sweep over the nodes, i.e. one evaluation of the window and of
+ * the indices per node for the oversampled vectors G[0],...,G[d] */
+
+/** f_hat_t = sign 2 pi i k_t f_hat */
+static void nfft_grad_f_hat(const X(plan) *ths, const INT t, const R sign,
+  const C *f_hat, C *f_hat_t)
+{
+  const INT N_t = ths->N[t];
+  const INT stride = intprod(ths->N + t + 1, 0, ths->d - t - 1);
+  INT k;
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+#endif
+  for (k = 0; k < ths->N_total; k++)
+    f_hat_t[k] = (sign * K2PI * (R)((k / stride) % N_t - N_t/2) * I) * f_hat[k];
+}
+
+/** window value at entry l_L of row j of B, taken from psi for
+ *  NFFT_COMPACT_FULL_PSI */
+#define MACRO_B_grad_psi(l_L) \
+  ((ths->flags & NFFT_COMPACT_FULL_PSI) ? ths->psi[j*lprod+(l_L)] : phi_prod[d])
+
+/** f_j and the gradient at the nodes from G[0],...,G[d] */
+static void nfft_trafo_grad_B(X(plan) *ths, C *const *G, C *grad)
+{
+  const INT d = ths->d, l_max = 2*ths->m+2;
+  const int full = (ths->flags & PRE_FULL_PSI)
+    && !(ths->flags & NFFT_COMPACT_FULL_PSI);
+  INT lprod, k;
+  R fg_exp_l[d*l_max];
+
+  for (k = 0, lprod = 1; k < d; k++)
+    lprod *= l_max;
+
+  if (ths->flags & (PRE_FG_PSI | FG_PSI))
+    nfft_B_init_fg_exp_l(ths, fg_exp_l);
+
+  sort(ths);
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+#endif
+  for (k = 0; k < ths->M_total; k++)
+  {
+    const INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
+    INT u[d], o[d], t, t2, lj[d], ll_plain[d+1], l_L, c;
+    R phi_prod[d+1], psij_const[d*l_max];
+    C fj[d+1];
+
+    for (c = 0; c <= d; c++)
+      fj[c] = K(0.0);
+
+    if (full)
+    {
+      for (l_L = 0; l_L < lprod; l_L++)
+      {
+        const R psi_l = ths->psi[j*lprod+l_L];
+        const INT ix = ths->psi_index_g[j*lprod+l_L];
+
+        for (c = 0; c <= d; c++)
+          fj[c] += psi_l * G[c][ix];
+      }
+    }
+    else
+    {
+      phi_prod[0] = K(1.0);
+      ll_plain[0] = 0;
+
+      MACRO_init_uo_l_lj_t;
+
+      if (ths->flags & NFFT_COMPACT_FULL_PSI)
+        for (t2 = 0; t2 < d*l_max; t2++)
+          psij_const[t2] = K(1.0);
+      else
+        nfft_B_psij(ths, j, u, fg_exp_l, psij_const);
+
+      for (l_L = 0; l_L < lprod; l_L++)
+      {
+        R psi_l;
+
+        MACRO_update_phi_prod_ll_plain(without_PRE_PSI_improved);
+
+        psi_l = MACRO_B_grad_psi(l_L);
+
+        for (c = 0; c <= d; c++)
+          fj[c] += psi_l * G[c][ll_plain[d]];
+
+        MACRO_count_uo_l_lj_t;
+      }
+    }
+
+    ths->f[j] = fj[0];
+    for (c = 0; c < d; c++)
+      grad[j*d+c] = fj[c+1];
+  }
+}
+
+/** G[0],...,G[d] from f_j and the gradient at the nodes */
+static void nfft_adjoint_grad_B(X(plan) *ths, C *const *G, const C *grad)
+{
+  const INT d = ths->d, l_max = 2*ths->m+2;
+  const int full = (ths->flags & PRE_FULL_PSI)
+    && !(ths->flags & NFFT_COMPACT_FULL_PSI);
+  INT lprod, k;
+  R fg_exp_l[d*l_max];
+
+  for (k = 0, lprod = 1; k < d; k++)
+    lprod *= l_max;
+
+  for (k = 0; k <= d; k++)
+    nfft_zero(ths, G[k], (size_t)(ths->n_total) * sizeof(C));
+
+  if (ths->flags & (PRE_FG_PSI | FG_PSI))
+    nfft_B_init_fg_exp_l(ths, fg_exp_l);
+
+  sort(ths);
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+#endif
+  for (k = 0; k < ths->M_total; k++)
+  {
+    const INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
+    INT u[d], o[d], t, t2, lj[d], ll_plain[d+1], l_L, c;
+    R phi_prod[d+1], psij_const[d*l_max];
+    C fj[d+1];
+
+    fj[0] = ths->f[j];
+    for (c = 0; c < d; c++)
+      fj[c+1] = grad[j*d+c];
+
+    if (full)
+    {
+      for (l_L = 0; l_L < lprod; l_L++)
+      {
+        const R psi_l = ths->psi[j*lprod+l_L];
+        const INT ix = ths->psi_index_g[j*lprod+l_L];
+
+        for (c = 0; c <= d; c++)
+          nfft_B_many_T_add(G[c] + ix, fj + c, psi_l, 1, 0, 1);
+      }
+    }
+    else
+    {
+      phi_prod[0] = K(1.0);
+      ll_plain[0] = 0;
+
+      MACRO_init_uo_l_lj_t;
+
+      if (ths->flags & NFFT_COMPACT_FULL_PSI)
+        for (t2 = 0; t2 < d*l_max; t2++)
+          psij_const[t2] = K(1.0);
+      else
+        nfft_B_psij(ths, j, u, fg_exp_l, psij_const);
+
+      for (l_L = 0; l_L < lprod; l_L++)
+      {
+        R psi_l;
+
+        MACRO_update_phi_prod_ll_plain(without_PRE_PSI_improved);
+
+        psi_l = MACRO_B_grad_psi(l_L);
+
+        for (c = 0; c <= d; c++)
+          nfft_B_many_T_add(G[c] + ll_plain[d], fj + c, psi_l, 1, 0, 1);
+
+        MACRO_count_uo_l_lj_t;
+      }
+    }
+  }
+}
+
+/** value and gradient by d+1 direct transforms */
+static void nfft_grad_direct(X(plan) *ths, C *grad, const int adjoint)
+{
+  C *f_hat = ths->f_hat, *f = ths->f;
+  C *f_hat_t = (C*)Y(malloc)((size_t)(ths->N_total) * sizeof(C));
+  C *f_t = (C*)Y(malloc)((size_t)(ths->M_total) * sizeof(C));
+  INT t, j;
+
+  STATS_TIC(NFFT_STATS_OTHER)
+  if (adjoint)
+    X(adjoint_direct)(ths);
+  else
+    X(trafo_direct)(ths);
+
+  ths->f_hat = f_hat_t;
+  ths->f = f_t;
+
+  for (t = 0; t < ths->d; t++)
+  {
+    if (adjoint)
+    {
+      for (j = 0; j < ths->M_total; j++)
+        f_t[j] = grad[j*ths->d+t];
+
+      X(adjoint_direct)(ths);
+
+      for (j = 0; j < ths->N_total; j++)
+        f_hat[j] += K2PI * (R)((j / intprod(ths->N + t + 1, 0, ths->d - t - 1))
+          % ths->N[t] - ths->N[t]/2) * I * f_hat_t[j];
+    }
+    else
+    {
+      nfft_grad_f_hat(ths, t, K(-1.0), f_hat, f_hat_t);
+
+      X(trafo_direct)(ths);
+
+      for (j = 0; j < ths->M_total; j++)
+        grad[j*ths->d+t] = f_t[j];
+    }
+  }
+  STATS_TOC(NFFT_STATS_OTHER)
+
+  ths->f_hat = f_hat;
+  ths->f = f;
+  Y(free)(f_t);
+  Y(free)(f_hat_t);
+}
+
+void X(trafo_grad)(X(plan) *ths, C *grad)
+{
+  const INT d = ths->d;
+  C *f_hat = ths->f_hat, *f_hat_t, *G_t;
+  C *G[d+1];
+  INT t;
+
+  ths->stats.trafo_calls++;
+  nfft_stats_count(ths, ths->M_total, d + 1, d + 1);
+
+  for (t = 0; t < d; t++)
+  {
+    if ((ths->N[t] <= ths->m) || (ths->n[t] <= 2*ths->m+2))
+    {
+      nfft_grad_direct(ths, grad, 0);
+      return;
+    }
+  }
+
+  f_hat_t = (C*)Y(malloc)((size_t)(ths->N_total) * sizeof(C));
+  G_t = (C*)Y(malloc)((size_t)(d * ths->n_total) * sizeof(C));
+
+  ths->g_hat = ths->g1;
+  ths->g = ths->g2;
+
+  /* the derivatives first, the values stay in g */
+  for (t = d; t >= 0; t--)
+  {
+    if (t > 0)
+      nfft_grad_f_hat(ths, t-1, K(-1.0), f_hat, f_hat_t);
+
+    ths->f_hat = (t > 0) ? f_hat_t : f_hat;
+
+    TIC(0)
+    D_A(ths);
+    TOC(0)
+
+    TIC_FFTW(1)
+    nfft_fftw_execute_A(ths);
+    TOC_FFTW(1)
+
+    G[t] = (t > 0) ? G_t + (t-1) * ths->n_total : ths->g;
+
+    if (t > 0)
+      memcpy(G[t], ths->g, (size_t)(ths->n_total) * sizeof(C));
+  }
+
+  ths->f_hat = f_hat;
+
+  TIC(2)
+  nfft_trafo_grad_B(ths, G, grad);
+  TOC(2)
+
+  Y(free)(G_t);
+  Y(free)(f_hat_t);
+}
+
+void X(adjoint_grad)(X(plan) *ths, const C *grad)
+{
+  const INT d = ths->d;
+  C *f_hat = ths->f_hat, *f_hat_t, *G_t;
+  C *G[d+1];
+  INT t, k;
+
+  ths->stats.adjoint_calls++;
+  nfft_stats_count(ths, ths->M_total, d + 1, d + 1);
+
+  for (t = 0; t < d; t++)
+  {
+    if ((ths->N[t] <= ths->m) || (ths->n[t] <= 2*ths->m+2))
+    {
+      nfft_grad_direct(ths, (C*)grad, 1);
+      return;
+    }
+  }
+
+  f_hat_t = (C*)Y(malloc)((size_t)(ths->N_total) * sizeof(C));
+  G_t = (C*)Y(malloc)((size_t)(d * ths->n_total) * sizeof(C));
+
+  ths->g_hat = ths->g1;
+  ths->g = ths->g2;
+
+  G[0] = ths->g;
+  for (t = 1; t <= d; t++)
+    G[t] = G_t + (t-1) * ths->n_total;
+
+  TIC(2)
+  nfft_adjoint_grad_B(ths, G, grad);
+  TOC(2)
+
+  /* the values first, G[0] is g */
+  for (t = 0; t <= d; t++)
+  {
+    if (t > 0)
+      memcpy(ths->g, G[t], (size_t)(ths->n_total) * sizeof(C));
+
+    ths->f_hat = (t > 0) ? f_hat_t : f_hat;
+
+    TIC_FFTW(1)
+    nfft_fftw_execute_T(ths);
+    TOC_FFTW(1)
+
+    TIC(0)
+    D_T(ths);
+    TOC(0)
+
+    if (t > 0)
+    {
+      nfft_grad_f_hat(ths, t-1, K(1.0), f_hat_t, f_hat_t);
+
+#ifdef _OPENMP
+      #pragma omp parallel for default(shared) private(k) num_threads(ths->nthreads)
+#endif
+      for (k = 0; k < ths->N_total; k++)
+        f_hat[k] += f_hat_t[k];
+    }
+  }
+
+  ths->f_hat = f_hat;
+
+  Y(free)(G_t);
+  Y(free)(f_hat_t);
+}
+
+void X(get_stats)(const X(plan) *ths, X(stats) *stats)
+{
+  *stats = ths->stats;
+}
+
+void X(reset_stats)(X(plan) *ths)
+{
+  memset(&ths->stats, 0, sizeof(ths->stats));
+  ths->stats.nthreads = ths->nthreads;
+}
+
+
+/** initialisation of direct transform
+ */
+/**
+ * Gauss-Legendre nodes x and weights w of order q on [-1,1], by Newton's
+ * method on the Legendre polynomial P_q.
+ */
+static void gauss_legendre(const INT q, R *x, R *w)
+{
+  INT i, j, it;
+
+  for (i = 0; i < q; i++)
+  {
+    R z = COS(KPI * ((R)(i) + K(0.75)) / ((R)(q) + K(0.5))), z1, dp = K(1.0);
+
+    for (it = 0; it < 100; it++)
+    {
+      R p1 = K(1.0), p2 = K(0.0), p3;
+
+      for (j = 1; j <= q; j++)
+      {
+        p3 = p2;
+        p2 = p1;
+        p1 = ((R)(2 * j - 1) * z * p2 - (R)(j - 1) * p3) / (R)(j);
+      }
+
+      dp = (R)(q) * (z * p1 - p2) / (z * z - K(1.0));
+      z1 = z;
+      z = z1 - p1 / dp;
+
+      if (FABS(z - z1) <= K(4.0) * NFFT_EPSILON)
+        break;
+    }
+
+    x[i] = z;
+    w[i] = K(2.0) / ((K(1.0) - z * z) * dp * dp);
+  }
+}
+
+/**
+ * Computes 1/PHI_HUT for the exponential of semicircle window by
+ * Gauss-Legendre quadrature of
+ * \f$\hat\varphi(k) = 2\int_0^m \varphi(s) \cos(2\pi k s/n) ds\f$.
+ */
+static void precompute_phi_hut_exp_semicircle(X(plan) *ths)
+{
+  const INT q = 3 * ths->m + 2;
+  R x[q], w[q], phi[q];
+  INT t, ks, i;
+
+  gauss_legendre(q, x, w);
+
+  /* nodes and weights on [0,m] */
+  for (i = 0; i < q; i++)
+  {
+    x[i] = (x[i] + K(1.0)) * K(0.5) * (R)(ths->m);
+    w[i] = w[i] * K(0.5) * (R)(ths->m);
+  }
+
+  for (t = 0; t < ths->d; t++)
+  {
+    for (i = 0; i < q; i++)
+      phi[i] = w[i] * PHI_EXP_SEMICIRCLE(1, x[i], t);
+
+    for (ks = 0; ks < ths->N[t]; ks++)
+    {
+      const R omega = K2PI * (R)(ks - ths->N[t] / 2) / (R)(ths->n[t]);
+      R phi_hut = K(0.0);
+
+      for (i = 0; i < q; i++)
+        phi_hut += phi[i] * COS(omega * x[i]);
+
+      ths->c_phi_inv[t][ks] = K(1.0) / (K(2.0) * phi_hut);
+    }
+  }
+}
+
+/**
+ * Fits the exponential of semicircle window by piecewise polynomials: for
+ * each dimension and each of the 2m+2 window values of a node, the values
+ * at Chebyshev points of frac(n x) in [0,1) are interpolated and the
+ * Chebyshev series is converted to monomials for Horner's rule.
+ */
+static void init_window_exp_semicircle(X(plan) *ths)
+{
+  const INT m2p2 = 2 * ths->m + 2;
+  const INT p = WINDOW_EXP_SEMICIRCLE_DEGREE(ths->m), q = p + 1;
+  R z[q], val[q], cheb[q], T0[q], T1[q], T2[q];
+  INT t, l, i, k, j;
+
+  ths->window_coeffs = (R*) plan_malloc(ths, (size_t)(ths->d * q * m2p2) * sizeof(R));
+
+  for (i = 0; i < q; i++)
+    z[i] = COS(KPI * ((R)(i) + K(0.5)) / (R)(q));
+
+  for (t = 0; t < ths->d; t++)
+  {
+    R *c = ths->window_coeffs + t * q * m2p2;
+
+    for (l = 0; l < m2p2; l++)
+    {
+      for (i = 0; i < q; i++)
+        val[i] = PHI_EXP_SEMICIRCLE(1, (R)(ths->m - l) + (z[i] + K(1.0)) * K(0.5), t);
+
+      for (k = 0; k < q; k++)
+      {
+        cheb[k] = K(0.0);
+        for (i = 0; i < q; i++)
+          cheb[k] += val[i] * COS(KPI * (R)(k) * ((R)(i) + K(0.5)) / (R)(q));
+        cheb[k] *= (k == 0 ? K(1.0) : K(2.0)) / (R)(q);
+      }
+
+      /* monomial coefficients of T_0, T_1 and the sum */
+      for (j = 0; j < q; j++)
+      {
+        T0[j] = (j == 0) ? K(1.0) : K(0.0);
+        T1[j] = (j == 1) ? K(1.0) : K(0.0);
+        c[j * m2p2 + l] = cheb[0] * T0[j] + (q > 1 ? cheb[1] * T1[j] : K(0.0));
+      }
+
+      for (k = 2; k < q; k++)
+      {
+        for (j = 0; j < q; j++)
+        {
+          T2[j] = (j > 0 ? K(2.0) * T1[j-1] : K(0.0)) - T0[j];
+          c[j * m2p2 + l] += cheb[k] * T2[j];
+        }
+        for (j = 0; j < q; j++)
+        {
+          T0[j] = T1[j];
+          T1[j] = T2[j];
+        }
+      }
+    }
+  }
+}
+
+static void precompute_phi_hut(X(plan) *ths)
+{
+  INT ks[ths->d]; /* index over all frequencies */
+  INT t; /* index over all dimensions */
+
+  ths->c_phi_inv = (R**) plan_malloc(ths, (size_t)(ths->d) * sizeof(R*));
+
+  for (t = 0; t < ths->d; t++)
+    ths->c_phi_inv[t] = (R*)plan_malloc(ths, (size_t)(ths->N[t]) * sizeof(R));
+
+  if (ths->window == NFFT_WINDOW_EXP_SEMICIRCLE)
+  {
+    precompute_phi_hut_exp_semicircle(ths);
+    return;
+  }
+
+  for (t = 0; t < ths->d; t++)
+  {
+    for (ks[t] = 0; ks[t] < ths->N[t]; ks[t]++)
+    {
+      ths->c_phi_inv[t][ks[t]]= K(1.0) / (PHI_HUT(ths->n[t], ks[t] - ths->N[t] / 2,t));
+    }
+  }
+} /* nfft_phi_hut */
+
+/** create a lookup table, but NOT for each node
+ *  good idea K=2^xx
+ *  assumes an EVEN window function
+ */
+void X(precompute_lin_psi)(X(plan) *ths)
+{
+  INT t;                                /**< index over all dimensions       */
+  INT j;                                /**< index over all nodes            */
+  R step;                          /**< step size in [0,(m+2)/n]        */
+
+  plan_file_own(ths);
+  STATS_TIC(NFFT_STATS_PRECOMPUTE)
+  for (t=0; t<ths->d; t++)
+    {
+      step = ((R)(ths->m+2)) / ((R)(ths->K * ths->n[t]));
+      for(j = 0;j <= ths->K; j++)
+  {
+    ths->psi[(ths->K+1)*t + j] = PHI(ths->n[t], (R)(j) * step,t);
+  } /* for(j) */
+    } /* for(t) */
+  STATS_TOC(NFFT_STATS_PRECOMPUTE)
+}
+
+/** Precomputes the data of PRE_FG_PSI for node j in dimension t. */
+static inline void precompute_fg_psi_tj(X(plan) *ths, const INT t, const INT j)
+{
+  INT u, o;
+
+  uo(ths,j,&u,&o,t);
+
+  ths->psi[2*(j*ths->d+t)]=
+      (PHI(ths->n[t] ,(ths->x[j*ths->d+t] - ((R)u) / (R)(ths->n[t])),t));
+
+  ths->psi[2*(j*ths->d+t)+1]=
+      EXP(K(2.0) * ((R)(ths->n[t]) * ths->x[j*ths->d+t] - (R)(u)) / ths->b[t]);
+}
+
+void X(precompute_fg_psi)(X(plan) *ths)
+{
+  INT t;                                /**< index over all dimensions       */
+
+  plan_file_own(ths);
+  STATS_TIC(NFFT_STATS_PRECOMPUTE)
+  ths->index_x_sorted = 0;
+  sort(ths);
+
+  for (t=0; t<ths->d; t++)
+  {
+    INT j;
+#ifdef _OPENMP
+    #pragma omp parallel for default(shared) private(j) num_threads(ths->nthreads)
+#endif
+    for (j = 0; j < ths->M_total; j++)
+      precompute_fg_psi_tj(ths, t, j);
+  }
+  /* for(t) */
+  STATS_TOC(NFFT_STATS_PRECOMPUTE)
+} /* nfft_precompute_fg_psi */
+
+/** Precomputes the data of PRE_PSI for node j in dimension t, scale is the
+ * factor of NFFT_MIXED_PRECISION. */
+static inline void precompute_psi_tj(X(plan) *ths, const INT t, const INT j,
+  const R scale)
+{
+  INT u, o; /* depends on x_j */
+
+  uo(ths,j,&u,&o,t);
+
+  if (ths->flags & NFFT_MIXED_PRECISION)
+  {
+    R psij[2 * ths->m + 2];
+    float *psij_single = &ths->psi_single[(j * ths->d + t) * (2 * ths->m + 2)];
+    INT l;
+
+    window_psij(ths, t, ths->x[j*ths->d+t], u, psij);
+
+    for (l = 0; l < 2 * ths->m + 2; l++)
+      psij_single[l] = (float)(psij[l] / scale);
+  }
+  else
+    window_psij(ths, t, ths->x[j*ths->d+t], u,
+      &ths->psi[(j * ths->d + t) * (2 * ths->m + 2)]);
+}
+
+void X(precompute_psi)(X(plan) *ths)
+{
+  INT t; /* index over all dimensions */
+
+  plan_file_own(ths);
+  STATS_TIC(NFFT_STATS_PRECOMPUTE)
+  ths->index_x_sorted = 0;
+  sort(ths);
+
+  for (t=0; t<ths->d; t++)
+  {
+    const R scale = (ths->flags & NFFT_MIXED_PRECISION)
+      ? nfft_mixed_scale(ths, t) : K(1.0);
+    INT j;
+#ifdef _OPENMP
+    #pragma omp parallel for default(shared) private(j) num_threads(ths->nthreads)
+#endif
+    for (j = 0; j < ths->M_total; j++)
+      precompute_psi_tj(ths, t, j, scale);
+  }
+  /* for(t) */
+  STATS_TOC(NFFT_STATS_PRECOMPUTE)
+} /* nfft_precompute_psi */
+
+/** Number of INT in ths->psi_index_g for PRE_FULL_PSI. */
+static INT nfft_full_psi_index_size(const X(plan) *ths)
+{
+  INT t, lprod;
+
+  if (ths->flags & NFFT_COMPACT_FULL_PSI)
+    return ths->M_total * ths->d;
+
+  for (t = 0, lprod = 1; t < ths->d; t++)
+    lprod *= 2 * ths->m + 2;
+
+  return ths->M_total * lprod;
+}
+
+/** Precomputes the data of PRE_FULL_PSI for node j, lprod = (2m+2)^d. */
+static void nfft_precompute_full_psi_j(X(plan) *ths, const INT j,
+  const INT lprod)
+{
+  INT t,t2;                             /**< index over all dimensions       */
+  INT l_L;                              /**< plain index 0<=l_L<lprod        */
+  INT lj[ths->d];                       /**< multi index 0<=lj<u+o+1         */
+  INT ll_plain[ths->d+1];               /**< postfix plain index             */
+
+  INT u[ths->d], o[ths->d];             /**< depends on x_j                  */
+
+  R phi_prod[ths->d+1];
+  R psij_const[ths->d * (2*ths->m+2)];
+  INT ix = j*lprod;
+
+  phi_prod[0]=1;
+  ll_plain[0]=0;
+
+  MACRO_init_uo_l_lj_t;
+
+  for (t2 = 0; t2 < ths->d; t2++)
+    window_psij(ths, t2, ths->x[j*ths->d+t2], u[t2],
+      &psij_const[t2 * (2*ths->m+2)]);
+
+  if (ths->flags & NFFT_COMPACT_FULL_PSI)
+  {
+    for (t2 = 0; t2 < ths->d; t2++)
+      ths->psi_index_g[j*ths->d+t2] = (u[t2] + ths->n[t2]) % ths->n[t2];
+  }
+
+  for(l_L=0; l_L<lprod; l_L++, ix++)
+  {
+    MACRO_update_phi_prod_ll_plain(without_PRE_PSI_improved);
+
+    if (!(ths->flags & NFFT_COMPACT_FULL_PSI))
+      ths->psi_index_g[ix]=ll_plain[ths->d];
+    ths->psi[ix]=phi_prod[ths->d];
+
+    MACRO_count_uo_l_lj_t;
+  } /* for(l_L) */
+
+  ths->psi_index_f[j]=lprod;
+}
+
+void X(precompute_full_psi)(X(plan) *ths)
+{
+  INT j; /* index over all nodes */
+  INT t, lprod; /* 'bandwidth' of matrix B */
+
+  plan_file_own(ths);
+  STATS_TIC(NFFT_STATS_PRECOMPUTE)
+  ths->index_x_sorted = 0;
+  sort(ths);
+
+  for (t = 0, lprod = 1; t < ths->d; t++)
+    lprod *= 2 * ths->m + 2;
+
+#ifdef _OPENMP
+  #pragma omp parallel for default(shared) private(j) num_threads(ths->nthreads)
+#endif
+  for (j = 0; j < ths->M_total; j++)
+    nfft_precompute_full_psi_j(ths, j, lprod);
+  STATS_TOC(NFFT_STATS_PRECOMPUTE)
+}
+
+void X(precompute_one_psi)(X(plan) *ths)
+{
+  if(ths->flags & PRE_LIN_PSI)
+    X(precompute_lin_psi)(ths);
+  if(ths->flags & PRE_FG_PSI)
+    X(precompute_fg_psi)(ths);
+  if(ths->flags & PRE_PSI)
+    X(precompute_psi)(ths);
+  if(ths->flags & PRE_FULL_PSI)
+    X(precompute_full_psi)(ths);
+}
+
+/** Creates the FFTW plans of the plan for ths->nthreads threads. */
+static void init_fftw_plans(X(plan) *ths)
+{
+  INT t;
+
+  /* The thread count of the FFTW planner is global, so it is set in the
+   * same critical section as the plans are created, also for a thread-safe
+   * planner. */
+#if defined(_OPENMP) && defined(HAVE_FFTW_MAKE_PLANNER_THREAD_SAFE)
+  planner_thread_safe();
+#endif
+#ifdef _OPENMP
+  #pragma omp critical (nfft_omp_critical_fftw_plan)
+#endif
+  {
+#ifdef _OPENMP
+    FFTW(plan_with_nthreads)((int)ths->nthreads);
+#endif
+    Y(wisdom_before_plan)();
+    {
+      int *_n = Y(malloc)((size_t)(ths->d) * sizeof(int));
+
+      for (t = 0; t < ths->d; t++)
+        _n[t] = (int)(ths->n[t]);
+
+      if (ths->flags & NFFT_REAL)
+      {
+        ths->my_fftw_plan1 = FFTW(plan_dft_c2r)((int)ths->d, _n, ths->g1, ths->g_r, ths->fftw_flags);
+        ths->my_fftw_plan2 = FFTW(plan_dft_r2c)((int)ths->d, _n, ths->g_r, ths->g1, ths->fftw_flags);
+      }
+      else if (ths->howmany > 1)
+      {
+        /* batch vectors are interleaved in g1 and g2 */
+        const int hm = (int)ths->howmany;
+        ths->my_fftw_plan1 = FFTW(plan_many_dft)((int)ths->d, _n, hm, ths->g1, NULL, hm, 1, ths->g2, NULL, hm, 1, FFTW_FORWARD, ths->fftw_flags);
+        ths->my_fftw_plan2 = FFTW(plan_many_dft)((int)ths->d, _n, hm, ths->g2, NULL, hm, 1, ths->g1, NULL, hm, 1, FFTW_BACKWARD, ths->fftw_flags);
+      }
+      else if (ths->flags & NFFT_PRUNED_FFT)
+      {
+        /* the lines start at multiples of n_{d-1}, i.e. not necessarily
+         * with the alignment of g1 */
+        const unsigned fftw_flags = ths->fftw_flags
+          | ((ths->n[ths->d-1] % 4 != 0) ? FFTW_UNALIGNED : 0U);
+
+        /* the d-variate plans are not executed by the pruned FFT */
+        ths->my_fftw_plan1 = NULL;
+        ths->my_fftw_plan2 = NULL;
+
+        ths->my_fftw_plan1_pruned = (FFTW(plan)*) plan_malloc(ths, (size_t)(ths->d) * sizeof(FFTW(plan)));
+        ths->my_fftw_plan2_pruned = (FFTW(plan)*) plan_malloc(ths, (size_t)(ths->d) * sizeof(FFTW(plan)));
+
+        for (t = 0; t < ths->d; t++)
+        {
+          if (t == ths->d - 1)
+          {
+            /* N_{d-2}/2 consecutive rows */
+            const int hm = (int)(ths->N[t-1] / 2);
+            ths->my_fftw_plan1_pruned[t] = FFTW(plan_many_dft)(1, &_n[t], hm, ths->g1, NULL, 1, _n[t], ths->g1, NULL, 1, _n[t], FFTW_FORWARD, fftw_flags);
+            ths->my_fftw_plan2_pruned[t] = FFTW(plan_many_dft)(1, &_n[t], hm, ths->g1, NULL, 1, _n[t], ths->g1, NULL, 1, _n[t], FFTW_BACKWARD, fftw_flags);
+          }
+          else
+          {
+            /* all lines with fixed indices in the dimensions 0,...,t-1 */
+            const int st = (int)(intprod(ths->n + t + 1, 0, ths->d - t - 1));
+            ths->my_fftw_plan1_pruned[t] = FFTW(plan_many_dft)(1, &_n[t], st, ths->g1, NULL, st, 1, ths->g1, NULL, st, 1, FFTW_FORWARD, fftw_flags);
+            ths->my_fftw_plan2_pruned[t] = FFTW(plan_many_dft)(1, &_n[t], st, ths->g1, NULL, st, 1, ths->g1, NULL, st, 1, FFTW_BACKWARD, fftw_flags);
+          }
+        }
+      }
+      else
+      {
+        ths->my_fftw_plan1 = FFTW(plan_dft)((int)ths->d, _n, ths->g1, ths->g2, FFTW_FORWARD, ths->fftw_flags);
+        ths->my_fftw_plan2 = FFTW(plan_dft)((int)ths->d, _n, ths->g2, ths->g1, FFTW_BACKWARD, ths->fftw_flags);
+      }
+      Y(free)(_n);
+    }
+    Y(wisdom_after_plan)(ths->fftw_flags);
+  }
+}
+
+/** Destroys the FFTW plans of the plan. With a thread-safe FFTW planner this
+ *  needs no critical section. */
+static void finalize_fftw_plans(X(plan) *ths)
+{
+  INT t;
+
+#if defined(_OPENMP) && !defined(HAVE_FFTW_MAKE_PLANNER_THREAD_SAFE)
+  #pragma omp critical (nfft_omp_critical_fftw_plan)
+#endif
+  {
+    if (ths->flags & NFFT_PRUNED_FFT)
+    {
+      for (t = 0; t < ths->d; t++)
+      {
+        FFTW(destroy_plan)(ths->my_fftw_plan2_pruned[t]);
+        FFTW(destroy_plan)(ths->my_fftw_plan1_pruned[t]);
+      }
+    }
+    else
+    {
+      FFTW(destroy_plan)(ths->my_fftw_plan2);
+      FFTW(destroy_plan)(ths->my_fftw_plan1);
+    }
+  }
+
+  if (ths->flags & NFFT_PRUNED_FFT)
+  {
+    plan_free(ths, ths->my_fftw_plan2_pruned);
+    plan_free(ths, ths->my_fftw_plan1_pruned);
+  }
+}
+
+/** Adjusts the flags and sets the derived parameters of the plan, the part
+ *  of init_help that allocates nothing. */
+static void init_parameters(X(plan) *ths)
+{
+  if (ths->flags & (NFFT_SORT_TILE_MAJOR | NFFT_SORT_MORTON))
+    ths->flags |= NFFT_SORT_NODES;
+
+  /* the blockwise adjoint searches the keys, which needs row-major order */
+  if (ths->flags & NFFT_OMP_BLOCKWISE_ADJOINT)
+  {
+    ths->flags |= NFFT_SORT_NODES;
+    ths->flags &= ~(NFFT_SORT_TILE_MAJOR | NFFT_SORT_MORTON);
+  }
+
+  /* single precision window values are supported for PRE_PSI only */
+  if (((ths->flags & PRE_ONE_PSI) != PRE_PSI) || (ths->flags & FG_PSI)
+    || (ths->flags & NFFT_REAL) || (ths->howmany > 1))
+    ths->flags &= ~NFFT_MIXED_PRECISION;
+
+  ths->psi_single = NULL;
+
+  /* the compact full psi kernels transform one complex vector only */
+  if (!(ths->flags & PRE_FULL_PSI) || (ths->flags & NFFT_REAL)
+    || (ths->howmany > 1))
+    ths->flags &= ~NFFT_COMPACT_FULL_PSI;
+
+  /* the pruned FFT works in place on g1 */
+  if ((ths->d < 2) || !(ths->flags & FFTW_INIT) || (ths->flags & NFFT_REAL)
+    || (ths->howmany > 1))
+    ths->flags &= ~NFFT_PRUNED_FFT;
+
+  if (ths->flags & NFFT_PRUNED_FFT)
+    ths->flags &= ~FFT_OUT_OF_PLACE;
+
+  ths->N_total = intprod(ths->N, 0, ths->d);
+  ths->n_total = intprod(ths->n, 0, ths->d);
+
+  ths->window = ths->flags & NFFT_WINDOW_MASK;
+  if (!ths->window)
+    ths->window = WINDOW_DEFAULT;
+
+  if ((ths->flags & PRE_LIN_PSI) && ths->K == 0)
+    ths->K = Y(m2K)(ths->m, ths->window);
+}
+
+/** Bytes allocated by init_help and the init routines, each array rounded
+ *  to ARENA_ALIGN bytes. */
+static void plan_memory(const X(plan) *ths, X(plan_memory) *mem)
+{
+  const INT m2p2 = 2 * ths->m + 2;
+  INT t, lprod;
+
+  for (t = 0, lprod = 1; t < ths->d; t++)
+    lprod *= m2p2;
+
+  memset(mem, 0, sizeof(*mem));
+
+  /* N, n, sigma and b */
+  mem->other = 2 * ARENA_ROUND((size_t)(ths->d) * sizeof(INT))
+    + 2 * ARENA_ROUND((size_t)(ths->d) * sizeof(R));
+
+  if (ths->window == NFFT_WINDOW_EXP_SEMICIRCLE)
+    mem->other += ARENA_ROUND((size_t)(ths->d * m2p2
+      * (WINDOW_EXP_SEMICIRCLE_DEGREE(ths->m) + 1)) * sizeof(R));
+
+  if (ths->flags & MALLOC_X)
+    mem->x = ARENA_ROUND((size_t)(ths->d * ths->M_total) * sizeof(R));
+
+  if (ths->flags & MALLOC_F_HAT)
+    mem->f_hat = ARENA_ROUND((size_t)((ths->N_total - 1) * ths->stride
+      + (ths->howmany - 1) * ths->f_hat_dist + 1) * sizeof(C));
+
+  if (ths->flags & MALLOC_F)
+    mem->f = (ths->flags & NFFT_REAL)
+      ? ARENA_ROUND((size_t)(ths->M_total) * sizeof(R))
+      : ARENA_ROUND((size_t)((ths->M_total - 1) * ths->stride
+        + (ths->howmany - 1) * ths->f_dist + 1) * sizeof(C));
+
+  mem->other += ARENA_ROUND((size_t)(ths->d) * sizeof(R*));
+  for (t = 0; t < ths->d; t++)
+    mem->c_phi_inv += ARENA_ROUND((size_t)(ths->N[t]) * sizeof(R));
+
+  if (ths->flags & PRE_LIN_PSI)
+    mem->psi += ARENA_ROUND((size_t)((ths->K + 1) * ths->d) * sizeof(R));
+
+  if (ths->flags & PRE_FG_PSI)
+    mem->psi += ARENA_ROUND((size_t)(ths->M_total * ths->d * 2) * sizeof(R));
+
+  if (ths->flags & NFFT_MIXED_PRECISION)
+    mem->psi += ARENA_ROUND((size_t)(ths->M_total * ths->d * m2p2) * sizeof(float));
+  else if (ths->flags & PRE_PSI)
+    mem->psi += ARENA_ROUND((size_t)(ths->M_total * ths->d * m2p2) * sizeof(R));
+
+  if (ths->flags & PRE_FULL_PSI)
+  {
+    mem->psi += ARENA_ROUND((size_t)(ths->M_total * lprod) * sizeof(R));
+    mem->psi_index = ARENA_ROUND((size_t)(ths->M_total) * sizeof(INT))
+      + ARENA_ROUND((size_t)(nfft_full_psi_index_size(ths)) * sizeof(INT));
+  }
+
+  if (ths->flags & FFTW_INIT)
+  {
+    if (ths->flags & NFFT_REAL)
+      mem->g = ARENA_ROUND((size_t)(ths->n_total / ths->n[ths->d-1]
+        * (ths->n[ths->d-1]/2+1)) * sizeof(C))
+        + ARENA_ROUND((size_t)(ths->n_total) * sizeof(R));
+    else
+      mem->g = ARENA_ROUND((size_t)(ths->n_total * ths->howmany) * sizeof(C))
+        * ((ths->flags & FFT_OUT_OF_PLACE) ? 2 : 1);
+  }
+
+  /* the one-dimensional FFTW plans, the memory of the plans themselves is
+   * allocated by FFTW */
+  if (ths->flags & NFFT_PRUNED_FFT)
+    mem->other += 2 * ARENA_ROUND((size_t)(ths->d) * sizeof(FFTW(plan)));
+
+  if (ths->flags & NFFT_SORT_NODES)
+    mem->index_x = 2 * ARENA_ROUND(sizeof(INT) * 2U * (size_t)(ths->M_total));
+
+  mem->total = mem->x + mem->f_hat + mem->f + mem->c_phi_inv + mem->psi
+    + mem->psi_index + mem->g + mem->index_x + mem->other;
+}
+
+/** Node independent part of the initialisation: the parameters, the window,
+ * f_hat and f, the oversampled vectors and the FFTW plans. */
+static void init_help_plan(X(plan) *ths)
+{
+  INT t; /* index over all dimensions */
+
+  ths->map = NULL;
+  ths->map_size = 0;
+  ths->map_x = NULL;
+  ths->index_x_sorted = 0;
+  ths->nthreads = Y(get_num_threads)();
+  X(reset_stats)(ths);
+
+  init_parameters(ths);
+
+  ths->my_fftw_plan1_pruned = NULL;
+  ths->my_fftw_plan2_pruned = NULL;
+
+  ths->sigma = (R*) plan_malloc(ths, (size_t)(ths->d) * sizeof(R));
+
+  for(t = 0;t < ths->d; t++)
+    ths->sigma[t] = ((R)ths->n[t]) / (R)(ths->N[t]);
+
+#ifdef NFFT_SIMD
+  simd_init();
+#endif
+
+  ths->b = (R*) plan_malloc(ths, (size_t)(ths->d) * sizeof(R));
+
+  for(t = 0;t < ths->d; t++)
+  {
+    switch (ths->window)
+    {
+      case NFFT_WINDOW_GAUSSIAN:
+        ths->b[t] = WINDOW_HELP_B_GAUSSIAN(ths->sigma[t], ths->m);
+        break;
+      case NFFT_WINDOW_KAISER_BESSEL:
+        ths->b[t] = WINDOW_HELP_B_KAISER_BESSEL(ths->sigma[t], ths->m);
+        break;
+      case NFFT_WINDOW_EXP_SEMICIRCLE:
+        ths->b[t] = WINDOW_HELP_B_EXP_SEMICIRCLE(ths->sigma[t], ths->m);
+        break;
+      default:
+        ths->b[t] = K(0.0);
+    }
+  }
+
+  ths->window_coeffs = NULL;
+
+  if (ths->window == NFFT_WINDOW_EXP_SEMICIRCLE)
+    init_window_exp_semicircle(ths);
+
+  if(ths->flags & MALLOC_F_HAT)
+    ths->f_hat = (C*)malloc_first_touch(ths, (size_t)((ths->N_total - 1) * ths->stride
+      + (ths->howmany - 1) * ths->f_hat_dist + 1) * sizeof(C));
+
+  if(ths->flags & NFFT_REAL)
+  {
+    ths->f = NULL;
+    ths->f_r = NULL;
+    if(ths->flags & MALLOC_F)
+      ths->f_r = (R*)malloc_first_touch(ths, (size_t)(ths->M_total) * sizeof(R));
+  }
+  else
+  {
+    ths->f_r = NULL;
+    if(ths->flags & MALLOC_F)
+      ths->f = (C*)malloc_first_touch(ths, (size_t)((ths->M_total - 1) * ths->stride
+        + (ths->howmany - 1) * ths->f_dist + 1) * sizeof(C));
+  }
+
+  ths->g_r = NULL;
+
+  if(ths->flags & FFTW_INIT)
+  {
+    if(ths->flags & NFFT_REAL)
+    {
+      /* half spectrum and real samples, always out of place */
+      ths->g1 = (C*)malloc_first_touch(ths, (size_t)(ths->n_total / ths->n[ths->d-1]
+        * (ths->n[ths->d-1]/2+1)) * sizeof(C));
+      ths->g_r = (R*)malloc_first_touch(ths, (size_t)(ths->n_total) * sizeof(R));
+      ths->g2 = NULL;
+    }
+    else
+    {
+      ths->g1 = (C*)malloc_first_touch(ths, (size_t)(ths->n_total * ths->howmany) * sizeof(C));
+
+      if(ths->flags & FFT_OUT_OF_PLACE)
+        ths->g2 = (C*) malloc_first_touch(ths, (size_t)(ths->n_total * ths->howmany) * sizeof(C));
+      else
+        ths->g2 = ths->g1;
+    }
+
+    init_fftw_plans(ths);
+  }
+
+  ths->index_x = NULL;
+  ths->index_x_temp = NULL;
+
+  if(ths->flags & NFFT_SORT_NODES)
+    ths->index_x_temp = (INT*) malloc_first_touch(ths, sizeof(INT) * 2U * (size_t)(ths->M_total));
+
+  ths->mv_trafo = (void (*) (void* ))X(trafo);
+  ths->mv_adjoint = (void (*) (void* ))X(adjoint);
+}
+
+/** Node dependent part of the initialisation: x, the matrix D and the arrays
+ * of the precomputation of psi and of the sorting. */
+static void init_help_nodes(X(plan) *ths)
+{
+  INT t; /* index over all dimensions */
+  INT lprod; /* 'bandwidth' of matrix B */
+
+  if(ths->flags & MALLOC_X)
+    ths->x = (R*)malloc_first_touch(ths, (size_t)(ths->d * ths->M_total) * sizeof(R));
+
+  STATS_TIC(NFFT_STATS_PRECOMPUTE)
+  precompute_phi_hut(ths);
+  STATS_TOC(NFFT_STATS_PRECOMPUTE)
+
+  if (ths->flags & PRE_LIN_PSI)
+    ths->psi = (R*) plan_malloc(ths, (size_t)((ths->K+1) * ths->d) * sizeof(R));
+
+  if(ths->flags & PRE_FG_PSI)
+    ths->psi = (R*) malloc_first_touch(ths, (size_t)(ths->M_total * ths->d * 2) * sizeof(R));
+
+  if(ths->flags & NFFT_MIXED_PRECISION)
+  {
+    ths->psi = NULL;
+    ths->psi_single = (float*) malloc_first_touch(ths, (size_t)(ths->M_total * ths->d * (2 * ths->m + 2)) * sizeof(float));
+  }
+  else if(ths->flags & PRE_PSI)
+    ths->psi = (R*) malloc_first_touch(ths, (size_t)(ths->M_total * ths->d * (2 * ths->m + 2)) * sizeof(R));
+
+  if(ths->flags & PRE_FULL_PSI)
+  {
+      for (t = 0, lprod = 1; t < ths->d; t++)
+        lprod *= 2 * ths->m + 2;
+
+      ths->psi = (R*) malloc_first_touch(ths, (size_t)(ths->M_total * lprod) * sizeof(R));
+
+      ths->psi_index_f = (INT*) malloc_first_touch(ths, (size_t)(ths->M_total) * sizeof(INT));
+      ths->psi_index_g = (INT*) malloc_first_touch(ths, (size_t)(nfft_full_psi_index_size(ths)) * sizeof(INT));
+  }
+
+  if(ths->flags & NFFT_SORT_NODES)
+    ths->index_x = (INT*) malloc_first_touch(ths, sizeof(INT) * 2U * (size_t)(ths->M_total));
+}
+
+static void init_help(X(plan) *ths)
+{
+  init_help_plan(ths);
+  init_help_nodes(ths);
+}
+
+void X(init)(X(plan) *ths, int d, int *N, int M_total)
+{
+  INT t; /* index over all dimensions */
+
+  ths->d = (INT)d;
+
+  arena_init(ths, NULL, 0);
+  ths->N = (INT*) plan_malloc(ths, (size_t)(d) * sizeof(INT));
+
+  for (t = 0; t < d; t++)
+    ths->N[t] = (INT)N[t];
+
+  ths->M_total = (INT)M_total;
+
+  ths->n = (INT*) plan_malloc(ths, (size_t)(d) * sizeof(INT));
+
+  for (t = 0; t < d; t++)
+    ths->n[t] = 2 * (Y(next_power_of_2)(ths->N[t]));
+
+  ths->m = WINDOW_HELP_ESTIMATE_m;
+
+  if (d > 1)
+  {
+#ifdef _OPENMP
+    ths->flags = PRE_PHI_HUT | PRE_PSI | MALLOC_X| MALLOC_F_HAT | MALLOC_F |
+                      FFTW_INIT | FFT_OUT_OF_PLACE | NFFT_SORT_NODES |
+                 NFFT_OMP_BLOCKWISE_ADJOINT;
+#else
+    ths->flags = PRE_PHI_HUT | PRE_PSI | MALLOC_X| MALLOC_F_HAT | MALLOC_F |
+                      FFTW_INIT | FFT_OUT_OF_PLACE | NFFT_SORT_NODES;
+#endif
+  }
+  else
+    ths->flags = PRE_PHI_HUT | PRE_PSI | MALLOC_X| MALLOC_F_HAT | MALLOC_F |
+                      FFTW_INIT | FFT_OUT_OF_PLACE;
+
+  ths->fftw_flags= FFTW_ESTIMATE| FFTW_DESTROY_INPUT;
+
+  ths->K = 0;
+  ths->howmany = 1;
+  ths->stride = 1;
+  ths->f_hat_dist = ths->f_dist = 0;
+  init_help(ths);
+}
+
+/** init_guru with the arena of the plan set up. */
+static void init_guru_help(X(plan) *ths, int d, int *N, int M_total, int *n,
+  int m, unsigned flags, unsigned fftw_flags)
+{
+  INT t; /* index over all dimensions */
+
+  ths->d = (INT)d;
+  ths->M_total = (INT)M_total;
+  ths->N = (INT*)plan_malloc(ths, (size_t)(ths->d) * sizeof(INT));
+
+  for (t = 0; t < d; t++)
+    ths->N[t] = (INT)N[t];
+
+  ths->n = (INT*)plan_malloc(ths, (size_t)(ths->d) * sizeof(INT));
+
+  for (t = 0; t < d; t++)
+    ths->n[t] = (INT)n[t];
+
+  ths->m = (INT)m;
+
+  ths->flags = flags;
+  ths->fftw_flags = fftw_flags;
+
+  ths->K = 0;
+  ths->howmany = 1;
+  ths->stride = 1;
+  ths->f_hat_dist = ths->f_dist = 0;
+  init_help(ths);
+}
+
+void X(init_guru)(X(plan) *ths, int d, int *N, int M_total, int *n, int m,
+  unsigned flags, unsigned fftw_flags)
+{
+  arena_init(ths, NULL, 0);
+  init_guru_help(ths, d, N, M_total, n, m, flags, fftw_flags);
+}
+
+size_t X(estimate_memory)(int d, int *N, int M_total, int *n, int m,
+  unsigned flags, X(plan_memory) *mem)
+{
+  X(plan) p;
+  X(plan_memory) q;
+  INT N1[d], n1[d];
+  INT t;
+
+  memset(&p, 0, sizeof(p));
+
+  for (t = 0; t < d; t++)
+  {
+    N1[t] = (INT)N[t];
+    n1[t] = (INT)n[t];
+  }
+
+  p.d = (INT)d;
+  p.N = N1;
+  p.n = n1;
+  p.M_total = (INT)M_total;
+  p.m = (INT)m;
+  p.flags = flags;
+  p.howmany = 1;
+  p.stride = 1;
+
+  init_parameters(&p);
+
+  if (!mem)
+    mem = &q;
+
+  plan_memory(&p, mem);
+
+  return mem->total;
+}
+
+void X(init_guru_arena)(X(plan) *ths, int d, int *N, int M_total, int *n,
+  int m, unsigned flags, unsigned fftw_flags, void *arena, size_t arena_size)
+{
+  if (arena)
+    arena_init(ths, arena, arena_size);
+  else
+  {
+    const size_t size = X(estimate_memory)(d, N, M_total, n, m, flags, NULL);
+    const size_t align = (size >= ARENA_HUGE_PAGE) ? ARENA_HUGE_PAGE : ARENA_ALIGN;
+    void *block = Y(malloc)(size + align);
+    char *a = (char*)block + (align - (size_t)((uintptr_t)block % align)) % align;
+
+#if defined(NFFT_PLAN_MMAP) && defined(HAVE_MADVISE) && defined(MADV_HUGEPAGE)
+    if (align == ARENA_HUGE_PAGE)
+      madvise(a, size / ARENA_HUGE_PAGE * ARENA_HUGE_PAGE, MADV_HUGEPAGE);
+#endif
+
+    arena_init(ths, a, size);
+    ths->arena_block = block;
+  }
+
+  init_guru_help(ths, d, N, M_total, n, m, flags, fftw_flags);
+}
+
+void X(init_guru_many)(X(plan) *ths, int d, int *N, int M_total, int *n, int m,
+  int howmany, int stride, int f_hat_dist, int f_dist, unsigned flags,
+  unsigned fftw_flags)
+{
+  INT t; /* index over all dimensions */
+
+  ths->d = (INT)d;
+  arena_init(ths, NULL, 0);
+  ths->M_total = (INT)M_total;
+  ths->N = (INT*)plan_malloc(ths, (size_t)(ths->d) * sizeof(INT));
+
+  for (t = 0; t < d; t++)
+    ths->N[t] = (INT)N[t];
+
+  ths->n = (INT*)plan_malloc(ths, (size_t)(ths->d) * sizeof(INT));
+
+  for (t = 0; t < d; t++)
+    ths->n[t] = (INT)n[t];
+
+  ths->m = (INT)m;
+
+  ths->flags = flags;
+  ths->fftw_flags = fftw_flags;
+
+  ths->K = 0;
+  ths->howmany = (INT)howmany;
+  ths->stride = (INT)stride;
+  ths->f_hat_dist = (INT)f_hat_dist;
+  ths->f_dist = (INT)f_dist;
+  init_help(ths);
+}
+
+void X(init_guru_real)(X(plan) *ths, int d, int *N, int M_total, int *n, int m,
+  unsigned flags, unsigned fftw_flags)
+{
+  X(init_guru)(ths, d, N, M_total, n, m, flags | NFFT_REAL, fftw_flags);
+}
+
+void X(init_lin)(X(plan) *ths, int d, int *N, int M_total, int *n, int m, int K,
+  unsigned flags, unsigned fftw_flags)
+{
+  INT t; /* index over all dimensions */
+
+  ths->d = (INT)d;
+  arena_init(ths, NULL, 0);
+  ths->M_total = (INT)M_total;
+  ths->N = (INT*)plan_malloc(ths, (size_t)(ths->d) * sizeof(INT));
+
+  for (t = 0; t < d; t++)
+    ths->N[t] = (INT)N[t];
+
+  ths->n = (INT*)plan_malloc(ths, (size_t)(ths->d) * sizeof(INT));
+
+  for (t = 0; t < d; t++)
+    ths->n[t] = (INT)n[t];
+
+  ths->m = (INT)m;
+
+  ths->flags = flags;
+  ths->fftw_flags = fftw_flags;
+
+  ths->K = K;
+  ths->howmany = 1;
+  ths->stride = 1;
+  ths->f_hat_dist = ths->f_dist = 0;
+  init_help(ths);
+}
+
+void X(init_1d)(X(plan) *ths, int N1, int M_total)
+{
+  int N[1];
+
+  N[0] = N1;
+
+  X(init)(ths, 1, N, M_total);
+}
+
+void X(init_2d)(X(plan) *ths, int N1, int N2, int M_total)
+{
+  int N[2];
+
+  N[0] = N1;
+  N[1] = N2;
+  X(init)(ths, 2, N, M_total);
+}
+
+void X(init_3d)(X(plan) *ths, int N1, int N2, int N3, int M_total)
+{
+  int N[3];
+
+  N[0] = N1;
+  N[1] = N2;
+  N[2] = N3;
+  X(init)(ths, 3, N, M_total);
+}
+
+const char* X(get_plan_window_name)(const X(plan) *ths)
+{
+  return Y(window_name)(ths->window);
+}
+
+const char* X(check)(X(plan) *ths)
+{
+  INT j;
+
+  if ((ths->flags & NFFT_REAL) ? !ths->f_r : !ths->f)
+      return "Member f not initialized.";
+
+  if (!ths->x)
+      return "Member x not initialized.";
+
+  if (!ths->f_hat)
+      return "Member f_hat not initialized.";
+
+  if ((ths->flags & PRE_LIN_PSI) && ths->K < ths->M_total)
+    return "Number of nodes too small to use PRE_LIN_PSI.";
+
+  if (ths->howmany < 1 || ths->stride < 1 || ths->f_hat_dist < 0 || ths->f_dist < 0)
+    return "Invalid batch layout (howmany, stride, f_hat_dist, f_dist).";
+
+  if ((ths->flags & NFFT_REAL) && ths->howmany > 1)
+    return "Flag NFFT_REAL does not support howmany > 1.";
+
+  if (ths->window > NFFT_WINDOW_EXP_SEMICIRCLE)
+    return "Unknown window function.";
+
+  if ((ths->flags & (FG_PSI | PRE_FG_PSI)) && ths->window != NFFT_WINDOW_GAUSSIAN)
+    return "Flags FG_PSI and PRE_FG_PSI require the Gaussian window.";
+
+  for (j = 0; j < ths->M_total * ths->d; j++)
+  {
+    if ((ths->x[j]<-K(0.5)) || (ths->x[j]>= K(0.5)))
+    {
+      return "ths->x out of range [-0.5,0.5)";
+    }
+  }
+
+  for (j = 0; j < ths->d; j++)
+  {
+    if (ths->sigma[j] <= 1)
+      return "Oversampling factor too small";
+    
+    /* Automatically calls trafo_direct if 
+    if(ths->N[j] <= ths->m)
+      return "Polynomial degree N is <= cut-off m";
+    */
+
+    if(ths->N[j]%2 == 1)
+      return "polynomial degree N has to be even";
+  }
+  return 0;
+}
+
+static void plan_file_release(X(plan) *ths);
+
+void X(finalize)(X(plan) *ths)
+{
+  INT t; /* index over dimensions */
+
+  if (ths->map)
+    plan_file_release(ths);
+
+  if(ths->flags & NFFT_SORT_NODES)
+  {
+    plan_free(ths, ths->index_x_temp);
+    plan_free(ths, ths->index_x);
+  }
+
+  if(ths->flags & FFTW_INIT)
+  {
+    finalize_fftw_plans(ths);
+
+    if(ths->flags & NFFT_REAL)
+      plan_free(ths, ths->g_r);
+    else if(ths->flags & FFT_OUT_OF_PLACE)
+      plan_free(ths, ths->g2);
+
+    plan_free(ths, ths->g1);
+  }
+
+  if(ths->flags & PRE_FULL_PSI)
+  {
+    plan_free(ths, ths->psi_index_g);
+    plan_free(ths, ths->psi_index_f);
+    plan_free(ths, ths->psi);
+  }
+
+  if(ths->flags & PRE_PSI)
+    plan_free(ths, ths->psi);
+
+  if(ths->flags & NFFT_MIXED_PRECISION)
+    plan_free(ths, ths->psi_single);
+
+  if(ths->flags & PRE_FG_PSI)
+    plan_free(ths, ths->psi);
+
+  if(ths->flags & PRE_LIN_PSI)
+    plan_free(ths, ths->psi);
+
+  for (t = 0; t < ths->d; t++)
+    plan_free(ths, ths->c_phi_inv[t]);
+  plan_free(ths, ths->c_phi_inv);
+
+  if(ths->flags & MALLOC_F)
+  {
+    if(ths->flags & NFFT_REAL)
+      plan_free(ths, ths->f_r);
+    else
+      plan_free(ths, ths->f);
+  }
+
+  if(ths->flags & MALLOC_F_HAT)
+    plan_free(ths, ths->f_hat);
+
+  if(ths->flags & MALLOC_X)
+    plan_free(ths, ths->x);
+
+  if (ths->window_coeffs)
+    plan_free(ths, ths->window_coeffs);
+
+  plan_free(ths, ths->b);
+
+  plan_free(ths, ths->sigma);
+  plan_free(ths, ths->n);
+  plan_free(ths, ths->N);
+
+  if (ths->arena_block)
+    Y(free)(ths->arena_block);
+}
+
+/** Replaces an array depending on the number of nodes, arrays of a plan file
+ *  or the arena stay in place. */
+static void *nodes_realloc(X(plan) *ths, void *p, const size_t size)
+{
+  plan_free(ths, p);
+
+  return malloc_first_touch(ths, size);
+}
+
+const char* X(set_nodes)(X(plan) *ths, int M_total, const R *x)
+{
+  /* the array of the caller has room for the old number of nodes only */
+  if (!(ths->flags & MALLOC_X) && (INT)M_total != ths->M_total && x
+    && x != ths->x)
+    return "Without MALLOC_X, set ths->x to an array for the new number of nodes.";
+
+  plan_file_own(ths);
+
+  if ((INT)M_total != ths->M_total)
+  {
+    const INT M = (INT)M_total;
+    INT t, lprod;
+
+    for (t = 0, lprod = 1; t < ths->d; t++)
+      lprod *= 2 * ths->m + 2;
+
+    ths->M_total = M;
+
+    if(ths->flags & MALLOC_X)
+      ths->x = (R*) nodes_realloc(ths, ths->x, (size_t)(ths->d * M) * sizeof(R));
+
+    if(ths->flags & MALLOC_F)
+    {
+      if(ths->flags & NFFT_REAL)
+        ths->f_r = (R*) nodes_realloc(ths, ths->f_r, (size_t)(M) * sizeof(R));
+      else
+        ths->f = (C*) nodes_realloc(ths, ths->f, (size_t)((M - 1) * ths->stride
+          + (ths->howmany - 1) * ths->f_dist + 1) * sizeof(C));
+    }
+
+    /* same precedence as in init_help */
+    if(ths->flags & PRE_FULL_PSI)
+    {
+      ths->psi = (R*) nodes_realloc(ths, ths->psi, (size_t)(M * lprod) * sizeof(R));
+      ths->psi_index_f = (INT*) nodes_realloc(ths, ths->psi_index_f, (size_t)(M) * sizeof(INT));
+      ths->psi_index_g = (INT*) nodes_realloc(ths, ths->psi_index_g, (size_t)(nfft_full_psi_index_size(ths)) * sizeof(INT));
+    }
+    else if(ths->flags & NFFT_MIXED_PRECISION)
+      ths->psi_single = (float*) nodes_realloc(ths, ths->psi_single, (size_t)(M * ths->d * (2 * ths->m + 2)) * sizeof(float));
+    else if(ths->flags & PRE_PSI)
+      ths->psi = (R*) nodes_realloc(ths, ths->psi, (size_t)(M * ths->d * (2 * ths->m + 2)) * sizeof(R));
+    else if(ths->flags & PRE_FG_PSI)
+      ths->psi = (R*) nodes_realloc(ths, ths->psi, (size_t)(M * ths->d * 2) * sizeof(R));
+
+    if(ths->flags & NFFT_SORT_NODES)
+    {
+      ths->index_x = (INT*) nodes_realloc(ths, ths->index_x, sizeof(INT) * 2U * (size_t)(M));
+      ths->index_x_temp = (INT*) nodes_realloc(ths, ths->index_x_temp, sizeof(INT) * 2U * (size_t)(M));
+    }
+  }
+
+  if (x && x != ths->x)
+    memcpy(ths->x, x, (size_t)(ths->d * ths->M_total) * sizeof(R));
+
+  X(precompute_one_psi)(ths);
+
+  return 0;
+}
+
+/** Moves the marked nodes in ths->index_x by sorting their new pairs and
+ *  merging them with the remaining ones. The marks are the M_total entries
+ *  of index_x_temp past the 4c entries of c pairs and their sort scratch. */
+static void update_index_merge(X(plan) *ths, const INT c, const INT *mark,
+  const INT *edge, const INT *nt, const INT *bits, const INT bits_max,
+  const INT nprod)
+{
+  INT *ar = ths->index_x, *moved = ths->index_x_temp;
+  INT i, j, k, l;
+
+  for (j = 0, k = 0; j < ths->M_total; j++)
+  {
+    if (mark[j])
+    {
+      moved[2 * k] = sort_key(ths->d, ths->n, ths->m, ths->flags,
+        &ths->x[j * ths->d], edge, nt, bits, bits_max);
+      moved[2 * k + 1] = j;
+      k++;
+    }
+  }
+
+  Y(sort_node_indices_radix_lsdf)(c, moved, moved + 2 * c,
+    (INT) LRINT(CEIL(LOG2((R)nprod))) - 1, ths->nthreads);
+
+  for (i = 0, l = 0; i < ths->M_total; i++)
+  {
+    if (!mark[ar[2 * i + 1]])
+    {
+      ar[2 * l] = ar[2 * i];
+      ar[2 * l + 1] = ar[2 * i + 1];
+      l++;
+    }
+  }
+
+  /* merge from the back, l + c = M_total */
+  for (i = ths->M_total - 1, l--, k = c - 1; k >= 0; i--)
+  {
+    if (l >= 0 && (ar[2 * l] > moved[2 * k]
+      || (ar[2 * l] == moved[2 * k] && ar[2 * l + 1] > moved[2 * k + 1])))
+    {
+      ar[2 * i] = ar[2 * l];
+      ar[2 * i + 1] = ar[2 * l + 1];
+      l--;
+    }
+    else
+    {
+      ar[2 * i] = moved[2 * k];
+      ar[2 * i + 1] = moved[2 * k + 1];
+      k--;
     }
+  }
+}
+
+void X(update_nodes)(X(plan) *ths, int count, const int *indices, const R *x)
+{
+  const INT M = ths->M_total, d = ths->d;
+  const int repair = (ths->flags & NFFT_SORT_NODES)
+    && (ths->flags & (PRE_PSI | PRE_FG_PSI | PRE_FULL_PSI));
+  INT *moved = NULL; /* distinct nodes to recompute */
+  INT c = 0, i, j, t;
 
+  if (count <= 0)
     return;
-  } /* if(FG_PSI) */
 
-  if(ths->flags & PRE_LIN_PSI)
+  plan_file_own(ths);
+
+  if (ths->flags & (PRE_PSI | PRE_FG_PSI | PRE_FULL_PSI))
+    moved = (INT*) Y(malloc)((size_t)(count) * sizeof(INT));
+
+  if (repair && ths->index_x_sorted && (INT)(count) * 4 <= M)
   {
-    const INT K = ths->K;
-    const INT ip_s = K / (m + 2);
+    INT edge[d], nt[d], bits[d], bits_max;
+    const INT nprod = sort_key_init(d, ths->n, ths->flags, edge, nt, bits,
+      &bits_max);
+    INT *mark = ths->index_x_temp + M;
 
-    sort(ths);
+    memset(mark, 0, (size_t)(M) * sizeof(INT));
 
-#ifdef _OPENMP
-    MACRO_adjoint_3d_B_OMP_BLOCKWISE(PRE_LIN_PSI)
-#endif
+    for (i = 0; i < count; i++)
+    {
+      j = (INT)(indices[i]);
+      memcpy(&ths->x[j * d], &x[i * d], (size_t)(d) * sizeof(R));
+      if (!mark[j])
+        moved[c++] = j;
+      mark[j] = 1;
+    }
 
-#ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k)
-#endif
-    for (k = 0; k < M; k++)
+    STATS_TIC(NFFT_STATS_SORT)
+    update_index_merge(ths, c, mark, edge, nt, bits, bits_max, nprod);
+    STATS_TOC(NFFT_STATS_SORT)
+  }
+  else
+  {
+    /* a repeated index is recomputed once, the loops below write per node */
+    unsigned char *mark = moved ? (unsigned char*) Y(malloc)((size_t)(M)) : NULL;
+
+    if (mark)
+      memset(mark, 0, (size_t)(M));
+
+    for (i = 0; i < count; i++)
     {
-      INT u,o,l;
-      INT ip_u;
-      R ip_y, ip_w;
-      INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
-      R psij_const[3*(2*m+2)];
+      j = (INT)(indices[i]);
+      memcpy(&ths->x[j * d], &x[i * d], (size_t)(d) * sizeof(R));
+      if (mark && !mark[j])
+      {
+        moved[c++] = j;
+        mark[j] = 1;
+      }
+    }
 
-      uo(ths,j,&u,&o,(INT)0);
-      ip_y = FABS((R)(n0) * ths->x[3*j+0] - (R)(u)) * ((R)ip_s);
-      ip_u = (INT)(LRINT(FLOOR(ip_y)));
-      ip_w = ip_y - (R)(ip_u);
-      for(l=0; l < 2*m+2; l++)
-        psij_const[l] = ths->psi[ABS(ip_u-l*ip_s)]*(K(1.0)-ip_w) +
-          ths->psi[ABS(ip_u-l*ip_s+1)]*(ip_w);
+    Y(free)(mark);
 
-      uo(ths,j,&u,&o,(INT)1);
-      ip_y = FABS((R)(n1) * ths->x[3*j+1] - (R)(u)) * ((R)ip_s);
-      ip_u = (INT)(LRINT(FLOOR(ip_y)));
-      ip_w = ip_y - (R)(ip_u);
-      for(l=0; l < 2*m+2; l++)
-        psij_const[2*m+2+l] = ths->psi[(K+1)+ABS(ip_u-l*ip_s)]*(K(1.0)-ip_w) +
-          ths->psi[(K+1)+ABS(ip_u-l*ip_s+1)]*(ip_w);
+    ths->index_x_sorted = 0;
 
-      uo(ths,j,&u,&o,(INT)2);
-      ip_y = FABS((R)(n2) * ths->x[3*j+2] - (R)(u))*((R)ip_s);
-      ip_u = (INT)(LRINT(FLOOR(ip_y)));
-      ip_w = ip_y - (R)(ip_u);
-      for(l=0; l < 2*m+2; l++)
-        psij_const[2*(2*m+2)+l] = ths->psi[2*(K+1)+ABS(ip_u-l*ip_s)]*(K(1.0)-ip_w) +
-          ths->psi[2*(K+1)+ABS(ip_u-l*ip_s+1)]*(ip_w);
+    if (repair)
+      sort(ths);
+  }
 
-#ifdef _OPENMP
-      nfft_adjoint_3d_compute_omp_atomic(ths->f[j], g, psij_const, psij_const+2*m+2, psij_const+(2*m+2)*2, ths->x+3*j, ths->x+3*j+1, ths->x+3*j+2, n0, n1, n2, m);
-#else
-      nfft_adjoint_3d_compute_serial(ths->f+j, g, psij_const, psij_const+2*m+2, psij_const+(2*m+2)*2, ths->x+3*j, ths->x+3*j+1, ths->x+3*j+2, n0, n1, n2, m);
-#endif
-    }
-    return;
-  } /* if(PRE_LIN_PSI) */
+  if (ths->flags & PRE_FULL_PSI)
+  {
+    INT lprod;
 
-  /* no precomputed psi at all */
-  sort(ths);
+    for (t = 0, lprod = 1; t < d; t++)
+      lprod *= 2 * ths->m + 2;
 
 #ifdef _OPENMP
-  MACRO_adjoint_3d_B_OMP_BLOCKWISE(NO_PSI)
+    #pragma omp parallel for default(shared) private(i) num_threads(ths->nthreads)
 #endif
+    for (i = 0; i < c; i++)
+      nfft_precompute_full_psi_j(ths, moved[i], lprod);
+  }
+  else if (ths->flags & PRE_PSI)
+  {
+    for (t = 0; t < d; t++)
+    {
+      const R scale = (ths->flags & NFFT_MIXED_PRECISION)
+        ? nfft_mixed_scale(ths, t) : K(1.0);
 
 #ifdef _OPENMP
-  #pragma omp parallel for default(shared) private(k)
+      #pragma omp parallel for default(shared) private(i) num_threads(ths->nthreads)
 #endif
-  for (k = 0; k < M; k++)
+      for (i = 0; i < c; i++)
+        precompute_psi_tj(ths, t, moved[i], scale);
+    }
+  }
+  else if (ths->flags & PRE_FG_PSI)
   {
-    INT u,o,l;
-    R psij_const[3*(2*m+2)];
-    INT j = (ths->flags & NFFT_SORT_NODES) ? ths->index_x[2*k+1] : k;
+    for (t = 0; t < d; t++)
+    {
+#ifdef _OPENMP
+      #pragma omp parallel for default(shared) private(i) num_threads(ths->nthreads)
+#endif
+      for (i = 0; i < c; i++)
+        precompute_fg_psi_tj(ths, t, moved[i]);
+    }
+  }
 
-    uo(ths,j,&u,&o,(INT)0);
-    for(l=0;l<=2*m+1;l++)
-      psij_const[l]=(PHI(ths->n[0], ths->x[3*j] - ((R)((u+l))) / (R)(n0),0));
+  Y(free)(moved);
+}
 
-    uo(ths,j,&u,&o,(INT)1);
-    for(l=0;l<=2*m+1;l++)
-      psij_const[2*m+2+l]=(PHI(ths->n[1], ths->x[3*j+1] - ((R)((u+l))) / (R)(n1),1));
+void X(plan_with_nthreads)(X(plan) *ths, int nthreads)
+{
+  const INT k = (nthreads > 0) ? (INT)nthreads : Y(get_num_threads)();
 
-    uo(ths,j,&u,&o,(INT)2);
-    for(l=0;l<=2*m+1;l++)
-      psij_const[2*(2*m+2)+l]=(PHI(ths->n[2], ths->x[3*j+2] - ((R)((u+l))) / (R)(n2),2));
+  if (k == ths->nthreads)
+    return;
+
+  ths->nthreads = k;
 
 #ifdef _OPENMP
-    nfft_adjoint_3d_compute_omp_atomic(ths->f[j], g, psij_const, psij_const+2*m+2, psij_const+(2*m+2)*2, ths->x+3*j, ths->x+3*j+1, ths->x+3*j+2, n0, n1, n2, m);
-#else
-    nfft_adjoint_3d_compute_serial(ths->f+j, g, psij_const, psij_const+2*m+2, psij_const+(2*m+2)*2, ths->x+3*j, ths->x+3*j+1, ths->x+3*j+2, n0, n1, n2, m);
-#endif
+  /* FFTW plans keep the thread count they were created with */
+  if (ths->flags & FFTW_INIT)
+  {
+    finalize_fftw_plans(ths);
+    init_fftw_plans(ths);
   }
+#endif
 }
 
+/* Plan files. A plan file starts with the identifier "NFFT", the format
+ * version, sizeof(R) and sizeof(INT), followed by the header fields PF_*, the
+ * bandwidths N and the FFT lengths n. The sections PF_SEC_* follow at offsets
+ * aligned to PLAN_FILE_ALIGN bytes, in native byte order, such that the file
+ * can be mapped into memory and used in place. */
 
-void X(trafo_3d)(X(plan) *ths)
+#define PLAN_FILE_VERSION 2
+#define PLAN_FILE_ALIGN ((size_t)64)
+#define PLAN_FILE_ROUND(s) (((s) + PLAN_FILE_ALIGN - 1) / PLAN_FILE_ALIGN * PLAN_FILE_ALIGN)
+
+enum { PF_D, PF_M_TOTAL, PF_M, PF_K, PF_HOWMANY, PF_STRIDE, PF_F_HAT_DIST,
+  PF_F_DIST, PF_FLAGS, PF_FFTW_FLAGS, PF_WINDOW, PF_WISDOM, PF_LEN };
+
+enum { PF_SEC_WISDOM, PF_SEC_X, PF_SEC_PHI, PF_SEC_PSI, PF_SEC_PSI_F,
+  PF_SEC_PSI_G, PF_SEC_INDEX_X, PF_SEC_END };
+
+/** Number of R in ths->psi, depending on the precomputation flag, with the
+ * same precedence as the allocation in init_help. */
+static INT plan_psi_size(const X(plan) *ths)
 {
-  if((ths->N[0] <= ths->m) || (ths->N[1] <= ths->m) || (ths->N[2] <= ths->m) || (ths->n[0] <= 2*ths->m+2) || (ths->n[1] <= 2*ths->m+2) || (ths->n[2] <= 2*ths->m+2))
+  INT t, lprod;
+
+  if (ths->flags & PRE_FULL_PSI)
   {
-    X(trafo_direct)(ths);
-    return;
+    for (t = 0, lprod = 1; t < ths->d; t++)
+      lprod *= 2 * ths->m + 2;
+    return ths->M_total * lprod;
   }
-  
-  INT k0,k1,k2,n0,n1,n2,N0,N1,N2;
-  C *g_hat,*f_hat;
-  R *c_phi_inv01, *c_phi_inv02, *c_phi_inv11, *c_phi_inv12, *c_phi_inv21, *c_phi_inv22;
-  R ck01, ck02, ck11, ck12, ck21, ck22;
-  C *g_hat111,*f_hat111,*g_hat211,*f_hat211,*g_hat121,*f_hat121,*g_hat221,*f_hat221;
-  C *g_hat112,*f_hat112,*g_hat212,*f_hat212,*g_hat122,*f_hat122,*g_hat222,*f_hat222;
-
-  ths->g_hat=ths->g1;
-  ths->g=ths->g2;
 
-  N0=ths->N[0];
-  N1=ths->N[1];
-  N2=ths->N[2];
-  n0=ths->n[0];
-  n1=ths->n[1];
-  n2=ths->n[2];
+  if (ths->flags & PRE_PSI)
+    return ths->M_total * ths->d * (2 * ths->m + 2);
 
-  f_hat=(C*)ths->f_hat;
-  g_hat=(C*)ths->g_hat;
+  if (ths->flags & PRE_FG_PSI)
+    return ths->M_total * ths->d * 2;
 
-  TIC(0)
-#ifdef _OPENMP
-  #pragma omp parallel for default(shared) private(k0)
-  for (k0 = 0; k0 < ths->n_total; k0++)
-    ths->g_hat[k0] = 0.0;
-#else
-  memset(ths->g_hat, 0, (size_t)(ths->n_total) * sizeof(C));
-#endif
+  if (ths->flags & PRE_LIN_PSI)
+    return (ths->K + 1) * ths->d;
 
-  if(ths->flags & PRE_PHI_HUT)
-    {
-      c_phi_inv01=ths->c_phi_inv[0];
-      c_phi_inv02=&ths->c_phi_inv[0][N0/2];
+  return 0;
+}
 
-#ifdef _OPENMP
-      #pragma omp parallel for default(shared) private(k0,k1,k2,ck01,ck02,c_phi_inv11,c_phi_inv12,ck11,ck12,c_phi_inv21,c_phi_inv22,g_hat111,f_hat111,g_hat211,f_hat211,g_hat121,f_hat121,g_hat221,f_hat221,g_hat112,f_hat112,g_hat212,f_hat212,g_hat122,f_hat122,g_hat222,f_hat222,ck21,ck22)
-#endif
-      for(k0=0;k0<N0/2;k0++)
-  {
-    ck01=c_phi_inv01[k0];
-    ck02=c_phi_inv02[k0];
-    c_phi_inv11=ths->c_phi_inv[1];
-    c_phi_inv12=&ths->c_phi_inv[1][N1/2];
+/** Size of the PSI section in bytes, the window values are floats for
+ * NFFT_MIXED_PRECISION. */
+static size_t plan_psi_bytes(const X(plan) *ths)
+{
+  return (size_t)(plan_psi_size(ths))
+    * ((ths->flags & NFFT_MIXED_PRECISION) ? sizeof(float) : sizeof(R));
+}
 
-    for(k1=0;k1<N1/2;k1++)
-      {
-        ck11=c_phi_inv11[k1];
-        ck12=c_phi_inv12[k1];
-        c_phi_inv21=ths->c_phi_inv[2];
-        c_phi_inv22=&ths->c_phi_inv[2][N2/2];
-
-        g_hat111=g_hat + ((n0-(N0/2)+k0)*n1+n1-(N1/2)+k1)*n2+n2-(N2/2);
-        f_hat111=f_hat + (k0*N1+k1)*N2;
-        g_hat211=g_hat + (k0*n1+n1-(N1/2)+k1)*n2+n2-(N2/2);
-        f_hat211=f_hat + (((N0/2)+k0)*N1+k1)*N2;
-        g_hat121=g_hat + ((n0-(N0/2)+k0)*n1+k1)*n2+n2-(N2/2);
-        f_hat121=f_hat + (k0*N1+(N1/2)+k1)*N2;
-        g_hat221=g_hat + (k0*n1+k1)*n2+n2-(N2/2);
-        f_hat221=f_hat + (((N0/2)+k0)*N1+(N1/2)+k1)*N2;
-
-        g_hat112=g_hat + ((n0-(N0/2)+k0)*n1+n1-(N1/2)+k1)*n2;
-        f_hat112=f_hat + (k0*N1+k1)*N2+(N2/2);
-        g_hat212=g_hat + (k0*n1+n1-(N1/2)+k1)*n2;
-        f_hat212=f_hat + (((N0/2)+k0)*N1+k1)*N2+(N2/2);
-        g_hat122=g_hat + ((n0-(N0/2)+k0)*n1+k1)*n2;
-        f_hat122=f_hat + (k0*N1+N1/2+k1)*N2+(N2/2);
-        g_hat222=g_hat + (k0*n1+k1)*n2;
-        f_hat222=f_hat + (((N0/2)+k0)*N1+(N1/2)+k1)*N2+(N2/2);
-
-        for(k2=0;k2<N2/2;k2++)
-    {
-      ck21=c_phi_inv21[k2];
-      ck22=c_phi_inv22[k2];
-
-      g_hat111[k2] = f_hat111[k2] * ck01 * ck11 * ck21;
-      g_hat211[k2] = f_hat211[k2] * ck02 * ck11 * ck21;
-      g_hat121[k2] = f_hat121[k2] * ck01 * ck12 * ck21;
-      g_hat221[k2] = f_hat221[k2] * ck02 * ck12 * ck21;
-
-      g_hat112[k2] = f_hat112[k2] * ck01 * ck11 * ck22;
-      g_hat212[k2] = f_hat212[k2] * ck02 * ck11 * ck22;
-      g_hat122[k2] = f_hat122[k2] * ck01 * ck12 * ck22;
-      g_hat222[k2] = f_hat222[k2] * ck02 * ck12 * ck22;
-    }
-      }
-  }
-    }
-  else
-#ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k0,k1,k2,ck01,ck02,ck11,ck12,ck21,ck22)
-#endif
-    for(k0=0;k0<N0/2;k0++)
-      {
-  ck01=K(1.0)/(PHI_HUT(ths->n[0],k0-N0/2,0));
-  ck02=K(1.0)/(PHI_HUT(ths->n[0],k0,0));
-  for(k1=0;k1<N1/2;k1++)
-    {
-      ck11=K(1.0)/(PHI_HUT(ths->n[1],k1-N1/2,1));
-      ck12=K(1.0)/(PHI_HUT(ths->n[1],k1,1));
+/** Offsets of the sections of a plan file, off[PF_SEC_END] is its size. */
+static void plan_file_layout(const X(plan) *ths, const INT wisdom,
+  size_t *off)
+{
+  size_t size[PF_SEC_END];
+  INT t, N_sum;
+  int i;
+
+  for (t = 0, N_sum = 0; t < ths->d; t++)
+    N_sum += ths->N[t];
+
+  size[PF_SEC_WISDOM] = (size_t)(wisdom + 1);
+  size[PF_SEC_X] = (size_t)(ths->d * ths->M_total) * sizeof(R);
+  size[PF_SEC_PHI] = (size_t)(N_sum) * sizeof(R);
+  size[PF_SEC_PSI] = plan_psi_bytes(ths);
+  size[PF_SEC_PSI_F] = (ths->flags & PRE_FULL_PSI)
+    ? (size_t)(ths->M_total) * sizeof(INT) : 0;
+  size[PF_SEC_PSI_G] = (ths->flags & PRE_FULL_PSI)
+    ? (size_t)(nfft_full_psi_index_size(ths)) * sizeof(INT) : 0;
+  size[PF_SEC_INDEX_X] = (ths->flags & NFFT_SORT_NODES)
+    ? (size_t)(2 * ths->M_total) * sizeof(INT) : 0;
+
+  off[0] = PLAN_FILE_ROUND(8 + (size_t)(PF_LEN + 2 * ths->d) * sizeof(INT));
+  for (i = 0; i < PF_SEC_END; i++)
+    off[i + 1] = PLAN_FILE_ROUND(off[i] + size[i]);
+}
 
-      for(k2=0;k2<N2/2;k2++)
-        {
-    ck21=K(1.0)/(PHI_HUT(ths->n[2],k2-N2/2,2));
-    ck22=K(1.0)/(PHI_HUT(ths->n[2],k2,2));
-
-    g_hat[((n0-N0/2+k0)*n1+n1-N1/2+k1)*n2+n2-N2/2+k2] = f_hat[(k0*N1+k1)*N2+k2]                  * ck01 * ck11 * ck21;
-    g_hat[(k0*n1+n1-N1/2+k1)*n2+n2-N2/2+k2]           = f_hat[((N0/2+k0)*N1+k1)*N2+k2]           * ck02 * ck11 * ck21;
-    g_hat[((n0-N0/2+k0)*n1+k1)*n2+n2-N2/2+k2]         = f_hat[(k0*N1+N1/2+k1)*N2+k2]             * ck01 * ck12 * ck21;
-    g_hat[(k0*n1+k1)*n2+n2-N2/2+k2]                   = f_hat[((N0/2+k0)*N1+N1/2+k1)*N2+k2]      * ck02 * ck12 * ck21;
-
-    g_hat[((n0-N0/2+k0)*n1+n1-N1/2+k1)*n2+k2]         = f_hat[(k0*N1+k1)*N2+N2/2+k2]             * ck01 * ck11 * ck22;
-    g_hat[(k0*n1+n1-N1/2+k1)*n2+k2]                   = f_hat[((N0/2+k0)*N1+k1)*N2+N2/2+k2]      * ck02 * ck11 * ck22;
-    g_hat[((n0-N0/2+k0)*n1+k1)*n2+k2]                 = f_hat[(k0*N1+N1/2+k1)*N2+N2/2+k2]        * ck01 * ck12 * ck22;
-    g_hat[(k0*n1+k1)*n2+k2]                           = f_hat[((N0/2+k0)*N1+N1/2+k1)*N2+N2/2+k2] * ck02 * ck12 * ck22;
-        }
-    }
-      }
+/** Writes size bytes at offset off, padding with zeros from position *pos. */
+static int plan_file_write(FILE *f, size_t *pos, const size_t off,
+  const void *p, const size_t size)
+{
+  static const char zeros[64] = {0};
 
-  TOC(0)
+  while (*pos < off)
+  {
+    const size_t l = MIN(off - *pos, sizeof(zeros));
+    if (fwrite(zeros, 1, l, f) != l)
+      return 0;
+    *pos += l;
+  }
 
-  TIC_FFTW(1)
-  FFTW(execute)(ths->my_fftw_plan1);
-  TOC_FFTW(1);
+  if (size > 0 && fwrite(p, 1, size, f) != size)
+    return 0;
+  *pos += size;
 
-  TIC(2);
-  nfft_trafo_3d_B(ths);
-  TOC(2);
+  return 1;
 }
 
-void X(adjoint_3d)(X(plan) *ths)
+const char* X(plan_save)(const X(plan) *ths, const char *filename)
 {
-  if((ths->N[0] <= ths->m) || (ths->N[1] <= ths->m) || (ths->N[2] <= ths->m) || (ths->n[0] <= 2*ths->m+2) || (ths->n[1] <= 2*ths->m+2) || (ths->n[2] <= 2*ths->m+2))
+  const unsigned char id[8] = {'N', 'F', 'F', 'T', PLAN_FILE_VERSION,
+    (unsigned char)sizeof(R), (unsigned char)sizeof(INT), 0};
+  INT header[PF_LEN];
+  size_t off[PF_SEC_END + 1], pos = 0;
+  char *wisdom;
+  FILE *f;
+  INT t;
+  int ok;
+
+#ifdef _OPENMP
+  #pragma omp critical (nfft_omp_critical_fftw_plan)
+#endif
+  wisdom = FFTW(export_wisdom_to_string)();
+
+  header[PF_D] = ths->d;
+  header[PF_M_TOTAL] = ths->M_total;
+  header[PF_M] = ths->m;
+  header[PF_K] = ths->K;
+  header[PF_HOWMANY] = ths->howmany;
+  header[PF_STRIDE] = ths->stride;
+  header[PF_F_HAT_DIST] = ths->f_hat_dist;
+  header[PF_F_DIST] = ths->f_dist;
+  header[PF_FLAGS] = (INT)ths->flags;
+  header[PF_FFTW_FLAGS] = (INT)ths->fftw_flags;
+  header[PF_WINDOW] = (INT)ths->window;
+  header[PF_WISDOM] = wisdom ? (INT)strlen(wisdom) : 0;
+
+  plan_file_layout(ths, header[PF_WISDOM], off);
+
+  f = fopen(filename, "wb");
+  if (!f)
   {
-    X(adjoint_direct)(ths);
-    return;
+    free(wisdom);
+    return "Cannot open plan file for writing.";
   }
-  
-  INT k0,k1,k2,n0,n1,n2,N0,N1,N2;
-  C *g_hat,*f_hat;
-  R *c_phi_inv01, *c_phi_inv02, *c_phi_inv11, *c_phi_inv12, *c_phi_inv21, *c_phi_inv22;
-  R ck01, ck02, ck11, ck12, ck21, ck22;
-  C *g_hat111,*f_hat111,*g_hat211,*f_hat211,*g_hat121,*f_hat121,*g_hat221,*f_hat221;
-  C *g_hat112,*f_hat112,*g_hat212,*f_hat212,*g_hat122,*f_hat122,*g_hat222,*f_hat222;
 
-  ths->g_hat=ths->g1;
-  ths->g=ths->g2;
+  ok = plan_file_write(f, &pos, 0, id, sizeof(id))
+    && plan_file_write(f, &pos, pos, header, sizeof(header))
+    && plan_file_write(f, &pos, pos, ths->N, (size_t)(ths->d) * sizeof(INT))
+    && plan_file_write(f, &pos, pos, ths->n, (size_t)(ths->d) * sizeof(INT))
+    && plan_file_write(f, &pos, off[PF_SEC_WISDOM], wisdom ? wisdom : "",
+      (size_t)(header[PF_WISDOM] + 1))
+    && plan_file_write(f, &pos, off[PF_SEC_X], ths->x,
+      (size_t)(ths->d * ths->M_total) * sizeof(R));
+
+  free(wisdom);
+
+  for (t = 0; ok && t < ths->d; t++)
+    ok = plan_file_write(f, &pos, t == 0 ? off[PF_SEC_PHI] : pos,
+      ths->c_phi_inv[t], (size_t)(ths->N[t]) * sizeof(R));
+
+  ok = ok
+    && plan_file_write(f, &pos, off[PF_SEC_PSI],
+      (ths->flags & NFFT_MIXED_PRECISION) ? (const void*)ths->psi_single
+      : (const void*)ths->psi, plan_psi_bytes(ths))
+    && plan_file_write(f, &pos, off[PF_SEC_PSI_F], ths->psi_index_f,
+      (ths->flags & PRE_FULL_PSI) ? (size_t)(ths->M_total) * sizeof(INT) : 0)
+    && plan_file_write(f, &pos, off[PF_SEC_PSI_G], ths->psi_index_g,
+      (ths->flags & PRE_FULL_PSI) ? (size_t)(nfft_full_psi_index_size(ths)) * sizeof(INT) : 0)
+    && plan_file_write(f, &pos, off[PF_SEC_INDEX_X], ths->index_x,
+      (ths->flags & NFFT_SORT_NODES) ? (size_t)(2 * ths->M_total) * sizeof(INT) : 0)
+    && plan_file_write(f, &pos, off[PF_SEC_END], NULL, 0);
+
+  if (fclose(f) != 0)
+    ok = 0;
+
+  return ok ? NULL : "Cannot write plan file.";
+}
 
-  N0=ths->N[0];
-  N1=ths->N[1];
-  N2=ths->N[2];
-  n0=ths->n[0];
-  n1=ths->n[1];
-  n2=ths->n[2];
+/** Maps the whole file into memory, read-only, or reads it into a buffer
+ * where mmap is not available. */
+static void *plan_file_map(const char *filename, size_t *size)
+{
+#ifdef NFFT_PLAN_MMAP
+  struct stat st;
+  void *map;
+  int fd = open(filename, O_RDONLY);
 
-  f_hat=(C*)ths->f_hat;
-  g_hat=(C*)ths->g_hat;
+  if (fd < 0)
+    return NULL;
 
-  TIC(2);
-  nfft_adjoint_3d_B(ths);
-  TOC(2);
+  if (fstat(fd, &st) != 0 || st.st_size <= 0)
+  {
+    close(fd);
+    return NULL;
+  }
 
-  TIC_FFTW(1)
-  FFTW(execute)(ths->my_fftw_plan2);
-  TOC_FFTW(1);
+  *size = (size_t)st.st_size;
+  map = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
 
-  TIC(0)
-  if(ths->flags & PRE_PHI_HUT)
-    {
-      c_phi_inv01=ths->c_phi_inv[0];
-      c_phi_inv02=&ths->c_phi_inv[0][N0/2];
+  return map == MAP_FAILED ? NULL : map;
+#else
+  void *map;
+  long l;
+  FILE *f = fopen(filename, "rb");
 
-#ifdef _OPENMP
-      #pragma omp parallel for default(shared) private(k0,k1,k2,ck01,ck02,c_phi_inv11,c_phi_inv12,ck11,ck12,c_phi_inv21,c_phi_inv22,g_hat111,f_hat111,g_hat211,f_hat211,g_hat121,f_hat121,g_hat221,f_hat221,g_hat112,f_hat112,g_hat212,f_hat212,g_hat122,f_hat122,g_hat222,f_hat222,ck21,ck22)
-#endif
-      for(k0=0;k0<N0/2;k0++)
+  if (!f)
+    return NULL;
+
+  if (fseek(f, 0, SEEK_END) != 0 || (l = ftell(f)) <= 0
+    || fseek(f, 0, SEEK_SET) != 0)
   {
-    ck01=c_phi_inv01[k0];
-    ck02=c_phi_inv02[k0];
-    c_phi_inv11=ths->c_phi_inv[1];
-    c_phi_inv12=&ths->c_phi_inv[1][N1/2];
+    fclose(f);
+    return NULL;
+  }
 
-    for(k1=0;k1<N1/2;k1++)
-      {
-        ck11=c_phi_inv11[k1];
-        ck12=c_phi_inv12[k1];
-        c_phi_inv21=ths->c_phi_inv[2];
-        c_phi_inv22=&ths->c_phi_inv[2][N2/2];
-
-        g_hat111=g_hat + ((n0-(N0/2)+k0)*n1+n1-(N1/2)+k1)*n2+n2-(N2/2);
-        f_hat111=f_hat + (k0*N1+k1)*N2;
-        g_hat211=g_hat + (k0*n1+n1-(N1/2)+k1)*n2+n2-(N2/2);
-        f_hat211=f_hat + (((N0/2)+k0)*N1+k1)*N2;
-        g_hat121=g_hat + ((n0-(N0/2)+k0)*n1+k1)*n2+n2-(N2/2);
-        f_hat121=f_hat + (k0*N1+(N1/2)+k1)*N2;
-        g_hat221=g_hat + (k0*n1+k1)*n2+n2-(N2/2);
-        f_hat221=f_hat + (((N0/2)+k0)*N1+(N1/2)+k1)*N2;
-
-        g_hat112=g_hat + ((n0-(N0/2)+k0)*n1+n1-(N1/2)+k1)*n2;
-        f_hat112=f_hat + (k0*N1+k1)*N2+(N2/2);
-        g_hat212=g_hat + (k0*n1+n1-(N1/2)+k1)*n2;
-        f_hat212=f_hat + (((N0/2)+k0)*N1+k1)*N2+(N2/2);
-        g_hat122=g_hat + ((n0-(N0/2)+k0)*n1+k1)*n2;
-        f_hat122=f_hat + (k0*N1+(N1/2)+k1)*N2+(N2/2);
-        g_hat222=g_hat + (k0*n1+k1)*n2;
-        f_hat222=f_hat + (((N0/2)+k0)*N1+(N1/2)+k1)*N2+(N2/2);
-
-        for(k2=0;k2<N2/2;k2++)
-    {
-      ck21=c_phi_inv21[k2];
-      ck22=c_phi_inv22[k2];
-
-      f_hat111[k2] = g_hat111[k2] * ck01 * ck11 * ck21;
-      f_hat211[k2] = g_hat211[k2] * ck02 * ck11 * ck21;
-      f_hat121[k2] = g_hat121[k2] * ck01 * ck12 * ck21;
-      f_hat221[k2] = g_hat221[k2] * ck02 * ck12 * ck21;
-
-      f_hat112[k2] = g_hat112[k2] * ck01 * ck11 * ck22;
-      f_hat212[k2] = g_hat212[k2] * ck02 * ck11 * ck22;
-      f_hat122[k2] = g_hat122[k2] * ck01 * ck12 * ck22;
-      f_hat222[k2] = g_hat222[k2] * ck02 * ck12 * ck22;
-    }
-      }
+  *size = (size_t)l;
+  map = Y(malloc)(*size);
+
+  if (fread(map, 1, *size, f) != *size)
+  {
+    Y(free)(map);
+    map = NULL;
   }
-    }
-  else
-#ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(k0,k1,k2,ck01,ck02,ck11,ck12,ck21,ck22)
+
+  fclose(f);
+  return map;
 #endif
-    for(k0=0;k0<N0/2;k0++)
-      {
-  ck01=K(1.0)/(PHI_HUT(ths->n[0],k0-N0/2,0));
-  ck02=K(1.0)/(PHI_HUT(ths->n[0],k0,0));
-  for(k1=0;k1<N1/2;k1++)
-    {
-      ck11=K(1.0)/(PHI_HUT(ths->n[1],k1-N1/2,1));
-      ck12=K(1.0)/(PHI_HUT(ths->n[1],k1,1));
+}
 
-      for(k2=0;k2<N2/2;k2++)
-        {
-    ck21=K(1.0)/(PHI_HUT(ths->n[2],k2-N2/2,2));
-    ck22=K(1.0)/(PHI_HUT(ths->n[2],k2,2));
-
-    f_hat[(k0*N1+k1)*N2+k2]                  = g_hat[((n0-N0/2+k0)*n1+n1-N1/2+k1)*n2+n2-N2/2+k2] * ck01 * ck11 * ck21;
-    f_hat[((N0/2+k0)*N1+k1)*N2+k2]           = g_hat[(k0*n1+n1-N1/2+k1)*n2+n2-N2/2+k2]           * ck02 * ck11 * ck21;
-    f_hat[(k0*N1+N1/2+k1)*N2+k2]             = g_hat[((n0-N0/2+k0)*n1+k1)*n2+n2-N2/2+k2]         * ck01 * ck12 * ck21;
-    f_hat[((N0/2+k0)*N1+N1/2+k1)*N2+k2]      = g_hat[(k0*n1+k1)*n2+n2-N2/2+k2]                   * ck02 * ck12 * ck21;
-
-    f_hat[(k0*N1+k1)*N2+N2/2+k2]             = g_hat[((n0-N0/2+k0)*n1+n1-N1/2+k1)*n2+k2]         * ck01 * ck11 * ck22;
-    f_hat[((N0/2+k0)*N1+k1)*N2+N2/2+k2]      = g_hat[(k0*n1+n1-N1/2+k1)*n2+k2]                   * ck02 * ck11 * ck22;
-    f_hat[(k0*N1+N1/2+k1)*N2+N2/2+k2]        = g_hat[((n0-N0/2+k0)*n1+k1)*n2+k2]                 * ck01 * ck12 * ck22;
-    f_hat[((N0/2+k0)*N1+N1/2+k1)*N2+N2/2+k2] = g_hat[(k0*n1+k1)*n2+k2]                           * ck02 * ck12 * ck22;
-        }
-    }
-      }
+static void plan_file_unmap(void *map, const size_t size)
+{
+#ifdef NFFT_PLAN_MMAP
+  munmap(map, size);
+#else
+  UNUSED(size);
+  Y(free)(map);
+#endif
+}
 
-  TOC(0)
+/** Whether p points into the plan file the plan was loaded from. */
+static int plan_file_contains(const X(plan) *ths, const void *p)
+{
+  const char *lo = (const char*)ths->map, *hi = lo + ths->map_size;
+
+  return ths->map && (const char*)p >= lo && (const char*)p < hi;
 }
 
-/** user routines
- */
-void X(trafo)(X(plan) *ths)
+/** Detaches the arrays pointing into the plan file before finalize frees the
+ * remaining ones. */
+static void plan_file_release(X(plan) *ths)
 {
-  /* use direct transform if degree N is too low */
-  for (int j = 0; j < ths->d; j++)
+  INT t;
+
+#define PLAN_FILE_DETACH(p) \
+  if (plan_file_contains(ths, p)) \
+    p = NULL;
+
+  PLAN_FILE_DETACH(ths->psi)
+  PLAN_FILE_DETACH(ths->psi_single)
+  PLAN_FILE_DETACH(ths->psi_index_f)
+  PLAN_FILE_DETACH(ths->psi_index_g)
+  PLAN_FILE_DETACH(ths->index_x)
+
+  for (t = 0; t < ths->d; t++)
+    PLAN_FILE_DETACH(ths->c_phi_inv[t])
+
+#undef PLAN_FILE_DETACH
+
+  if (ths->map_x)
   {
-    if((ths->N[j] <= ths->m) || (ths->n[j] <= 2*ths->m+2))
-    {
-      X(trafo_direct)(ths);
-      return;
-    }
+    plan_free(ths, ths->map_x);
+    ths->map_x = NULL;
   }
-  
-  switch(ths->d)
-  {
-    case 1: X(trafo_1d)(ths); break;
-    case 2: X(trafo_2d)(ths); break;
-    case 3: X(trafo_3d)(ths); break;
-    default:
-    {
-      /* use ths->my_fftw_plan1 */
-      ths->g_hat = ths->g1;
-      ths->g = ths->g2;
 
-      /** form \f$ \hat g_k = \frac{\hat f_k}{c_k\left(\phi\right)} \text{ for }
-       *  k \in I_N \f$
-       */
-      TIC(0)
-      D_A(ths);
-      TOC(0)
+  plan_file_unmap(ths->map, ths->map_size);
+  ths->map = NULL;
+  ths->map_size = 0;
+}
 
-      /** compute by d-variate discrete Fourier transform
-       *  \f$ g_l = \sum_{k \in I_N} \hat g_k {\rm e}^{-2\pi {\rm i} \frac{kl}{n}}
-       *  \text{ for } l \in I_n \f$
-       */
-      TIC_FFTW(1)
-      FFTW(execute)(ths->my_fftw_plan1);
-      TOC_FFTW(1)
+/** Copies the arrays of the precomputation of psi and of the sorting out of
+ * the read-only plan file, before they are computed again. */
+static void plan_file_own(X(plan) *ths)
+{
+  if (!ths->map)
+    return;
 
-      /** set \f$ f_j =\sum_{l \in I_n,m(x_j)} g_l \psi\left(x_j-\frac{l}{n}\right)
-       *  \text{ for } j=0,\dots,M_total-1 \f$
-       */
-      TIC(2)
-      B_A(ths);
-      TOC(2)
-    }
+#define PLAN_FILE_OWN(p, size) \
+  if (plan_file_contains(ths, p)) \
+  { \
+    void *q = malloc_first_touch(ths, size); \
+    memcpy(q, p, size); \
+    p = q; \
   }
-} /* nfft_trafo */
 
-void X(adjoint)(X(plan) *ths)
-{
-  /* use direct transform if degree N is too low */
-  for (int j = 0; j < ths->d; j++)
+  PLAN_FILE_OWN(ths->psi_single, plan_psi_bytes(ths))
+  PLAN_FILE_OWN(ths->psi, plan_psi_bytes(ths))
+
+  if (ths->flags & PRE_FULL_PSI)
   {
-    if((ths->N[j] <= ths->m) || (ths->n[j] <= 2*ths->m+2))
-    {
-      X(adjoint_direct)(ths);
-      return;
-    }
+    PLAN_FILE_OWN(ths->psi_index_f, (size_t)(ths->M_total) * sizeof(INT))
+    PLAN_FILE_OWN(ths->psi_index_g,
+      (size_t)(nfft_full_psi_index_size(ths)) * sizeof(INT))
   }
-  
-  switch(ths->d)
-  {
-    case 1: X(adjoint_1d)(ths); break;
-    case 2: X(adjoint_2d)(ths); break;
-    case 3: X(adjoint_3d)(ths); break;
-    default:
-    {
-      /* use ths->my_fftw_plan2 */
-      ths->g_hat=ths->g1;
-      ths->g=ths->g2;
-      
-      /** set \f$ g_l = \sum_{j=0}^{M_total-1} f_j \psi\left(x_j-\frac{l}{n}\right)
-       *  \text{ for } l \in I_n,m(x_j) \f$
-       */
-      TIC(2)
-      B_T(ths);
-      TOC(2)
 
-      /** compute by d-variate discrete Fourier transform
-       *  \f$ \hat g_k = \sum_{l \in I_n} g_l {\rm e}^{+2\pi {\rm i} \frac{kl}{n}}
-       *  \text{ for }  k \in I_N\f$
-       */
-      TIC_FFTW(1)
-      FFTW(execute)(ths->my_fftw_plan2);
-      TOC_FFTW(1)
+  if (ths->flags & NFFT_SORT_NODES)
+    PLAN_FILE_OWN(ths->index_x, sizeof(INT) * 2U * (size_t)(ths->M_total))
 
-      /** form \f$ \hat f_k = \frac{\hat g_k}{c_k\left(\phi\right)} \text{ for }
-       *  k \in I_N \f$
-       */
-      TIC(0)
-      D_T(ths);
-      TOC(0)
-    }
-  }
-} /* nfft_adjoint */
+#undef PLAN_FILE_OWN
+}
 
+/** a *= b, returns 0 if the product exceeds max. */
+static int plan_file_mul(size_t *a, const INT b, const size_t max)
+{
+  if (b < 0 || (b > 0 && *a > max / (size_t)b))
+    return 0;
 
-/** initialisation of direct transform
- */
-static void precompute_phi_hut(X(plan) *ths)
+  *a *= (size_t)b;
+  return 1;
+}
+
+/** Checks the identifier and the header of a plan file of size bytes and
+ * computes the offsets of its sections. Every array of a plan made from the
+ * header fits into the address space and every section into the file, and
+ * the indices in the sections, which the transforms use unchecked, are in
+ * range. */
+static const char *plan_file_check(const char *map, const size_t size,
+  size_t *off)
 {
-  INT ks[ths->d]; /* index over all frequencies */
-  INT t; /* index over all dimensions */
+  const size_t max = (size_t)(PTRDIFF_MAX) / sizeof(C);
+  const unsigned char *id = (const unsigned char*)map;
+  const INT *header = (const INT*)(map + 8);
+  const INT *N = header + PF_LEN, *n;
+  size_t N_total = 1, n_total = 1, g_total, w = 1, s;
+  X(plan) p;
+  INT t, d, j, lprod;
 
-  ths->c_phi_inv = (R**) Y(malloc)((size_t)(ths->d) * sizeof(R*));
+  if (size < 8 + sizeof(INT) * PF_LEN || memcmp(id, "NFFT", 4) != 0
+    || id[4] != PLAN_FILE_VERSION || id[5] != sizeof(R) || id[6] != sizeof(INT))
+    return "Invalid plan file, or written by another version or precision.";
 
-  for (t = 0; t < ths->d; t++)
+  d = header[PF_D];
+
+  if (d < 1 || (size_t)d > ((size - 8) / sizeof(INT) - PF_LEN) / 2)
+    return "Invalid plan file.";
+
+  n = N + d;
+
+  if (header[PF_M_TOTAL] < 0 || header[PF_M] < 0 || header[PF_K] < 0
+    || header[PF_HOWMANY] < 1 || header[PF_STRIDE] < 1
+    || header[PF_F_HAT_DIST] < 0 || header[PF_F_DIST] < 0
+    || header[PF_WISDOM] < 0
+    || ((unsigned)header[PF_WINDOW] & ~NFFT_WINDOW_MASK) != 0U
+    || (unsigned)header[PF_WINDOW] > NFFT_WINDOW_EXP_SEMICIRCLE)
+    return "Invalid plan file.";
+
+  /* N_total, n_total and the width (2m+2)^d of the window */
+  if (header[PF_M] > (INT)(max / 4))
+    return "Invalid plan file.";
+
+  for (t = 0; t < d; t++)
+  {
+    if (N[t] < 2 || N[t] % 2 != 0 || n[t] < N[t]
+      || !plan_file_mul(&N_total, N[t], max)
+      || !plan_file_mul(&n_total, n[t], max)
+      || !plan_file_mul(&w, 2 * header[PF_M] + 2, max))
+      return "Invalid plan file.";
+  }
+
+  g_total = n_total;
+
+  /* the oversampled vectors and f_hat of all batches */
+  if (!plan_file_mul(&n_total, header[PF_HOWMANY], max)
+    || !plan_file_mul(&N_total, header[PF_STRIDE], max)
+    || (size_t)(header[PF_HOWMANY]) > max / (size_t)(header[PF_F_HAT_DIST] + 1)
+    || N_total + (size_t)(header[PF_HOWMANY] * header[PF_F_HAT_DIST]) > max)
+    return "Invalid plan file.";
+
+  /* the nodes x are part of the file, f of all batches and the window
+   * values of all nodes */
+  s = (size_t)(header[PF_M_TOTAL]);
+  if (s > size / ((size_t)(d) * sizeof(R))
+    || ((header[PF_FLAGS] & PRE_LIN_PSI)
+      && (size_t)(header[PF_K]) >= size / ((size_t)(d) * sizeof(R)))
+    || !plan_file_mul(&s, header[PF_STRIDE], max)
+    || (size_t)(header[PF_HOWMANY]) > max / (size_t)(header[PF_F_DIST] + 1)
+    || s + (size_t)(header[PF_HOWMANY] * header[PF_F_DIST]) > max
+    || !plan_file_mul(&w, header[PF_M_TOTAL] + 1, max / sizeof(INT))
+    || (size_t)(header[PF_WISDOM]) >= size)
+    return "Invalid plan file.";
+
+  memset(&p, 0, sizeof(p));
+  p.d = d;
+  p.M_total = header[PF_M_TOTAL];
+  p.m = header[PF_M];
+  p.K = header[PF_K];
+  p.flags = (unsigned)header[PF_FLAGS];
+  p.N = (INT*)N;
+
+  plan_file_layout(&p, header[PF_WISDOM], off);
+
+  if (size < off[PF_SEC_END])
+    return "Truncated plan file.";
+
+  if (map[off[PF_SEC_WISDOM] + (size_t)(header[PF_WISDOM])] != '\0')
+    return "Invalid plan file.";
+
+  if (p.flags & PRE_FULL_PSI)
   {
-    ths->c_phi_inv[t] = (R*)Y(malloc)((size_t)(ths->N[t]) * sizeof(R));
+    const INT *psi_index_f = (const INT*)(map + off[PF_SEC_PSI_F]);
+    const INT *psi_index_g = (const INT*)(map + off[PF_SEC_PSI_G]);
 
-    for (ks[t] = 0; ks[t] < ths->N[t]; ks[t]++)
+    for (t = 0, lprod = 1; t < d; t++)
+      lprod *= 2 * p.m + 2;
+
+    for (j = 0; j < p.M_total; j++)
     {
-      ths->c_phi_inv[t][ks[t]]= K(1.0) / (PHI_HUT(ths->n[t], ks[t] - ths->N[t] / 2,t));
+      if (psi_index_f[j] != lprod)
+        return "Invalid plan file.";
+    }
+
+    /* the first grid index of each node in each dimension, or all of them */
+    if (p.flags & NFFT_COMPACT_FULL_PSI)
+    {
+      for (j = 0; j < p.M_total * d; j++)
+      {
+        if (psi_index_g[j] < 0 || psi_index_g[j] >= n[j % d])
+          return "Invalid plan file.";
+      }
+    }
+    else
+    {
+      for (j = 0; j < p.M_total * lprod; j++)
+      {
+        if (psi_index_g[j] < 0 || (size_t)(psi_index_g[j]) >= g_total)
+          return "Invalid plan file.";
+      }
     }
   }
-} /* nfft_phi_hut */
 
-/** create a lookup table, but NOT for each node
- *  good idea K=2^xx
- *  assumes an EVEN window function
- */
-void X(precompute_lin_psi)(X(plan) *ths)
-{
-  INT t;                                /**< index over all dimensions       */
-  INT j;                                /**< index over all nodes            */
-  R step;                          /**< step size in [0,(m+2)/n]        */
+  if (p.flags & NFFT_SORT_NODES)
+  {
+    const INT *index_x = (const INT*)(map + off[PF_SEC_INDEX_X]);
 
-  for (t=0; t<ths->d; t++)
+    for (j = 0; j < p.M_total; j++)
     {
-      step = ((R)(ths->m+2)) / ((R)(ths->K * ths->n[t]));
-      for(j = 0;j <= ths->K; j++)
-  {
-    ths->psi[(ths->K+1)*t + j] = PHI(ths->n[t], (R)(j) * step,t);
-  } /* for(j) */
-    } /* for(t) */
+      if (index_x[2 * j + 1] < 0 || index_x[2 * j + 1] >= p.M_total)
+        return "Invalid plan file.";
+    }
+  }
+
+  return NULL;
 }
 
-void X(precompute_fg_psi)(X(plan) *ths)
+/** Points the node dependent arrays into the plan file. The nodes x are
+ * always copied, such that they stay writable, the copy is kept in map_x
+ * without MALLOC_X. */
+static void plan_file_attach(X(plan) *ths, const size_t *off)
 {
-  INT t;                                /**< index over all dimensions       */
-  INT u, o;                             /**< depends on x_j                  */
+  const size_t size = (size_t)(ths->d * ths->M_total) * sizeof(R);
+  char *map = (char*)ths->map;
+  INT t;
 
-  sort(ths);
+  ths->x = (R*)malloc_first_touch(ths, size);
+  memcpy(ths->x, map + off[PF_SEC_X], size);
 
-  for (t=0; t<ths->d; t++)
-  {
-    INT j;
-#ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(j,u,o)
-#endif
-    for (j = 0; j < ths->M_total; j++)
-      {
-  uo(ths,j,&u,&o,t);
+  if (!(ths->flags & MALLOC_X))
+    ths->map_x = ths->x;
+
+  R *c_phi_inv = (R*)(map + off[PF_SEC_PHI]);
 
-        ths->psi[2*(j*ths->d+t)]=
-            (PHI(ths->n[t] ,(ths->x[j*ths->d+t] - ((R)u) / (R)(ths->n[t])),t));
+  ths->c_phi_inv = (R**) plan_malloc(ths, (size_t)(ths->d) * sizeof(R*));
 
-        ths->psi[2*(j*ths->d+t)+1]=
-            EXP(K(2.0) * ((R)(ths->n[t]) * ths->x[j*ths->d+t] - (R)(u)) / ths->b[t]);
-      } /* for(j) */
+  for (t = 0; t < ths->d; t++)
+  {
+    ths->c_phi_inv[t] = c_phi_inv;
+    c_phi_inv += ths->N[t];
   }
-  /* for(t) */
-} /* nfft_precompute_fg_psi */
 
-void X(precompute_psi)(X(plan) *ths)
-{
-  INT t; /* index over all dimensions */
-  INT l; /* index u<=l<=o */
-  INT lj; /* index 0<=lj<u+o+1 */
-  INT u, o; /* depends on x_j */
+  ths->psi = NULL;
+  ths->psi_single = NULL;
 
-  sort(ths);
+  if (ths->flags & NFFT_MIXED_PRECISION)
+    ths->psi_single = (float*)(map + off[PF_SEC_PSI]);
+  else if (plan_psi_size(ths) > 0)
+    ths->psi = (R*)(map + off[PF_SEC_PSI]);
 
-  for (t=0; t<ths->d; t++)
+  if (ths->flags & PRE_FULL_PSI)
   {
-    INT j;
-#ifdef _OPENMP
-    #pragma omp parallel for default(shared) private(j,l,lj,u,o)
-#endif
-    for (j = 0; j < ths->M_total; j++)
-    {
-      uo(ths,j,&u,&o,t);
-
-      for(l = u, lj = 0; l <= o; l++, lj++)
-        ths->psi[(j * ths->d + t) * (2 * ths->m + 2) + lj] =
-            (PHI(ths->n[t], (ths->x[j*ths->d+t] - ((R)l) / (R)(ths->n[t])), t));
-    } /* for(j) */
+    ths->psi_index_f = (INT*)(map + off[PF_SEC_PSI_F]);
+    ths->psi_index_g = (INT*)(map + off[PF_SEC_PSI_G]);
   }
-  /* for(t) */
-} /* nfft_precompute_psi */
-
-#ifdef _OPENMP
-static void nfft_precompute_full_psi_omp(X(plan) *ths)
-{
-  INT j;                                /**< index over all nodes            */
-  INT lprod;                            /**< 'bandwidth' of matrix B         */
 
+  if (ths->flags & NFFT_SORT_NODES)
   {
-    INT t;
-    for(t=0,lprod = 1; t<ths->d; t++)
-        lprod *= 2*ths->m+2;
+    ths->index_x = (INT*)(map + off[PF_SEC_INDEX_X]);
+    ths->index_x_sorted = (ths->flags & (PRE_PSI | PRE_FG_PSI | PRE_FULL_PSI))
+      ? 1 : 0;
   }
+}
 
-  #pragma omp parallel for default(shared) private(j)
-  for(j=0; j<ths->M_total; j++)
-    {
-      INT t,t2;                             /**< index over all dimensions       */
-      INT l_L;                              /**< plain index 0<=l_L<lprod        */
-      INT lj[ths->d];                       /**< multi index 0<=lj<u+o+1         */
-      INT ll_plain[ths->d+1];               /**< postfix plain index             */
+const char* X(plan_load)(X(plan) *ths, const char *filename)
+{
+  size_t size, off[PF_SEC_END + 1];
+  const INT *header;
+  const char *err;
+  char *map;
+  INT t;
 
-      INT u[ths->d], o[ths->d];             /**< depends on x_j                  */
+  map = (char*) plan_file_map(filename, &size);
 
-      R phi_prod[ths->d+1];
-      INT ix = j*lprod;
+  if (!map)
+    return "Cannot read plan file.";
 
-      phi_prod[0]=1;
-      ll_plain[0]=0;
+  err = plan_file_check(map, size, off);
 
-      MACRO_init_uo_l_lj_t;
+  if (err)
+  {
+    plan_file_unmap(map, size);
+    return err;
+  }
 
-      for(l_L=0; l_L<lprod; l_L++, ix++)
-      {
-        MACRO_update_phi_prod_ll_plain(without_PRE_PSI);
+  header = (const INT*)(map + 8);
 
-        ths->psi_index_g[ix]=ll_plain[ths->d];
-        ths->psi[ix]=phi_prod[ths->d];
+  ths->d = header[PF_D];
+  ths->M_total = header[PF_M_TOTAL];
+  ths->m = header[PF_M];
+  ths->K = header[PF_K];
+  ths->howmany = header[PF_HOWMANY];
+  ths->stride = header[PF_STRIDE];
+  ths->f_hat_dist = header[PF_F_HAT_DIST];
+  ths->f_dist = header[PF_F_DIST];
+  ths->flags = (unsigned)header[PF_FLAGS] | (unsigned)header[PF_WINDOW];
+  ths->fftw_flags = (unsigned)header[PF_FFTW_FLAGS];
 
-        MACRO_count_uo_l_lj_t;
-      } /* for(l_L) */
+  arena_init(ths, NULL, 0);
+  ths->N = (INT*)Y(malloc)((size_t)(ths->d) * sizeof(INT));
+  ths->n = (INT*)Y(malloc)((size_t)(ths->d) * sizeof(INT));
 
-      ths->psi_index_f[j]=lprod;
-    } /* for(j) */
-}
-#endif
+  for (t = 0; t < ths->d; t++)
+  {
+    ths->N[t] = header[PF_LEN + t];
+    ths->n[t] = header[PF_LEN + ths->d + t];
+  }
 
-void X(precompute_full_psi)(X(plan) *ths)
-{
+  /* FFTW plans are created from the wisdom of the file */
 #ifdef _OPENMP
-  sort(ths);
+  #pragma omp critical (nfft_omp_critical_fftw_plan)
+#endif
+  FFTW(import_wisdom_from_string)(map + off[PF_SEC_WISDOM]);
 
-  nfft_precompute_full_psi_omp(ths);
-#else
-  INT t, t2; /* index over all dimensions */
-  INT j; /* index over all nodes */
-  INT l_L; /* plain index 0 <= l_L < lprod */
-  INT lj[ths->d]; /* multi index 0<=lj<u+o+1 */
-  INT ll_plain[ths->d+1]; /* postfix plain index */
-  INT lprod; /* 'bandwidth' of matrix B */
-  INT u[ths->d], o[ths->d]; /* depends on x_j */
+  /* node dependent data are used in place */
+  init_help_plan(ths);
 
-  R phi_prod[ths->d+1];
+  ths->map = map;
+  ths->map_size = size;
 
-  INT ix, ix_old;
+  plan_file_attach(ths, off);
 
-  sort(ths);
+  return NULL;
+}
 
-  phi_prod[0] = K(1.0);
-  ll_plain[0] = 0;
+/* Planner. nfft_init_sigma and nfft_init_tuned choose 7-smooth FFT lengths n
+ * and the cut-off m for a target accuracy, nfft_init_tuned with
+ * NFFT_TUNE_MEASURE also the precomputation and sorting flags by timing the
+ * transforms on the given nodes. Measured choices are kept as tuning records,
+ * which can be exported and imported like FFTW wisdom. */
 
-  for (t = 0, lprod = 1; t < ths->d; t++)
-    lprod *= 2 * ths->m + 2;
+#define TUNE_M_MAX 32
+#define TUNE_FLAGS (PRE_PHI_HUT | MALLOC_X | MALLOC_F | MALLOC_F_HAT \
+  | FFTW_INIT | FFT_OUT_OF_PLACE)
 
-  for (j = 0, ix = 0, ix_old = 0; j < ths->M_total; j++)
-  {
-    MACRO_init_uo_l_lj_t;
+/* memory limits of the candidates PRE_FULL_PSI and PRE_LIN_PSI in bytes */
+#define TUNE_FULL_PSI_MAX ((size_t)1 << 28)
+#define TUNE_LIN_PSI_MAX ((size_t)1 << 24)
 
-    for (l_L = 0; l_L < lprod; l_L++, ix++)
-    {
-      MACRO_update_phi_prod_ll_plain(without_PRE_PSI);
+/* oversampling factors of the candidate FFT lengths */
+static const R tune_sigma[] = {K(1.25), K(1.5), K(2.0)};
+#define TUNE_SIGMA_COUNT ((int)(sizeof(tune_sigma) / sizeof(tune_sigma[0])))
 
-      ths->psi_index_g[ix] = ll_plain[ths->d];
-      ths->psi[ix] = phi_prod[ths->d];
+typedef struct tune_record_s
+{
+  /* key */
+  INT d, M_total, nthreads;
+  unsigned window;
+  double eps;
+  INT *N;
+  /* choice */
+  INT m;
+  unsigned flags;
+  INT *n;
+  struct tune_record_s *next;
+} tune_record;
+
+static tune_record *tune_records = NULL;
+
+static tune_record *tune_record_new(const INT d)
+{
+  tune_record *r = (tune_record*) Y(malloc)(sizeof(tune_record));
 
-      MACRO_count_uo_l_lj_t;
-    } /* for(l_L) */
+  r->d = d;
+  r->N = (INT*) Y(malloc)((size_t)(2 * d) * sizeof(INT));
+  r->n = r->N + d;
+  r->next = NULL;
 
-    ths->psi_index_f[j] = ix - ix_old;
-    ix_old = ix;
-  } /* for(j) */
-#endif
+  return r;
 }
 
-void X(precompute_one_psi)(X(plan) *ths)
+static void tune_record_free(tune_record *r)
 {
-  if(ths->flags & PRE_LIN_PSI)
-    X(precompute_lin_psi)(ths);
-  if(ths->flags & PRE_FG_PSI)
-    X(precompute_fg_psi)(ths);
-  if(ths->flags & PRE_PSI)
-    X(precompute_psi)(ths);
-  if(ths->flags & PRE_FULL_PSI)
-    X(precompute_full_psi)(ths);
+  Y(free)(r->N);
+  Y(free)(r);
 }
 
-static void init_help(X(plan) *ths)
+static int tune_record_matches(const tune_record *r, const INT d,
+  const INT *N, const INT M_total, const INT nthreads, const unsigned window,
+  const double eps)
 {
-  INT t; /* index over all dimensions */
-  INT lprod; /* 'bandwidth' of matrix B */
+  INT t;
 
-  if (ths->flags & NFFT_OMP_BLOCKWISE_ADJOINT)
-    ths->flags |= NFFT_SORT_NODES;
+  if (r->d != d || r->M_total != M_total || r->nthreads != nthreads
+    || r->window != window || r->eps != eps)
+    return 0;
 
-  ths->N_total = intprod(ths->N, 0, ths->d);
-  ths->n_total = intprod(ths->n, 0, ths->d);
+  for (t = 0; t < d; t++)
+    if (r->N[t] != N[t])
+      return 0;
 
-  ths->sigma = (R*) Y(malloc)((size_t)(ths->d) * sizeof(R));
+  return 1;
+}
 
-  for(t = 0;t < ths->d; t++)
-    ths->sigma[t] = ((R)ths->n[t]) / (R)(ths->N[t]);
+/** Adds the record r, replacing one with the same key. Call in the critical
+ *  section nfft_omp_critical_tuning. */
+static void tune_record_add(tune_record *r)
+{
+  tune_record **q = &tune_records;
+
+  while (*q)
+  {
+    if (tune_record_matches(*q, r->d, r->N, r->M_total, r->nthreads, r->window,
+      r->eps))
+    {
+      tune_record *old = *q;
+      *q = old->next;
+      tune_record_free(old);
+    }
+    else
+      q = &(*q)->next;
+  }
+
+  r->next = tune_records;
+  tune_records = r;
+}
+
+/** Smallest cut-off m such that d times the window error at the smallest
+ *  oversampling factor is at most eps, 0 if there is none. */
+static INT tune_m(const int d, const int *N, const int *n, const R eps,
+  const unsigned window)
+{
+  R sigma = (R)(n[0]) / (R)(N[0]);
+  INT t, m;
 
-  WINDOW_HELP_INIT;
+  for (t = 1; t < d; t++)
+    sigma = MIN(sigma, (R)(n[t]) / (R)(N[t]));
 
-  if(ths->flags & MALLOC_X)
-    ths->x = (R*)Y(malloc)((size_t)(ths->d * ths->M_total) * sizeof(R));
+  for (m = 1; m <= TUNE_M_MAX; m++)
+    if ((R)(d) * Y(window_error)(m, sigma, window) <= eps)
+      return m;
 
-  if(ths->flags & MALLOC_F_HAT)
-    ths->f_hat = (C*)Y(malloc)((size_t)(ths->N_total) * sizeof(C));
+  return 0;
+}
 
-  if(ths->flags & MALLOC_F)
-    ths->f = (C*)Y(malloc)((size_t)(ths->M_total) * sizeof(C));
+/** FFT lengths n > N for an oversampling factor of at least sigma and the
+ *  smallest cut-off m reaching eps with them, 0 if there is none. */
+static int tune_nm(const int d, const int *N, const R sigma, const R eps,
+  const unsigned window, int *n)
+{
+  INT t;
 
-  if(ths->flags & PRE_PHI_HUT)
-    precompute_phi_hut(ths);
+  for (t = 0; t < d; t++)
+    n[t] = (int)Y(next_fft_size)(MAX((INT)CEIL(sigma * (R)(N[t])),
+      (INT)(N[t]) + 1));
 
-  if (ths->flags & PRE_LIN_PSI)
-  {
-      if (ths->K == 0)
-      {
-        ths->K = Y(m2K)(ths->m);
-      }
-      ths->psi = (R*) Y(malloc)((size_t)((ths->K+1) * ths->d) * sizeof(R));
-  }
+  return (int)tune_m(d, N, n, eps, window);
+}
 
-  if(ths->flags & PRE_FG_PSI)
-    ths->psi = (R*) Y(malloc)((size_t)(ths->M_total * ths->d * 2) * sizeof(R));
+/** Cut-off m for n if no m reaches the target accuracy, the one with the
+ *  smallest error estimate. */
+static int tune_m_fallback(const int d, const int *N, const int *n,
+  const unsigned window)
+{
+  R sigma = (R)(n[0]) / (R)(N[0]), err, best_err = K(0.0);
+  INT t, m, best_m = 1;
 
-  if(ths->flags & PRE_PSI)
-    ths->psi = (R*) Y(malloc)((size_t)(ths->M_total * ths->d * (2 * ths->m + 2)) * sizeof(R));
+  for (t = 1; t < d; t++)
+    sigma = MIN(sigma, (R)(n[t]) / (R)(N[t]));
 
-  if(ths->flags & PRE_FULL_PSI)
+  for (m = 1; m <= TUNE_M_MAX; m++)
   {
-      for (t = 0, lprod = 1; t < ths->d; t++)
-        lprod *= 2 * ths->m + 2;
-
-      ths->psi = (R*) Y(malloc)((size_t)(ths->M_total * lprod) * sizeof(R));
+    err = Y(window_error)(m, sigma, window);
 
-      ths->psi_index_f = (INT*) Y(malloc)((size_t)(ths->M_total) * sizeof(INT));
-      ths->psi_index_g = (INT*) Y(malloc)((size_t)(ths->M_total * lprod) * sizeof(INT));
+    if (m == 1 || err < best_err)
+    {
+      best_m = m;
+      best_err = err;
+    }
   }
 
-  if(ths->flags & FFTW_INIT)
+  return (int)best_m;
+}
+
+/** The flags of nfft_init. */
+static unsigned tune_flags(const int d)
+{
+  unsigned flags = TUNE_FLAGS | PRE_PSI;
+
+  if (d > 1)
   {
+    flags |= NFFT_SORT_NODES;
 #ifdef _OPENMP
-    INT nthreads = Y(get_num_threads)();
+    flags |= NFFT_OMP_BLOCKWISE_ADJOINT;
 #endif
+  }
 
-    ths->g1 = (C*)Y(malloc)((size_t)(ths->n_total) * sizeof(C));
-
-    if(ths->flags & FFT_OUT_OF_PLACE)
-      ths->g2 = (C*) Y(malloc)((size_t)(ths->n_total) * sizeof(C));
-    else
-      ths->g2 = ths->g1;
+  return flags;
+}
 
-#ifdef _OPENMP
-#pragma omp critical (nfft_omp_critical_fftw_plan)
+/** Model of the cost of a transform, the B step against the FFT. */
+static R tune_cost(const int d, const int *n, const INT M_total, const INT m)
 {
-    FFTW(plan_with_nthreads)(nthreads);
-#endif
-    {
-      int *_n = Y(malloc)((size_t)(ths->d) * sizeof(int));
+  R n_total = K(1.0), lprod = K(1.0);
+  INT t;
 
-      for (t = 0; t < ths->d; t++)
-        _n[t] = (int)(ths->n[t]);
+  for (t = 0; t < d; t++)
+  {
+    n_total *= (R)(n[t]);
+    lprod *= (R)(2 * m + 2);
+  }
 
-      ths->my_fftw_plan1 = FFTW(plan_dft)((int)ths->d, _n, ths->g1, ths->g2, FFTW_FORWARD, ths->fftw_flags);
-      ths->my_fftw_plan2 = FFTW(plan_dft)((int)ths->d, _n, ths->g2, ths->g1, FFTW_BACKWARD, ths->fftw_flags);
-      Y(free)(_n);
-    }
-#ifdef _OPENMP
+  return (R)(M_total) * lprod + n_total * (R)(Y(log2i)((INT)n_total) + 1);
 }
-#endif
-  }
 
-  if(ths->flags & NFFT_SORT_NODES)
-    ths->index_x = (INT*) Y(malloc)(sizeof(INT) * 2U * (size_t)(ths->M_total));
-  else
-    ths->index_x = NULL;
+/** Ticks of one trafo and one adjoint of the candidate after a warm-up run. */
+static double tune_time(const int d, int *N, const int M_total, int *n,
+  const int m, const unsigned flags, const R *x)
+{
+  X(plan) p;
+  ticks t0, t1;
+  INT j;
 
-  ths->mv_trafo = (void (*) (void* ))X(trafo);
-  ths->mv_adjoint = (void (*) (void* ))X(adjoint);
+  X(init_guru)(&p, d, N, M_total, n, m, flags, FFTW_ESTIMATE | FFTW_DESTROY_INPUT);
+
+  memcpy(p.x, x, (size_t)(d * M_total) * sizeof(R));
+  X(precompute_one_psi)(&p);
+
+  for (j = 0; j < p.N_total; j++)
+    p.f_hat[j] = K(0.0);
+
+  X(trafo)(&p);
+  X(adjoint)(&p);
+
+  t0 = getticks();
+  X(trafo)(&p);
+  X(adjoint)(&p);
+  t1 = getticks();
+
+  X(finalize)(&p);
+
+  return elapsed(t1, t0);
 }
 
-void X(init)(X(plan) *ths, int d, int *N, int M_total)
+void X(init_sigma)(X(plan) *ths, int d, int *N, int M_total, R sigma)
 {
-  INT t; /* index over all dimensions */
+  /* the accuracy of nfft_init, which oversamples by at least 2 */
+  const R eps = (R)(d) * Y(window_error)(WINDOW_HELP_ESTIMATE_m, K(2.0),
+    WINDOW_DEFAULT);
+  int n[d], m, t;
 
-  ths->d = (INT)d;
+  /* without oversampling the window cannot be deconvolved */
+  if (!(sigma > K(1.0)))
+    sigma = tune_sigma[0];
 
-  ths->N = (INT*) Y(malloc)((size_t)(d) * sizeof(INT));
+  m = tune_nm(d, N, sigma, eps, WINDOW_DEFAULT, n);
+
+  if (!m)
+    m = tune_m_fallback(d, N, n, WINDOW_DEFAULT);
 
   for (t = 0; t < d; t++)
-    ths->N[t] = (INT)N[t];
+    CK(n[t] > N[t]);
 
-  ths->M_total = (INT)M_total;
+  X(init_guru)(ths, d, N, M_total, n, m, tune_flags(d),
+    FFTW_ESTIMATE | FFTW_DESTROY_INPUT);
+}
 
-  ths->n = (INT*) Y(malloc)((size_t)(d) * sizeof(INT));
+void X(init_tuned)(X(plan) *ths, int d, int *N, int M_total, const R *x,
+  R eps, unsigned flags)
+{
+  const unsigned window = (flags & NFFT_WINDOW_MASK) ? (flags & NFFT_WINDOW_MASK)
+    : WINDOW_DEFAULT;
+  const INT nthreads = Y(get_num_threads)();
+  INT N1[d];
+  int n[TUNE_SIGMA_COUNT][d], m[TUNE_SIGMA_COUNT];
+  int best_n[d], best_m = 0;
+  unsigned best_flags, fftw_flags = FFTW_ESTIMATE | FFTW_DESTROY_INPUT;
+  R best_cost = K(0.0);
+  int found = 0, i, t;
 
   for (t = 0; t < d; t++)
-    ths->n[t] = 2 * (Y(next_power_of_2)(ths->N[t]));
+    N1[t] = (INT)N[t];
 
-  ths->m = WINDOW_HELP_ESTIMATE_m;
-
-  if (d > 1)
-  {
 #ifdef _OPENMP
-    ths->flags = PRE_PHI_HUT | PRE_PSI | MALLOC_X| MALLOC_F_HAT | MALLOC_F |
-                      FFTW_INIT | FFT_OUT_OF_PLACE | NFFT_SORT_NODES |
-                 NFFT_OMP_BLOCKWISE_ADJOINT;
-#else
-    ths->flags = PRE_PHI_HUT | PRE_PSI | MALLOC_X| MALLOC_F_HAT | MALLOC_F |
-                      FFTW_INIT | FFT_OUT_OF_PLACE | NFFT_SORT_NODES;
+  #pragma omp critical (nfft_omp_critical_tuning)
 #endif
+  {
+    const tune_record *r;
+
+    for (r = tune_records; r && !found; r = r->next)
+    {
+      if (tune_record_matches(r, d, N1, M_total, nthreads, window, (double)eps))
+      {
+        for (t = 0; t < d; t++)
+          best_n[t] = (int)r->n[t];
+        best_m = (int)r->m;
+        best_flags = r->flags;
+        found = 1;
+      }
+    }
   }
-  else
-    ths->flags = PRE_PHI_HUT | PRE_PSI | MALLOC_X| MALLOC_F_HAT | MALLOC_F |
-                      FFTW_INIT | FFT_OUT_OF_PLACE;
 
-  ths->fftw_flags= FFTW_ESTIMATE| FFTW_DESTROY_INPUT;
+  if (!found)
+  {
+    /* the cheapest lengths and cut-off reaching eps, by the model */
+    for (i = 0; i < TUNE_SIGMA_COUNT; i++)
+    {
+      m[i] = tune_nm(d, N, tune_sigma[i], eps, window, n[i]);
 
-  ths->K = 0;
-  init_help(ths);
-}
+      if (m[i] > 0 && (!best_m || tune_cost(d, n[i], M_total, m[i]) < best_cost))
+      {
+        for (t = 0; t < d; t++)
+          best_n[t] = n[i][t];
+        best_m = m[i];
+        best_cost = tune_cost(d, n[i], M_total, m[i]);
+      }
+    }
 
-void X(init_guru)(X(plan) *ths, int d, int *N, int M_total, int *n, int m,
-  unsigned flags, unsigned fftw_flags)
-{
-  INT t; /* index over all dimensions */
+    /* eps out of reach, the most accurate choice */
+    if (!best_m)
+    {
+      i = TUNE_SIGMA_COUNT - 1;
+      for (t = 0; t < d; t++)
+        best_n[t] = n[i][t];
+      best_m = m[i] = tune_m_fallback(d, N, n[i], window);
+    }
 
-  ths->d = (INT)d;
-  ths->M_total = (INT)M_total;
-  ths->N = (INT*)Y(malloc)((size_t)(ths->d) * sizeof(INT));
+    best_flags = tune_flags(d) | window;
 
-  for (t = 0; t < d; t++)
-    ths->N[t] = (INT)N[t];
+    if ((flags & NFFT_TUNE_MEASURE) && x)
+    {
+      static const unsigned psi[] = {PRE_PSI, PRE_FULL_PSI, PRE_LIN_PSI};
+      static const unsigned sort[] = {0U, NFFT_SORT_NODES,
+        NFFT_SORT_NODES | NFFT_OMP_BLOCKWISE_ADJOINT};
+      double best_time = -1.0;
+      int k, l;
 
-  ths->n = (INT*)Y(malloc)((size_t)(ths->d) * sizeof(INT));
+      for (i = 0; i < TUNE_SIGMA_COUNT; i++)
+      {
+        R lprod = K(1.0);
+        int j;
 
-  for (t = 0; t < d; t++)
-    ths->n[t] = (INT)n[t];
+        /* factors rounding to the same lengths */
+        for (j = 0; j < i && memcmp(n[j], n[i], sizeof(n[i])) != 0; j++) ;
 
-  ths->m = (INT)m;
+        if (m[i] <= 0 || j < i)
+          continue;
 
-  ths->flags = flags;
-  ths->fftw_flags = fftw_flags;
+        for (t = 0; t < d; t++)
+          lprod *= (R)(2 * m[i] + 2);
 
-  ths->K = 0;
-  init_help(ths);
-}
+        for (k = 0; k < (int)(sizeof(psi) / sizeof(psi[0])); k++)
+        {
+          if (psi[k] == PRE_FULL_PSI && (R)(M_total) * lprod
+            * (R)(sizeof(R) + sizeof(INT)) > (R)(TUNE_FULL_PSI_MAX))
+            continue;
 
-void X(init_lin)(X(plan) *ths, int d, int *N, int M_total, int *n, int m, int K,
-  unsigned flags, unsigned fftw_flags)
-{
-  INT t; /* index over all dimensions */
+          if (psi[k] == PRE_LIN_PSI && (size_t)(Y(m2K)(m[i], window) + 1)
+            * (size_t)(d) * sizeof(R) > TUNE_LIN_PSI_MAX)
+            continue;
 
-  ths->d = (INT)d;
-  ths->M_total = (INT)M_total;
-  ths->N = (INT*)Y(malloc)((size_t)(ths->d) * sizeof(INT));
+          for (l = 0; l < (int)(sizeof(sort) / sizeof(sort[0])); l++)
+          {
+            const unsigned f = TUNE_FLAGS | window | psi[k] | sort[l];
+            double time;
 
-  for (t = 0; t < d; t++)
-    ths->N[t] = (INT)N[t];
+#ifdef _OPENMP
+            if ((sort[l] & NFFT_OMP_BLOCKWISE_ADJOINT) && (d < 2 || nthreads < 2))
+              continue;
+#else
+            if (sort[l] & NFFT_OMP_BLOCKWISE_ADJOINT)
+              continue;
+#endif
 
-  ths->n = (INT*)Y(malloc)((size_t)(ths->d) * sizeof(INT));
+            time = tune_time(d, N, M_total, n[i], m[i], f, x);
 
-  for (t = 0; t < d; t++)
-    ths->n[t] = (INT)n[t];
+            if (best_time < 0.0 || time < best_time)
+            {
+              for (t = 0; t < d; t++)
+                best_n[t] = n[i][t];
+              best_m = m[i];
+              best_flags = f;
+              best_time = time;
+            }
+          }
+        }
+      }
 
-  ths->m = (INT)m;
+#ifdef _OPENMP
+      #pragma omp critical (nfft_omp_critical_tuning)
+#endif
+      {
+        tune_record *r = tune_record_new(d);
 
-  ths->flags = flags;
-  ths->fftw_flags = fftw_flags;
+        r->M_total = M_total;
+        r->nthreads = nthreads;
+        r->window = window;
+        r->eps = (double)eps;
+        r->m = best_m;
+        r->flags = best_flags;
 
-  ths->K = K;
-  init_help(ths);
-}
+        for (t = 0; t < d; t++)
+        {
+          r->N[t] = N[t];
+          r->n[t] = best_n[t];
+        }
 
-void X(init_1d)(X(plan) *ths, int N1, int M_total)
-{
-  int N[1];
+        tune_record_add(r);
+      }
+    }
+  }
 
-  N[0] = N1;
+  if (flags & NFFT_TUNE_MEASURE)
+    fftw_flags = FFTW_MEASURE | FFTW_DESTROY_INPUT;
 
-  X(init)(ths, 1, N, M_total);
+  X(init_guru)(ths, d, N, M_total, best_n, best_m, best_flags, fftw_flags);
+
+  if (x)
+  {
+    memcpy(ths->x, x, (size_t)(d * M_total) * sizeof(R));
+    X(precompute_one_psi)(ths);
+  }
 }
 
-void X(init_2d)(X(plan) *ths, int N1, int N2, int M_total)
+/** Writes the tuning records to s of size bytes, or only counts the
+ *  characters if s is NULL. One line per record holds d, M_total, nthreads,
+ *  window, eps and N of the key, then m, flags and n of the choice. */
+static size_t tune_print(char *s, const size_t size)
 {
-  int N[2];
+  const tune_record *r;
+  size_t l = 0;
+  INT t;
 
-  N[0] = N1;
-  N[1] = N2;
-  X(init)(ths, 2, N, M_total);
+#define TUNE_PRINT(...) \
+  l += (size_t)snprintf(s ? s + l : NULL, s ? size - l : 0, __VA_ARGS__);
+
+  for (r = tune_records; r; r = r->next)
+  {
+    TUNE_PRINT("%lld %lld %lld %u %.17g", (long long)r->d,
+      (long long)r->M_total, (long long)r->nthreads, r->window, r->eps)
+    for (t = 0; t < r->d; t++)
+      TUNE_PRINT(" %lld", (long long)r->N[t])
+    TUNE_PRINT(" %lld %u", (long long)r->m, r->flags)
+    for (t = 0; t < r->d; t++)
+      TUNE_PRINT(" %lld", (long long)r->n[t])
+    TUNE_PRINT("\n")
+  }
+
+#undef TUNE_PRINT
+
+  return l;
 }
 
-void X(init_3d)(X(plan) *ths, int N1, int N2, int N3, int M_total)
+char* X(export_tuning_to_string)(void)
 {
-  int N[3];
+  char *s;
 
-  N[0] = N1;
-  N[1] = N2;
-  N[2] = N3;
-  X(init)(ths, 3, N, M_total);
+#ifdef _OPENMP
+  #pragma omp critical (nfft_omp_critical_tuning)
+#endif
+  {
+    const size_t size = tune_print(NULL, 0) + 1;
+
+    s = (char*) Y(malloc)(size);
+    s[0] = '\0';
+    tune_print(s, size);
+  }
+
+  return s;
 }
 
-const char* X(check)(X(plan) *ths)
+/** Reads a number of the tuning format, 0 at the end or on errors. */
+static int tune_scan(const char **s, long long *v, double *e)
 {
-  INT j;
+  char *end;
 
-  if (!ths->f)
-      return "Member f not initialized.";
+  if (e)
+    *e = strtod(*s, &end);
+  else
+    *v = strtoll(*s, &end, 10);
 
-  if (!ths->x)
-      return "Member x not initialized.";
+  if (end == *s)
+    return 0;
 
-  if (!ths->f_hat)
-      return "Member f_hat not initialized.";
+  *s = end;
+  return 1;
+}
 
-  if ((ths->flags & PRE_LIN_PSI) && ths->K < ths->M_total)
-    return "Number of nodes too small to use PRE_LIN_PSI.";
+/** Whether an imported record describes a plan nfft_init_tuned could have
+ *  chosen: even lengths n > N, a cut-off up to TUNE_M_MAX and only the flags
+ *  of the candidates, with the window of its key. */
+static int tune_record_valid(const tune_record *r)
+{
+  const unsigned flags = TUNE_FLAGS | NFFT_WINDOW_MASK | PRE_PSI | PRE_FG_PSI
+    | PRE_FULL_PSI | PRE_LIN_PSI | NFFT_SORT_NODES | NFFT_OMP_BLOCKWISE_ADJOINT;
+  INT t;
+
+  if (r->M_total < 0 || r->nthreads < 1 || r->window == 0U
+    || (r->window & ~NFFT_WINDOW_MASK) != 0U
+    || r->window > NFFT_WINDOW_EXP_SEMICIRCLE || !(r->eps > 0.0)
+    || r->m < 1 || r->m > TUNE_M_MAX || (r->flags & ~flags) != 0U
+    || (r->flags & NFFT_WINDOW_MASK) != r->window)
+    return 0;
 
-  for (j = 0; j < ths->M_total * ths->d; j++)
+  for (t = 0; t < r->d; t++)
   {
-    if ((ths->x[j]<-K(0.5)) || (ths->x[j]>= K(0.5)))
-    {
-      return "ths->x out of range [-0.5,0.5)";
-    }
+    if (r->N[t] < 2 || r->N[t] % 2 != 0 || r->n[t] <= r->N[t]
+      || r->n[t] % 2 != 0)
+      return 0;
   }
 
-  for (j = 0; j < ths->d; j++)
-  {
-    if (ths->sigma[j] <= 1)
-      return "Oversampling factor too small";
-    
-    /* Automatically calls trafo_direct if 
-    if(ths->N[j] <= ths->m)
-      return "Polynomial degree N is <= cut-off m";
-    */
-
-    if(ths->N[j]%2 == 1)
-      return "polynomial degree N has to be even";
-  }
-  return 0;
+  return 1;
 }
 
-void X(finalize)(X(plan) *ths)
+int X(import_tuning_from_string)(const char *s)
 {
-  INT t; /* index over dimensions */
-
-  if(ths->flags & NFFT_SORT_NODES)
-    Y(free)(ths->index_x);
+  tune_record *list = NULL, *r;
+  long long v[5];
+  double eps;
+  int ok = 1;
+  INT t;
 
-  if(ths->flags & FFTW_INIT)
+  while (ok)
   {
-#ifdef _OPENMP
-    #pragma omp critical (nfft_omp_critical_fftw_plan)
-#endif
-    FFTW(destroy_plan)(ths->my_fftw_plan2);
-#ifdef _OPENMP
-    #pragma omp critical (nfft_omp_critical_fftw_plan)
-#endif
-    FFTW(destroy_plan)(ths->my_fftw_plan1);
+    while (*s == ' ' || *s == '\n' || *s == '\t' || *s == '\r')
+      s++;
 
-    if(ths->flags & FFT_OUT_OF_PLACE)
-      Y(free)(ths->g2);
+    if (!*s)
+      break;
 
-    Y(free)(ths->g1);
-  }
+    ok = tune_scan(&s, &v[0], NULL) && tune_scan(&s, &v[1], NULL)
+      && tune_scan(&s, &v[2], NULL) && tune_scan(&s, &v[3], NULL)
+      && tune_scan(&s, NULL, &eps) && v[0] >= 1 && v[0] <= 64;
 
-  if(ths->flags & PRE_FULL_PSI)
-  {
-    Y(free)(ths->psi_index_g);
-    Y(free)(ths->psi_index_f);
-    Y(free)(ths->psi);
-  }
+    if (!ok)
+      break;
 
-  if(ths->flags & PRE_PSI)
-    Y(free)(ths->psi);
+    r = tune_record_new((INT)v[0]);
+    r->M_total = (INT)v[1];
+    r->nthreads = (INT)v[2];
+    r->window = (unsigned)v[3];
+    r->eps = eps;
+    r->next = list;
+    list = r;
 
-  if(ths->flags & PRE_FG_PSI)
-    Y(free)(ths->psi);
+    for (t = 0; ok && t < r->d; t++)
+      if ((ok = tune_scan(&s, &v[4], NULL)))
+        r->N[t] = (INT)v[4];
 
-  if(ths->flags & PRE_LIN_PSI)
-    Y(free)(ths->psi);
+    ok = ok && tune_scan(&s, &v[0], NULL) && tune_scan(&s, &v[1], NULL);
+    r->m = (INT)v[0];
+    r->flags = (unsigned)v[1];
 
-  if(ths->flags & PRE_PHI_HUT)
-  {
-    for (t = 0; t < ths->d; t++)
-        Y(free)(ths->c_phi_inv[t]);
-    Y(free)(ths->c_phi_inv);
-  }
+    for (t = 0; ok && t < r->d; t++)
+      if ((ok = tune_scan(&s, &v[4], NULL)))
+        r->n[t] = (INT)v[4];
 
-  if(ths->flags & MALLOC_F)
-    Y(free)(ths->f);
+    ok = ok && tune_record_valid(r);
+  }
 
-  if(ths->flags & MALLOC_F_HAT)
-    Y(free)(ths->f_hat);
+  /* nothing is imported from an invalid string */
+#ifdef _OPENMP
+  #pragma omp critical (nfft_omp_critical_tuning)
+#endif
+  while (list)
+  {
+    r = list;
+    list = r->next;
 
-  if(ths->flags & MALLOC_X)
-    Y(free)(ths->x);
+    if (ok)
+      tune_record_add(r);
+    else
+      tune_record_free(r);
+  }
 
-  WINDOW_HELP_FINALIZE;
+  return ok;
+}
 
-  Y(free)(ths->sigma);
-  Y(free)(ths->n);
-  Y(free)(ths->N);
+void X(forget_tuning)(void)
+{
+#ifdef _OPENMP
+  #pragma omp critical (nfft_omp_critical_tuning)
+#endif
+  while (tune_records)
+  {
+    tune_record *r = tune_records;
+    tune_records = r->next;
+    tune_record_free(r);
+  }
 }
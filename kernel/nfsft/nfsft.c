@@ -281,6 +281,9 @@ void nfsft_init_guru(nfsft_plan *plan, int N, int M, unsigned int flags,
   /* Save the flags in the plan. */
   plan->flags = flags;
 
+  memset(&plan->stats, 0, sizeof(plan->stats));
+  plan->stats.nthreads = nfft_get_num_threads();
+
   /* Save the bandwidth N and the number of samples M in the plan. */
   plan->N = N;
   plan->M_total = M;
@@ -670,6 +673,14 @@ static void nfsft_set_f_nan(nfsft_plan *plan)
     plan->f[m] = nan_value;
 }
 
+/** Adds a run of the polynomial transform, the change of basis or a direct
+ *  transform to the statistics, the fast NFFT counts in plan_nfft. */
+static inline void stats_other(nfsft_plan *plan, const double seconds)
+{
+  plan->stats.time[NFFT_STATS_OTHER] += seconds;
+  plan->stats.calls[NFFT_STATS_OTHER]++;
+}
+
 void nfsft_trafo_direct(nfsft_plan *plan)
 {
   int m;               /*< The node index                                    */
@@ -686,11 +697,9 @@ void nfsft_trafo_direct(nfsft_plan *plan)
   double stheta;       /*< Current angle theta for Clenshaw algorithm        */
   double sphi;         /*< Current angle phi for Clenshaw algorithm          */
 
-#ifdef MEASURE_TIME
   plan->MEASURE_TIME_t[0] = 0.0;
   plan->MEASURE_TIME_t[1] = 0.0;
   plan->MEASURE_TIME_t[2] = 0.0;
-#endif
 
   if (wisdom.flags & NFSFT_NO_DIRECT_ALGORITHM)
   {
@@ -864,11 +873,9 @@ void nfsft_adjoint_direct(nfsft_plan *plan)
                            coefficient beta_k^n for associated Legendre
                            functions P_k^n                                   */
 
-#ifdef MEASURE_TIME
   plan->MEASURE_TIME_t[0] = 0.0;
   plan->MEASURE_TIME_t[1] = 0.0;
   plan->MEASURE_TIME_t[2] = 0.0;
-#endif
 
   if (wisdom.flags & NFSFT_NO_DIRECT_ALGORITHM)
   {
@@ -1069,9 +1076,7 @@ void nfsft_trafo(nfsft_plan *plan)
 {
   int k; /*< The degree k                                                    */
   int n; /*< The order n                                                     */
-#ifdef MEASURE_TIME
   ticks t0, t1;
-#endif
   #ifdef DEBUG
     double t, t_pre, t_nfft, t_fpt, t_c2e, t_norm;
     t_pre = 0.0;
@@ -1081,11 +1086,12 @@ void nfsft_trafo(nfsft_plan *plan)
     t_nfft = 0.0;
   #endif
 
-#ifdef MEASURE_TIME
   plan->MEASURE_TIME_t[0] = 0.0;
   plan->MEASURE_TIME_t[1] = 0.0;
   plan->MEASURE_TIME_t[2] = 0.0;
-#endif
+
+  plan->stats.trafo_calls++;
+  plan->stats.nodes += (unsigned long long)plan->M_total;
 
   if ((wisdom.flags & NFSFT_NO_FAST_ALGORITHM) || (plan->flags & NFSFT_NO_FAST_ALGORITHM))
   {
@@ -1106,7 +1112,10 @@ void nfsft_trafo(nfsft_plan *plan)
   if (plan->N < NFSFT_BREAK_EVEN)
   {
     /* Use NDSFT. */
+    t0 = getticks();
     nfsft_trafo_direct(plan);
+    t1 = getticks();
+    stats_other(plan, nfft_elapsed_seconds(t1,t0));
   }
 
   /* Check for correct value of the bandwidth N. */
@@ -1153,9 +1162,7 @@ void nfsft_trafo(nfsft_plan *plan)
       }
     }
 
-#ifdef MEASURE_TIME
     t0 = getticks();
-#endif
     /* Check, which polynomial transform algorithm should be used. */
     if (plan->flags & NFSFT_USE_DPT)
     {
@@ -1233,24 +1240,18 @@ void nfsft_trafo(nfsft_plan *plan)
       }
 #endif
     }
-#ifdef MEASURE_TIME
     t1 = getticks();
     plan->MEASURE_TIME_t[0] = nfft_elapsed_seconds(t1,t0);
-#endif
+    stats_other(plan, plan->MEASURE_TIME_t[0]);
 
-#ifdef MEASURE_TIME
     t0 = getticks();
-#endif
     /* Convert Chebyshev coefficients to Fourier coefficients. */
     c2e(plan);
-#ifdef MEASURE_TIME
     t1 = getticks();
     plan->MEASURE_TIME_t[1] = nfft_elapsed_seconds(t1,t0);
-#endif
+    stats_other(plan, plan->MEASURE_TIME_t[1]);
 
-#ifdef MEASURE_TIME
     t0 = getticks();
-#endif
     if (plan->flags & NFSFT_EQUISPACED)
     {
       /* Algorithm for equispaced nodes.
@@ -1276,6 +1277,7 @@ void nfsft_trafo(nfsft_plan *plan)
       {
         FFTW(plan_with_nthreads)(nthreads);
 #endif
+        X(wisdom_before_plan)();
         plan_fftw = fftw_plan_dft(2, N, plan->f_hat_intern, plan->f_hat_intern, FFTW_FORWARD, FFTW_ESTIMATE);
 #ifdef _OPENMP
       }
@@ -1306,10 +1308,10 @@ void nfsft_trafo(nfsft_plan *plan)
       //fprintf(stderr,"nfsft_adjoint: nfft_trafo\n");
       nfft_trafo_2d(&plan->plan_nfft);
     }
-#ifdef MEASURE_TIME
     t1 = getticks();
     plan->MEASURE_TIME_t[2] = nfft_elapsed_seconds(t1,t0);
-#endif
+    if (plan->flags & (NFSFT_EQUISPACED | NFSFT_USE_NDFT))
+      stats_other(plan, plan->MEASURE_TIME_t[2]);
   }
 }
 
@@ -1317,15 +1319,14 @@ void nfsft_adjoint(nfsft_plan *plan)
 {
   int k; /*< The degree k                                                    */
   int n; /*< The order n                                                     */
-#ifdef MEASURE_TIME
   ticks t0, t1;
-#endif
 
-#ifdef MEASURE_TIME
   plan->MEASURE_TIME_t[0] = 0.0;
   plan->MEASURE_TIME_t[1] = 0.0;
   plan->MEASURE_TIME_t[2] = 0.0;
-#endif
+
+  plan->stats.adjoint_calls++;
+  plan->stats.nodes += (unsigned long long)plan->M_total;
 
   if ((wisdom.flags & NFSFT_NO_FAST_ALGORITHM) || (plan->flags & NFSFT_NO_FAST_ALGORITHM))
   {
@@ -1346,7 +1347,10 @@ void nfsft_adjoint(nfsft_plan *plan)
   if (plan->N < NFSFT_BREAK_EVEN)
   {
     /* Use adjoint NDSFT. */
+    t0 = getticks();
     nfsft_adjoint_direct(plan);
+    t1 = getticks();
+    stats_other(plan, nfft_elapsed_seconds(t1,t0));
   }
   /* Check for correct value of the bandwidth N. */
   else if (plan->N <= wisdom.N_MAX)
@@ -1363,9 +1367,7 @@ void nfsft_adjoint(nfsft_plan *plan)
       plan->plan_nfft.f_hat = plan->f_hat;
     }
 
-#ifdef MEASURE_TIME
     t0 = getticks();
-#endif
     if (plan->flags & NFSFT_EQUISPACED)
     {
       /* Algorithm for equispaced nodes.
@@ -1381,7 +1383,9 @@ void nfsft_adjoint(nfsft_plan *plan)
         for (int k=N[1]/2; k<N[1]; k++)
           plan->f_hat[j*N[1]+k] = plan->f[j*N[1]/2+k-N[1]/2] * ((j+k)%2 ? -1 : 1);
       }
-      fftw_plan plan_fftw = FFTW(plan_dft)(2, N, plan->f_hat, plan->f_hat, FFTW_BACKWARD, FFTW_ESTIMATE);
+      fftw_plan plan_fftw;
+      X(wisdom_before_plan)();
+      plan_fftw = FFTW(plan_dft)(2, N, plan->f_hat, plan->f_hat, FFTW_BACKWARD, FFTW_ESTIMATE);
       fftw_execute(plan_fftw);
       for (int j=0; j<N[0]; j++)
         for (int k=0; k<N[1]; k++)
@@ -1407,26 +1411,21 @@ void nfsft_adjoint(nfsft_plan *plan)
       /* Use adjoint NFFT. */
       nfft_adjoint_2d(&plan->plan_nfft);
     }
-#ifdef MEASURE_TIME
     t1 = getticks();
     plan->MEASURE_TIME_t[2] = nfft_elapsed_seconds(t1,t0);
-#endif
+    if (plan->flags & (NFSFT_EQUISPACED | NFSFT_USE_NDFT))
+      stats_other(plan, plan->MEASURE_TIME_t[2]);
 
     //fprintf(stderr,"nfsft_adjoint: Executing c2e_transposed\n");
     //fflush(stderr);
-#ifdef MEASURE_TIME
     t0 = getticks();
-#endif
     /* Convert Fourier coefficients to Chebyshev coefficients. */
     c2e_transposed(plan);
-#ifdef MEASURE_TIME
     t1 = getticks();
     plan->MEASURE_TIME_t[1] = nfft_elapsed_seconds(t1,t0);
-#endif
+    stats_other(plan, plan->MEASURE_TIME_t[1]);
 
-#ifdef MEASURE_TIME
     t0 = getticks();
-#endif
     /* Check, which transposed polynomial transform algorithm should be used */
     if (plan->flags & NFSFT_USE_DPT)
     {
@@ -1505,10 +1504,9 @@ void nfsft_adjoint(nfsft_plan *plan)
       }
 #endif
     }
-#ifdef MEASURE_TIME
     t1 = getticks();
     plan->MEASURE_TIME_t[0] = nfft_elapsed_seconds(t1,t0);
-#endif
+    stats_other(plan, plan->MEASURE_TIME_t[0]);
 
     /* Check, if we compute with L^2-normalized spherical harmonics. If so,
      * multiply spherical Fourier coefficients with corresponding normalization
@@ -1560,4 +1558,22 @@ void nfsft_precompute_x(nfsft_plan *plan)
   if (plan->plan_nfft.flags & PRE_ONE_PSI)
     nfft_precompute_one_psi(&plan->plan_nfft);
 }
+
+void nfsft_get_stats(const nfsft_plan *plan, nfft_stats *stats)
+{
+  *stats = plan->stats;
+
+  /* the steps D, FFT and B and the precomputation of the internal NFFT */
+  if (!(plan->flags & NFSFT_NO_FAST_ALGORITHM) && !(plan->flags & NFSFT_EQUISPACED))
+    STATS_MERGE(*stats, plan->plan_nfft.stats);
+}
+
+void nfsft_reset_stats(nfsft_plan *plan)
+{
+  memset(&plan->stats, 0, sizeof(plan->stats));
+  plan->stats.nthreads = nfft_get_num_threads();
+
+  if (!(plan->flags & NFSFT_NO_FAST_ALGORITHM) && !(plan->flags & NFSFT_EQUISPACED))
+    nfft_reset_stats(&plan->plan_nfft);
+}
 /* \} */
@@ -695,11 +695,37 @@ static inline void B_ ## which_one (X(plan) *ths) \
 MACRO_B(A)
 MACRO_B(T)
 
+/** Counts a transform of the M_total nodes in the statistics, with an
+ *  estimate of the bytes read and written. */
+static void stats_count(X(plan) *ths)
+{
+  INT t, lprod;
+  double node;
+
+  for (t = 0, lprod = 1; t < ths->d; t++)
+    lprod *= 2 * ths->m + 2;
+
+  node = (double)((ths->d + 1 + lprod) * (INT)sizeof(R));
+
+  if (ths->flags & PRE_PSI)
+    node += (double)(ths->d * (2 * ths->m + 2) * (INT)sizeof(R));
+  else if (ths->flags & PRE_FULL_PSI)
+    node += (double)lprod * (double)(sizeof(R) + sizeof(INT));
+
+  ths->stats.nodes += (unsigned long long)ths->M_total;
+  ths->stats.bytes += (double)ths->M_total * node + (double)(2 * ths->N_total
+    + 4 * ths->n_total) * (double)sizeof(R);
+  ths->stats.nthreads = Y(get_num_threads)();
+}
+
 /**
  * user routines
  */
 void X(trafo)(X(plan) *ths)
 {
+  ths->stats.trafo_calls++;
+  stats_count(ths);
+
   switch(ths->d)
   {
     default:
@@ -741,6 +767,9 @@ void X(trafo)(X(plan) *ths)
 
 void X(adjoint)(X(plan) *ths)
 {
+  ths->stats.adjoint_calls++;
+  stats_count(ths);
+
   switch(ths->d)
   {
     default:
@@ -805,6 +834,7 @@ void X(precompute_lin_psi)(X(plan) *ths)
   INT j; /**< index over all nodes */
   R step; /**< step size in [0,(m+2)/n] */
 
+  STATS_TIC(NFFT_STATS_PRECOMPUTE)
   for (t = 0; t < ths->d; t++)
   {
     step = ((R)(ths->m+2)) / (((R)ths->K) * (2 * NN(ths->n[t])));
@@ -814,6 +844,7 @@ void X(precompute_lin_psi)(X(plan) *ths)
       ths->psi[(ths->K + 1) * t + j] = PHI((2 * NN(ths->n[t])), (j * step), t);
     } /* for(j) */
   } /* for(t) */
+  STATS_TOC(NFFT_STATS_PRECOMPUTE)
 }
 
 void X(precompute_fg_psi)(X(plan) *ths)
@@ -821,6 +852,7 @@ void X(precompute_fg_psi)(X(plan) *ths)
   INT t; /* index over all dimensions */
   INT u, o; /* depends on x_j */
 
+  STATS_TIC(NFFT_STATS_PRECOMPUTE)
 //  sort(ths);
 
   for (t = 0; t < ths->d; t++)
@@ -836,6 +868,7 @@ void X(precompute_fg_psi)(X(plan) *ths)
       } /* for(j) */
   }
   /* for(t) */
+  STATS_TOC(NFFT_STATS_PRECOMPUTE)
 } /* nfft_precompute_fg_psi */
 
 void X(precompute_psi)(X(plan) *ths)
@@ -844,6 +877,7 @@ void X(precompute_psi)(X(plan) *ths)
   INT lj; /* index 0<=lj<u+o+1 */
   INT u, o; /* depends on x_j */
 
+  STATS_TIC(NFFT_STATS_PRECOMPUTE)
   //sort(ths);
 
   for (t = 0; t < ths->d; t++)
@@ -859,6 +893,7 @@ void X(precompute_psi)(X(plan) *ths)
             (PHI((2 * NN(ths->n[t])), ((ths->x[(j) * ths->d + (t)]) - ((R)(lj + u)) / (K(2.0) * ((R)NN(ths->n[t])))), t));
     } /* for (j) */
   } /* for (t) */
+  STATS_TOC(NFFT_STATS_PRECOMPUTE)
 } /* precompute_psi */
 
 void X(precompute_full_psi)(X(plan) *ths)
@@ -883,6 +918,7 @@ void X(precompute_full_psi)(X(plan) *ths)
 
   INT ix, ix_old;
 
+  STATS_TIC(NFFT_STATS_PRECOMPUTE)
   //sort(ths);
 
   phi_prod[0] = K(1.0);
@@ -909,6 +945,7 @@ void X(precompute_full_psi)(X(plan) *ths)
     ix_old = ix;
   } /* for(j) */
 //#endif
+  STATS_TOC(NFFT_STATS_PRECOMPUTE)
 }
 
 void X(precompute_one_psi)(X(plan) *ths)
@@ -928,6 +965,8 @@ static inline void init_help(X(plan) *ths)
   INT t; /* index over all dimensions */
   INT lprod; /* 'bandwidth' of matrix B */
 
+  X(reset_stats)(ths);
+
   if (ths->flags & NFFT_OMP_BLOCKWISE_ADJOINT)
     ths->flags |= NFFT_SORT_NODES;
 
@@ -956,7 +995,11 @@ static inline void init_help(X(plan) *ths)
     ths->f = (R*)Y(malloc)((size_t)(ths->M_total) * sizeof(R));
 
   if (ths->flags & PRE_PHI_HUT)
+  {
+    STATS_TIC(NFFT_STATS_PRECOMPUTE)
     precompute_phi_hut(ths);
+    STATS_TOC(NFFT_STATS_PRECOMPUTE)
+  }
 
   if(ths->flags & PRE_LIN_PSI)
   {
@@ -996,7 +1039,9 @@ static inline void init_help(X(plan) *ths)
       for (t = 0; t < ths->d; t++)
         _n[t] = (int)(ths->n[t]);
 
+      Y(wisdom_before_plan)();
       ths->my_fftw_r2r_plan = FFTW(plan_r2r)((int)ths->d, _n, ths->g1, ths->g2, ths->r2r_kind, ths->fftw_flags);
+      Y(wisdom_after_plan)(ths->fftw_flags);
       Y(free)(_n);
     }
   }
@@ -1140,6 +1185,17 @@ const char* X(check)(X(plan) *ths)
   return 0;
 }
 
+void X(get_stats)(const X(plan) *ths, Y(stats) *stats)
+{
+  *stats = ths->stats;
+}
+
+void X(reset_stats)(X(plan) *ths)
+{
+  memset(&ths->stats, 0, sizeof(ths->stats));
+  ths->stats.nthreads = Y(get_num_threads)();
+}
+
 void X(finalize)(X(plan) *ths)
 {
   INT t; /* index over dimensions */
@@ -1596,18 +1596,25 @@ static void nsfft_init_2d(nsfft_plan *ths, int J, int M, int m, unsigned snfft_f
   ths->set_fftw_plan1[0]=ths->act_nfft_plan->my_fftw_plan1;
   ths->set_fftw_plan2[0]=ths->act_nfft_plan->my_fftw_plan2;
 
-  for(r=1;r<=J/2;r++)
-    {
-      N[0]=X(exp2i)(r);   n[0]=ths->sigma*N[0];
-      N[1]=X(exp2i)(J-r); n[1]=ths->sigma*N[1];
-      ths->set_fftw_plan1[r] =
-	fftw_plan_dft(2, n, ths->act_nfft_plan->g1, ths->act_nfft_plan->g2,
-		      FFTW_FORWARD, ths->act_nfft_plan->fftw_flags);
-
-      ths->set_fftw_plan2[r] =
-	fftw_plan_dft(2, n, ths->act_nfft_plan->g2, ths->act_nfft_plan->g1,
-		      FFTW_BACKWARD, ths->act_nfft_plan->fftw_flags);
-    }
+#ifdef _OPENMP
+  #pragma omp critical (nfft_omp_critical_fftw_plan)
+#endif
+  {
+    X(wisdom_before_plan)();
+    for(r=1;r<=J/2;r++)
+      {
+        N[0]=X(exp2i)(r);   n[0]=ths->sigma*N[0];
+        N[1]=X(exp2i)(J-r); n[1]=ths->sigma*N[1];
+        ths->set_fftw_plan1[r] =
+	  fftw_plan_dft(2, n, ths->act_nfft_plan->g1, ths->act_nfft_plan->g2,
+			FFTW_FORWARD, ths->act_nfft_plan->fftw_flags);
+
+        ths->set_fftw_plan2[r] =
+	  fftw_plan_dft(2, n, ths->act_nfft_plan->g2, ths->act_nfft_plan->g1,
+			FFTW_BACKWARD, ths->act_nfft_plan->fftw_flags);
+      }
+    X(wisdom_after_plan)(ths->act_nfft_plan->fftw_flags);
+  }
 
   /* planning the 1d nffts */
   for(r=0;r<=X(log2i)(m);r++)
@@ -1688,37 +1695,44 @@ static void nsfft_init_3d(nsfft_plan *ths, int J, int M, int m, unsigned snfft_f
   ths->act_nfft_plan->g1 = nfft_malloc(ths->sigma*ths->sigma*ths->sigma*X(exp2i)(J+(J+1)/2)*sizeof(double _Complex));
   ths->act_nfft_plan->g2 = nfft_malloc(ths->sigma*ths->sigma*ths->sigma*X(exp2i)(J+(J+1)/2)*sizeof(double _Complex));
 
-  ths->act_nfft_plan->my_fftw_plan1 =
-    fftw_plan_dft(3, n, ths->act_nfft_plan->g1, ths->act_nfft_plan->g2,
-		  FFTW_FORWARD, ths->act_nfft_plan->fftw_flags);
-  ths->act_nfft_plan->my_fftw_plan2 =
-    fftw_plan_dft(3, n, ths->act_nfft_plan->g2, ths->act_nfft_plan->g1,
-		  FFTW_BACKWARD, ths->act_nfft_plan->fftw_flags);
-
-  ths->set_fftw_plan1[0]=ths->act_nfft_plan->my_fftw_plan1;
-  ths->set_fftw_plan2[0]=ths->act_nfft_plan->my_fftw_plan2;
-
-  for(rr=1;rr<=(J+1)/2;rr++)
-    {
-      a=X(exp2i)(J-rr);
-      b=X(exp2i)(rr);
-
-      r=MIN(rr,J-rr);
-
-      n[0]=ths->sigma*X(exp2i)(r);
-      if(a<b)
-	n[1]=ths->sigma*X(exp2i)(J-r);
-      else
-	n[1]=ths->sigma*X(exp2i)(r);
-      n[2]=ths->sigma*X(exp2i)(J-r);
-
-      ths->set_fftw_plan1[rr] =
-	fftw_plan_dft(3, n, ths->act_nfft_plan->g1, ths->act_nfft_plan->g2,
-		      FFTW_FORWARD, ths->act_nfft_plan->fftw_flags);
-      ths->set_fftw_plan2[rr] =
-	fftw_plan_dft(3, n, ths->act_nfft_plan->g2, ths->act_nfft_plan->g1,
-		      FFTW_BACKWARD, ths->act_nfft_plan->fftw_flags);
-    }
+#ifdef _OPENMP
+  #pragma omp critical (nfft_omp_critical_fftw_plan)
+#endif
+  {
+    X(wisdom_before_plan)();
+    ths->act_nfft_plan->my_fftw_plan1 =
+      fftw_plan_dft(3, n, ths->act_nfft_plan->g1, ths->act_nfft_plan->g2,
+		    FFTW_FORWARD, ths->act_nfft_plan->fftw_flags);
+    ths->act_nfft_plan->my_fftw_plan2 =
+      fftw_plan_dft(3, n, ths->act_nfft_plan->g2, ths->act_nfft_plan->g1,
+		    FFTW_BACKWARD, ths->act_nfft_plan->fftw_flags);
+
+    ths->set_fftw_plan1[0]=ths->act_nfft_plan->my_fftw_plan1;
+    ths->set_fftw_plan2[0]=ths->act_nfft_plan->my_fftw_plan2;
+
+    for(rr=1;rr<=(J+1)/2;rr++)
+      {
+        a=X(exp2i)(J-rr);
+        b=X(exp2i)(rr);
+
+        r=MIN(rr,J-rr);
+
+        n[0]=ths->sigma*X(exp2i)(r);
+        if(a<b)
+	  n[1]=ths->sigma*X(exp2i)(J-r);
+        else
+	  n[1]=ths->sigma*X(exp2i)(r);
+        n[2]=ths->sigma*X(exp2i)(J-r);
+
+        ths->set_fftw_plan1[rr] =
+	  fftw_plan_dft(3, n, ths->act_nfft_plan->g1, ths->act_nfft_plan->g2,
+			FFTW_FORWARD, ths->act_nfft_plan->fftw_flags);
+        ths->set_fftw_plan2[rr] =
+	  fftw_plan_dft(3, n, ths->act_nfft_plan->g2, ths->act_nfft_plan->g1,
+			FFTW_BACKWARD, ths->act_nfft_plan->fftw_flags);
+      }
+    X(wisdom_after_plan)(ths->act_nfft_plan->fftw_flags);
+  }
 
   /* planning the 1d nffts */
   for(r=0;r<=X(log2i)(m);r++)
@@ -71,6 +71,8 @@ void X(init_advanced_complex)(X(plan_complex)* ths, Y(mv_plan_complex) *mv,
 
   if(ths->flags & PRECOMPUTE_DAMP)
     ths->w_hat = (R*) Y(malloc)((size_t)(ths->mv->N_total) * sizeof(R));
+
+  ths->normal = NULL;
 }
 
 void X(init_complex)(X(plan_complex)* ths, Y(mv_plan_complex) *mv)
@@ -78,8 +80,20 @@ void X(init_complex)(X(plan_complex)* ths, Y(mv_plan_complex) *mv)
   X(init_advanced_complex)(ths, mv, CGNR);
 }
 
+/** Whether the member normal was initialised with the plan mv and the
+ *  weights w (PRECOMPUTE_WEIGHT) or none. */
+static int solver_normal_matches_complex(const X(plan_complex) *ths)
+{
+  return (const void*)(ths->normal->p) == (const void*)(ths->mv)
+    && ths->normal->w == ((ths->flags & PRECOMPUTE_WEIGHT) ? ths->w : NULL);
+}
+
 void X(before_loop_complex)(X(plan_complex)* ths)
 {
+  /* without one the iteration takes a transform and an adjoint transform */
+  if ((ths->flags & NORMAL_OPERATOR) && ths->normal != NULL)
+    CK(solver_normal_matches_complex(ths));
+
   Y(cp_complex)(ths->mv->f_hat, ths->f_hat_iter, ths->mv->N_total);
 
   CSWAP(ths->r_iter, ths->mv->f);
@@ -343,9 +357,88 @@ static void solver_loop_one_step_cgne_complex(X(plan_complex) *ths)
     ths->dot_p_hat_iter = Y(dot_complex)(ths->p_hat_iter, ths->mv->N_total);
 } /* void solver_loop_one_step_cgne */
 
+/** real part of the damped inner product of a and b */
+static R solver_dot_normal_complex(X(plan_complex) *ths, const C *a,
+  const C *b)
+{
+  R dot = K(0.0);
+  INT k;
+
+  for (k = 0; k < ths->mv->N_total; k++)
+    dot += ((ths->flags & PRECOMPUTE_DAMP) ? ths->w_hat[k] : K(1.0))
+      * CREAL(CONJ(a[k]) * b[k]);
+
+  return dot;
+}
+
+/** void solver_loop_one_step_normal
+ *  Landweber, steepest descent and CGNR with the normal operator A^H W A,
+ *  which updates z_hat_iter without a transform and adjoint; r_iter is not
+ *  updated, dot_r_iter follows from
+ *  |r - alpha v|^2 = |r|^2 - 2 alpha Re(s, z) + alpha^2 |v|^2 */
+static void solver_loop_one_step_normal_complex(X(plan_complex) *ths)
+{
+  C *s = (ths->flags & CGNR) ? ths->p_hat_iter : ths->z_hat_iter;
+  const int norms = (!(ths->flags & LANDWEBER))
+    || (ths->flags & NORMS_FOR_LANDWEBER);
+
+  if(ths->flags & PRECOMPUTE_DAMP)
+    Y(cp_w_complex)(ths->normal->f_hat, ths->w_hat, s, ths->mv->N_total);
+  else
+    Y(cp_complex)(ths->normal->f_hat, s, ths->mv->N_total);
+
+  Y(trafo_normal)(ths->normal);
+
+  ths->dot_v_iter = solver_dot_normal_complex(ths, s, ths->normal->f_hat);
+
+  /*-----------------*/
+  if(!(ths->flags & LANDWEBER))
+    ths->alpha_iter = ths->dot_z_hat_iter / ths->dot_v_iter;
+
+  /*-----------------*/
+  if(norms)
+    ths->dot_r_iter += ths->alpha_iter * (ths->alpha_iter * ths->dot_v_iter
+      - K(2.0) * solver_dot_normal_complex(ths, s, ths->z_hat_iter));
+
+  if(ths->flags & PRECOMPUTE_DAMP)
+    Y(upd_xpawy_complex)(ths->f_hat_iter, ths->alpha_iter, ths->w_hat, s,
+			   ths->mv->N_total);
+  else
+    Y(upd_xpay_complex)(ths->f_hat_iter, ths->alpha_iter, s, ths->mv->N_total);
+
+  /*-----------------*/
+  Y(upd_xpay_complex)(ths->z_hat_iter, -ths->alpha_iter, ths->normal->f_hat,
+			ths->mv->N_total);
+
+  ths->dot_z_hat_iter_old = ths->dot_z_hat_iter;
+  if(norms)
+    {
+      if(ths->flags & PRECOMPUTE_DAMP)
+	ths->dot_z_hat_iter = Y(dot_w_complex)(ths->z_hat_iter, ths->w_hat,
+						 ths->mv->N_total);
+      else
+	ths->dot_z_hat_iter = Y(dot_complex)(ths->z_hat_iter,
+					       ths->mv->N_total);
+    }
+
+  if(ths->flags & CGNR)
+    {
+      ths->beta_iter = ths->dot_z_hat_iter / ths->dot_z_hat_iter_old;
+
+      Y(upd_axpy_complex)(ths->p_hat_iter, ths->beta_iter, ths->z_hat_iter,
+			    ths->mv->N_total);
+    }
+} /* void solver_loop_one_step_normal */
+
 /** void solver_loop_one_step */
 void X(loop_one_step_complex)(X(plan_complex) *ths)
 {
+  if((ths->flags & NORMAL_OPERATOR) && ths->normal && !(ths->flags & CGNE))
+    {
+      solver_loop_one_step_normal_complex(ths);
+      return;
+    }
+
   if(ths->flags & LANDWEBER)
     solver_loop_one_step_landweber_complex(ths);
 
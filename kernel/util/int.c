@@ -131,6 +131,33 @@ INT Y(next_power_of_2)(const INT x)
     }
 }
 
+/**
+ * Returns the smallest even integer larger or equal to the input of the form
+ * 2^a 3^b 5^c 7^d, for which FFTW has efficient codelets. Inputs below 2
+ * yield 2.
+ */
+INT Y(next_fft_size)(const INT x)
+{
+    INT n = MAX(x, 2);
+
+    for (n += n % 2; ; n += 2)
+    {
+        INT r = n / 2;
+
+        while (r % 2 == 0)
+            r /= 2;
+        while (r % 3 == 0)
+            r /= 3;
+        while (r % 5 == 0)
+            r /= 5;
+        while (r % 7 == 0)
+            r /= 7;
+
+        if (r == 1)
+            return n;
+    }
+}
+
 /** Computes /f$n\ge N/f$ such that /f$n=2^j,\, j\in\mathhb{N}_0/f$.
  */
 void Y(next_power_of_2_exp)(const INT N, INT *N2, INT *t)
@@ -86,83 +86,91 @@ static inline void sort_node_indices_radix_rearrange(INT n, INT *keys_in, INT *k
 /**
  * Radix sort for node indices with OpenMP support.
  *
+ * Sorts the n pairs (key, index) in keys0 by key, where 0 <= key < 2^(rhigh+1).
+ * The rhigh+1 key bits are split into the least number of digits of at most
+ * rwidth bits, all of equal width. Each thread counts the digits of its share
+ * of the pairs in a histogram of its own; the per-thread prefix sums then give
+ * every thread disjoint target ranges for the stable scatter. All passes run
+ * in one parallel region of at most nthreads threads. keys1 is scratch of the
+ * same size as keys0.
+ *
  * \author Michael Hofmann
  */
-void Y(sort_node_indices_radix_lsdf)(INT n, INT *keys0, INT *keys1, INT rhigh)
+void Y(sort_node_indices_radix_lsdf)(INT n, INT *keys0, INT *keys1, INT rhigh,
+  INT nthreads)
 {
-  const INT radix_mask = radix_n - 1;
-  const INT rhigh_in = rhigh;
-
   const INT tmax =
 #ifdef _OPENMP
-    omp_get_max_threads();
+    MAX(nthreads, 1);
 #else
     1;
 #endif
+  const INT passes = (rhigh + 1 + rwidth - 1) / rwidth;
+  const INT width = (passes > 0) ? (rhigh + 1 + passes - 1) / passes : 0;
+  const INT radix = (INT)1 << width;
+  const INT radix_mask = radix - 1;
 
-  INT *from, *to, *tmp;
-
-  INT i, k, l, h;
+  INT *from = keys0, *to = keys1;
   INT *lcounts;
 
-  INT tid = 0, tnum = 1;
+#ifndef _OPENMP
+  UNUSED(nthreads);
+#endif
 
-  STACK_MALLOC(INT*, lcounts, (size_t)(tmax * radix_n) * sizeof(INT));
+  if (passes <= 0 || n <= 1)
+    return;
 
-  from = keys0;
-  to = keys1;
+  STACK_MALLOC(INT*, lcounts, (size_t)(tmax * radix) * sizeof(INT));
 
-  while (rhigh >= 0)
-  {
 #ifdef _OPENMP
-    #pragma omp parallel private(tid, tnum, i, l, h)
-    {
-      tid = omp_get_thread_num();
-      tnum = omp_get_num_threads();
+  #pragma omp parallel default(shared) num_threads(tmax)
 #endif
+  {
+    INT tid = 0, tnum = 1;
+    INT i, l, h, pass;
 
-      for (i = 0; i < radix_n; ++i) lcounts[tid * radix_n + i] = 0;
-
-      l = (tid * n) / tnum;
-      h = ((tid + 1) * n) / tnum;
-
-      sort_node_indices_radix_count(h - l, from + (2 * l), rhigh_in - rhigh, radix_mask, &lcounts[tid * radix_n]);
 #ifdef _OPENMP
-    }
+    tid = omp_get_thread_num();
+    tnum = omp_get_num_threads();
 #endif
 
-    k = 0;
-    for (i = 0; i < radix_n; ++i)
-    {
-      for (l = 0; l < tmax; ++l) lcounts[l * radix_n + i] = (k += lcounts[l * radix_n + i]) - lcounts[l * radix_n + i];
-    }
+    l = (tid * n) / tnum;
+    h = ((tid + 1) * n) / tnum;
 
-#ifdef _OPENMP
-    #pragma omp parallel private(tid, tnum, i, l, h)
+    for (pass = 0; pass < passes; pass++)
     {
-      tid = omp_get_thread_num();
-      tnum = omp_get_num_threads();
-#endif
+      for (i = 0; i < radix; ++i) lcounts[tid * radix + i] = 0;
 
-      l = (tid * n) / tnum;
-      h = ((tid + 1) * n) / tnum;
+      sort_node_indices_radix_count(h - l, from + (2 * l), pass * width, radix_mask, &lcounts[tid * radix]);
 
-      sort_node_indices_radix_rearrange(h - l, from + (2 * l), to, rhigh_in - rhigh, radix_mask, &lcounts[tid * radix_n]);
 #ifdef _OPENMP
-    }
+      #pragma omp barrier
+      #pragma omp single
 #endif
+      {
+        INT j, k = 0;
+        for (i = 0; i < radix; ++i)
+        {
+          for (j = 0; j < tnum; ++j) lcounts[j * radix + i] = (k += lcounts[j * radix + i]) - lcounts[j * radix + i];
+        }
+      }
 
-/*    print_keys(n, to);*/
+      sort_node_indices_radix_rearrange(h - l, from + (2 * l), to, pass * width, radix_mask, &lcounts[tid * radix]);
 
-    tmp = from;
-    from = to;
-    to = tmp;
+#ifdef _OPENMP
+      #pragma omp barrier
+      #pragma omp single
+#endif
+      {
+        INT *tmp = from;
+        from = to;
+        to = tmp;
+      }
+    }
 
-    rhigh -= rwidth;
+    if (from != keys0) memcpy(keys0 + 2 * l, from + 2 * l, (size_t)(h - l) * 2 * sizeof(INT));
   }
 
-  if (to == keys0) memcpy(to, from, (size_t)(n) * 2 * sizeof(INT));
-
   STACK_FREE(lcounts);
 }
 
@@ -25,16 +25,7 @@
 INT Y(get_num_threads)(void)
 {
 #ifdef _OPENMP
-  INT nthreads;
-  #pragma omp parallel default(shared)
-  {
-    INT n = (INT)omp_get_num_threads();
-    #pragma omp master
-    {
-      nthreads = n;
-    }
-  }
-  return nthreads;
+  return (INT)omp_get_max_threads();
 #else
   return 1;
 #endif
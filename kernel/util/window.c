@@ -18,26 +18,123 @@
 
 #include "api.h"
 
-#if defined(DIRAC_DELTA)
-  static const INT m2K_[] = {0};
-#elif defined(GAUSSIAN)
-  static const INT m2K_[] = {0, 1, 3, 6, 7, 9, 11, 13, 15, 17, 19, 21, 22, 23, 24};
-#elif defined(B_SPLINE)
-  static const INT m2K_[] = {0, 0, 4, 7, 10, 13, 15, 17, 19, 22, 24};
-#elif defined(SINC_POWER)
-  static const INT m2K_[] = {0, 0, 2, 5, 8, 11, 12, 14, 16, 18, 21, 23, 24, 24};
-#else /* Kaiser-Bessel is the default. */
-  static const INT m2K_[] = {1, 3, 7, 9, 14, 17, 20, 23, 24};
-#endif
+static const INT m2K_dirac_delta[] = {0};
+static const INT m2K_gaussian[] = {0, 1, 3, 6, 7, 9, 11, 13, 15, 17, 19, 21, 22, 23, 24};
+static const INT m2K_b_spline[] = {0, 0, 4, 7, 10, 13, 15, 17, 19, 22, 24};
+static const INT m2K_sinc_power[] = {0, 0, 2, 5, 8, 11, 12, 14, 16, 18, 21, 23, 24, 24};
+static const INT m2K_kaiser_bessel[] = {1, 3, 7, 9, 14, 17, 20, 23, 24};
+
+#define M2K(m2K_) \
+  { \
+    int j = MIN(((int)(m)), ((int)((sizeof(m2K_) / sizeof(m2K_[0])) - 1))); \
+    return (INT)((1U << m2K_[j]) * (m + 2)); \
+  }
 
 /**
  * Returns an appropriate value of the parameter K used with the PRE_LIN_PSI
- * flag for a given value of the cut-off parameter m.
+ * flag for a given value of the cut-off parameter m and a window function
+ * NFFT_WINDOW_*.
+ */
+INT Y(m2K)(const INT m, const unsigned window)
+{
+  switch (window)
+  {
+    case NFFT_WINDOW_DIRAC_DELTA: M2K(m2K_dirac_delta)
+    case NFFT_WINDOW_GAUSSIAN: M2K(m2K_gaussian)
+    case NFFT_WINDOW_B_SPLINE: M2K(m2K_b_spline)
+    case NFFT_WINDOW_SINC_POWER: M2K(m2K_sinc_power)
+    case NFFT_WINDOW_EXP_SEMICIRCLE: M2K(m2K_kaiser_bessel)
+    default: M2K(m2K_kaiser_bessel)
+  }
+}
+
+/**
+ * Returns the default window cut off m for a window function NFFT_WINDOW_*.
+ */
+INT Y(window_cut_off)(const unsigned window)
+{
+  switch (window)
+  {
+    case NFFT_WINDOW_DIRAC_DELTA: return WINDOW_HELP_ESTIMATE_m_DIRAC_DELTA;
+    case NFFT_WINDOW_GAUSSIAN: return WINDOW_HELP_ESTIMATE_m_GAUSSIAN;
+    case NFFT_WINDOW_B_SPLINE: return WINDOW_HELP_ESTIMATE_m_B_SPLINE;
+    case NFFT_WINDOW_SINC_POWER: return WINDOW_HELP_ESTIMATE_m_SINC_POWER;
+    case NFFT_WINDOW_EXP_SEMICIRCLE: return WINDOW_HELP_ESTIMATE_m_EXP_SEMICIRCLE;
+    default: return WINDOW_HELP_ESTIMATE_m_KAISER_BESSEL;
+  }
+}
+
+/**
+ * Returns an estimate of the relative error of a one-dimensional NFFT with
+ * cut-off m and oversampling factor sigma for a window function NFFT_WINDOW_*.
+ * It is the aliasing and truncation error of the window plus the rounding
+ * error amplified by the division by the Fourier coefficients of the window,
+ * which grows with m and dominates for small sigma.
+ */
+R Y(window_error)(const INT m, const R sigma, const unsigned window)
+{
+  const R mr = (R)(m);
+  R err, amp;
+
+  switch (window)
+  {
+    case NFFT_WINDOW_GAUSSIAN:
+      err = K(4.0) * EXP(-mr * KPI * (K(1.0) - K(1.0) / (K(2.0) * sigma - K(1.0))));
+      amp = EXP(mr * KPI / (K(2.0) * sigma * (K(2.0) * sigma - K(1.0))));
+      break;
+    case NFFT_WINDOW_B_SPLINE:
+      err = K(4.0) * POW(K(1.0) / (K(2.0) * sigma - K(1.0)), K(2.0) * mr);
+      amp = POW(Y(sinc)(KPI / (K(2.0) * sigma)), -K(2.0) * mr);
+      break;
+    case NFFT_WINDOW_SINC_POWER:
+      if (m < 2)
+        return K(1.0);
+      err = (K(1.0) / (mr - K(1.0))) * (K(2.0) / POW(sigma, K(2.0) * mr)
+        + POW(sigma / (K(2.0) * sigma - K(1.0)), K(2.0) * mr));
+      /* Gaussian approximation of the B-spline PHI_HUT */
+      amp = EXP(K(3.0) * mr / ((K(2.0) * sigma - K(1.0)) * (K(2.0) * sigma - K(1.0))));
+      break;
+    case NFFT_WINDOW_DIRAC_DELTA:
+      return K(1.0);
+    case NFFT_WINDOW_EXP_SEMICIRCLE:
+    {
+      /* Kaiser-Bessel with the decay of the Fourier transform of the window,
+       * sqrt(b^2 - c^2) for b below the 2 pi m (1 - 1/(2 sigma)) of
+       * Kaiser-Bessel */
+      const R b = WINDOW_HELP_B_EXP_SEMICIRCLE(sigma, m), c = mr * KPI / sigma;
+      err = K(4.0) * KPI * (SQRT(mr) + mr) * SQRT(SQRT(K(1.0) - K(1.0) / sigma))
+        * EXP(-SQRT(b * b - c * c));
+      amp = EXP(b - SQRT(b * b - c * c));
+      break;
+    }
+    default:
+    {
+      /* Kaiser-Bessel */
+      const R b = WINDOW_HELP_B_KAISER_BESSEL(sigma, m), c = KPI / sigma;
+      err = K(4.0) * KPI * (SQRT(mr) + mr) * SQRT(SQRT(K(1.0) - K(1.0) / sigma))
+        * EXP(-K2PI * mr * SQRT(K(1.0) - K(1.0) / sigma));
+      amp = EXP(mr * (b - SQRT(b * b - c * c)));
+    }
+  }
+
+  return err + NFFT_EPSILON * amp;
+}
+
+/**
+ * Returns the name of a window function NFFT_WINDOW_*, using the same names
+ * as the configure option --with-window.
  */
-INT Y(m2K)(const INT m)
+const char *Y(window_name)(const unsigned window)
 {
-  int j = MIN(((int)(m)), ((int)((sizeof(m2K_) / sizeof(m2K_[0])) - 1)));
-  return (INT)((1U << m2K_[j]) * (m + 2));
+  switch (window)
+  {
+    case NFFT_WINDOW_DIRAC_DELTA: return "delta";
+    case NFFT_WINDOW_GAUSSIAN: return "gaussian";
+    case NFFT_WINDOW_B_SPLINE: return "bspline";
+    case NFFT_WINDOW_SINC_POWER: return "sinc";
+    case NFFT_WINDOW_EXP_SEMICIRCLE: return "expsemicircle";
+    default: return "kaiserbessel";
+  }
 }
 
 /**
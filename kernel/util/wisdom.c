@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2002, 2017 Jens Keiner, Stefan Kunis, Daniel Potts
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* FFTW wisdom store. All FFTW plans of the library are created between
+ * Y(wisdom_before_plan) and Y(wisdom_after_plan). The first call imports the
+ * wisdom file once, the second one merges the file with the wisdom of this
+ * process and writes it back if a plan has been measured. The file is locked
+ * while it is read or written, so concurrent processes may share it. */
+
+#include "api.h"
+
+#if defined(HAVE_FCNTL_H) && defined(HAVE_UNISTD_H)
+#include <fcntl.h>
+#include <unistd.h>
+#define WISDOM_LOCK
+#endif
+
+#if defined(NFFT_SINGLE)
+#define WISDOM_ENV "NFFTF_WISDOM_FILE"
+#elif defined(NFFT_LDOUBLE)
+#define WISDOM_ENV "NFFTL_WISDOM_FILE"
+#else
+#define WISDOM_ENV "NFFT_WISDOM_FILE"
+#endif
+
+static char *wisdom_filename = NULL;
+static int wisdom_initialized = 0;
+static int wisdom_imported = 0;
+static char *wisdom_synced = NULL; /* wisdom of this process after last sync */
+
+static void wisdom_set(const char *filename)
+{
+  Y(free)(wisdom_filename);
+  wisdom_filename = NULL;
+
+  if (filename && filename[0])
+  {
+    wisdom_filename = (char*) Y(malloc)(strlen(filename) + 1);
+    strcpy(wisdom_filename, filename);
+  }
+
+  free(wisdom_synced);
+  wisdom_synced = NULL;
+
+  wisdom_initialized = 1;
+  wisdom_imported = 0;
+}
+
+/** Takes the file from the environment unless set explicitly. */
+static void wisdom_init(void)
+{
+  if (!wisdom_initialized)
+    wisdom_set(getenv(WISDOM_ENV));
+}
+
+#ifdef WISDOM_LOCK
+static char *wisdom_read(const int fd)
+{
+  const off_t size = lseek(fd, 0, SEEK_END);
+  char *s;
+  size_t l = 0;
+
+  if (size < 0 || lseek(fd, 0, SEEK_SET) != 0)
+    return NULL;
+
+  s = (char*) Y(malloc)((size_t)(size) + 1);
+
+  while (l < (size_t)(size))
+  {
+    const ssize_t r = read(fd, s + l, (size_t)(size) - l);
+    if (r <= 0)
+      break;
+    l += (size_t)(r);
+  }
+
+  s[l] = '\0';
+  return s;
+}
+
+static void wisdom_write(const int fd, const char *s)
+{
+  const size_t size = strlen(s);
+  size_t l = 0;
+
+  if (ftruncate(fd, 0) != 0 || lseek(fd, 0, SEEK_SET) != 0)
+    return;
+
+  while (l < size)
+  {
+    const ssize_t r = write(fd, s + l, size - l);
+    if (r <= 0)
+      break;
+    l += (size_t)(r);
+  }
+}
+
+/** Imports the wisdom file and, if write_back is set, writes the merged wisdom
+ * back unless it is unchanged. */
+static void wisdom_sync(const int write_back)
+{
+  struct flock lock;
+  char *s;
+  const int fd = open(wisdom_filename, write_back ? O_RDWR | O_CREAT : O_RDONLY,
+    0644);
+
+  if (fd < 0)
+    return;
+
+  memset(&lock, 0, sizeof(lock));
+  lock.l_type = write_back ? F_WRLCK : F_RDLCK;
+  lock.l_whence = SEEK_SET;
+
+  if (fcntl(fd, F_SETLKW, &lock) == 0)
+  {
+    s = wisdom_read(fd);
+
+    if (s && s[0])
+      FFTW(import_wisdom_from_string)(s);
+
+    if (write_back)
+    {
+      char *w = FFTW(export_wisdom_to_string)();
+
+      if (w && (!s || strcmp(w, s) != 0))
+        wisdom_write(fd, w);
+
+      free(w);
+    }
+
+    Y(free)(s);
+
+    lock.l_type = F_UNLCK;
+    fcntl(fd, F_SETLK, &lock);
+  }
+
+  close(fd);
+}
+#else
+static void wisdom_sync(const int write_back)
+{
+  FFTW(import_wisdom_from_filename)(wisdom_filename);
+
+  if (write_back)
+    FFTW(export_wisdom_to_filename)(wisdom_filename);
+}
+#endif
+
+void Y(set_wisdom_filename)(const char *filename)
+{
+#ifdef _OPENMP
+  #pragma omp critical (nfft_omp_critical_wisdom)
+#endif
+  wisdom_set(filename);
+}
+
+const char *Y(get_wisdom_filename)(void)
+{
+  const char *filename;
+
+#ifdef _OPENMP
+  #pragma omp critical (nfft_omp_critical_wisdom)
+#endif
+  {
+    wisdom_init();
+    filename = wisdom_filename;
+  }
+
+  return filename;
+}
+
+void Y(wisdom_before_plan)(void)
+{
+#ifdef _OPENMP
+  #pragma omp critical (nfft_omp_critical_wisdom)
+#endif
+  {
+    wisdom_init();
+
+    if (wisdom_filename && !wisdom_imported)
+    {
+      wisdom_sync(0);
+      wisdom_imported = 1;
+    }
+  }
+}
+
+void Y(wisdom_after_plan)(const unsigned fftw_flags)
+{
+  /* only measured plans create new wisdom */
+  if (fftw_flags & (FFTW_ESTIMATE | FFTW_WISDOM_ONLY))
+    return;
+
+#ifdef _OPENMP
+  #pragma omp critical (nfft_omp_critical_wisdom)
+#endif
+  {
+    wisdom_init();
+
+    if (wisdom_filename)
+    {
+      char *w = FFTW(export_wisdom_to_string)();
+
+      /* plans found in the wisdom leave it unchanged */
+      if (!w || !wisdom_synced || strcmp(w, wisdom_synced) != 0)
+      {
+        wisdom_sync(1);
+        free(wisdom_synced);
+        wisdom_synced = FFTW(export_wisdom_to_string)();
+      }
+
+      free(w);
+    }
+  }
+}
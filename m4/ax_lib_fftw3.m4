@@ -104,6 +104,17 @@ AC_DEFUN([AX_LIB_FFTW3],
       fftw3_threads_LIBS="-lfftw3${PREC_SUFFIX}_threads ${fftw3_lib_flag} -lpthread -lm"
     fi
 
+    # Check for thread-safe planner (FFTW 3.3.5 and later)
+    if test "x$ax_lib_fftw3_threads" = "xyes"; then
+      LIBS="${fftw3_threads_LIBS}"
+      AC_MSG_CHECKING([for fftw${PREC_SUFFIX}_make_planner_thread_safe])
+      AC_LINK_IFELSE([AC_LANG_CALL([], [fftw${PREC_SUFFIX}_make_planner_thread_safe])], [ax_lib_fftw3_planner_thread_safe=yes], [ax_lib_fftw3_planner_thread_safe=no])
+      AC_MSG_RESULT([$ax_lib_fftw3_planner_thread_safe])
+      if test "x$ax_lib_fftw3_planner_thread_safe" = "xyes"; then
+        AC_DEFINE(HAVE_FFTW_MAKE_PLANNER_THREAD_SAFE, 1, [Define if the threaded FFTW provides make_planner_thread_safe.])
+      fi
+    fi
+
     LIBS="$saved_LIBS"
   fi
 
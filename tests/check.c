@@ -48,6 +48,9 @@ int main(void)
   CU_add_test(util, "window_name", X(check_get_window_name));
   CU_add_test(util, "log2i", X(check_log2i));
   CU_add_test(util, "next_power_of_2", X(check_next_power_of_2));
+  CU_add_test(util, "next_fft_size", X(check_next_fft_size));
+  CU_add_test(util, "sort_node_indices", X(check_sort_node_indices));
+  CU_add_test(util, "wisdom_store", X(check_wisdom_store));
 
 #undef X
 #define X(name) NFFT(name)
@@ -77,6 +80,33 @@ int main(void)
   CU_add_test(nfft, "nfft_4d_online", X(check_4d_online));
   CU_add_test(nfft, "nfft_adjoint_4d_online", X(check_adjoint_4d_online));
 #endif
+  CU_add_test(nfft, "nfft_many_online", X(check_many_online));
+  CU_add_test(nfft, "nfft_adjoint_many_online", X(check_adjoint_many_online));
+  CU_add_test(nfft, "nfft_real_online", X(check_real_online));
+  CU_add_test(nfft, "nfft_adjoint_real_online", X(check_adjoint_real_online));
+  CU_add_test(nfft, "nfft_window_online", X(check_window_online));
+  CU_add_test(nfft, "nfft_adjoint_window_online", X(check_adjoint_window_online));
+  CU_add_test(nfft, "nfft_exp_semicircle_online", X(check_exp_semicircle_online));
+  CU_add_test(nfft, "nfft_adjoint_tiled_online", X(check_adjoint_tiled_online));
+  CU_add_test(nfft, "nfft_simd_online", X(check_simd_online));
+  CU_add_test(nfft, "nfft_sort_order_online", X(check_sort_order_online));
+  CU_add_test(nfft, "nfft_mixed_precision_online", X(check_mixed_precision_online));
+  CU_add_test(nfft, "nfft_pruned_fft_online", X(check_pruned_fft_online));
+  CU_add_test(nfft, "nfft_compact_full_psi_online", X(check_compact_full_psi_online));
+  CU_add_test(nfft, "nfft_nd_online", X(check_nd_online));
+  CU_add_test(nfft, "nfft_plan_save_load", X(check_plan_save_load));
+  CU_add_test(nfft, "nfft_set_nodes", X(check_set_nodes));
+  CU_add_test(nfft, "nfft_update_nodes", X(check_update_nodes));
+  CU_add_test(nfft, "nfft_plan_with_nthreads", X(check_plan_with_nthreads));
+  CU_add_test(nfft, "nfft_numa_first_touch", X(check_numa_first_touch));
+  CU_add_test(nfft, "nfft_init_guru_arena", X(check_arena));
+  CU_add_test(nfft, "nfft_init_sigma", X(check_init_sigma));
+  CU_add_test(nfft, "nfft_init_tuned", X(check_init_tuned));
+  CU_add_test(nfft, "nfft_tuning_records", X(check_tuning_records));
+  CU_add_test(nfft, "nfft_stream", X(check_stream));
+  CU_add_test(nfft, "nfft_normal", X(check_normal));
+  CU_add_test(nfft, "nfft_grad", X(check_grad));
+  CU_add_test(nfft, "nfft_stats", X(check_stats));
 #ifdef HAVE_NFCT
 #undef X
 #define X(name) NFCT(name)
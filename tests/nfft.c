@@ -225,7 +225,9 @@ static R err_trafo(X(plan) *p)
   int i;
   for (i = 0, s = ((R)p->sigma[0]); i < p->d; i++)
     s = FMIN(s, ((R)p->sigma[i]));
-#if defined(GAUSSIAN)
+  switch (p->window)
+  {
+    case NFFT_WINDOW_GAUSSIAN:
 #if defined(NFFT_LDOUBLE)
     a = K(0.6);
     b = K(50.0);
@@ -237,10 +239,8 @@ static R err_trafo(X(plan) *p)
     b = K(50.0);
 #endif
     err = EXP(-m*KPI*(K(1.0)-K(1.0)/(K(2.0)*K(2.0) - K(1.0))));
-#elif defined(B_SPLINE)
-    //printf("m = %E, s = %E, a1 = %E, a2 = %E, z = %E\n", m, s, K(1.0)/(K(2.0)*s-K(1.0)), K(2.0)*m, K(4.0) * POW(K(1.0)/(K(2.0)*s-K(1.0)),K(2.0)*m));
-    //printf("\n<s = %E>\n", s);
-    //fflush(stdout);
+    break;
+    case NFFT_WINDOW_B_SPLINE:
 #if defined(NFFT_LDOUBLE)
     a = K(0.3);
     b = K(50.0);
@@ -252,7 +252,8 @@ static R err_trafo(X(plan) *p)
     b = K(2000.0);
 #endif
     err = K(3000.0) * K(4.0) * POW(K(1.0)/(K(2.0)*s-K(1.0)),K(2.0)*m);
-  #elif defined(SINC_POWER)
+    break;
+    case NFFT_WINDOW_SINC_POWER:
 #if defined(NFFT_LDOUBLE)
     a = K(0.3);
     b = K(50.0);
@@ -264,7 +265,9 @@ static R err_trafo(X(plan) *p)
     b = K(2000.0);
 #endif
     err = (K(1.0)/(m-K(1.0))) * ((K(2.0)/(POW(s,K(2.0)*m))) + POW(s/(K(2.0)*s-K(1.0)),K(2.0)*m));
-  #elif defined(KAISER_BESSEL)
+    break;
+    case NFFT_WINDOW_KAISER_BESSEL:
+    case NFFT_WINDOW_EXP_SEMICIRCLE:
 #if defined(NFFT_LDOUBLE)
     a = K(1.5);
     b = K(50.0);
@@ -272,13 +275,34 @@ static R err_trafo(X(plan) *p)
     a = K(0.4);
     b = K(2000.0);
 #else
-    a = K(0.3);
+    /* the exponential of semicircle is less accurate for small m */
+    a = (p->window == NFFT_WINDOW_EXP_SEMICIRCLE && p->m < 3) ? K(1.0) : K(0.3);
     b = K(2100.0);
 #endif
-    err = KPI * (SQRT(m) + m) * SQRT(SQRT(K(1.0) - K(1.0)/K(2.0))) * EXP(-K2PI * m * SQRT(K(1.0) - K(1.0) / K(2.0)));
-  #else
-    #error Unsupported window function.
-  #endif
+    if (p->window == NFFT_WINDOW_EXP_SEMICIRCLE)
+    {
+      /* its Fourier transform decays with sqrt(beta^2 - (pi m / sigma)^2),
+       * see nfft_window_error */
+      const R beta = WINDOW_HELP_B_EXP_SEMICIRCLE(K(2.0), p->m);
+      err = KPI * (SQRT(m) + m) * SQRT(SQRT(K(1.0) - K(1.0)/K(2.0))) * EXP(-SQRT(beta * beta - (m * KPI / K(2.0)) * (m * KPI / K(2.0))));
+    }
+    else
+      err = KPI * (SQRT(m) + m) * SQRT(SQRT(K(1.0) - K(1.0)/K(2.0))) * EXP(-K2PI * m * SQRT(K(1.0) - K(1.0) / K(2.0)));
+    break;
+    default:
+    /* No error estimate, e.g. for NFFT_WINDOW_DIRAC_DELTA. */
+    a = K(1.0);
+    b = K(1.0) / NFFT_EPSILON;
+    err = K(1.0);
+  }
+
+  /* window values and convolution in single precision */
+  if (p->flags & NFFT_MIXED_PRECISION)
+  {
+    a = FMAX(a, K(0.4));
+    b = K(100.0);
+    eps = FMAX(eps, (R)(FLT_EPSILON));
+  }
 
   return FMAX(FMAX(a * err, b * eps), err_trafo_direct(p));
 }
@@ -1333,6 +1357,2695 @@ void X(check_adjoint_4d_online)(void)
 }
 #endif
 
+/* Batched transforms. */
+
+static int check_many_single(const int d, const int Nd, const int M,
+  const int howmany, const int interleaved, const unsigned flags,
+  const int adjoint)
+{
+  X(plan) p, q;
+  int N[d], n[d], NN, i, j, v, ok;
+  const int stride = interleaved ? howmany : 1;
+  R err = K(0.0), bound;
+
+  for (i = 0, NN = 1; i < d; i++)
+  {
+    N[i] = Nd;
+    n[i] = 2 * (int)(Y(next_power_of_2)(Nd));
+    NN *= Nd;
+  }
+
+  printf("%-31s d = %-1d, N = %-5d, M = %-5d, howmany = %-2d, %-11s, %s", "nfft_many_online",
+    d, Nd, M, howmany, interleaved ? "interleaved" : "contiguous", adjoint ? "adjoint_many" : "trafo_many");
+
+  X(init_guru_many)(&p, d, N, M, n, WINDOW_HELP_ESTIMATE_m, howmany, stride,
+    interleaved ? 1 : NN, interleaved ? 1 : M, flags, DEFAULT_FFTW_FLAGS);
+  X(init_guru)(&q, d, N, M, n, WINDOW_HELP_ESTIMATE_m, DEFAULT_NFFT_FLAGS,
+    DEFAULT_FFTW_FLAGS);
+
+  for (j = 0; j < M*d; j++)
+    p.x[j] = q.x[j] = Y(drand48)() - K(0.5);
+
+  if(p.flags & PRE_ONE_PSI)
+    X(precompute_one_psi)(&p);
+
+  for (v = 0; v < howmany; v++)
+  {
+    for (j = 0; j < NN; j++)
+      p.f_hat[j*stride + v*p.f_hat_dist] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+    for (j = 0; j < M; j++)
+      p.f[j*stride + v*p.f_dist] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+  }
+
+  if (adjoint)
+    X(adjoint_many)(&p);
+  else
+    X(trafo_many)(&p);
+
+  /* Compare each vector with the direct transform. */
+  for (v = 0; v < howmany; v++)
+  {
+    R numerator = K(0.0), denominator = K(0.0);
+
+    if (adjoint)
+    {
+      for (j = 0; j < M; j++)
+        q.f[j] = p.f[j*stride + v*p.f_dist];
+      X(adjoint_direct)(&q);
+      for (j = 0; j < NN; j++)
+        numerator = MAX(numerator, CABS(q.f_hat[j] - p.f_hat[j*stride + v*p.f_hat_dist]));
+      for (j = 0; j < M; j++)
+        denominator += CABS(q.f[j]);
+    }
+    else
+    {
+      for (j = 0; j < NN; j++)
+        q.f_hat[j] = p.f_hat[j*stride + v*p.f_hat_dist];
+      X(trafo_direct)(&q);
+      for (j = 0; j < M; j++)
+        numerator = MAX(numerator, CABS(q.f[j] - p.f[j*stride + v*p.f_dist]));
+      for (j = 0; j < NN; j++)
+        denominator += CABS(q.f_hat[j]);
+    }
+
+    err = MAX(err, numerator == K(0.0) ? K(0.0) : numerator/denominator);
+  }
+
+  bound = err_trafo(&p);
+  ok = IF(err < bound, 1, 0);
+  printf(" -> %-4s " __FE__ " (" __FE__ ")\n", IF(ok == 0, "FAIL", "OK"), err, bound);
+
+  X(finalize)(&q);
+  X(finalize)(&p);
+
+  return ok;
+}
+
+static const unsigned flags_many[] =
+{
+  PRE_PHI_HUT | PRE_PSI | DEFAULT_NFFT_FLAGS,
+  PRE_PHI_HUT | PRE_FULL_PSI | DEFAULT_NFFT_FLAGS,
+  PRE_PSI | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS,
+  PRE_PHI_HUT | DEFAULT_NFFT_FLAGS,
+  PRE_PHI_HUT | PRE_PSI | NFFT_OMP_BLOCKWISE_ADJOINT | DEFAULT_NFFT_FLAGS,
+  PRE_PHI_HUT | PRE_FULL_PSI | NFFT_OMP_TILED_ADJOINT | DEFAULT_NFFT_FLAGS,
+#if defined(GAUSSIAN)
+  PRE_PHI_HUT | FG_PSI | PRE_FG_PSI | DEFAULT_NFFT_FLAGS,
+#endif
+};
+
+static void check_many_online(const int adjoint)
+{
+  int ok = 1, r, d, i;
+
+  for (d = 1; d <= 4; d++)
+  {
+    for (i = 0; i < (int)SIZE(flags_many); i++)
+    {
+      r = check_many_single(d, d < 4 ? 16 : 12, 40, 3, (i + d) % 2, flags_many[i], adjoint);
+      ok = MIN(ok, r);
+    }
+  }
+
+  /* Direct transform for small bandwidths. */
+  r = check_many_single(2, 4, 20, 2, 1, flags_many[0], adjoint);
+  ok = MIN(ok, r);
+
+  CU_ASSERT(ok);
+}
+
+void X(check_many_online)(void)
+{
+  check_many_online(0);
+}
+
+void X(check_adjoint_many_online)(void)
+{
+  check_many_online(1);
+}
+
+/* Real transforms. */
+
+static int check_real_single(const int d, const int Nd, const int M,
+  const unsigned flags, const int adjoint)
+{
+  X(plan) p, q;
+  int N[d], n[d], NN, i, j, ok;
+  R err, bound, numerator = K(0.0), denominator = K(0.0);
+
+  for (i = 0, NN = 1; i < d; i++)
+  {
+    N[i] = Nd;
+    n[i] = 2 * (int)(Y(next_power_of_2)(Nd));
+    NN *= Nd;
+  }
+
+  printf("%-31s d = %-1d, N = %-5d, M = %-5d, %s", "nfft_real_online", d, Nd, M,
+    adjoint ? "adjoint_real" : "trafo_real");
+
+  X(init_guru_real)(&p, d, N, M, n, WINDOW_HELP_ESTIMATE_m, flags, DEFAULT_FFTW_FLAGS);
+  X(init_guru)(&q, d, N, M, n, WINDOW_HELP_ESTIMATE_m, DEFAULT_NFFT_FLAGS,
+    DEFAULT_FFTW_FLAGS);
+
+  for (j = 0; j < M*d; j++)
+    p.x[j] = q.x[j] = Y(drand48)() - K(0.5);
+
+  if(p.flags & PRE_ONE_PSI)
+    X(precompute_one_psi)(&p);
+
+  if (adjoint)
+  {
+    for (j = 0; j < M; j++)
+      p.f_r[j] = q.f[j] = Y(drand48)() - K(0.5);
+
+    X(adjoint_real)(&p);
+    X(adjoint_direct)(&q);
+
+    for (j = 0; j < NN; j++)
+      numerator = MAX(numerator, CABS(q.f_hat[j] - p.f_hat[j]));
+    for (j = 0; j < M; j++)
+      denominator += FABS(p.f_r[j]);
+  }
+  else
+  {
+    /* Arbitrary coefficients, the real transform yields the real part. */
+    for (j = 0; j < NN; j++)
+      p.f_hat[j] = q.f_hat[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+    X(trafo_real)(&p);
+    X(trafo_direct)(&q);
+
+    for (j = 0; j < M; j++)
+      numerator = MAX(numerator, FABS(CREAL(q.f[j]) - p.f_r[j]));
+    for (j = 0; j < NN; j++)
+      denominator += CABS(p.f_hat[j]);
+  }
+
+  err = numerator == K(0.0) ? K(0.0) : numerator/denominator;
+  bound = err_trafo(&p);
+  ok = IF(err < bound, 1, 0);
+  printf(" -> %-4s " __FE__ " (" __FE__ ")\n", IF(ok == 0, "FAIL", "OK"), err, bound);
+
+  X(finalize)(&q);
+  X(finalize)(&p);
+
+  return ok;
+}
+
+static void check_real_online(const int adjoint)
+{
+  int ok = 1, r, d, i;
+
+  for (d = 1; d <= 4; d++)
+  {
+    for (i = 0; i < (int)SIZE(flags_many); i++)
+    {
+      r = check_real_single(d, d < 4 ? 16 : 12, 40, flags_many[i], adjoint);
+      ok = MIN(ok, r);
+    }
+  }
+
+  /* Direct transform for small bandwidths. */
+  r = check_real_single(2, 4, 20, flags_many[0], adjoint);
+  ok = MIN(ok, r);
+
+  CU_ASSERT(ok);
+}
+
+void X(check_real_online)(void)
+{
+  check_real_online(0);
+}
+
+void X(check_adjoint_real_online)(void)
+{
+  check_real_online(1);
+}
+
+static const unsigned windows[] =
+{
+  NFFT_WINDOW_KAISER_BESSEL,
+  NFFT_WINDOW_GAUSSIAN,
+  NFFT_WINDOW_B_SPLINE,
+  NFFT_WINDOW_SINC_POWER,
+  NFFT_WINDOW_EXP_SEMICIRCLE
+};
+
+static const char *window_names[] =
+{
+  "kaiserbessel",
+  "gaussian",
+  "bspline",
+  "sinc",
+  "expsemicircle"
+};
+
+static int check_flags_single_m(const char *name, const int w, const int d,
+  const int Nd, const int nd, const int m, const int M, const unsigned flags,
+  const int adjoint)
+{
+  X(plan) p, q;
+  int N[d], n[d], NN, i, j, ok;
+  R err, bound, numerator = K(0.0), denominator = K(0.0);
+
+  for (i = 0, NN = 1; i < d; i++)
+  {
+    N[i] = Nd;
+    n[i] = nd;
+    NN *= Nd;
+  }
+
+  printf("%-31s d = %-1d, N = %-5d, n = %-5d, M = %-5d, %-12s flags = 0x%05x, %s",
+    name, d, Nd, nd, M, window_names[w], flags, adjoint ? "adjoint" : "trafo");
+
+  X(init_guru)(&p, d, N, M, n, m, flags | windows[w], DEFAULT_FFTW_FLAGS);
+  X(init_guru)(&q, d, N, M, n, WINDOW_HELP_ESTIMATE_m, DEFAULT_NFFT_FLAGS,
+    DEFAULT_FFTW_FLAGS);
+
+  for (j = 0; j < M*d; j++)
+    p.x[j] = q.x[j] = Y(drand48)() - K(0.5);
+
+  if(p.flags & PRE_ONE_PSI)
+    X(precompute_one_psi)(&p);
+
+  ok = IF(X(check)(&p) == 0
+    && strcmp(X(get_plan_window_name)(&p), window_names[w]) == 0, 1, 0);
+
+  if (adjoint)
+  {
+    for (j = 0; j < M; j++)
+      p.f[j] = q.f[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+    X(adjoint)(&p);
+    X(adjoint_direct)(&q);
+
+    for (j = 0; j < NN; j++)
+      numerator = MAX(numerator, CABS(q.f_hat[j] - p.f_hat[j]));
+    for (j = 0; j < M; j++)
+      denominator += CABS(p.f[j]);
+  }
+  else
+  {
+    for (j = 0; j < NN; j++)
+      p.f_hat[j] = q.f_hat[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+    X(trafo)(&p);
+    X(trafo_direct)(&q);
+
+    for (j = 0; j < M; j++)
+      numerator = MAX(numerator, CABS(q.f[j] - p.f[j]));
+    for (j = 0; j < NN; j++)
+      denominator += CABS(p.f_hat[j]);
+  }
+
+  err = numerator == K(0.0) ? K(0.0) : numerator/denominator;
+  bound = err_trafo(&p);
+  ok = IF(ok && err < bound, 1, 0);
+  printf(" -> %-4s " __FE__ " (" __FE__ ")\n", IF(ok == 0, "FAIL", "OK"), err, bound);
+
+  X(finalize)(&q);
+  X(finalize)(&p);
+
+  return ok;
+}
+
+static int check_flags_single(const char *name, const int w, const int d,
+  const int Nd, const int nd, const int M, const unsigned flags,
+  const int adjoint)
+{
+  return check_flags_single_m(name, w, d, Nd, nd,
+    (int)Y(window_cut_off)(windows[w]), M, flags, adjoint);
+}
+
+static void check_window_online(const int adjoint)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | DEFAULT_NFFT_FLAGS,
+    DEFAULT_NFFT_FLAGS
+  };
+  int ok = 1, r, w, d, i;
+
+  for (w = 0; w < (int)SIZE(windows); w++)
+  {
+    for (d = 1; d <= 2; d++)
+    {
+      for (i = 0; i < (int)SIZE(flags); i++)
+      {
+        r = check_flags_single("nfft_window_online", w, d, 16, 32, 100,
+          flags[i], adjoint);
+        ok = MIN(ok, r);
+      }
+    }
+  }
+
+  /* Fast Gaussian gridding only works with the Gaussian window. */
+  r = check_flags_single("nfft_window_online", 1, 2, 16, 32, 100, PRE_PHI_HUT
+    | FG_PSI | PRE_FG_PSI | DEFAULT_NFFT_FLAGS, adjoint);
+  ok = MIN(ok, r);
+
+  CU_ASSERT(ok);
+}
+
+void X(check_window_online)(void)
+{
+  check_window_online(0);
+}
+
+void X(check_adjoint_window_online)(void)
+{
+  check_window_online(1);
+}
+
+/* Window values of the exponential of semicircle from its polynomials. */
+static int check_exp_semicircle_psi(const int m)
+{
+  int N = MAX(16, 2 * m + 4), n = 2 * N;
+  const int M = 100;
+  X(plan) p, *ths = &p;
+  int j, l, u, ok;
+  R err = K(0.0), bound;
+
+  printf("%-31s d = 1, N = %-5d, n = %-5d, M = %-5d, m = %-3d, psi",
+    "nfft_exp_semicircle_online", N, n, M, m);
+
+  X(init_guru)(&p, 1, &N, M, &n, m, NFFT_WINDOW_EXP_SEMICIRCLE | PRE_PSI
+    | DEFAULT_NFFT_FLAGS, DEFAULT_FFTW_FLAGS);
+
+  for (j = 0; j < M; j++)
+    p.x[j] = Y(drand48)() - K(0.5);
+
+  X(precompute_psi)(&p);
+
+  for (j = 0; j < M; j++)
+  {
+    u = (int)LRINT(FLOOR(p.x[j] * (R)(n))) - m;
+
+    for (l = 0; l < 2 * m + 2; l++)
+      err = MAX(err, FABS(p.psi[j * (2 * m + 2) + l] - PHI_EXP_SEMICIRCLE(n,
+        p.x[j] - ((R)(u + l)) / (R)(n), 0)));
+  }
+
+  /* the polynomials are accurate up to the error of the window itself */
+  bound = err_trafo(&p);
+  ok = IF(err < bound, 1, 0);
+  printf(" -> %-4s " __FE__ " (" __FE__ ")\n", IF(ok == 0, "FAIL", "OK"), err,
+    bound);
+
+  X(finalize)(&p);
+
+  return ok;
+}
+
+void X(check_exp_semicircle_online)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_LIN_PSI | DEFAULT_NFFT_FLAGS,
+    DEFAULT_NFFT_FLAGS
+  };
+  /* every cut-off up to the largest one nfft_init_tuned chooses */
+  static const int m_max = 32;
+  /* beyond this cut-off, the error of the transforms is roundoff only */
+  static const int m_max_trafo = 16;
+  const int w = 4, M = 100;
+  int ok = 1, r, m, i, adjoint, N = 16;
+  X(plan) p;
+
+  /* PHI_HUT is kept by the plan, without adding PRE_PHI_HUT to its flags */
+  X(init_guru)(&p, 1, &N, 10, &N, 4, NFFT_WINDOW_EXP_SEMICIRCLE
+    | DEFAULT_NFFT_FLAGS, DEFAULT_FFTW_FLAGS);
+  ok = IF(p.flags == (NFFT_WINDOW_EXP_SEMICIRCLE | DEFAULT_NFFT_FLAGS), 1, 0);
+  X(finalize)(&p);
+
+  for (m = 1; m <= m_max; m++)
+  {
+    r = check_exp_semicircle_psi(m);
+    ok = MIN(ok, r);
+
+    if (m > m_max_trafo)
+      continue;
+
+    /* sigma = 2 and no direct transform */
+    N = MAX(16, 2 * m + 4);
+
+    for (i = 0; i < (int)SIZE(flags); i++)
+    {
+      /* the table of PRE_LIN_PSI holds at least M and, as in nfft_init_tuned,
+       * at most 2^24 bytes */
+      if ((flags[i] & PRE_LIN_PSI) && (Y(m2K)(m, NFFT_WINDOW_EXP_SEMICIRCLE)
+        < M || (size_t)(Y(m2K)(m, NFFT_WINDOW_EXP_SEMICIRCLE)) * sizeof(R)
+        > ((size_t)1 << 24)))
+        continue;
+
+      for (adjoint = 0; adjoint <= 1; adjoint++)
+      {
+        r = check_flags_single_m("nfft_exp_semicircle_online", w, 1, N, 2 * N,
+          m, M, flags[i], adjoint);
+        ok = MIN(ok, r);
+      }
+    }
+  }
+
+  CU_ASSERT(ok);
+}
+
+void X(check_adjoint_tiled_online)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | NFFT_OMP_TILED_ADJOINT | DEFAULT_NFFT_FLAGS,
+    NFFT_OMP_TILED_ADJOINT | DEFAULT_NFFT_FLAGS
+  };
+  /* d, N, n: two and three tiles per dimension, a single tile, and a single
+   * tile whose padded subgrid would be wider than the grid */
+  static const int sizes[][3] =
+  {
+    {1, 1024, 2048}, {1, 1536, 3072},
+    {2, 64, 128}, {2, 96, 192}, {2, 16, 32},
+    {3, 24, 48},
+    {1, 12, 24}, {2, 12, 24}, {3, 12, 24}
+  };
+  int ok = 1, r, i, k;
+
+  for (k = 0; k < (int)SIZE(sizes); k++)
+  {
+    for (i = 0; i < (int)SIZE(flags); i++)
+    {
+      r = check_flags_single("nfft_adjoint_tiled_online", 0, sizes[k][0],
+        sizes[k][1], sizes[k][2], 100, flags[i], 1);
+      ok = MIN(ok, r);
+    }
+  }
+
+  r = check_flags_single("nfft_adjoint_tiled_online", 1, 2, 96, 192, 100,
+    PRE_PHI_HUT | FG_PSI | PRE_FG_PSI | NFFT_OMP_TILED_ADJOINT
+    | DEFAULT_NFFT_FLAGS, 1);
+  ok = MIN(ok, r);
+
+  CU_ASSERT(ok);
+}
+
+/** Transforms with a vector unit and compares with the scalar kernels. */
+static int check_simd_single(const int d, const int Nd, const int nd,
+  const int M, const unsigned flags, const int isa)
+{
+  X(plan) p;
+  int N[d], n[d], i, j, ok;
+  C *f_hat, *f;
+  R err = K(0.0), norm = K(0.0);
+
+  for (i = 0; i < d; i++)
+  {
+    N[i] = Nd;
+    n[i] = nd;
+  }
+
+  printf("nfft_simd_online                 d = %-1d, N = %-5d, n = %-5d, M = %-5d, flags = 0x%05x, isa = %d",
+    d, Nd, nd, M, flags, isa);
+
+  X(init_guru)(&p, d, N, M, n, WINDOW_HELP_ESTIMATE_m, flags, DEFAULT_FFTW_FLAGS);
+
+  f_hat = (C*) Y(malloc)((size_t)(p.N_total) * sizeof(C));
+  f = (C*) Y(malloc)((size_t)(M) * sizeof(C));
+
+  for (j = 0; j < M*d; j++)
+    p.x[j] = Y(drand48)() - K(0.5);
+
+  X(precompute_one_psi)(&p);
+
+  for (j = 0; j < p.N_total; j++)
+    f_hat[j] = p.f_hat[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+  Y(simd_select)(SIMD_NONE);
+  X(trafo)(&p);
+  memcpy(f, p.f, (size_t)(M) * sizeof(C));
+
+  Y(simd_select)(isa);
+  memcpy(p.f_hat, f_hat, (size_t)(p.N_total) * sizeof(C));
+  X(trafo)(&p);
+
+  for (j = 0; j < M; j++)
+  {
+    err = MAX(err, CABS(p.f[j] - f[j]));
+    norm = MAX(norm, CABS(f[j]));
+  }
+
+  Y(simd_select)(SIMD_NONE);
+  X(adjoint)(&p);
+  memcpy(f_hat, p.f_hat, (size_t)(p.N_total) * sizeof(C));
+
+  Y(simd_select)(isa);
+  memcpy(p.f, f, (size_t)(M) * sizeof(C));
+  X(adjoint)(&p);
+
+  for (j = 0; j < p.N_total; j++)
+  {
+    err = MAX(err, CABS(p.f_hat[j] - f_hat[j]));
+    norm = MAX(norm, CABS(f_hat[j]));
+  }
+
+  /* FMA and the order of the sums change the rounding only */
+  ok = IF(err <= K(1e3) * NFFT_EPSILON * norm, 1, 0);
+  printf(" -> %-4s " __FE__ "\n", IF(ok == 0, "FAIL", "OK"), err / norm);
+
+  Y(free)(f);
+  Y(free)(f_hat);
+  X(finalize)(&p);
+
+  return ok;
+}
+
+void X(check_simd_online)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_OMP_TILED_ADJOINT | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_LIN_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | FG_PSI | PRE_FG_PSI | DEFAULT_NFFT_FLAGS,
+    DEFAULT_NFFT_FLAGS
+  };
+  /* d, N, n, also with lengths not a power of two and small grids where most
+   * rows wrap around */
+  static const int sizes[][3] = {{2, 32, 64}, {2, 20, 40}, {3, 12, 24}, {3, 10, 20}};
+  const int isa_max = Y(simd_select)(-1);
+  int ok = 1, r, isa, i, k;
+
+  for (isa = SIMD_AVX2; isa <= isa_max; isa++)
+  {
+    for (k = 0; k < (int)SIZE(sizes); k++)
+    {
+      for (i = 0; i < (int)SIZE(flags); i++)
+      {
+        r = check_simd_single(sizes[k][0], sizes[k][1], sizes[k][2], 200,
+          flags[i], isa);
+        ok = MIN(ok, r);
+      }
+    }
+  }
+
+  if (isa_max == SIMD_NONE)
+    printf("nfft_simd_online                 no vector unit\n");
+
+  Y(simd_select)(-1);
+
+  CU_ASSERT(ok);
+}
+
+/** Key of node j in the order selected by the flags of p: the grid index of
+ * its first touched cell, row-major, tile-major or with interleaved bits. */
+static INT sort_order_key(const X(plan) *p, const INT j)
+{
+  INT u[p->d], edge, tile = 0, cell = 0, key = 0, bits, pos = 0, b, t;
+
+  for (t = 0; t < p->d; t++)
+  {
+    u[t] = (INT) LRINT(FLOOR((R)(p->n[t]) * p->x[p->d * j + t] - (R)(p->m)));
+    u[t] = (u[t] % p->n[t] + p->n[t]) % p->n[t];
+  }
+
+  if (p->flags & NFFT_SORT_MORTON)
+  {
+    for (b = 0; b < (INT)(8 * sizeof(INT)) - 1; b++)
+    {
+      for (t = p->d - 1; t >= 0; t--)
+      {
+        for (bits = 1; ((INT)1 << bits) < p->n[t]; bits++)
+          ;
+        if (b < bits)
+          key |= ((u[t] >> b) & 1) << pos++;
+      }
+    }
+  }
+  else if (p->flags & NFFT_SORT_TILE_MAJOR)
+  {
+    /* tiles of 1024, 64, 16 and 8 points per dimension for d = 1, 2, 3, 4+ */
+    edge = p->d == 1 ? 1024 : (p->d == 2 ? 64 : (p->d == 3 ? 16 : 8));
+    for (t = 0; t < p->d; t++)
+    {
+      const INT e = MIN(edge, p->n[t]);
+      tile = tile * ((p->n[t] + e - 1) / e) + u[t] / e;
+      cell = cell * e + u[t] % e;
+    }
+    for (t = 0; t < p->d; t++)
+      tile *= MIN(edge, p->n[t]);
+    key = tile + cell;
+  }
+  else
+  {
+    for (t = 0; t < p->d; t++)
+      key = key * p->n[t] + u[t];
+  }
+
+  return key;
+}
+
+static int check_sort_order_single(const int d, const int Nd, const int nd,
+  const int M, const unsigned flags)
+{
+  X(plan) p;
+  int N[d], n[d], NN, i, j, ok = 1;
+  INT key, key_prev = -1;
+  char *seen;
+
+  for (i = 0, NN = 1; i < d; i++)
+  {
+    N[i] = Nd;
+    n[i] = nd;
+    NN *= Nd;
+  }
+
+  printf("%-31s d = %-1d, N = %-5d, n = %-5d, M = %-5d, flags = 0x%05x",
+    "nfft_sort_order_online", d, Nd, nd, M, flags);
+
+  X(init_guru)(&p, d, N, M, n, WINDOW_HELP_ESTIMATE_m, flags,
+    DEFAULT_FFTW_FLAGS);
+
+  for (j = 0; j < M*d; j++)
+    p.x[j] = Y(drand48)() - K(0.5);
+
+  if(p.flags & PRE_ONE_PSI)
+    X(precompute_one_psi)(&p);
+
+  for (j = 0; j < NN; j++)
+    p.f_hat[j] = Y(drand48)() - K(0.5);
+
+  /* the nodes are sorted by the transform */
+  X(trafo)(&p);
+
+  seen = (char*) Y(malloc)((size_t)M * sizeof(char));
+  memset(seen, 0, (size_t)M * sizeof(char));
+
+  for (j = 0; j < M; j++)
+  {
+    const INT k = p.index_x[2 * j + 1];
+
+    if (k < 0 || k >= M || seen[k])
+    {
+      ok = 0;
+      break;
+    }
+    seen[k] = 1;
+
+    /* the stored keys are those of the order and do not decrease */
+    key = sort_order_key(&p, k);
+    if (key != p.index_x[2 * j] || key < key_prev)
+    {
+      ok = 0;
+      break;
+    }
+    key_prev = key;
+  }
+
+  printf(" -> %-4s\n", IF(ok == 0, "FAIL", "OK"));
+
+  Y(free)(seen);
+  X(finalize)(&p);
+
+  return ok;
+}
+
+void X(check_sort_order_online)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_TILE_MAJOR | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_MORTON | DEFAULT_NFFT_FLAGS,
+    NFFT_SORT_TILE_MAJOR | DEFAULT_NFFT_FLAGS,
+    NFFT_SORT_MORTON | DEFAULT_NFFT_FLAGS,
+    NFFT_SORT_MORTON | NFFT_OMP_BLOCKWISE_ADJOINT | DEFAULT_NFFT_FLAGS
+  };
+  /* the order itself, also the row-major one of NFFT_SORT_NODES */
+  static const unsigned flags_order[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_TILE_MAJOR | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_MORTON | DEFAULT_NFFT_FLAGS,
+    NFFT_SORT_TILE_MAJOR | DEFAULT_NFFT_FLAGS,
+    NFFT_SORT_MORTON | DEFAULT_NFFT_FLAGS,
+    NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS
+  };
+  /* d, N, n: grids that are not a multiple of the tile edge or a power of two */
+  static const int sizes[][3] =
+  {
+    {1, 768, 1536}, {2, 96, 192}, {3, 20, 40}
+  };
+  int ok = 1, r, i, k, adjoint;
+
+  for (k = 0; k < (int)SIZE(sizes); k++)
+  {
+    for (i = 0; i < (int)SIZE(flags); i++)
+    {
+      for (adjoint = 0; adjoint <= 1; adjoint++)
+      {
+        r = check_flags_single("nfft_sort_order_online", 0, sizes[k][0],
+          sizes[k][1], sizes[k][2], 100, flags[i], adjoint);
+        ok = MIN(ok, r);
+      }
+    }
+
+    for (i = 0; i < (int)SIZE(flags_order); i++)
+    {
+      r = check_sort_order_single(sizes[k][0], sizes[k][1], sizes[k][2], 1000,
+        flags_order[i]);
+      ok = MIN(ok, r);
+    }
+  }
+
+  CU_ASSERT(ok);
+}
+
+void X(check_mixed_precision_online)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | NFFT_MIXED_PRECISION | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_MIXED_PRECISION | NFFT_SORT_NODES
+      | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_MIXED_PRECISION | NFFT_SORT_MORTON
+      | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_MIXED_PRECISION | NFFT_OMP_BLOCKWISE_ADJOINT
+      | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_MIXED_PRECISION | NFFT_OMP_TILED_ADJOINT
+      | DEFAULT_NFFT_FLAGS
+  };
+  /* d, N, n: nodes wrapping around the grid in every dimension */
+  static const int sizes[][3] =
+  {
+    {1, 64, 128}, {2, 16, 32}, {3, 12, 24}, {4, 10, 20}
+  };
+  int ok = 1, r, i, k, adjoint;
+
+  for (k = 0; k < (int)SIZE(sizes); k++)
+  {
+    for (i = 0; i < (int)SIZE(flags); i++)
+    {
+      for (adjoint = 0; adjoint <= 1; adjoint++)
+      {
+        r = check_flags_single("nfft_mixed_precision_online", 0, sizes[k][0],
+          sizes[k][1], sizes[k][2], 100, flags[i], adjoint);
+        ok = MIN(ok, r);
+      }
+    }
+  }
+
+  CU_ASSERT(ok);
+}
+
+void X(check_pruned_fft_online)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | NFFT_PRUNED_FFT | DEFAULT_NFFT_FLAGS,
+    NFFT_PRUNED_FFT | DEFAULT_NFFT_FLAGS
+  };
+  /* d, N, n: N/2 odd, n not a multiple of 4 */
+  static const int sizes[][3] =
+  {
+    {2, 16, 32}, {2, 18, 36}, {2, 14, 30}, {3, 12, 24}, {3, 14, 28},
+    {4, 10, 20}
+  };
+  int ok = 1, r, i, k, adjoint;
+
+  for (k = 0; k < (int)SIZE(sizes); k++)
+  {
+    for (i = 0; i < (int)SIZE(flags); i++)
+    {
+      for (adjoint = 0; adjoint <= 1; adjoint++)
+      {
+        r = check_flags_single("nfft_pruned_fft_online", 0, sizes[k][0],
+          sizes[k][1], sizes[k][2], 100, flags[i], adjoint);
+        ok = MIN(ok, r);
+      }
+    }
+  }
+
+  /* only the one-dimensional plans are created */
+  {
+    X(plan) p;
+    int N[3] = {12, 12, 12}, n[3] = {24, 24, 24};
+
+    X(init_guru)(&p, 3, N, 10, n, WINDOW_HELP_ESTIMATE_m, flags[0],
+      DEFAULT_FFTW_FLAGS);
+    r = IF(p.my_fftw_plan1 == NULL && p.my_fftw_plan2 == NULL
+      && p.my_fftw_plan1_pruned != NULL && p.my_fftw_plan2_pruned != NULL, 1, 0);
+    printf("nfft_pruned_fft_online          only one-dimensional FFTW plans -> %s\n",
+      r ? "OK" : "FAIL");
+    ok = MIN(ok, r);
+    X(finalize)(&p);
+  }
+
+  CU_ASSERT(ok);
+}
+
+void X(check_nd_online)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_OMP_BLOCKWISE_ADJOINT | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_LIN_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | NFFT_OMP_BLOCKWISE_ADJOINT | DEFAULT_NFFT_FLAGS
+  };
+  /* d, N, n, m: small cut-off parameters keep the PRE_LIN_PSI tables small;
+   * the error of the Kaiser-Bessel window grows with d, so no size has the
+   * oversampling factor 2 its estimate assumes */
+  static const int sizes[][4] =
+  {
+    {4, 10, 22, 5}, {4, 12, 26, 5}, {5, 6, 16, 5}, {6, 4, 12, 3}
+  };
+  int ok = 1, r, i, k, adjoint;
+
+  for (k = 0; k < (int)SIZE(sizes); k++)
+  {
+    for (i = 0; i < (int)SIZE(flags); i++)
+    {
+      for (adjoint = 0; adjoint <= 1; adjoint++)
+      {
+        r = check_flags_single_m("nfft_nd_online", 0, sizes[k][0],
+          sizes[k][1], sizes[k][2], sizes[k][3], 100, flags[i], adjoint);
+        ok = MIN(ok, r);
+      }
+    }
+  }
+
+  /* Fast Gaussian gridding only works with the Gaussian window, its error
+   * bound is too tight for the small oversampling factor of the first size. */
+  for (k = 1; k < (int)SIZE(sizes); k++)
+  {
+    for (adjoint = 0; adjoint <= 1; adjoint++)
+    {
+      r = check_flags_single_m("nfft_nd_online", 1, sizes[k][0], sizes[k][1],
+        sizes[k][2], sizes[k][3], 100, PRE_PHI_HUT | FG_PSI | PRE_FG_PSI
+        | DEFAULT_NFFT_FLAGS, adjoint);
+      ok = MIN(ok, r);
+      r = check_flags_single_m("nfft_nd_online", 1, sizes[k][0], sizes[k][1],
+        sizes[k][2], sizes[k][3], 100, PRE_PHI_HUT | FG_PSI
+        | DEFAULT_NFFT_FLAGS, adjoint);
+      ok = MIN(ok, r);
+    }
+  }
+
+  CU_ASSERT(ok);
+}
+
+void X(check_compact_full_psi_online)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_FULL_PSI | NFFT_COMPACT_FULL_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | NFFT_COMPACT_FULL_PSI | NFFT_SORT_NODES
+      | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | NFFT_COMPACT_FULL_PSI
+      | NFFT_OMP_BLOCKWISE_ADJOINT | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | NFFT_COMPACT_FULL_PSI | NFFT_OMP_TILED_ADJOINT
+      | DEFAULT_NFFT_FLAGS
+  };
+  /* d, N, n: nodes wrapping around the grid in every dimension */
+  static const int sizes[][3] =
+  {
+    {1, 64, 128}, {2, 16, 32}, {2, 14, 30}, {3, 12, 24}, {4, 10, 20}
+  };
+  static const int sizes_tiled[][3] =
+  {
+    {1, 1536, 3072}, {2, 96, 192}, {3, 24, 48}
+  };
+  int ok = 1, r, i, k, adjoint;
+
+  for (k = 0; k < (int)SIZE(sizes); k++)
+  {
+    for (i = 0; i < (int)SIZE(flags); i++)
+    {
+      for (adjoint = 0; adjoint <= 1; adjoint++)
+      {
+        r = check_flags_single("nfft_compact_full_psi_online", 0, sizes[k][0],
+          sizes[k][1], sizes[k][2], 100, flags[i], adjoint);
+        ok = MIN(ok, r);
+      }
+    }
+  }
+
+  /* several blocks and three tiles per dimension for the adjoint */
+  for (k = 0; k < (int)SIZE(sizes_tiled); k++)
+  {
+    for (i = SIZE(flags) - 2; i < (int)SIZE(flags); i++)
+    {
+      r = check_flags_single("nfft_compact_full_psi_online", 0,
+        sizes_tiled[k][0], sizes_tiled[k][1], sizes_tiled[k][2], 100, flags[i],
+        1);
+      ok = MIN(ok, r);
+    }
+  }
+
+  CU_ASSERT(ok);
+}
+
+static int check_plan_save_load_single(const int d, const int Nd,
+  const int nd, const int M, const unsigned flags)
+{
+  static const char *filename = "nfft_check_plan.bin";
+  X(plan) p, q;
+  int N[d], n[d], NN, i, j, ok;
+  const char *err;
+  R numerator = K(0.0), denominator = K(0.0);
+
+  for (i = 0, NN = 1; i < d; i++)
+  {
+    N[i] = Nd;
+    n[i] = nd;
+    NN *= Nd;
+  }
+
+  printf("nfft_plan_save_load              d = %-1d, N = %-5d, n = %-5d, M = %-5d, flags = 0x%05x",
+    d, Nd, nd, M, flags);
+
+  X(init_guru)(&p, d, N, M, n, WINDOW_HELP_ESTIMATE_m, flags, DEFAULT_FFTW_FLAGS);
+
+  for (j = 0; j < M*d; j++)
+    p.x[j] = Y(drand48)() - K(0.5);
+
+  X(precompute_one_psi)(&p);
+
+  err = X(plan_save)(&p, filename);
+  ok = IF(err == NULL, 1, 0);
+
+  if (ok)
+  {
+    err = X(plan_load)(&q, filename);
+    ok = IF(err == NULL && q.d == p.d && q.M_total == p.M_total
+      && q.window == p.window && (q.flags | NFFT_WINDOW_MASK) == (p.flags | NFFT_WINDOW_MASK), 1, 0);
+
+    if (ok)
+    {
+      for (j = 0; j < M*d; j++)
+        numerator = MAX(numerator, FABS(q.x[j] - p.x[j]));
+
+      for (j = 0; j < NN; j++)
+        p.f_hat[j] = q.f_hat[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+      X(trafo)(&p);
+      X(trafo)(&q);
+
+      for (j = 0; j < M; j++)
+        numerator = MAX(numerator, CABS(q.f[j] - p.f[j]));
+
+      X(adjoint)(&p);
+      X(adjoint)(&q);
+
+      for (j = 0; j < NN; j++)
+        numerator = MAX(numerator, CABS(q.f_hat[j] - p.f_hat[j]));
+
+      /* the precomputation writes to memory of the plan, not to the file */
+      X(set_nodes)(&q, M, p.x);
+      X(trafo)(&p);
+      X(trafo)(&q);
+
+      for (j = 0; j < M; j++)
+        numerator = MAX(numerator, CABS(q.f[j] - p.f[j]));
+
+      for (j = 0; j < M; j++)
+        denominator += CABS(p.f[j]);
+
+      /* with OpenMP the adjoint may sum in a different order */
+      ok = IF(numerator <= K(1e3) * NFFT_EPSILON * denominator, 1, 0);
+      X(finalize)(&q);
+    }
+  }
+
+  remove(filename);
+  printf(" -> %-4s %s\n", IF(ok == 0, "FAIL", "OK"), err ? err : "");
+
+  X(finalize)(&p);
+
+  return ok;
+}
+
+/** Reads the file written by nfft_plan_save for p, NULL on failure. */
+static unsigned char *plan_file_read(X(plan) *p, const char *filename,
+  long *size)
+{
+  unsigned char *buf = NULL;
+  FILE *f;
+
+  *size = 0;
+
+  if (X(plan_save)(p, filename) == NULL && (f = fopen(filename, "rb")))
+  {
+    if (fseek(f, 0, SEEK_END) == 0 && (*size = ftell(f)) > 0 && fseek(f, 0, SEEK_SET) == 0)
+    {
+      buf = (unsigned char*) Y(malloc)((size_t)(*size));
+      if (fread(buf, 1, (size_t)(*size), f) != (size_t)(*size))
+        *size = 0;
+    }
+    fclose(f);
+  }
+
+  return buf;
+}
+
+/** Writes size bytes of buf and checks that the file is rejected. */
+static int plan_file_rejected(const char *filename, const unsigned char *buf,
+  const long size)
+{
+  X(plan) q;
+  FILE *f;
+  int ok = 0;
+
+  if ((f = fopen(filename, "wb")))
+  {
+    ok = IF(fwrite(buf, 1, (size_t)size, f) == (size_t)size, 1, 0);
+    fclose(f);
+  }
+
+  return ok && IF(X(plan_load)(&q, filename) != NULL, 1, 0);
+}
+
+/** Writes a plan file, sets its header entry to value, or truncates it to
+ * half its size for entry < 0, and checks that it is rejected. */
+static int check_plan_load_invalid(const int entry, const INT value)
+{
+  static const char *filename = "nfft_check_plan_invalid.bin";
+  X(plan) p;
+  int N[2] = {12, 12}, n[2] = {24, 24}, j, ok = 0;
+  unsigned char *buf;
+  long size;
+
+  X(init_guru)(&p, 2, N, 50, n, WINDOW_HELP_ESTIMATE_m,
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS, DEFAULT_FFTW_FLAGS);
+
+  for (j = 0; j < 2 * 50; j++)
+    p.x[j] = Y(drand48)() - K(0.5);
+
+  X(precompute_one_psi)(&p);
+
+  buf = plan_file_read(&p, filename, &size);
+
+  if (buf && size > 0)
+  {
+    /* the header entries follow the 8 bytes of the identifier */
+    if (entry >= 0)
+      memcpy(buf + 8 + (size_t)(entry) * sizeof(INT), &value, sizeof(INT));
+    else
+      size /= 2;
+
+    ok = plan_file_rejected(filename, buf, size);
+  }
+
+  printf("nfft_plan_load_invalid           entry = %-2d, value = %-20td -> %-4s\n",
+    entry, (ptrdiff_t)value, IF(ok == 0, "FAIL", "OK"));
+
+  remove(filename);
+  Y(free)(buf);
+  X(finalize)(&p);
+
+  return ok;
+}
+
+/** Writes a plan file with the flags, sets entry k of the index array
+ * psi_index_f, psi_index_g or index_x (section 0, 1 or 2) to value in the
+ * file and checks that it is rejected. */
+static int check_plan_load_invalid_index(const unsigned flags,
+  const int section, const int k, const INT value)
+{
+  static const char *filename = "nfft_check_plan_invalid.bin";
+  static const char *name[] = {"psi_index_f", "psi_index_g", "index_x"};
+  X(plan) p;
+  int N[2] = {12, 12}, n[2] = {24, 24}, j, ok = 0;
+  unsigned char *buf;
+  const INT *a;
+  size_t len;
+  long size, pos;
+
+  X(init_guru)(&p, 2, N, 50, n, WINDOW_HELP_ESTIMATE_m, flags, DEFAULT_FFTW_FLAGS);
+
+  for (j = 0; j < 2 * 50; j++)
+    p.x[j] = Y(drand48)() - K(0.5);
+
+  X(precompute_one_psi)(&p);
+
+  if (section == 0)
+  {
+    a = p.psi_index_f;
+    len = 50;
+  }
+  else if (section == 1)
+  {
+    a = p.psi_index_g;
+    len = (p.flags & NFFT_COMPACT_FULL_PSI) ? 2 * 50 : 50 * (size_t)((2 * p.m + 2) * (2 * p.m + 2));
+  }
+  else
+  {
+    a = p.index_x;
+    len = 2 * 50;
+  }
+
+  buf = plan_file_read(&p, filename, &size);
+
+  /* the sections are copies of the arrays of the plan */
+  for (pos = 0; buf && pos + (long)(len * sizeof(INT)) <= size; pos += (long)sizeof(INT))
+  {
+    if (memcmp(buf + pos, a, len * sizeof(INT)) == 0)
+    {
+      memcpy(buf + pos + (long)((size_t)(k) * sizeof(INT)), &value, sizeof(INT));
+      ok = plan_file_rejected(filename, buf, size);
+      break;
+    }
+  }
+
+  printf("nfft_plan_load_invalid           %-11s[%d] = %-16td -> %-4s\n",
+    name[section], k, (ptrdiff_t)value, IF(ok == 0, "FAIL", "OK"));
+
+  remove(filename);
+  Y(free)(buf);
+  X(finalize)(&p);
+
+  return ok;
+}
+
+/** Compares the transforms of a plan and of the plan loaded from its file. */
+static R check_plan_load_trafo(X(plan) *p, X(plan) *q, R *denominator)
+{
+  R numerator = K(0.0);
+  int j, NN = (int)(p->N_total);
+
+  for (j = 0; j < NN; j++)
+    p->f_hat[j] = q->f_hat[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+  X(trafo)(p);
+  X(trafo)(q);
+
+  for (j = 0; j < p->M_total; j++)
+  {
+    numerator = MAX(numerator, CABS(q->f[j] - p->f[j]));
+    *denominator += CABS(p->f[j]);
+  }
+
+  return numerator;
+}
+
+/** The nodes of a plan loaded without MALLOC_X stay writable. */
+static int check_plan_load_own_x(const int d, const int Nd, const int nd)
+{
+  static const char *filename = "nfft_check_plan_own_x.bin";
+  X(plan) p, q;
+  int N[d], n[d], i, j, ok, index = 7;
+  R *x = (R*) Y(malloc)((size_t)(d * 100) * sizeof(R));
+  R *y = (R*) Y(malloc)((size_t)(d * 100) * sizeof(R));
+  R numerator = K(0.0), denominator = K(0.0);
+
+  for (i = 0; i < d; i++)
+  {
+    N[i] = Nd;
+    n[i] = nd;
+  }
+
+  printf("nfft_plan_save_load              d = %-1d, N = %-5d, n = %-5d, own x",
+    d, Nd, nd);
+
+  X(init_guru)(&p, d, N, 100, n, WINDOW_HELP_ESTIMATE_m, PRE_PHI_HUT | PRE_PSI
+    | NFFT_SORT_NODES | MALLOC_F | MALLOC_F_HAT | FFTW_INIT | FFT_OUT_OF_PLACE,
+    DEFAULT_FFTW_FLAGS);
+
+  for (j = 0; j < 100*d; j++)
+  {
+    x[j] = Y(drand48)() - K(0.5);
+    y[j] = Y(drand48)() - K(0.5);
+  }
+
+  p.x = x;
+  X(precompute_one_psi)(&p);
+
+  ok = IF(X(plan_save)(&p, filename) == NULL, 1, 0);
+  ok = ok && IF(X(plan_load)(&q, filename) == NULL, 1, 0);
+
+  if (ok)
+  {
+    ok = IF(!(q.flags & MALLOC_X) && q.x != x, 1, 0);
+
+    /* move one node, then replace all of them */
+    X(update_nodes)(&q, 1, &index, y);
+    memcpy(x + index * d, y, (size_t)(d) * sizeof(R));
+    X(precompute_one_psi)(&p);
+    numerator = MAX(numerator, check_plan_load_trafo(&p, &q, &denominator));
+
+    ok = MIN(ok, IF(X(set_nodes)(&q, 100, y) == NULL, 1, 0));
+    memcpy(x, y, (size_t)(d * 100) * sizeof(R));
+    X(precompute_one_psi)(&p);
+    numerator = MAX(numerator, check_plan_load_trafo(&p, &q, &denominator));
+
+    ok = MIN(ok, IF(numerator <= K(1e3) * NFFT_EPSILON * denominator, 1, 0));
+    X(finalize)(&q);
+  }
+
+  remove(filename);
+  printf(" -> %-4s\n", IF(ok == 0, "FAIL", "OK"));
+
+  X(finalize)(&p);
+  Y(free)(y);
+  Y(free)(x);
+
+  return ok;
+}
+
+void X(check_plan_save_load)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_MIXED_PRECISION | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | NFFT_COMPACT_FULL_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | FG_PSI | PRE_FG_PSI | NFFT_WINDOW_GAUSSIAN | DEFAULT_NFFT_FLAGS,
+    DEFAULT_NFFT_FLAGS
+  };
+  int ok = 1, r, i, d;
+
+  for (d = 1; d <= 3; d++)
+  {
+    for (i = 0; i < (int)SIZE(flags); i++)
+    {
+      r = check_plan_save_load_single(d, 12, 24, 200, flags[i]);
+      ok = MIN(ok, r);
+    }
+
+    r = check_plan_load_own_x(d, 12, 24);
+    ok = MIN(ok, r);
+  }
+
+  /* a missing plan file must be rejected */
+  {
+    X(plan) q;
+    ok = MIN(ok, IF(X(plan_load)(&q, "nfft_check_plan_missing.bin") != NULL, 1, 0));
+  }
+
+  /* truncated files and header entries d, M_total, m, N_0 and the length of
+   * the wisdom out of range */
+  ok = MIN(ok, check_plan_load_invalid(-1, 0));
+  ok = MIN(ok, check_plan_load_invalid(0, 0));
+  ok = MIN(ok, check_plan_load_invalid(1, (INT)1 << 40));
+  ok = MIN(ok, check_plan_load_invalid(1, -1));
+  ok = MIN(ok, check_plan_load_invalid(2, (INT)1 << 40));
+  ok = MIN(ok, check_plan_load_invalid(12, 3));
+  ok = MIN(ok, check_plan_load_invalid(11, (INT)1 << 30));
+
+  /* indices in the sections out of range */
+  ok = MIN(ok, check_plan_load_invalid_index(PRE_PHI_HUT | PRE_FULL_PSI
+    | DEFAULT_NFFT_FLAGS, 0, 7, 3));
+  ok = MIN(ok, check_plan_load_invalid_index(PRE_PHI_HUT | PRE_FULL_PSI
+    | DEFAULT_NFFT_FLAGS, 1, 9, 24 * 24));
+  ok = MIN(ok, check_plan_load_invalid_index(PRE_PHI_HUT | PRE_FULL_PSI
+    | NFFT_COMPACT_FULL_PSI | DEFAULT_NFFT_FLAGS, 1, 3, 24));
+  ok = MIN(ok, check_plan_load_invalid_index(PRE_PHI_HUT | PRE_PSI
+    | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS, 2, 5, 50));
+  ok = MIN(ok, check_plan_load_invalid_index(PRE_PHI_HUT | PRE_PSI
+    | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS, 2, 5, -1));
+
+  CU_ASSERT(ok);
+}
+
+/** Transforms with the current nodes of a plan and compares with the NDFT. */
+static int check_set_nodes_trafo(X(plan) *p)
+{
+  C *f = (C*) Y(malloc)((size_t)(p->M_total) * sizeof(C));
+  C *f_hat = (C*) Y(malloc)((size_t)(p->N_total) * sizeof(C));
+  R numerator = K(0.0), denominator = K(0.0);
+  int j;
+
+  for (j = 0; j < p->N_total; j++)
+    p->f_hat[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+  for (j = 0; j < p->N_total; j++)
+    denominator += CABS(p->f_hat[j]);
+
+  X(trafo)(p);
+  memcpy(f, p->f, (size_t)(p->M_total) * sizeof(C));
+  X(trafo_direct)(p);
+
+  for (j = 0; j < p->M_total; j++)
+    numerator = MAX(numerator, CABS(f[j] - p->f[j]));
+
+  X(adjoint)(p);
+  memcpy(f_hat, p->f_hat, (size_t)(p->N_total) * sizeof(C));
+  X(adjoint_direct)(p);
+
+  for (j = 0; j < p->N_total; j++)
+    numerator = MAX(numerator, CABS(f_hat[j] - p->f_hat[j]));
+  for (j = 0; j < p->M_total; j++)
+    denominator += CABS(p->f[j]);
+
+  Y(free)(f_hat);
+  Y(free)(f);
+
+  return IF(numerator < err_trafo(p) * denominator, 1, 0);
+}
+
+static int check_set_nodes_single(const int d, const int Nd, const int nd,
+  const unsigned flags, const int load)
+{
+  static const char *filename = "nfft_check_set_nodes.bin";
+  static const int Ms[] = {100, 150, 60, 60};
+  X(plan) p;
+  int N[d], n[d], i, j, ok = 1;
+  R *x = (R*) Y(malloc)((size_t)(d * 150) * sizeof(R));
+
+  for (i = 0; i < d; i++)
+  {
+    N[i] = Nd;
+    n[i] = nd;
+  }
+
+  printf("nfft_set_nodes                   d = %-1d, N = %-5d, n = %-5d, flags = 0x%05x%s",
+    d, Nd, nd, flags, load ? ", loaded" : "");
+
+  X(init_guru)(&p, d, N, Ms[0], n, WINDOW_HELP_ESTIMATE_m, flags, DEFAULT_FFTW_FLAGS);
+
+  for (j = 0; j < Ms[0]*d; j++)
+    p.x[j] = Y(drand48)() - K(0.5);
+
+  X(precompute_one_psi)(&p);
+
+  /* node dependent arrays in a plan file */
+  if (load)
+  {
+    X(plan) q;
+
+    ok = IF(X(plan_save)(&p, filename) == NULL
+      && X(plan_load)(&q, filename) == NULL, 1, 0);
+    remove(filename);
+
+    if (!ok)
+    {
+      printf(" -> FAIL\n");
+      X(finalize)(&p);
+      Y(free)(x);
+      return 0;
+    }
+
+    X(finalize)(&p);
+    p = q;
+  }
+
+  /* changing number of nodes, the same number, and nodes set in place */
+  for (i = 1; i < (int)SIZE(Ms); i++)
+  {
+    for (j = 0; j < Ms[i]*d; j++)
+      x[j] = Y(drand48)() - K(0.5);
+
+    if (i < 3)
+      X(set_nodes)(&p, Ms[i], x);
+    else
+    {
+      for (j = 0; j < Ms[i]*d; j++)
+        p.x[j] = x[j];
+      X(set_nodes)(&p, Ms[i], NULL);
+    }
+
+    ok = MIN(ok, IF(p.M_total == Ms[i], 1, 0));
+    ok = MIN(ok, check_set_nodes_trafo(&p));
+  }
+
+  printf(" -> %-4s\n", IF(ok == 0, "FAIL", "OK"));
+
+  X(finalize)(&p);
+  Y(free)(x);
+
+  return ok;
+}
+
+/** More nodes for a plan without MALLOC_X need an array from the caller. */
+static int check_set_nodes_own_x(const int d, const int Nd, const int nd)
+{
+  X(plan) p;
+  int N[d], n[d], i, j, ok;
+  R *x = (R*) Y(malloc)((size_t)(d * 100) * sizeof(R));
+  R *y = (R*) Y(malloc)((size_t)(d * 150) * sizeof(R));
+
+  for (i = 0; i < d; i++)
+  {
+    N[i] = Nd;
+    n[i] = nd;
+  }
+
+  printf("nfft_set_nodes                   d = %-1d, N = %-5d, n = %-5d, own x",
+    d, Nd, nd);
+
+  X(init_guru)(&p, d, N, 100, n, WINDOW_HELP_ESTIMATE_m, PRE_PHI_HUT | PRE_PSI
+    | MALLOC_F | MALLOC_F_HAT | FFTW_INIT | FFT_OUT_OF_PLACE, DEFAULT_FFTW_FLAGS);
+
+  for (j = 0; j < 100*d; j++)
+    x[j] = Y(drand48)() - K(0.5);
+  for (j = 0; j < 150*d; j++)
+    y[j] = Y(drand48)() - K(0.5);
+
+  p.x = x;
+  X(precompute_one_psi)(&p);
+
+  /* rejected while x has room for 100 nodes only */
+  ok = IF(X(set_nodes)(&p, 150, y) != NULL && p.M_total == 100 && p.x == x,
+    1, 0);
+  ok = MIN(ok, check_set_nodes_trafo(&p));
+
+  p.x = y;
+  ok = MIN(ok, IF(X(set_nodes)(&p, 150, y) == NULL && p.M_total == 150, 1, 0));
+  ok = MIN(ok, check_set_nodes_trafo(&p));
+
+  printf(" -> %-4s\n", IF(ok == 0, "FAIL", "OK"));
+
+  X(finalize)(&p);
+  Y(free)(y);
+  Y(free)(x);
+
+  return ok;
+}
+
+void X(check_set_nodes)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_MIXED_PRECISION | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | NFFT_COMPACT_FULL_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | FG_PSI | PRE_FG_PSI | NFFT_WINDOW_GAUSSIAN | DEFAULT_NFFT_FLAGS,
+    DEFAULT_NFFT_FLAGS
+  };
+  int ok = 1, r, i, d, load;
+
+  for (d = 1; d <= 3; d++)
+  {
+    for (i = 0; i < (int)SIZE(flags); i++)
+    {
+      for (load = 0; load <= 1; load++)
+      {
+        r = check_set_nodes_single(d, 12, 24, flags[i], load);
+        ok = MIN(ok, r);
+      }
+    }
+
+    r = check_set_nodes_own_x(d, 12, 24);
+    ok = MIN(ok, r);
+  }
+
+  CU_ASSERT(ok);
+}
+
+/** Number of window values of a plan, see init_help. */
+static int update_nodes_psi_size(const X(plan) *p)
+{
+  int t, lprod;
+
+  for (t = 0, lprod = 1; t < p->d; t++)
+    lprod *= 2 * p->m + 2;
+
+  if (p->flags & PRE_FULL_PSI)
+    return p->M_total * lprod;
+  if (p->flags & PRE_PSI)
+    return p->M_total * p->d * (2 * p->m + 2);
+  if (p->flags & PRE_FG_PSI)
+    return p->M_total * p->d * 2;
+  return 0;
+}
+
+static int check_update_nodes_single(const int d, const int Nd, const int nd,
+  const unsigned flags)
+{
+  static const int M = 1000;
+  /* merge and sorting again */
+  static const int counts[] = {5, 100, 600};
+  X(plan) p, q;
+  int N[d], n[d], i, j, k, ok = 1;
+  int *indices = (int*) Y(malloc)((size_t)(M) * sizeof(int));
+  R *x = (R*) Y(malloc)((size_t)(d * M) * sizeof(R));
+
+  for (i = 0; i < d; i++)
+  {
+    N[i] = Nd;
+    n[i] = nd;
+  }
+
+  printf("nfft_update_nodes                d = %-1d, N = %-5d, n = %-5d, flags = 0x%05x",
+    d, Nd, nd, flags);
+
+  X(init_guru)(&p, d, N, M, n, WINDOW_HELP_ESTIMATE_m, flags, DEFAULT_FFTW_FLAGS);
+  X(init_guru)(&q, d, N, M, n, WINDOW_HELP_ESTIMATE_m, flags, DEFAULT_FFTW_FLAGS);
+
+  for (j = 0; j < M*d; j++)
+    p.x[j] = Y(drand48)() - K(0.5);
+
+  X(precompute_one_psi)(&p);
+
+  for (k = 0; k < (int)SIZE(counts); k++)
+  {
+    /* the last two indices repeat earlier ones */
+    for (i = 0; i < counts[k] - 2; i++)
+      indices[i] = (int)(Y(drand48)() * M) % M;
+    indices[counts[k] - 2] = indices[0];
+    indices[counts[k] - 1] = indices[1];
+
+    for (j = 0; j < counts[k]*d; j++)
+      x[j] = Y(drand48)() - K(0.5);
+
+    X(update_nodes)(&p, counts[k], indices, x);
+
+    memcpy(q.x, p.x, (size_t)(M * d) * sizeof(R));
+    X(precompute_one_psi)(&q);
+
+    /* the transforms use the repaired index_x without sorting */
+    if (flags & NFFT_SORT_NODES)
+      ok = MIN(ok, IF(p.index_x_sorted
+        && memcmp(p.index_x, q.index_x, 2 * (size_t)(M) * sizeof(INT)) == 0, 1, 0));
+
+    if (flags & NFFT_MIXED_PRECISION)
+      ok = MIN(ok, IF(memcmp(p.psi_single, q.psi_single,
+        (size_t)(update_nodes_psi_size(&p)) * sizeof(float)) == 0, 1, 0));
+    else if (update_nodes_psi_size(&p) > 0)
+      ok = MIN(ok, IF(memcmp(p.psi, q.psi,
+        (size_t)(update_nodes_psi_size(&p)) * sizeof(R)) == 0, 1, 0));
+
+    if (flags & PRE_FULL_PSI)
+      ok = MIN(ok, IF(memcmp(p.psi_index_g, q.psi_index_g,
+        (size_t)((flags & NFFT_COMPACT_FULL_PSI) ? M * d
+        : update_nodes_psi_size(&p)) * sizeof(INT)) == 0, 1, 0));
+
+    for (j = 0; j < p.N_total; j++)
+      p.f_hat[j] = q.f_hat[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+    X(trafo)(&p);
+    X(trafo)(&q);
+
+    ok = MIN(ok, IF(memcmp(p.f, q.f, (size_t)(M) * sizeof(C)) == 0, 1, 0));
+  }
+
+  printf(" -> %-4s\n", IF(ok == 0, "FAIL", "OK"));
+
+  X(finalize)(&q);
+  X(finalize)(&p);
+  Y(free)(x);
+  Y(free)(indices);
+
+  return ok;
+}
+
+void X(check_update_nodes)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_MORTON | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_TILE_MAJOR | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_NODES | NFFT_MIXED_PRECISION | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | NFFT_COMPACT_FULL_PSI | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | FG_PSI | PRE_FG_PSI | NFFT_SORT_NODES | NFFT_WINDOW_GAUSSIAN | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | DEFAULT_NFFT_FLAGS
+  };
+  int ok = 1, r, i, d;
+
+  for (d = 1; d <= 3; d++)
+  {
+    for (i = 0; i < (int)SIZE(flags); i++)
+    {
+      r = check_update_nodes_single(d, 12, 24, flags[i]);
+      ok = MIN(ok, r);
+    }
+  }
+
+  CU_ASSERT(ok);
+}
+
+static int check_plan_with_nthreads_single(const int d, const int Nd,
+  const int nd, const unsigned flags)
+{
+  static const int M = 500;
+  /* 0 selects the default again */
+  static const int nthreads[] = {1, 3, 0};
+  X(plan) p, q;
+  int N[d], n[d], NN, i, j, k, ok = 1;
+  R numerator, denominator;
+
+  for (i = 0, NN = 1; i < d; i++)
+  {
+    N[i] = Nd;
+    n[i] = nd;
+    NN *= Nd;
+  }
+
+  printf("nfft_plan_with_nthreads          d = %-1d, N = %-5d, n = %-5d, flags = 0x%05x",
+    d, Nd, nd, flags);
+
+  X(init_guru)(&p, d, N, M, n, WINDOW_HELP_ESTIMATE_m, flags, DEFAULT_FFTW_FLAGS);
+  X(init_guru)(&q, d, N, M, n, WINDOW_HELP_ESTIMATE_m, flags, DEFAULT_FFTW_FLAGS);
+
+  ok = IF(p.nthreads == Y(get_num_threads)(), 1, 0);
+
+  for (j = 0; j < M*d; j++)
+    p.x[j] = q.x[j] = Y(drand48)() - K(0.5);
+
+  X(precompute_one_psi)(&p);
+  X(precompute_one_psi)(&q);
+
+  for (k = 0; k < (int)SIZE(nthreads); k++)
+  {
+    X(plan_with_nthreads)(&p, nthreads[k]);
+    ok = IF(ok && p.nthreads == (nthreads[k] > 0 ? nthreads[k]
+      : Y(get_num_threads)()), 1, 0);
+
+    numerator = K(0.0);
+    denominator = K(0.0);
+
+    for (j = 0; j < NN; j++)
+      p.f_hat[j] = q.f_hat[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+    X(trafo)(&p);
+    X(trafo)(&q);
+
+    for (j = 0; j < M; j++)
+      numerator = MAX(numerator, CABS(q.f[j] - p.f[j]));
+
+    X(adjoint)(&p);
+    X(adjoint)(&q);
+
+    for (j = 0; j < NN; j++)
+      numerator = MAX(numerator, CABS(q.f_hat[j] - p.f_hat[j]));
+
+    for (j = 0; j < M; j++)
+      denominator += CABS(p.f[j]);
+
+    /* the adjoint may sum in a different order */
+    ok = IF(ok && numerator <= K(1e3) * NFFT_EPSILON * denominator, 1, 0);
+  }
+
+  printf(" -> %-4s\n", IF(ok == 0, "FAIL", "OK"));
+
+  X(finalize)(&q);
+  X(finalize)(&p);
+
+  return ok;
+}
+
+void X(check_plan_with_nthreads)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_OMP_BLOCKWISE_ADJOINT | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_OMP_TILED_ADJOINT | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_PRUNED_FFT | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | DEFAULT_NFFT_FLAGS
+  };
+  int ok = 1, r, i, d;
+
+  for (d = 1; d <= 4; d++)
+  {
+    for (i = 0; i < (int)SIZE(flags); i++)
+    {
+      /* (2m+2)^4 window values per node */
+      if (d == 4 && (flags[i] & PRE_FULL_PSI))
+        continue;
+
+      r = check_plan_with_nthreads_single(d, 12, 24, flags[i]);
+      ok = MIN(ok, r);
+    }
+  }
+
+  CU_ASSERT(ok);
+}
+
+static int check_numa_first_touch_single(const int d, const int Nd,
+  const int nd, const unsigned flags)
+{
+  static const int M = 500;
+  X(plan) p, q;
+  int N[d], n[d], NN, i, j, ok = 1;
+  R numerator, denominator;
+
+  for (i = 0, NN = 1; i < d; i++)
+  {
+    N[i] = Nd;
+    n[i] = nd;
+    NN *= Nd;
+  }
+
+  printf("nfft_numa_first_touch            d = %-1d, N = %-5d, n = %-5d, flags = 0x%05x",
+    d, Nd, nd, flags);
+
+  X(init_guru)(&p, d, N, M, n, WINDOW_HELP_ESTIMATE_m,
+    flags | NFFT_NUMA_FIRST_TOUCH, DEFAULT_FFTW_FLAGS);
+  X(init_guru)(&q, d, N, M, n, WINDOW_HELP_ESTIMATE_m, flags, DEFAULT_FFTW_FLAGS);
+
+#ifdef _OPENMP
+  /* first touched arrays start out cleared */
+  for (j = 0; j < NN; j++)
+    ok = IF(ok && p.f_hat[j] == K(0.0), 1, 0);
+  for (j = 0; j < M; j++)
+    ok = IF(ok && p.f[j] == K(0.0), 1, 0);
+#endif
+
+  for (j = 0; j < M*d; j++)
+    p.x[j] = q.x[j] = Y(drand48)() - K(0.5);
+
+  X(precompute_one_psi)(&p);
+  X(precompute_one_psi)(&q);
+
+  for (j = 0; j < NN; j++)
+    p.f_hat[j] = q.f_hat[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+  /* only the placement of pages differs, so do the results */
+  X(trafo)(&p);
+  X(trafo)(&q);
+
+  for (j = 0; j < M; j++)
+    ok = IF(ok && p.f[j] == q.f[j], 1, 0);
+
+  X(adjoint)(&p);
+  X(adjoint)(&q);
+
+  numerator = K(0.0);
+  denominator = K(0.0);
+
+  for (j = 0; j < NN; j++)
+    numerator = MAX(numerator, CABS(q.f_hat[j] - p.f_hat[j]));
+
+  for (j = 0; j < M; j++)
+    denominator += CABS(p.f[j]);
+
+  /* the adjoint may sum in a different order */
+  ok = IF(ok && numerator <= K(1e3) * NFFT_EPSILON * denominator, 1, 0);
+
+  printf(" -> %-4s\n", IF(ok == 0, "FAIL", "OK"));
+
+  X(finalize)(&q);
+  X(finalize)(&p);
+
+  return ok;
+}
+
+void X(check_numa_first_touch)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_OMP_BLOCKWISE_ADJOINT | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | DEFAULT_NFFT_FLAGS
+  };
+  int ok = 1, r, i, d;
+
+  for (d = 1; d <= 3; d++)
+  {
+    for (i = 0; i < (int)SIZE(flags); i++)
+    {
+      r = check_numa_first_touch_single(d, 12, 24, flags[i]);
+      ok = MIN(ok, r);
+    }
+  }
+
+  CU_ASSERT(ok);
+}
+
+static int check_arena_single(const int d, const int Nd, const int nd,
+  const unsigned flags)
+{
+  static const int M = 500;
+  X(plan) p, q, r;
+  X(plan_memory) mem;
+  int N[d], n[d], NN, i, j, ok = 1;
+  R numerator, denominator;
+  size_t total;
+  void *arena;
+
+  for (i = 0, NN = 1; i < d; i++)
+  {
+    N[i] = Nd;
+    n[i] = nd;
+    NN *= Nd;
+  }
+
+  printf("nfft_init_guru_arena             d = %-1d, N = %-5d, n = %-5d, flags = 0x%06x",
+    d, Nd, nd, flags);
+
+  total = X(estimate_memory)(d, N, M, n, WINDOW_HELP_ESTIMATE_m, flags, &mem);
+  arena = Y(malloc)(total + 64);
+
+  ok = IF(total == mem.x + mem.f_hat + mem.f + mem.c_phi_inv + mem.psi
+    + mem.psi_index + mem.g + mem.index_x + mem.other, 1, 0);
+
+  /* allocated by the plan and provided by the caller, both fit exactly */
+  X(init_guru_arena)(&p, d, N, M, n, WINDOW_HELP_ESTIMATE_m, flags,
+    DEFAULT_FFTW_FLAGS, NULL, 0);
+  X(init_guru_arena)(&r, d, N, M, n, WINDOW_HELP_ESTIMATE_m, flags,
+    DEFAULT_FFTW_FLAGS, arena, total + 64);
+  X(init_guru)(&q, d, N, M, n, WINDOW_HELP_ESTIMATE_m, flags, DEFAULT_FFTW_FLAGS);
+
+  /* the caller's arena is used from its first 64 byte boundary on */
+  ok = IF(ok && p.arena_used == total && r.arena_used >= total
+    && r.arena_used < total + 64, 1, 0);
+  ok = IF(ok && (char*)r.x >= (char*)arena
+    && (char*)r.x < (char*)arena + total + 64, 1, 0);
+
+  /* the arrays of the one-dimensional FFTW plans are counted, too */
+  if (r.flags & NFFT_PRUNED_FFT)
+    ok = IF(ok && (char*)r.my_fftw_plan2_pruned >= (char*)arena
+      && (char*)r.my_fftw_plan2_pruned < (char*)arena + total + 64, 1, 0);
+
+  for (j = 0; j < M*d; j++)
+    p.x[j] = q.x[j] = r.x[j] = Y(drand48)() - K(0.5);
+
+  X(precompute_one_psi)(&p);
+  X(precompute_one_psi)(&q);
+  X(precompute_one_psi)(&r);
+
+  for (j = 0; j < NN; j++)
+    p.f_hat[j] = q.f_hat[j] = r.f_hat[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+  X(trafo)(&p);
+  X(trafo)(&q);
+  X(trafo)(&r);
+
+  for (j = 0; j < M; j++)
+    ok = IF(ok && p.f[j] == q.f[j] && r.f[j] == q.f[j], 1, 0);
+
+  X(adjoint)(&p);
+  X(adjoint)(&q);
+  X(adjoint)(&r);
+
+  numerator = K(0.0);
+  denominator = K(0.0);
+
+  for (j = 0; j < NN; j++)
+    numerator = MAX(numerator, MAX(CABS(q.f_hat[j] - p.f_hat[j]),
+      CABS(q.f_hat[j] - r.f_hat[j])));
+
+  for (j = 0; j < M; j++)
+    denominator += CABS(q.f[j]);
+
+  /* the adjoint may sum in a different order */
+  ok = IF(ok && numerator <= K(1e3) * NFFT_EPSILON * denominator, 1, 0);
+
+  printf(" -> %-4s\n", IF(ok == 0, "FAIL", "OK"));
+
+  X(finalize)(&r);
+  X(finalize)(&q);
+  X(finalize)(&p);
+  Y(free)(arena);
+
+  return ok;
+}
+
+void X(check_arena)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_MIXED_PRECISION | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | NFFT_COMPACT_FULL_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FG_PSI | NFFT_WINDOW_GAUSSIAN | DEFAULT_NFFT_FLAGS,
+    PRE_PSI | NFFT_WINDOW_EXP_SEMICIRCLE | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_PRUNED_FFT | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | MALLOC_X | MALLOC_F | MALLOC_F_HAT | FFTW_INIT
+  };
+  int ok = 1, r, i, d;
+
+  for (d = 1; d <= 3; d++)
+  {
+    for (i = 0; i < (int)SIZE(flags); i++)
+    {
+      r = check_arena_single(d, 12, 24, flags[i]);
+      ok = MIN(ok, r);
+    }
+  }
+
+  CU_ASSERT(ok);
+}
+
+/** Relative error of trafo against trafo_direct for random coefficients. */
+static R err_trafo_random(X(plan) *p)
+{
+  C *f = (C*) Y(malloc)((size_t)(p->M_total) * sizeof(C));
+  R numerator = K(0.0), denominator = K(0.0);
+  INT j;
+
+  for (j = 0; j < p->N_total; j++)
+    p->f_hat[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+  X(trafo)(p);
+  memcpy(f, p->f, (size_t)(p->M_total) * sizeof(C));
+  X(trafo_direct)(p);
+
+  for (j = 0; j < p->M_total; j++)
+    numerator = MAX(numerator, CABS(f[j] - p->f[j]));
+
+  for (j = 0; j < p->N_total; j++)
+    denominator += CABS(p->f_hat[j]);
+
+  Y(free)(f);
+
+  return numerator / denominator;
+}
+
+static int check_init_sigma_single(const int d, const int Nd, const R sigma)
+{
+  static const int M = 300;
+  X(plan) p, q;
+  int N[d], i, j, ok = 1;
+  R err_p, err_q;
+
+  for (i = 0; i < d; i++)
+    N[i] = Nd;
+
+  printf("nfft_init_sigma                  d = %-1d, N = %-5d, sigma = %4.2f",
+    d, Nd, (double)sigma);
+
+  X(init_sigma)(&p, d, N, M, sigma);
+  X(init)(&q, d, N, M);
+
+  for (i = 0; i < d; i++)
+    ok = IF(ok && p.n[i] == Y(next_fft_size)((INT)CEIL(sigma * (R)(Nd)))
+      && p.n[i] < q.n[i], 1, 0);
+
+  ok = IF(ok && p.m >= q.m, 1, 0);
+
+  printf(", n = %-5d, m = %2d, flags = 0x%05x", (int)p.n[0], (int)p.m,
+    p.flags);
+
+  for (j = 0; j < M*d; j++)
+    p.x[j] = q.x[j] = Y(drand48)() - K(0.5);
+
+  X(precompute_one_psi)(&p);
+  X(precompute_one_psi)(&q);
+
+  /* as accurate as nfft_init up to the rounding error amplified by the
+   * deconvolution, which is bounded by the error estimate */
+  err_p = err_trafo_random(&p);
+  err_q = err_trafo_random(&q);
+  ok = IF(ok && err_p <= FMAX(K(10.0) * err_q,
+    (R)(d) * Y(window_error)(p.m, sigma, p.window)), 1, 0);
+
+  printf(" -> %-4s %.2E (%.2E)\n", IF(ok == 0, "FAIL", "OK"), (double)err_p,
+    (double)err_q);
+
+  X(finalize)(&q);
+  X(finalize)(&p);
+
+  return ok;
+}
+
+void X(check_init_sigma)(void)
+{
+  static const R sigma[] = {K(1.25), K(1.5)};
+  int ok = 1, r, i, d;
+
+  for (d = 1; d <= 3; d++)
+  {
+    for (i = 0; i < (int)SIZE(sigma); i++)
+    {
+      r = check_init_sigma_single(d, 20, sigma[i]);
+      ok = MIN(ok, r);
+    }
+  }
+
+  /* no oversampling is replaced by the factor 1.25 */
+  for (i = 0; i < 2; i++)
+  {
+    X(plan) p;
+    int N[1] = {20};
+
+    X(init_sigma)(&p, 1, N, 10, i == 0 ? K(1.0) : K(0.5));
+    ok = MIN(ok, IF(p.n[0] == Y(next_fft_size)(25), 1, 0));
+    X(finalize)(&p);
+  }
+
+  CU_ASSERT(ok);
+}
+
+static int check_init_tuned_single(const int d, const int Nd, const R eps,
+  const unsigned flags)
+{
+  static const int M = 300;
+  X(plan) p, q;
+  int N[d], n[d], NN, i, j, ok;
+  R *x, numerator = K(0.0), denominator = K(0.0);
+  C *f;
+
+  for (i = 0, NN = 1; i < d; i++)
+  {
+    N[i] = Nd;
+    NN *= Nd;
+  }
+
+  printf("nfft_init_tuned                  d = %-1d, N = %-5d, eps = %8.2E, flags = 0x%08x",
+    d, Nd, (double)eps, flags);
+
+  x = (R*) Y(malloc)((size_t)(M * d) * sizeof(R));
+  f = (C*) Y(malloc)((size_t)(M) * sizeof(C));
+
+  for (j = 0; j < M*d; j++)
+    x[j] = Y(drand48)() - K(0.5);
+
+  X(init_tuned)(&p, d, N, M, x, eps, flags);
+
+  printf(", n = %-5d, m = %2d, flags = 0x%05x", (int)p.n[0], (int)p.m,
+    p.flags);
+
+  /* The measurement also times PRE_LIN_PSI, whose table is interpolated. It
+   * has to reach eps as well with the chosen lengths and cut-off. */
+  if (flags & NFFT_TUNE_MEASURE)
+  {
+    for (i = 0; i < d; i++)
+      n[i] = (int)p.n[i];
+
+    X(init_guru)(&q, d, N, M, n, (int)p.m, PRE_PHI_HUT | PRE_LIN_PSI
+      | (p.flags & NFFT_WINDOW_MASK) | DEFAULT_NFFT_FLAGS, DEFAULT_FFTW_FLAGS);
+    memcpy(q.x, x, (size_t)(M * d) * sizeof(R));
+    X(precompute_one_psi)(&q);
+  }
+
+  for (j = 0; j < NN; j++)
+    p.f_hat[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+  X(trafo)(&p);
+  memcpy(f, p.f, (size_t)(M) * sizeof(C));
+  X(trafo_direct)(&p);
+
+  for (j = 0; j < M; j++)
+    numerator = MAX(numerator, CABS(f[j] - p.f[j]));
+
+  if (flags & NFFT_TUNE_MEASURE)
+  {
+    memcpy(q.f_hat, p.f_hat, (size_t)(NN) * sizeof(C));
+    X(trafo)(&q);
+
+    for (j = 0; j < M; j++)
+      numerator = MAX(numerator, CABS(q.f[j] - p.f[j]));
+
+    X(finalize)(&q);
+  }
+
+  for (j = 0; j < NN; j++)
+    denominator += CABS(p.f_hat[j]);
+
+  ok = IF(numerator <= eps * denominator, 1, 0);
+
+  printf(" -> %-4s %.2E\n", IF(ok == 0, "FAIL", "OK"),
+    (double)(numerator / denominator));
+
+  X(finalize)(&p);
+  Y(free)(f);
+  Y(free)(x);
+
+  return ok;
+}
+
+void X(check_init_tuned)(void)
+{
+  const R eps[] = {K(1e-3), FMAX(K(1e-9), K(1e4) * NFFT_EPSILON)};
+  int ok = 1, r, i, d;
+
+  for (d = 1; d <= 3; d++)
+  {
+    for (i = 0; i < (int)SIZE(eps); i++)
+    {
+      r = check_init_tuned_single(d, 12, eps[i], NFFT_TUNE_ESTIMATE);
+      ok = MIN(ok, r);
+      r = check_init_tuned_single(d, 12, eps[i], NFFT_TUNE_MEASURE);
+      ok = MIN(ok, r);
+    }
+  }
+
+  CU_ASSERT(ok);
+}
+
+void X(check_tuning_records)(void)
+{
+  static const int d = 2, M = 300;
+  /* records nfft_init_tuned cannot have chosen: odd n, n <= N, m = 0,
+   * m > 32, NFFT_MIXED_PRECISION and another window than the key, the first
+   * after a valid record */
+  static const char *invalid[] =
+  {
+    "2 300 1 16384 0.0001 16 12 3 18385 17 16\n",
+    "2 300 1 16384 0.0001 16 12 3 18385 16 16\n",
+    "2 300 1 16384 0.0001 16 12 0 18385 18 16\n",
+    "2 300 1 16384 0.0001 16 12 33 18385 18 16\n",
+    "2 300 1 16384 0.0001 16 12 3 1066961 18 16\n",
+    "2 300 1 16384 0.0001 16 12 3 34769 18 16\n",
+    "2 300 1 16384 0.0001 16 12 3 18385 18 16\n"
+    "2 300 1 16384 0.0001 16 12 3 18385 17 16\n"
+  };
+  int N[] = {16, 12};
+  X(plan) p, q;
+  R x[2 * 300];
+  char *s, *t;
+  int i, j, ok;
+
+  printf("nfft_tuning_records             ");
+
+  for (j = 0; j < M*d; j++)
+    x[j] = Y(drand48)() - K(0.5);
+
+  X(forget_tuning)();
+  t = X(export_tuning_to_string)();
+  ok = IF(t[0] == '\0', 1, 0);
+  Y(free)(t);
+
+  /* a measured choice is recorded and found again after a round trip */
+  X(init_tuned)(&p, d, N, M, x, K(1e-4), NFFT_TUNE_MEASURE);
+  s = X(export_tuning_to_string)();
+  X(forget_tuning)();
+  ok = IF(ok && s[0] != '\0' && X(import_tuning_from_string)(s), 1, 0);
+  t = X(export_tuning_to_string)();
+  ok = IF(ok && strcmp(s, t) == 0, 1, 0);
+  Y(free)(t);
+
+  X(init_tuned)(&q, d, N, M, x, K(1e-4), NFFT_TUNE_MEASURE);
+  ok = IF(ok && p.m == q.m && p.flags == q.flags && p.n[0] == q.n[0]
+    && p.n[1] == q.n[1], 1, 0);
+
+  /* invalid strings leave the records unchanged */
+  ok = IF(ok && !X(import_tuning_from_string)("2 300 x"), 1, 0);
+  for (i = 0; i < (int)SIZE(invalid); i++)
+    ok = IF(ok && !X(import_tuning_from_string)(invalid[i]), 1, 0);
+  t = X(export_tuning_to_string)();
+  ok = IF(ok && strcmp(s, t) == 0, 1, 0);
+  Y(free)(t);
+
+  /* the valid record of the last string alone is imported */
+  ok = IF(ok && X(import_tuning_from_string)("2 300 1 16384 0.0001 16 12 3 18385 18 16\n"), 1, 0);
+
+  printf(" -> %-4s\n", IF(ok == 0, "FAIL", "OK"));
+
+  X(forget_tuning)();
+  X(finalize)(&q);
+  X(finalize)(&p);
+  Y(free)(s);
+
+  CU_ASSERT(ok);
+}
+
+static int check_stream_single(const int d, const int Nd, const int nd,
+  const unsigned flags)
+{
+  static const int M = 500, chunk = 97;
+  X(plan) p, q;
+  int N[d], n[d], i, j;
+  R numerator = K(0.0), denominator = K(0.0), err_trafo, err_adjoint;
+  C *f = (C*) Y(malloc)((size_t)(M) * sizeof(C));
+
+  for (i = 0; i < d; i++)
+  {
+    N[i] = Nd;
+    n[i] = nd;
+  }
+
+  printf("nfft_stream                      d = %-1d, N = %-5d, n = %-5d, flags = 0x%05x",
+    d, Nd, nd, flags);
+
+  /* the streamed plan holds no nodes */
+  X(init_guru)(&p, d, N, M, n, WINDOW_HELP_ESTIMATE_m, flags, DEFAULT_FFTW_FLAGS);
+  X(init_guru)(&q, d, N, 0, n, WINDOW_HELP_ESTIMATE_m,
+    flags & ~(MALLOC_X | MALLOC_F), DEFAULT_FFTW_FLAGS);
+
+  for (j = 0; j < M*d; j++)
+    p.x[j] = Y(drand48)() - K(0.5);
+
+  X(precompute_one_psi)(&p);
+  X(precompute_one_psi)(&q);
+
+  for (j = 0; j < p.N_total; j++)
+    p.f_hat[j] = q.f_hat[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+  X(trafo)(&p);
+
+  i = IF(X(trafo_stream_begin)(&q) == 0, 1, 0);
+  for (j = 0; j < M; j += chunk)
+    X(trafo_stream_chunk)(&q, MIN(chunk, M - j), p.x + j*d, f + j);
+
+  for (j = 0; j < M; j++)
+    numerator = MAX(numerator, CABS(f[j] - p.f[j]));
+  for (j = 0; j < p.N_total; j++)
+    denominator += CABS(p.f_hat[j]);
+  err_trafo = numerator / denominator;
+
+  for (j = 0; j < M; j++)
+    p.f[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+  X(adjoint)(&p);
+
+  i = IF(i && X(adjoint_stream_begin)(&q) == 0, 1, 0);
+  for (j = 0; j < M; j += chunk)
+    X(adjoint_stream_chunk)(&q, MIN(chunk, M - j), p.x + j*d, p.f + j);
+  X(adjoint_stream_end)(&q);
+
+  numerator = denominator = K(0.0);
+  for (j = 0; j < p.N_total; j++)
+    numerator = MAX(numerator, CABS(q.f_hat[j] - p.f_hat[j]));
+  for (j = 0; j < M; j++)
+    denominator += CABS(p.f[j]);
+  err_adjoint = numerator / denominator;
+
+  i = IF(i && err_trafo < K(1e3) * NFFT_EPSILON && err_adjoint < K(1e3) * NFFT_EPSILON, 1, 0);
+
+  printf(" -> %-4s %.2E %.2E\n", IF(i == 0, "FAIL", "OK"), (double)err_trafo,
+    (double)err_adjoint);
+
+  X(finalize)(&q);
+  X(finalize)(&p);
+  Y(free)(f);
+
+  return i;
+}
+
+/* Plans without streamed transforms: real, batched and direct ones. */
+static int check_stream_rejected(void)
+{
+  X(plan) p;
+  int N = 12, n = 24, N_small = 4, n_small = 8, ok = 1;
+
+  printf("nfft_stream_rejected");
+
+  X(init_guru_real)(&p, 1, &N, 10, &n, 4, DEFAULT_NFFT_FLAGS, DEFAULT_FFTW_FLAGS);
+  ok = IF(ok && X(trafo_stream_begin)(&p) != 0
+    && X(adjoint_stream_begin)(&p) != 0, 1, 0);
+  X(finalize)(&p);
+
+  X(init_guru_many)(&p, 1, &N, 10, &n, 4, 2, 1, N, 10, DEFAULT_NFFT_FLAGS,
+    DEFAULT_FFTW_FLAGS);
+  ok = IF(ok && X(trafo_stream_begin)(&p) != 0
+    && X(adjoint_stream_begin)(&p) != 0, 1, 0);
+  X(finalize)(&p);
+
+  /* n <= 2m+2 */
+  X(init_guru)(&p, 1, &N_small, 10, &n_small, 4, DEFAULT_NFFT_FLAGS,
+    DEFAULT_FFTW_FLAGS);
+  ok = IF(ok && X(trafo_stream_begin)(&p) != 0
+    && X(adjoint_stream_begin)(&p) != 0, 1, 0);
+  X(finalize)(&p);
+
+  printf(" -> %-4s\n", IF(ok == 0, "FAIL", "OK"));
+
+  return ok;
+}
+
+void X(check_stream)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | NFFT_MIXED_PRECISION | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_PRUNED_FFT | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | FG_PSI | PRE_FG_PSI | NFFT_WINDOW_GAUSSIAN | DEFAULT_NFFT_FLAGS,
+    DEFAULT_NFFT_FLAGS
+  };
+  int ok = 1, r, i, d;
+
+  for (d = 1; d <= 4; d++)
+  {
+    for (i = 0; i < (int)SIZE(flags); i++)
+    {
+      r = check_stream_single(d, 12, 24, flags[i]);
+      ok = MIN(ok, r);
+    }
+  }
+
+  r = check_stream_rejected();
+  ok = MIN(ok, r);
+
+  CU_ASSERT(ok);
+}
+
+static int check_normal_single(const int d, const int Nd)
+{
+  static const int M = 300, iterations = 5;
+  X(plan) p;
+  X(normal_plan) t;
+  SOLVER(plan_complex) ip, iq, ir;
+  int N[d], i, j, ok;
+  R *w = (R*) Y(malloc)((size_t)(M) * sizeof(R));
+  R numerator = K(0.0), denominator = K(0.0), err_normal, err_solver;
+
+  for (i = 0; i < d; i++)
+    N[i] = Nd;
+
+  printf("nfft_normal                      d = %-1d, N = %-5d, M = %-5d", d, Nd, M);
+
+  X(init)(&p, d, N, M);
+
+  for (j = 0; j < M*d; j++)
+    p.x[j] = Y(drand48)() - K(0.5);
+  for (j = 0; j < M; j++)
+    w[j] = Y(drand48)();
+
+  X(precompute_one_psi)(&p);
+
+  /* CGNR with and without the normal operator, which is bound to the plan
+   * and the weights of the solver */
+  SOLVER(init_advanced_complex)(&ip, (X(mv_plan_complex)*) &p, CGNR | PRECOMPUTE_WEIGHT | PRECOMPUTE_DAMP);
+  SOLVER(init_advanced_complex)(&iq, (X(mv_plan_complex)*) &p, CGNR | PRECOMPUTE_WEIGHT | PRECOMPUTE_DAMP | NORMAL_OPERATOR);
+
+  for (j = 0; j < M; j++)
+    iq.w[j] = w[j];
+
+  X(init_normal)(&t, &p, iq.w);
+
+  /* against A^H W A by the direct transforms */
+  for (j = 0; j < p.N_total; j++)
+    t.f_hat[j] = p.f_hat[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+  X(trafo_direct)(&p);
+  for (j = 0; j < M; j++)
+    p.f[j] *= w[j];
+  X(adjoint_direct)(&p);
+  X(trafo_normal)(&t);
+
+  for (j = 0; j < p.N_total; j++)
+  {
+    numerator = MAX(numerator, CABS(t.f_hat[j] - p.f_hat[j]));
+    denominator = MAX(denominator, CABS(p.f_hat[j]));
+  }
+  err_normal = numerator / denominator;
+
+  iq.normal = &t;
+
+  /* without a normal operator, the solver takes the transforms instead */
+  SOLVER(init_advanced_complex)(&ir, (X(mv_plan_complex)*) &p, CGNR | PRECOMPUTE_WEIGHT | PRECOMPUTE_DAMP | NORMAL_OPERATOR);
+
+  for (j = 0; j < M; j++)
+  {
+    ip.y[j] = iq.y[j] = ir.y[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+    ip.w[j] = ir.w[j] = w[j];
+  }
+  for (j = 0; j < p.N_total; j++)
+  {
+    ip.w_hat[j] = iq.w_hat[j] = ir.w_hat[j] = K(1.0) / (K(1.0) + (R)(j % Nd));
+    ip.f_hat_iter[j] = iq.f_hat_iter[j] = ir.f_hat_iter[j] = K(0.0);
+  }
+
+  SOLVER(before_loop_complex)(&ip);
+  SOLVER(before_loop_complex)(&iq);
+  SOLVER(before_loop_complex)(&ir);
+
+  for (i = 0; i < iterations; i++)
+  {
+    SOLVER(loop_one_step_complex)(&ip);
+    SOLVER(loop_one_step_complex)(&iq);
+    SOLVER(loop_one_step_complex)(&ir);
+  }
+
+  numerator = denominator = K(0.0);
+  for (j = 0; j < p.N_total; j++)
+  {
+    numerator = MAX(numerator, CABS(iq.f_hat_iter[j] - ip.f_hat_iter[j]));
+    denominator = MAX(denominator, CABS(ip.f_hat_iter[j]));
+  }
+  err_solver = MAX(numerator / denominator,
+    FABS(iq.dot_r_iter - ip.dot_r_iter) / ip.dot_r_iter);
+
+  numerator = K(0.0);
+  for (j = 0; j < p.N_total; j++)
+    numerator = MAX(numerator, CABS(ir.f_hat_iter[j] - ip.f_hat_iter[j]));
+  err_solver = MAX(err_solver, numerator / denominator);
+
+  ok = IF(err_normal < K(1e4) * NFFT_EPSILON && err_solver < K(1e4) * NFFT_EPSILON
+    && iq.normal == &t && ir.normal == NULL, 1, 0);
+
+  printf(" -> %-4s %.2E %.2E\n", IF(ok == 0, "FAIL", "OK"), (double)err_normal,
+    (double)err_solver);
+
+  SOLVER(finalize_complex)(&ir);
+  SOLVER(finalize_complex)(&iq);
+  SOLVER(finalize_complex)(&ip);
+  X(finalize_normal)(&t);
+  X(finalize)(&p);
+  Y(free)(w);
+
+  return ok;
+}
+
+void X(check_normal)(void)
+{
+  static const int Nd[] = {32, 12, 8};
+  int ok = 1, r, d;
+
+  for (d = 1; d <= 3; d++)
+  {
+    r = check_normal_single(d, Nd[d-1]);
+    ok = MIN(ok, r);
+  }
+
+  /* too small to stream the kernel, 2N <= m */
+  r = check_normal_single(1, 4);
+  ok = MIN(ok, r);
+
+  CU_ASSERT(ok);
+}
+
+static int check_grad_single(const int d, const int Nd, const int nd,
+  const unsigned flags)
+{
+  static const int M = 200;
+  X(plan) p;
+  int N[d], n[d], stride[d+1], i, j, k, t;
+  R numerator, denominator, err_trafo, err_adjoint;
+  C *f_hat, *ref;
+  C *f = (C*) Y(malloc)((size_t)(M) * sizeof(C));
+  C *grad = (C*) Y(malloc)((size_t)(d * M) * sizeof(C));
+
+  for (i = 0; i < d; i++)
+  {
+    N[i] = Nd;
+    n[i] = nd;
+  }
+
+  printf("nfft_grad                        d = %-1d, N = %-5d, n = %-5d, flags = 0x%05x",
+    d, Nd, nd, flags);
+
+  X(init_guru)(&p, d, N, M, n, WINDOW_HELP_ESTIMATE_m, flags, DEFAULT_FFTW_FLAGS);
+
+  f_hat = (C*) Y(malloc)((size_t)(p.N_total) * sizeof(C));
+  ref = (C*) Y(malloc)((size_t)((d + 1) * MAX(M, p.N_total)) * sizeof(C));
+
+  /* k_t of the coefficient k is (k / stride[t+1]) % N - N/2 */
+  for (t = d, stride[d] = 1; t > 0; t--)
+    stride[t-1] = stride[t] * Nd;
+
+  for (j = 0; j < M*d; j++)
+    p.x[j] = Y(drand48)() - K(0.5);
+
+  X(precompute_one_psi)(&p);
+
+  /* f and its partial derivatives by d+1 direct transforms */
+  for (k = 0; k < p.N_total; k++)
+    f_hat[k] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+  for (t = 0; t <= d; t++)
+  {
+    for (k = 0; k < p.N_total; k++)
+    {
+      const int kt = (t == 0) ? 0 : (k / stride[t]) % Nd - Nd/2;
+      p.f_hat[k] = ((t == 0) ? K(1.0) : -K2PI * (R)(kt) * I) * f_hat[k];
+    }
+
+    X(trafo_direct)(&p);
+
+    for (j = 0; j < M; j++)
+      ref[t*M+j] = p.f[j];
+  }
+
+  memcpy(p.f_hat, f_hat, (size_t)(p.N_total) * sizeof(C));
+  X(trafo_grad)(&p, grad);
+
+  numerator = denominator = K(0.0);
+  for (t = 0; t <= d; t++)
+  {
+    for (j = 0; j < M; j++)
+    {
+      numerator = MAX(numerator, CABS(((t == 0) ? p.f[j] : grad[j*d+t-1]) - ref[t*M+j]));
+      denominator = MAX(denominator, CABS(ref[t*M+j]));
+    }
+  }
+  err_trafo = numerator / denominator;
+
+  /* the adjoint sums d+1 direct adjoint transforms */
+  for (j = 0; j < M; j++)
+    f[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+  for (j = 0; j < d*M; j++)
+    grad[j] = (Y(drand48)() - K(0.5)) + (Y(drand48)() - K(0.5)) * I;
+
+  for (k = 0; k < p.N_total; k++)
+    ref[k] = K(0.0);
+
+  for (t = 0; t <= d; t++)
+  {
+    for (j = 0; j < M; j++)
+      p.f[j] = (t == 0) ? f[j] : grad[j*d+t-1];
+
+    X(adjoint_direct)(&p);
+
+    for (k = 0; k < p.N_total; k++)
+    {
+      const int kt = (t == 0) ? 0 : (k / stride[t]) % Nd - Nd/2;
+      ref[k] += ((t == 0) ? K(1.0) : K2PI * (R)(kt) * I) * p.f_hat[k];
+    }
+  }
+
+  memcpy(p.f, f, (size_t)(M) * sizeof(C));
+  X(adjoint_grad)(&p, grad);
+
+  numerator = denominator = K(0.0);
+  for (k = 0; k < p.N_total; k++)
+  {
+    numerator = MAX(numerator, CABS(p.f_hat[k] - ref[k]));
+    denominator = MAX(denominator, CABS(ref[k]));
+  }
+  err_adjoint = numerator / denominator;
+
+  /* relative to the accuracy of the window */
+  numerator = MAX(K(1e-10), K(10.0) * Y(window_error)(p.m, (R)(nd) / (R)(Nd), p.window));
+  i = IF(err_trafo < numerator && err_adjoint < numerator, 1, 0);
+
+  printf(" -> %-4s %.2E %.2E\n", IF(i == 0, "FAIL", "OK"), (double)err_trafo,
+    (double)err_adjoint);
+
+  X(finalize)(&p);
+  Y(free)(ref);
+  Y(free)(grad);
+  Y(free)(f);
+  Y(free)(f_hat);
+
+  return i;
+}
+
+void X(check_grad)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | NFFT_COMPACT_FULL_PSI | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_PSI | NFFT_PRUNED_FFT | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | FG_PSI | PRE_FG_PSI | NFFT_WINDOW_GAUSSIAN | DEFAULT_NFFT_FLAGS,
+    DEFAULT_NFFT_FLAGS
+  };
+  int ok = 1, r, i, d;
+
+  for (d = 1; d <= 3; d++)
+  {
+    for (i = 0; i < (int)SIZE(flags); i++)
+    {
+      r = check_grad_single(d, 12, 24, flags[i]);
+      ok = MIN(ok, r);
+    }
+  }
+
+  /* direct transforms for small n */
+  r = check_grad_single(2, 12, 16, PRE_PHI_HUT | PRE_PSI | DEFAULT_NFFT_FLAGS);
+  ok = MIN(ok, r);
+
+  CU_ASSERT(ok);
+}
+
+static int check_stats_single(const int d, const int Nd, const int nd,
+  const unsigned flags)
+{
+  static const int M = 100;
+  X(plan) p;
+  X(stats) s;
+  int N[d], n[d], i, j, k;
+  const int direct = (nd <= 2 * WINDOW_HELP_ESTIMATE_m + 2);
+
+  for (i = 0; i < d; i++)
+  {
+    N[i] = Nd;
+    n[i] = nd;
+  }
+
+  printf("nfft_stats                       d = %-1d, N = %-5d, n = %-5d, flags = 0x%05x",
+    d, Nd, nd, flags);
+
+  X(init_guru)(&p, d, N, M, n, WINDOW_HELP_ESTIMATE_m, flags, DEFAULT_FFTW_FLAGS);
+
+  for (j = 0; j < M*d; j++)
+    p.x[j] = Y(drand48)() - K(0.5);
+
+  X(precompute_one_psi)(&p);
+
+  for (k = 0; k < p.N_total; k++)
+    p.f_hat[k] = Y(drand48)() - K(0.5);
+
+  X(trafo)(&p);
+  X(trafo)(&p);
+  X(adjoint)(&p);
+
+  X(get_stats)(&p, &s);
+
+  /* PRE_PHI_HUT at init and the window at precompute_one_psi */
+  i = IF(s.trafo_calls == 2 && s.adjoint_calls == 1
+    && s.nodes == 3 * (unsigned long long)M && s.bytes > 0.0
+    && s.nthreads == p.nthreads
+    && s.calls[NFFT_STATS_PRECOMPUTE] == 2, 1, 0);
+
+  if (direct)
+    i = IF(i && s.calls[NFFT_STATS_OTHER] == 3 && s.calls[NFFT_STATS_D] == 0
+      && s.calls[NFFT_STATS_B] == 0, 1, 0);
+  else
+    i = IF(i && s.calls[NFFT_STATS_OTHER] == 0 && s.calls[NFFT_STATS_D] == 3
+      && s.calls[NFFT_STATS_FFT] == 3 && s.calls[NFFT_STATS_B] == 3, 1, 0);
+
+  /* at least at precompute_one_psi */
+  if (flags & NFFT_SORT_NODES)
+    i = IF(i && s.calls[NFFT_STATS_SORT] >= 1, 1, 0);
+
+  for (k = 0; k < NFFT_STATS_PHASES; k++)
+    i = IF(i && s.time[k] >= 0.0 && (s.calls[k] > 0 || s.time[k] == 0.0), 1, 0);
+
+  X(reset_stats)(&p);
+  X(get_stats)(&p, &s);
+
+  for (k = 0; k < NFFT_STATS_PHASES; k++)
+    i = IF(i && s.time[k] == 0.0 && s.calls[k] == 0, 1, 0);
+
+  i = IF(i && s.trafo_calls == 0 && s.adjoint_calls == 0 && s.nodes == 0
+    && s.bytes == 0.0, 1, 0);
+
+  printf(" -> %-4s\n", IF(i == 0, "FAIL", "OK"));
+
+  X(finalize)(&p);
+
+  return i;
+}
+
+void X(check_stats)(void)
+{
+  static const unsigned flags[] =
+  {
+    PRE_PHI_HUT | PRE_PSI | NFFT_SORT_NODES | DEFAULT_NFFT_FLAGS,
+    PRE_PHI_HUT | PRE_FULL_PSI | DEFAULT_NFFT_FLAGS
+  };
+  int ok = 1, r, i, d;
+
+  for (d = 1; d <= 3; d++)
+  {
+    for (i = 0; i < (int)SIZE(flags); i++)
+    {
+      r = check_stats_single(d, 12, 24, flags[i]);
+      ok = MIN(ok, r);
+    }
+  }
+
+  /* direct transforms for small n */
+  r = check_stats_single(2, 12, 16, flags[0]);
+  ok = MIN(ok, r);
+
+  CU_ASSERT(ok);
+}
+
 /* accuracy */
 
 static int check_single_file(const testcase_delegate_t *testcase,
@@ -43,4 +43,32 @@ void X(check_adjoint_3d_fast_file)(void);
 void X(check_adjoint_3d_online)(void);
 void X(check_adjoint_4d_online)(void);
 
+void X(check_many_online)(void);
+void X(check_adjoint_many_online)(void);
+void X(check_real_online)(void);
+void X(check_adjoint_real_online)(void);
+void X(check_window_online)(void);
+void X(check_adjoint_window_online)(void);
+void X(check_exp_semicircle_online)(void);
+void X(check_adjoint_tiled_online)(void);
+void X(check_simd_online)(void);
+void X(check_sort_order_online)(void);
+void X(check_mixed_precision_online)(void);
+void X(check_pruned_fft_online)(void);
+void X(check_compact_full_psi_online)(void);
+void X(check_nd_online)(void);
+void X(check_plan_save_load)(void);
+void X(check_set_nodes)(void);
+void X(check_update_nodes)(void);
+void X(check_plan_with_nthreads)(void);
+void X(check_numa_first_touch)(void);
+void X(check_arena)(void);
+void X(check_init_sigma)(void);
+void X(check_init_tuned)(void);
+void X(check_tuning_records)(void);
+void X(check_stream)(void);
+void X(check_normal)(void);
+void X(check_grad)(void);
+void X(check_stats)(void);
+
 void X(check_acc)(void);
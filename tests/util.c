@@ -151,3 +151,96 @@ void X(check_next_power_of_2)(void)
     }
 }
 
+void X(check_next_fft_size)(void)
+{
+  INT j;
+  int all = 1;
+
+  for (j = -1; j <= 1000; j++)
+  {
+    INT r = Y(next_fft_size)(j), k, q;
+    int ok = r >= MAX(j, 2) && r % 2 == 0;
+
+    /* r is 7-smooth and no even number in between is */
+    for (k = MAX(j, 2); ok && k <= r; k++)
+    {
+      for (q = k; q % 2 == 0; q /= 2) ;
+      for (; q % 3 == 0; q /= 3) ;
+      for (; q % 5 == 0; q /= 5) ;
+      for (; q % 7 == 0; q /= 7) ;
+      ok = (k % 2 == 0 && q == 1) ? k == r : k < r;
+    }
+
+    if (!ok)
+      printf("next_fft_size("__D__") = "__D__" -> FAIL\n", j, r);
+    all = all && ok;
+  }
+
+  printf("next_fft_size(-1..1000) -> %s\n", all ? "OK" : "FAIL");
+  CU_ASSERT(all)
+}
+
+
+void X(check_sort_node_indices)(void)
+{
+    INT rhigh;
+
+    for (rhigh = -1; rhigh < 24; rhigh += 5)
+    {
+        const INT n = 10000;
+        INT *keys0 = (INT*) Y(malloc)(2 * (size_t)n * sizeof(INT));
+        INT *keys1 = (INT*) Y(malloc)(2 * (size_t)n * sizeof(INT));
+        INT i;
+        int ok = 1;
+
+        for (i = 0; i < n; i++)
+        {
+            keys0[2 * i] = (rhigh < 0) ? 0 : (INT)(Y(drand48)() * (R)((INT)1 << (rhigh + 1)));
+            keys0[2 * i + 1] = i;
+        }
+
+        Y(sort_node_indices_radix_lsdf)(n, keys0, keys1, rhigh,
+          Y(get_num_threads)());
+
+        /* sorted by key, stable with respect to the index */
+        for (i = 1; i < n; i++)
+            if (keys0[2 * (i - 1)] > keys0[2 * i] || (keys0[2 * (i - 1)] == keys0[2 * i]
+                && keys0[2 * (i - 1) + 1] >= keys0[2 * i + 1]))
+                ok = 0;
+
+        printf("sort_node_indices_radix_lsdf(rhigh = "__D__") -> %s\n", rhigh, ok ? "OK" : "FAIL");
+        CU_ASSERT(ok)
+
+        Y(free)(keys1);
+        Y(free)(keys0);
+    }
+}
+
+void X(check_wisdom_store)(void)
+{
+    static const char *filename = "nfft_check_wisdom.txt";
+    NFFT(plan) p;
+    FILE *f;
+    int ok, N = 16, n = 32;
+
+    remove(filename);
+    Y(set_wisdom_filename)(filename);
+    ok = Y(get_wisdom_filename)() != NULL && strcmp(Y(get_wisdom_filename)(), filename) == 0;
+
+    /* a measured plan writes the wisdom file */
+    NFFT(init_guru)(&p, 1, &N, 10, &n, WINDOW_HELP_ESTIMATE_m, MALLOC_X | MALLOC_F
+        | MALLOC_F_HAT | FFTW_INIT | FFT_OUT_OF_PLACE, FFTW_MEASURE);
+    NFFT(finalize)(&p);
+
+    f = fopen(filename, "r");
+    ok = ok && f != NULL && fgetc(f) != EOF;
+    if (f)
+        fclose(f);
+
+    Y(set_wisdom_filename)(NULL);
+    ok = ok && Y(get_wisdom_filename)() == NULL;
+    remove(filename);
+
+    printf("wisdom_store -> %s\n", ok ? "OK" : "FAIL");
+    CU_ASSERT(ok)
+}
@@ -20,3 +20,6 @@
 
 void X(check_log2i)(void);
 void X(check_next_power_of_2)(void);
+void X(check_next_fft_size)(void);
+void X(check_sort_node_indices)(void);
+void X(check_wisdom_store)(void);